@@ -37,6 +37,10 @@
 #include "core/frontend/framebuffer_layout.h"
 #include "core/frontend/scope_acquire_context.h"
 #include "core/gdbstub/gdbstub.h"
+#include "core/hle/kernel/ipc_debugger/profiler.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/svc_replay.h"
+#include "core/hle/kernel/svc_trace.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/cfg/cfg.h"
 #include "core/loader/loader.h"
@@ -68,6 +72,13 @@ static void PrintHelp(const char* argv0) {
                  "-r, --movie-record=[file]  Record a movie (game inputs) to the given file\n"
                  "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file\n"
                  "-d, --dump-video=[file]    Dumps audio and video to the given video file\n"
+                 "-P, --ipc-profile=[file]   Profiles HLE service requests and writes the\n"
+                 "                           statistics to the given .json or .csv file on exit\n"
+                 "-T, --svc-trace=[file]     Records every SVC call to the given file, and logs\n"
+                 "                           the SVCs taking the most time on exit\n"
+                 "-R, --replay-svc-trace=[file]\n"
+                 "                           Replays an SVC trace on the HLE kernel, logs how\n"
+                 "                           long it took and exits\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
                  "-h, --help           Display this help and exit\n"
                  "-v, --version        Output version information and exit\n";
@@ -194,6 +205,8 @@ int main(int argc, char** argv) {
     std::string movie_record;
     std::string movie_play;
     std::string dump_video;
+    std::string ipc_profile;
+    std::string svc_trace;
 
     InitializeLogging();
 
@@ -220,12 +233,14 @@ int main(int argc, char** argv) {
         {"gdbport", required_argument, 0, 'g'},     {"install", required_argument, 0, 'i'},
         {"multiplayer", required_argument, 0, 'm'}, {"movie-record", required_argument, 0, 'r'},
         {"movie-play", required_argument, 0, 'p'},  {"dump-video", required_argument, 0, 'd'},
+        {"ipc-profile", required_argument, 0, 'P'}, {"svc-trace", required_argument, 0, 'T'},
+        {"replay-svc-trace", required_argument, 0, 'R'},
         {"fullscreen", no_argument, 0, 'f'},        {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},           {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "g:i:m:r:p:fhv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "g:i:m:r:p:P:T:R:fhv", long_options, &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'g':
@@ -291,6 +306,18 @@ int main(int argc, char** argv) {
             case 'd':
                 dump_video = optarg;
                 break;
+            case 'P':
+                ipc_profile = optarg;
+                break;
+            case 'T':
+                svc_trace = optarg;
+                break;
+            case 'R':
+                if (!Kernel::BenchmarkSVCTrace(std::string(optarg))) {
+                    LOG_CRITICAL(Frontend, "Failed to read the SVC trace {}", optarg);
+                    exit(1);
+                }
+                return 0;
             case 'f':
                 fullscreen = true;
                 LOG_INFO(Frontend, "Starting in fullscreen mode...");
@@ -406,6 +433,12 @@ int main(int argc, char** argv) {
     if (!movie_record.empty()) {
         Core::Movie::GetInstance().StartRecording(movie_record);
     }
+    if (!ipc_profile.empty()) {
+        system.Kernel().GetIPCProfiler().SetEnabled(true);
+    }
+    if (!svc_trace.empty()) {
+        system.Kernel().GetSVCTraceRecorder().Start(svc_trace);
+    }
     if (!dump_video.empty()) {
         Layout::FramebufferLayout layout{
             Layout::FrameLayoutFromResolutionScale(VideoCore::GetResolutionScaleFactor())};
@@ -430,6 +463,21 @@ int main(int argc, char** argv) {
     if (system.VideoDumper().IsDumping()) {
         system.VideoDumper().StopDumping();
     }
+    if (!ipc_profile.empty()) {
+        if (system.Kernel().GetIPCProfiler().DumpToFile(ipc_profile)) {
+            LOG_INFO(Frontend, "IPC profile written to {}", ipc_profile);
+        } else {
+            LOG_ERROR(Frontend, "Failed to write IPC profile to {}", ipc_profile);
+        }
+    }
+    if (system.Kernel().GetSVCTraceRecorder().IsEnabled()) {
+        auto& recorder = system.Kernel().GetSVCTraceRecorder();
+        recorder.Stop();
+        LOG_INFO(Frontend, "Recorded {} SVC calls to {}, {} dropped", recorder.GetRecordCount(),
+                 svc_trace, recorder.GetDroppedCount());
+        LOG_INFO(Frontend, "SVC trace summary:\n{}",
+                 Kernel::FormatSVCTraceSummary(recorder.GetSummary()));
+    }
 
     system.Shutdown();
 
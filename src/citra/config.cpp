@@ -106,6 +106,9 @@ void Config::ReadValues() {
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
     Settings::values.cpu_clock_percentage =
         sdl2_config->GetInteger("Core", "cpu_clock_percentage", 100);
+    Settings::values.async_y2r = sdl2_config->GetBoolean("Core", "async_y2r", false);
+    Settings::values.async_fs_io = sdl2_config->GetBoolean("Core", "async_fs_io", false);
+    Settings::values.skip_idle_loops = sdl2_config->GetBoolean("Core", "skip_idle_loops", false);
 
     // Renderer
     Settings::values.use_gles = sdl2_config->GetBoolean("Renderer", "use_gles", false);
@@ -176,9 +179,13 @@ void Config::ReadValues() {
 
     // Utility
     Settings::values.dump_textures = sdl2_config->GetBoolean("Utility", "dump_textures", false);
+    Settings::values.dump_textures_block_when_full =
+        sdl2_config->GetBoolean("Utility", "dump_textures_block_when_full", false);
     Settings::values.custom_textures = sdl2_config->GetBoolean("Utility", "custom_textures", false);
     Settings::values.preload_textures =
         sdl2_config->GetBoolean("Utility", "preload_textures", false);
+    Settings::values.custom_textures_budget =
+        static_cast<u32>(sdl2_config->GetInteger("Utility", "custom_textures_budget", 1024));
 
     // Audio
     Settings::values.enable_dsp_lle = sdl2_config->GetBoolean("Audio", "enable_dsp_lle", false);
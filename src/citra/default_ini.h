@@ -97,6 +97,19 @@ use_cpu_jit =
 # Range is any positive integer (but we suspect 25 - 400 is a good idea) Default is 100
 cpu_clock_percentage =
 
+# Whether large Y2R (video decoding) conversions run on a separate thread
+# 0 (default): Off, 1: On
+async_y2r =
+
+# Whether guest file reads and writes run on a host I/O thread instead of the emulation thread
+# 0 (default): Off, 1: On
+async_fs_io =
+
+# Whether to fast forward emulated time when a guest thread spins on svcSleepThread(0) with no
+# other thread ready, instead of running the loop until the next event
+# 0 (default): Off, 1: On
+skip_idle_loops =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0 (default): OpenGL, 1: GLES
@@ -200,6 +213,11 @@ upright_screen =
 # 0 (default): Off, 1: On
 dump_textures =
 
+# What to do when textures are dumped faster than they can be encoded. Dropped textures are dumped
+# again the next time they are loaded.
+# 0 (default): Drop the texture, 1: Wait for the encoder
+dump_textures_block_when_full =
+
 # Reads PNG files from load/textures/[Title ID]/ and replaces textures.
 # 0 (default): Off, 1: On
 custom_textures =
@@ -208,6 +226,11 @@ custom_textures =
 # 0 (default): Off, 1: On
 preload_textures =
 
+# Memory in MiB for custom textures that are loaded on demand, least recently used ones are
+# dropped first. Has no effect on preloaded textures.
+# 0: Unlimited, 1024 (default)
+custom_textures_budget =
+
 [Audio]
 # Whether or not to enable DSP LLE
 # 0 (default): No, 1: Yes
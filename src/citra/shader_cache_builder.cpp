@@ -0,0 +1,240 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <fmt/format.h>
+#include <glad/glad.h>
+
+// This needs to be included before getopt.h because the latter #defines symbols used by it
+#include "common/microprofile.h"
+
+#include "citra/config.h"
+#include "common/common_types.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_shader_manager.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+
+#undef _UNICODE
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <title id>\n"
+                 "Regenerates and compiles every shader in the transferable cache of the given\n"
+                 "title and writes the precompiled cache, so the first run does not stutter.\n\n"
+                 "-j, --threads=NUMBER  Number of GLSL generation threads (default: all cores)\n"
+                 "-n, --top=NUMBER      Number of slowest shaders to report (default: 10)\n"
+                 "-h, --help            Display this help and exit\n"
+                 "-v, --version         Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+static void InitializeLogging() {
+    Log::Filter log_filter(Log::Level::Debug);
+    log_filter.ParseFilterString(Settings::values.log_filter);
+    Log::SetGlobalFilter(log_filter);
+
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+}
+
+static const char* GetProgramTypeName(OpenGL::ProgramType type) {
+    switch (type) {
+    case OpenGL::ProgramType::VS:
+        return "VS";
+    case OpenGL::ProgramType::GS:
+        return "GS";
+    case OpenGL::ProgramType::FS:
+        return "FS";
+    }
+    return "??";
+}
+
+static void PrintReport(std::vector<OpenGL::ShaderBuildTiming> timings, std::size_t top) {
+    using std::chrono::microseconds;
+
+    microseconds total_generate{};
+    microseconds total_compile{};
+    for (const auto& timing : timings) {
+        total_generate += timing.generate_time;
+        total_compile += timing.compile_time;
+    }
+
+    std::sort(timings.begin(), timings.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.generate_time + lhs.compile_time > rhs.generate_time + rhs.compile_time;
+    });
+
+    std::cout << fmt::format("Built {} shaders: {} ms generating, {} ms compiling\n",
+                             timings.size(), total_generate.count() / 1000,
+                             total_compile.count() / 1000);
+
+    top = std::min(top, timings.size());
+    if (top == 0) {
+        return;
+    }
+    std::cout << fmt::format("\nSlowest {} shaders:\n", top);
+    std::cout << fmt::format("{:<18} {:<4} {:>10} {:>12} {:>12}\n", "id", "type", "glsl size",
+                             "generate us", "compile us");
+    for (std::size_t i = 0; i < top; ++i) {
+        const auto& timing = timings[i];
+        std::cout << fmt::format("{:016x}   {:<4} {:>10} {:>12} {:>12}\n",
+                                 timing.unique_identifier,
+                                 GetProgramTypeName(timing.program_type), timing.code_size,
+                                 timing.generate_time.count(), timing.compile_time.count());
+    }
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    Config config;
+    int option_index = 0;
+    std::size_t num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::size_t top = 10;
+    std::string title_id_str;
+
+    InitializeLogging();
+
+    char* endarg;
+    static struct option long_options[] = {
+        {"threads", required_argument, 0, 'j'},
+        {"top", required_argument, 0, 'n'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "j:n:hv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'j':
+                num_threads = std::strtoul(optarg, &endarg, 0);
+                if (endarg == optarg || num_threads == 0) {
+                    std::cout << "Invalid thread count\n";
+                    return -1;
+                }
+                break;
+            case 'n':
+                top = std::strtoul(optarg, &endarg, 0);
+                if (endarg == optarg) {
+                    std::cout << "Invalid report size\n";
+                    return -1;
+                }
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+            title_id_str = argv[optind];
+            optind++;
+        }
+    }
+
+    if (title_id_str.empty()) {
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    const u64 program_id = std::strtoull(title_id_str.c_str(), &endarg, 16);
+    if (endarg == title_id_str.c_str() || program_id == 0) {
+        LOG_CRITICAL(Frontend, "Invalid title id {}", title_id_str);
+        return -1;
+    }
+
+    MicroProfileOnThreadCreate("ShaderCacheBuilder");
+    SCOPE_EXIT({ MicroProfileShutdown(); });
+
+    // The disk cache is only used by the hardware shader path, force it on regardless of config
+    Settings::values.use_hw_renderer = true;
+    Settings::values.use_hw_shader = true;
+    Settings::values.use_disk_shader_cache = true;
+    Settings::Apply();
+    OpenGL::GLES = Settings::values.use_gles;
+
+    SDL_SetMainReady();
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        LOG_CRITICAL(Frontend, "Failed to initialize SDL2! Exiting...");
+        return -1;
+    }
+    SCOPE_EXIT({ SDL_Quit(); });
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    if (Settings::values.use_gles) {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+    } else {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    }
+
+    // Program binaries are only valid for the driver that produced them, so the context has to be
+    // created the same way the emulator creates its own
+    SDL_Window* window = SDL_CreateWindow(NULL, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                                          0, 0, SDL_WINDOW_HIDDEN | SDL_WINDOW_OPENGL);
+    if (window == nullptr) {
+        LOG_CRITICAL(Frontend, "Failed to create SDL2 window: {}", SDL_GetError());
+        return -1;
+    }
+    SCOPE_EXIT({ SDL_DestroyWindow(window); });
+
+    SDL_GLContext context = SDL_GL_CreateContext(window);
+    if (context == nullptr) {
+        LOG_CRITICAL(Frontend, "Failed to create SDL2 GL context: {}", SDL_GetError());
+        return -1;
+    }
+    SCOPE_EXIT({ SDL_GL_DeleteContext(context); });
+
+    auto gl_load_func = Settings::values.use_gles ? gladLoadGLES2Loader : gladLoadGLLoader;
+    if (!gl_load_func(static_cast<GLADloadproc>(SDL_GL_GetProcAddress))) {
+        LOG_CRITICAL(Frontend, "Failed to initialize GL functions: {}", SDL_GetError());
+        return -1;
+    }
+
+    LOG_INFO(Frontend, "Building shader cache for title id={:016X} with {} threads", program_id,
+             num_threads);
+
+    std::vector<OpenGL::ShaderBuildTiming> timings;
+    {
+        // The manager owns GL objects and must be destroyed while the context is still alive
+        OpenGL::ShaderProgramManager shader_manager(GLAD_GL_ARB_separate_shader_objects, false,
+                                                    program_id);
+        std::atomic_bool stop_loading = false;
+        timings = shader_manager.PrebuildDiskCache(
+            num_threads, stop_loading,
+            [](VideoCore::LoadCallbackStage stage, std::size_t value, std::size_t total) {
+                LOG_DEBUG(Frontend, "Loading stage {} progress {} {}", static_cast<u32>(stage),
+                          value, total);
+            });
+    }
+
+    if (timings.empty()) {
+        LOG_CRITICAL(Frontend, "No shaders were built for title id={:016X}", program_id);
+        return -1;
+    }
+
+    PrintReport(std::move(timings), top);
+    return 0;
+}
@@ -0,0 +1,237 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <fmt/format.h>
+
+// This needs to be included before getopt.h because the latter #defines symbols used by it
+#include "common/microprofile.h"
+
+#include "citra/lodepng_image_interface.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/texture.h"
+#include "core/custom_tex_cache.h"
+#include "core/custom_tex_pack.h"
+#include "video_core/texture/filters/texture_filter.h"
+
+#undef _UNICODE
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <texture directory> <output file>\n"
+                 "Converts a directory of custom texture PNGs into a texture pack. Place the pack\n"
+                 "as load/textures/[Title ID]/textures.pack to use it.\n\n"
+                 "-j, --threads=NUMBER  Number of PNG decoding threads (default: all cores)\n"
+                 "-l, --level=NUMBER    zstd compression level, 1 to 22 (default: 19)\n"
+                 "-f, --filter=NAME     Upscale every texture with the given texture filter\n"
+                 "-s, --scale=NUMBER    Scale factor of the filter, a power of 2 (default: 2)\n"
+                 "-h, --help            Display this help and exit\n"
+                 "-v, --version         Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+static void InitializeLogging() {
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetGlobalFilter(log_filter);
+
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    std::size_t num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    s32 compression_level = 19;
+    std::string filter_name;
+    u16 filter_scale = 2;
+    std::vector<std::string> positional;
+
+    InitializeLogging();
+
+    char* endarg;
+    static struct option long_options[] = {
+        {"threads", required_argument, 0, 'j'},
+        {"level", required_argument, 0, 'l'},
+        {"filter", required_argument, 0, 'f'},
+        {"scale", required_argument, 0, 's'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "j:l:f:s:hv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'j':
+                num_threads = std::strtoul(optarg, &endarg, 0);
+                if (endarg == optarg || num_threads == 0) {
+                    std::cout << "Invalid thread count\n";
+                    return -1;
+                }
+                break;
+            case 'l':
+                compression_level = static_cast<s32>(std::strtol(optarg, &endarg, 0));
+                if (endarg == optarg || compression_level < 1 || compression_level > 22) {
+                    std::cout << "Invalid compression level\n";
+                    return -1;
+                }
+                break;
+            case 'f':
+                filter_name = optarg;
+                break;
+            case 's':
+                filter_scale = static_cast<u16>(std::strtoul(optarg, &endarg, 0));
+                if (endarg == optarg || filter_scale < 2 || filter_scale > 16 ||
+                    std::bitset<16>(filter_scale).count() != 1) {
+                    std::cout << "Invalid scale factor\n";
+                    return -1;
+                }
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+            positional.emplace_back(argv[optind]);
+            optind++;
+        }
+    }
+
+    if (positional.size() != 2) {
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    const std::string& input_dir = positional[0];
+    const std::string& output_path = positional[1];
+
+    if (!FileUtil::IsDirectory(input_dir)) {
+        LOG_CRITICAL(Frontend, "{} is not a directory", input_dir);
+        return -1;
+    }
+
+    FileUtil::FSTEntry texture_dir;
+    std::vector<FileUtil::FSTEntry> files;
+    // 64 nested folders should be plenty for most cases
+    FileUtil::ScanDirectoryTree(input_dir, texture_dir, 64);
+    FileUtil::GetAllFilesFromNestedEntries(texture_dir, files);
+
+    std::unique_ptr<Pica::Texture::TextureFilter> filter;
+    if (!filter_name.empty()) {
+        filter = Pica::Texture::CreateTextureFilter(filter_name, filter_scale);
+        if (!filter) {
+            LOG_CRITICAL(Frontend, "Unknown texture filter {}, available filters:", filter_name);
+            for (const auto name : Pica::Texture::GetTextureFilterNames()) {
+                LOG_CRITICAL(Frontend, "  {}", name);
+            }
+            return -1;
+        }
+    }
+
+    std::vector<std::pair<u64, std::string>> textures;
+    std::unordered_set<u64> hashes;
+    for (const auto& file : files) {
+        u64 hash;
+        if (file.isDirectory ||
+            !Core::CustomTexCache::ParseTextureFileName(file.virtualName, hash)) {
+            continue;
+        }
+        if (!hashes.insert(hash).second) {
+            LOG_ERROR(Frontend, "Skipping {}, another texture has the same hash", file.physicalName);
+            continue;
+        }
+        textures.emplace_back(hash, file.physicalName);
+    }
+    if (textures.empty()) {
+        LOG_CRITICAL(Frontend, "No custom textures found in {}", input_dir);
+        return -1;
+    }
+
+    Core::CustomTexPackWriter writer(compression_level);
+    if (!writer.Open(output_path)) {
+        LOG_CRITICAL(Frontend, "Failed to create {}", output_path);
+        return -1;
+    }
+
+    LOG_INFO(Frontend, "Packing {} textures with {} threads", textures.size(), num_threads);
+
+    // Decoding and compressing run in parallel, only appending to the pack is serialized
+    std::atomic<std::size_t> next_index{0};
+    std::atomic<std::size_t> packed{0};
+    std::atomic_bool failed{false};
+    const auto PackWorker = [&] {
+        LodePNGImageInterface image_interface;
+        for (std::size_t i = next_index++; i < textures.size() && !failed; i = next_index++) {
+            const auto& [hash, path] = textures[i];
+
+            std::vector<u8> tex;
+            u32 width;
+            u32 height;
+            if (!image_interface.DecodePNG(tex, width, height, path)) {
+                LOG_ERROR(Frontend, "Skipping {}, failed to decode", path);
+                continue;
+            }
+            if (std::bitset<32>(width).count() != 1 || std::bitset<32>(height).count() != 1) {
+                LOG_ERROR(Frontend, "Skipping {}, size is not a power of 2", path);
+                continue;
+            }
+            if (filter) {
+                // Textures are already spread over the workers, filter each on a single thread
+                tex = Pica::Texture::FilterTexture(*filter, tex, width, height, 1);
+                width *= filter->scale_factor;
+                height *= filter->scale_factor;
+            }
+            Common::FlipRGBA8Texture(tex, width, height);
+
+            if (!writer.AddTexture(hash, width, height, tex)) {
+                LOG_CRITICAL(Frontend, "Failed to write {} to the pack", path);
+                failed = true;
+                return;
+            }
+            ++packed;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < num_threads; ++i) {
+        workers.emplace_back(PackWorker);
+    }
+    PackWorker();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (failed || !writer.Finish()) {
+        LOG_CRITICAL(Frontend, "Failed to write texture pack {}", output_path);
+        return -1;
+    }
+
+    std::cout << fmt::format("Packed {} of {} textures into {} ({} bytes)\n", packed.load(),
+                             textures.size(), output_path, FileUtil::GetSize(output_path));
+    return 0;
+}
@@ -240,10 +240,14 @@ void Config::ReadUtilityValues() {
     qt_config->beginGroup(QStringLiteral("Utility"));
 
     Settings::values.dump_textures = ReadSetting(QStringLiteral("dump_textures"), false).toBool();
+    Settings::values.dump_textures_block_when_full =
+        ReadSetting(QStringLiteral("dump_textures_block_when_full"), false).toBool();
     Settings::values.custom_textures =
         ReadSetting(QStringLiteral("custom_textures"), false).toBool();
     Settings::values.preload_textures =
         ReadSetting(QStringLiteral("preload_textures"), false).toBool();
+    Settings::values.custom_textures_budget =
+        ReadSetting(QStringLiteral("custom_textures_budget"), 1024).toUInt();
     Settings::values.use_disk_shader_cache =
         ReadSetting(QStringLiteral("use_disk_shader_cache"), true).toBool();
 
@@ -256,6 +260,10 @@ void Config::ReadCoreValues() {
     Settings::values.use_cpu_jit = ReadSetting(QStringLiteral("use_cpu_jit"), true).toBool();
     Settings::values.cpu_clock_percentage =
         ReadSetting(QStringLiteral("cpu_clock_percentage"), 100).toInt();
+    Settings::values.async_y2r = ReadSetting(QStringLiteral("async_y2r"), false).toBool();
+    Settings::values.async_fs_io = ReadSetting(QStringLiteral("async_fs_io"), false).toBool();
+    Settings::values.skip_idle_loops =
+        ReadSetting(QStringLiteral("skip_idle_loops"), false).toBool();
 
     qt_config->endGroup();
 }
@@ -770,8 +778,12 @@ void Config::SaveUtilityValues() {
     qt_config->beginGroup(QStringLiteral("Utility"));
 
     WriteSetting(QStringLiteral("dump_textures"), Settings::values.dump_textures, false);
+    WriteSetting(QStringLiteral("dump_textures_block_when_full"),
+                 Settings::values.dump_textures_block_when_full, false);
     WriteSetting(QStringLiteral("custom_textures"), Settings::values.custom_textures, false);
     WriteSetting(QStringLiteral("preload_textures"), Settings::values.preload_textures, false);
+    WriteSetting(QStringLiteral("custom_textures_budget"), Settings::values.custom_textures_budget,
+                 1024);
     WriteSetting(QStringLiteral("use_disk_shader_cache"), Settings::values.use_disk_shader_cache,
                  true);
 
@@ -784,6 +796,9 @@ void Config::SaveCoreValues() {
     WriteSetting(QStringLiteral("use_cpu_jit"), Settings::values.use_cpu_jit, true);
     WriteSetting(QStringLiteral("cpu_clock_percentage"), Settings::values.cpu_clock_percentage,
                  100);
+    WriteSetting(QStringLiteral("async_y2r"), Settings::values.async_y2r, false);
+    WriteSetting(QStringLiteral("async_fs_io"), Settings::values.async_fs_io, false);
+    WriteSetting(QStringLiteral("skip_idle_loops"), Settings::values.skip_idle_loops, false);
 
     qt_config->endGroup();
 }
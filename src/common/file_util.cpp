@@ -43,8 +43,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <pwd.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 #if defined(__APPLE__)
@@ -368,6 +370,21 @@ u64 GetSize(FILE* f) {
     return size;
 }
 
+s64 GetModificationTime(const std::string& filename) {
+    struct stat buf;
+#ifdef _WIN32
+    if (_wstat64(Common::UTF8ToUTF16W(filename).c_str(), &buf) == 0)
+#else
+    if (stat(filename.c_str(), &buf) == 0)
+#endif
+    {
+        return static_cast<s64>(buf.st_mtime);
+    }
+
+    LOG_ERROR(Common_Filesystem, "Stat failed {}: {}", filename, GetLastErrorMsg());
+    return 0;
+}
+
 bool CreateEmptyFile(const std::string& filename) {
     LOG_TRACE(Common_Filesystem, "{}", filename);
 
@@ -568,6 +585,32 @@ bool SetCurrentDir(const std::string& directory) {
 #endif
 }
 
+std::string GetTempDirectory() {
+#ifdef _WIN32
+    std::array<wchar_t, MAX_PATH + 1> path;
+    const DWORD length = GetTempPathW(static_cast<DWORD>(path.size()), path.data());
+    if (length != 0 && length < path.size()) {
+        std::string dir = Common::UTF16ToUTF8(std::wstring(path.data(), length));
+        std::replace(dir.begin(), dir.end(), '\\', '/');
+        if (dir.back() != '/') {
+            dir += '/';
+        }
+        return dir;
+    }
+#else
+    const char* tmpdir = getenv("TMPDIR");
+    if (tmpdir != nullptr && tmpdir[0] != '\0') {
+        std::string dir = tmpdir;
+        if (dir.back() != '/') {
+            dir += '/';
+        }
+        return dir;
+    }
+#endif
+    LOG_WARNING(Common_Filesystem, "Could not get the temporary directory, using /tmp/");
+    return "/tmp/";
+}
+
 #if defined(__APPLE__)
 std::string GetBundleDirectory() {
     CFURLRef BundleRef;
@@ -676,6 +719,8 @@ std::unordered_map<UserPath, std::string> g_paths;
 }
 
 void SetUserPath(const std::string& path) {
+    // Setting the user directory again replaces every path derived from it
+    g_paths.clear();
     std::string& user_path = g_paths[UserPath::UserDir];
 
     if (!path.empty() && CreateFullPath(path)) {
@@ -975,4 +1020,84 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+MappedFile::MappedFile(const std::string& filename) {
+    Open(filename);
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Common::UTF8ToUTF16W(filename).c_str(), GENERIC_READ,
+                              FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // The mapping keeps the file open
+    CloseHandle(file);
+    if (!m_mapping) {
+        LOG_ERROR(Common_Filesystem, "Could not map {}: {}", filename, GetLastErrorMsg());
+        return false;
+    }
+    void* data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        LOG_ERROR(Common_Filesystem, "Could not map {}: {}", filename, GetLastErrorMsg());
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return false;
+    }
+    m_size = static_cast<u64>(size.QuadPart);
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat buf;
+    if (fstat(fd, &buf) != 0 || buf.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* data =
+        mmap(nullptr, static_cast<std::size_t>(buf.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file open
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR(Common_Filesystem, "Could not map {}: {}", filename, GetLastErrorMsg());
+        return false;
+    }
+    m_size = static_cast<u64>(buf.st_size);
+#endif
+
+    m_data = static_cast<const u8*>(data);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (!IsOpen()) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    m_mapping = nullptr;
+#else
+    munmap(const_cast<u8*>(m_data), static_cast<std::size_t>(m_size));
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
 } // namespace FileUtil
@@ -62,6 +62,9 @@ u64 GetSize(const int fd);
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE* f);
 
+// Returns the last modification time of filename in seconds since the epoch, 0 on failure
+s64 GetModificationTime(const std::string& filename);
+
 // Returns true if successful, or path already exists.
 bool CreateDir(const std::string& filename);
 
@@ -135,6 +138,9 @@ void CopyDir(const std::string& source_path, const std::string& dest_path);
 // Set the current directory to given directory
 bool SetCurrentDir(const std::string& directory);
 
+// Returns the directory for temporary files, with a trailing '/'
+std::string GetTempDirectory();
+
 void SetUserPath(const std::string& path = "");
 
 // Returns a pointer to a string with a Citra data dir in the user's home
@@ -309,6 +315,46 @@ private:
     bool m_good = true;
 };
 
+// Read-only memory mapping of a whole file. Reading through the mapping copies straight from the
+// page cache and only touches the pages that are actually used.
+class MappedFile : public NonCopyable {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const {
+        return m_data != nullptr;
+    }
+
+    const u8* Data() const {
+        return m_data;
+    }
+
+    u64 GetSize() const {
+        return m_size;
+    }
+
+    // Returns a pointer to the range [offset, offset + length) of the file, or nullptr if the
+    // file isn't mapped or is too small
+    const u8* View(u64 offset, u64 length) const {
+        if (!IsOpen() || offset > m_size || length > m_size - offset) {
+            return nullptr;
+        }
+        return m_data + offset;
+    }
+
+private:
+    const u8* m_data = nullptr;
+    u64 m_size = 0;
+#ifdef _WIN32
+    void* m_mapping = nullptr;
+#endif
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
@@ -0,0 +1,71 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(std::size_t num_workers) {
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    work_available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& func) {
+    if (workers.empty() || count <= 1 || busy.exchange(true)) {
+        for (std::size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    std::unique_lock lock{mutex};
+    job = &func;
+    job_count = count;
+    next_part = 0;
+    unfinished_parts = count;
+    work_available.notify_all();
+
+    RunParts(lock);
+    work_done.wait(lock, [this] { return unfinished_parts == 0; });
+    job = nullptr;
+    busy = false;
+}
+
+void ThreadPool::WorkerLoop() {
+    std::unique_lock lock{mutex};
+    while (true) {
+        work_available.wait(lock, [this] { return stop || (job && next_part < job_count); });
+        if (stop) {
+            return;
+        }
+        RunParts(lock);
+    }
+}
+
+void ThreadPool::RunParts(std::unique_lock<std::mutex>& lock) {
+    while (job != nullptr && next_part < job_count) {
+        const std::size_t part = next_part++;
+        const auto& func = *job;
+        lock.unlock();
+        func(part);
+        lock.lock();
+        if (--unfinished_parts == 0) {
+            work_done.notify_all();
+        }
+    }
+}
+
+} // namespace Common
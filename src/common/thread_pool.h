@@ -0,0 +1,66 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Common {
+
+/**
+ * A fixed set of worker threads for splitting a job into parts that run in parallel. The threads
+ * are started once and kept waiting between jobs, so that jobs that come several times per frame
+ * don't pay for creating them.
+ */
+class ThreadPool {
+public:
+    /// Starts the given number of worker threads, the thread running a job helps as well
+    explicit ThreadPool(std::size_t num_workers);
+
+    /// Stops the workers, no job may be running
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Number of threads a job is spread over, including the calling thread
+    std::size_t GetThreadCount() const {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Calls func(i) for every i in [0, count) and returns once all calls have finished. The
+     * calls are spread over the workers and the calling thread. If another job is already
+     * running, every call is made on the calling thread instead of waiting for it.
+     */
+    void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& func);
+
+private:
+    void WorkerLoop();
+
+    /// Runs parts of the current job until none is left to start, the lock is held between parts
+    void RunParts(std::unique_lock<std::mutex>& lock);
+
+    std::vector<std::thread> workers;
+
+    /// Set for the duration of a job, so that only one runs at a time
+    std::atomic_bool busy{false};
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    const std::function<void(std::size_t)>* job = nullptr;
+    std::size_t job_count = 0;
+    std::size_t next_part = 0;
+    std::size_t unfinished_parts = 0;
+    bool stop = false;
+};
+
+} // namespace Common
@@ -4,159 +4,184 @@
 
 #pragma once
 
-#include <algorithm>
 #include <array>
-#include <deque>
+#include "common/bit_set.h"
+#include "common/common_types.h"
 
 namespace Common {
 
+/// Links of an element of a ThreadQueueList, embedded in the element itself.
+template <class T>
+struct ThreadQueueListNode {
+    T prev{};
+    T next{};
+    unsigned int priority = 0;
+    bool queued = false;
+};
+
+/**
+ * Priority queue of threads, one FIFO per priority level. Every operation is O(1): the FIFOs are
+ * intrusive lists threaded through the elements, and a bitmap of the non-empty levels finds the
+ * best one with a bit scan.
+ * T is a pointer to a type with a public `ThreadQueueListNode<T> queue_node` member, so an
+ * element can only be queued in a single list at a time.
+ */
 template <class T, unsigned int N>
 struct ThreadQueueList {
-    // TODO(yuriks): If performance proves to be a problem, the std::deques can be replaced with
-    //               (dynamically resizable) circular buffers to remove their overhead when
-    //               inserting and popping.
-
     typedef unsigned int Priority;
 
     // Number of priority levels. (Valid levels are [0..NUM_QUEUES).)
     static const Priority NUM_QUEUES = N;
 
-    ThreadQueueList() {
-        first = nullptr;
-    }
-
     // Only for debugging, returns priority level.
-    Priority contains(const T& uid) {
-        for (Priority i = 0; i < NUM_QUEUES; ++i) {
-            Queue& cur = queues[i];
-            if (std::find(cur.data.cbegin(), cur.data.cend(), uid) != cur.data.cend()) {
-                return i;
-            }
-        }
-
-        return -1;
+    Priority contains(const T& thread) const {
+        return thread->queue_node.queued ? thread->queue_node.priority : -1;
     }
 
-    T get_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                return cur->data.front();
-            }
-            cur = cur->next_nonempty;
-        }
-
-        return T();
+    T get_first() const {
+        const Priority priority = first_nonempty(NUM_QUEUES);
+        return priority == NUM_QUEUES ? T() : queues[priority].head;
     }
 
     T pop_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
-
-        return T();
+        return pop_front(first_nonempty(NUM_QUEUES));
     }
 
     T pop_first_better(Priority priority) {
-        Queue* cur = first;
-        Queue* stop = &queues[priority];
-        while (cur < stop) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
-
-        return T();
+        return pop_front(first_nonempty(priority));
     }
 
-    void push_front(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_front(thread_id);
+    void push_front(Priority priority, const T& thread) {
+        auto& node = thread->queue_node;
+        if (node.queued) {
+            return;
+        }
+        Queue& cur = queues[priority];
+        node.prev = T();
+        node.next = cur.head;
+        if (cur.head) {
+            cur.head->queue_node.prev = thread;
+        } else {
+            cur.tail = thread;
+            mark_nonempty(priority);
+        }
+        cur.head = thread;
+        node.priority = priority;
+        node.queued = true;
     }
 
-    void push_back(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_back(thread_id);
+    void push_back(Priority priority, const T& thread) {
+        auto& node = thread->queue_node;
+        if (node.queued) {
+            return;
+        }
+        Queue& cur = queues[priority];
+        node.prev = cur.tail;
+        node.next = T();
+        if (cur.tail) {
+            cur.tail->queue_node.next = thread;
+        } else {
+            cur.head = thread;
+            mark_nonempty(priority);
+        }
+        cur.tail = thread;
+        node.priority = priority;
+        node.queued = true;
     }
 
-    void move(const T& thread_id, Priority old_priority, Priority new_priority) {
-        remove(old_priority, thread_id);
-        prepare(new_priority);
-        push_back(new_priority, thread_id);
+    void move(const T& thread, Priority old_priority, Priority new_priority) {
+        remove(old_priority, thread);
+        push_back(new_priority, thread);
     }
 
-    void remove(Priority priority, const T& thread_id) {
-        Queue* const cur = &queues[priority];
-        const auto iter = std::remove(cur->data.begin(), cur->data.end(), thread_id);
-        cur->data.erase(iter, cur->data.end());
+    /// Removes the thread from the queue, if it is queued. The thread knows its own level, so the
+    /// priority is only kept for compatibility with the callers.
+    void remove(Priority /*priority*/, const T& thread) {
+        auto& node = thread->queue_node;
+        if (!node.queued) {
+            return;
+        }
+        Queue& cur = queues[node.priority];
+        if (node.prev) {
+            node.prev->queue_node.next = node.next;
+        } else {
+            cur.head = node.next;
+        }
+        if (node.next) {
+            node.next->queue_node.prev = node.prev;
+        } else {
+            cur.tail = node.prev;
+        }
+        if (!cur.head) {
+            mark_empty(node.priority);
+        }
+        node.prev = T();
+        node.next = T();
+        node.queued = false;
     }
 
     void rotate(Priority priority) {
-        Queue* cur = &queues[priority];
-
-        if (cur->data.size() > 1) {
-            cur->data.push_back(std::move(cur->data.front()));
-            cur->data.pop_front();
+        Queue& cur = queues[priority];
+        if (cur.head != cur.tail) {
+            T front = cur.head;
+            remove(priority, front);
+            push_back(priority, front);
         }
     }
 
     void clear() {
-        queues.fill(Queue());
-        first = nullptr;
+        for (Priority priority = 0; priority < NUM_QUEUES; ++priority) {
+            while (queues[priority].head) {
+                remove(priority, queues[priority].head);
+            }
+        }
     }
 
     bool empty(Priority priority) const {
-        const Queue* cur = &queues[priority];
-        return cur->data.empty();
-    }
-
-    void prepare(Priority priority) {
-        Queue* cur = &queues[priority];
-        if (cur->next_nonempty == UnlinkedTag())
-            link(priority);
+        return !queues[priority].head;
     }
 
 private:
     struct Queue {
-        // Points to the next active priority, skipping over ones that have never been used.
-        Queue* next_nonempty = UnlinkedTag();
-        // Double-ended queue of threads in this priority level
-        std::deque<T> data;
+        T head{};
+        T tail{};
     };
 
-    /// Special tag used to mark priority levels that have never been used.
-    static Queue* UnlinkedTag() {
-        return reinterpret_cast<Queue*>(1);
+    static constexpr std::size_t BitmapWords = (N + 63) / 64;
+
+    void mark_nonempty(Priority priority) {
+        nonempty[priority / 64] |= u64{1} << (priority % 64);
     }
 
-    void link(Priority priority) {
-        Queue* cur = &queues[priority];
+    void mark_empty(Priority priority) {
+        nonempty[priority / 64] &= ~(u64{1} << (priority % 64));
+    }
 
-        for (int i = priority - 1; i >= 0; --i) {
-            if (queues[i].next_nonempty != UnlinkedTag()) {
-                cur->next_nonempty = queues[i].next_nonempty;
-                queues[i].next_nonempty = cur;
-                return;
+    /// Returns the best non-empty level below limit, or NUM_QUEUES if there is none.
+    Priority first_nonempty(Priority limit) const {
+        for (std::size_t word = 0; word < BitmapWords && word * 64 < limit; ++word) {
+            if (nonempty[word] != 0) {
+                const Priority priority = static_cast<Priority>(
+                    word * 64 + LeastSignificantSetBit(static_cast<u64>(nonempty[word])));
+                return priority < limit ? priority : NUM_QUEUES;
             }
         }
+        return NUM_QUEUES;
+    }
 
-        cur->next_nonempty = first;
-        first = cur;
+    T pop_front(Priority priority) {
+        if (priority == NUM_QUEUES) {
+            return T();
+        }
+        T thread = queues[priority].head;
+        remove(priority, thread);
+        return thread;
     }
 
-    // The first queue that's ever been used.
-    Queue* first;
-    // The priority level queues of thread ids.
-    std::array<Queue, NUM_QUEUES> queues;
+    // The priority level queues of threads.
+    std::array<Queue, NUM_QUEUES> queues{};
+    // Bit i is set when level i has a thread queued.
+    std::array<u64, BitmapWords> nonempty{};
 };
 
 } // namespace Common
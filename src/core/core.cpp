@@ -24,6 +24,7 @@
 #include "core/custom_tex_cache.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/client_port.h"
+#include "core/hle/kernel/idle_loop_detector.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
@@ -217,6 +218,8 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
     }
     if (Settings::values.preload_textures)
         custom_tex_cache->PreloadTextures();
+    if (Settings::values.dump_textures)
+        custom_tex_cache->StartDumping();
     status = ResultStatus::Success;
     m_emu_window = &emu_window;
     m_filepath = filepath;
@@ -427,6 +430,16 @@ void System::Shutdown() {
     telemetry_session->AddField(Telemetry::FieldType::Performance, "Mean_Frametime_MS",
                                 perf_stats->GetMeanFrametime());
 
+    if (kernel) {
+        const auto& idle_stats = kernel->GetIdleLoopDetector().GetStats();
+        if (idle_stats.skipped_loops != 0) {
+            const auto process = kernel->GetCurrentProcess();
+            LOG_INFO(Core, "Title {:016X} skipped {} idle loops, {} CPU cycles",
+                     process ? process->codeset->program_id : 0, idle_stats.skipped_loops,
+                     idle_stats.skipped_ticks);
+        }
+    }
+
     // Shutdown emulation session
     GDBStub::Shutdown();
     VideoCore::Shutdown();
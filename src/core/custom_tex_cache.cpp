@@ -2,30 +2,118 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <mutex>
+#include <thread>
 #include <fmt/format.h>
 #include "common/file_util.h"
+#include "common/swap.h"
 #include "common/texture.h"
 #include "core.h"
 #include "core/custom_tex_cache.h"
+#include "core/custom_tex_dumper.h"
+#include "core/custom_tex_pack.h"
+#include "core/settings.h"
 
 namespace Core {
 CustomTexCache::CustomTexCache() = default;
 
 CustomTexCache::~CustomTexCache() = default;
 
+bool CustomTexCache::ParseTextureFileName(const std::string& file_name, u64& hash) {
+    if (file_name.substr(0, 5) != "tex1_")
+        return false;
+
+    u32 width;
+    u32 height;
+    u32 format; // unused
+    // TODO: more modern way of doing this
+    return std::sscanf(file_name.c_str(), "tex1_%ux%u_%llX_%u.png", &width, &height, &hash,
+                       &format) == 4;
+}
+
 bool CustomTexCache::IsTextureDumped(u64 hash) const {
+    std::lock_guard lock{dumped_textures_mutex};
     return dumped_textures.count(hash);
 }
 
 void CustomTexCache::SetTextureDumped(const u64 hash) {
+    std::lock_guard lock{dumped_textures_mutex};
     dumped_textures.insert(hash);
 }
 
+std::string CustomTexCache::GetDumpPath() {
+    return fmt::format(
+        "{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::DumpDir),
+        Core::System::GetInstance().Kernel().GetCurrentProcess()->codeset->program_id);
+}
+
+void CustomTexCache::StartDumping() {
+    if (texture_dumper)
+        return;
+
+    if (!FileUtil::CreateFullPath(GetDumpPath())) {
+        LOG_ERROR(Render, "Unable to create {}", GetDumpPath());
+    }
+
+    const std::string dumped_list_path = GetDumpPath() + "dumped_textures.bin";
+
+    // Textures dumped in earlier sessions are skipped even if their PNGs have been moved away
+    FileUtil::IOFile previous(dumped_list_path, "rb");
+    if (previous.IsOpen()) {
+        std::vector<u64_le> hashes(previous.GetSize() / sizeof(u64_le));
+        if (previous.ReadArray(hashes.data(), hashes.size()) == hashes.size()) {
+            std::lock_guard lock{dumped_textures_mutex};
+            dumped_textures.insert(hashes.begin(), hashes.end());
+        }
+        LOG_INFO(Render, "Skipping {} textures dumped in previous sessions", hashes.size());
+    }
+    previous.Close();
+    if (!dumped_list.Open(dumped_list_path, "ab")) {
+        LOG_ERROR(Render, "Unable to open {}, dumped textures won't be remembered",
+                  dumped_list_path);
+    }
+
+    constexpr std::size_t max_queued_textures = 32;
+    texture_dumper = std::make_unique<CustomTexDumper>(
+        Core::System::GetInstance().GetImageInterface(), max_queued_textures,
+        Settings::values.dump_textures_block_when_full, [this](u64 hash) {
+            std::lock_guard lock{dumped_list_mutex};
+            if (dumped_list.IsOpen()) {
+                const u64_le value = hash;
+                dumped_list.WriteObject(value);
+                dumped_list.Flush();
+            }
+        },
+        [this](u64 hash) {
+            // Let the texture be dumped again the next time it's uploaded
+            std::lock_guard lock{dumped_textures_mutex};
+            dumped_textures.erase(hash);
+        });
+}
+
+void CustomTexCache::DumpTexture(u64 hash, std::string path, std::vector<u8> tex, u32 width,
+                                 u32 height) {
+    // Dumping can be turned on while a game is running
+    StartDumping();
+
+    // A dropped texture stays undumped so that it is picked up again the next time it's uploaded
+    if (texture_dumper->Enqueue(hash, std::move(path), std::move(tex), width, height)) {
+        SetTextureDumped(hash);
+    }
+}
+
 bool CustomTexCache::IsTextureCached(u64 hash) const {
     return custom_textures.count(hash);
 }
 
-const CustomTexInfo& CustomTexCache::LookupTexture(u64 hash) const {
+const CustomTexInfo& CustomTexCache::LookupTexture(u64 hash) {
+    const auto lru_it = lru_positions.find(hash);
+    if (lru_it != lru_positions.end()) {
+        lru_textures.splice(lru_textures.begin(), lru_textures, lru_it->second);
+    }
     return custom_textures.at(hash);
 }
 
@@ -33,6 +121,70 @@ void CustomTexCache::CacheTexture(u64 hash, const std::vector<u8>& tex, u32 widt
     custom_textures[hash] = {width, height, tex};
 }
 
+const CustomTexInfo* CustomTexCache::LoadTexture(u64 hash) {
+    if (IsTextureCached(hash)) {
+        return &LookupTexture(hash);
+    }
+
+    CustomTexInfo tex_info;
+    if (!DecodeTexture(hash, tex_info)) {
+        return nullptr;
+    }
+
+    lru_size += tex_info.tex.size();
+    lru_textures.push_front(hash);
+    lru_positions[hash] = lru_textures.begin();
+    const auto& cached = custom_textures[hash] = std::move(tex_info);
+    EvictTextures();
+    return &cached;
+}
+
+bool CustomTexCache::DecodeTexture(u64 hash, CustomTexInfo& tex_info) {
+    // Loose files take priority so that single textures of a pack can be replaced
+    const auto path_it = custom_texture_paths.find(hash);
+    if (path_it == custom_texture_paths.end()) {
+        return texture_pack != nullptr && texture_pack->Read(hash, tex_info);
+    }
+
+    const auto& image_interface = Core::System::GetInstance().GetImageInterface();
+    const auto& path_info = path_it->second;
+    if (!image_interface->DecodePNG(tex_info.tex, tex_info.width, tex_info.height,
+                                    path_info.path)) {
+        LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
+        return false;
+    }
+
+    // Make sure the texture size is a power of 2
+    std::bitset<32> width_bits(tex_info.width);
+    std::bitset<32> height_bits(tex_info.height);
+    if (width_bits.count() != 1 || height_bits.count() != 1) {
+        LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
+        return false;
+    }
+
+    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
+    Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
+    return true;
+}
+
+void CustomTexCache::EvictTextures() {
+    const std::size_t budget =
+        static_cast<std::size_t>(Settings::values.custom_textures_budget) * 1024 * 1024;
+    if (budget == 0)
+        return;
+
+    // The most recently loaded texture is always kept, it is about to be uploaded
+    while (lru_size > budget && lru_textures.size() > 1) {
+        const u64 hash = lru_textures.back();
+        lru_textures.pop_back();
+        lru_positions.erase(hash);
+
+        const auto it = custom_textures.find(hash);
+        lru_size -= it->second.tex.size();
+        custom_textures.erase(it);
+    }
+}
+
 void CustomTexCache::AddTexturePath(u64 hash, const std::string& path) {
     if (custom_texture_paths.count(hash))
         LOG_ERROR(Core, "Textures {} and {} conflict!", custom_texture_paths[hash].path, path);
@@ -43,6 +195,7 @@ void CustomTexCache::AddTexturePath(u64 hash, const std::string& path) {
 void CustomTexCache::FindCustomTextures() {
     // Custom textures are currently stored as
     // [TitleID]/tex1_[width]x[height]_[64-bit hash]_[format].png
+    // or bundled in [TitleID]/textures.pack, see CustomTexPack
 
     const std::string load_path =
         fmt::format("{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::LoadDir),
@@ -58,47 +211,70 @@ void CustomTexCache::FindCustomTextures() {
         for (const auto& file : textures) {
             if (file.isDirectory)
                 continue;
-            if (file.virtualName.substr(0, 5) != "tex1_")
-                continue;
 
-            u32 width;
-            u32 height;
             u64 hash;
-            u32 format; // unused
-            // TODO: more modern way of doing this
-            if (std::sscanf(file.virtualName.c_str(), "tex1_%ux%u_%llX_%u.png", &width, &height,
-                            &hash, &format) == 4) {
+            if (ParseTextureFileName(file.virtualName, hash)) {
                 AddTexturePath(hash, file.physicalName);
             }
         }
     }
+
+    const std::string pack_path = load_path + "textures.pack";
+    if (FileUtil::Exists(pack_path)) {
+        auto pack = std::make_unique<CustomTexPack>();
+        if (pack->Open(pack_path)) {
+            texture_pack = std::move(pack);
+        }
+    }
 }
 
 void CustomTexCache::PreloadTextures() {
+    std::vector<u64> hashes;
+    hashes.reserve(custom_texture_paths.size());
     for (const auto& path : custom_texture_paths) {
-        const auto& image_interface = Core::System::GetInstance().GetImageInterface();
-        const auto& path_info = path.second;
-        Core::CustomTexInfo tex_info;
-        if (image_interface->DecodePNG(tex_info.tex, tex_info.width, tex_info.height,
-                                       path_info.path)) {
-            // Make sure the texture size is a power of 2
-            std::bitset<32> width_bits(tex_info.width);
-            std::bitset<32> height_bits(tex_info.height);
-            if (width_bits.count() == 1 && height_bits.count() == 1) {
-                LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-                Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
-                CacheTexture(path_info.hash, tex_info.tex, tex_info.width, tex_info.height);
-            } else {
-                LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
+        hashes.push_back(path.first);
+    }
+    if (texture_pack != nullptr) {
+        for (const auto& entry : texture_pack->GetEntries()) {
+            if (!custom_texture_paths.count(entry.hash)) {
+                hashes.push_back(entry.hash);
             }
-        } else {
-            LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
         }
     }
+
+    // Decoding dominates, so the workers only share an index and the results are cached at the end
+    std::vector<CustomTexInfo> decoded(hashes.size());
+    std::vector<u8> succeeded(hashes.size());
+    std::atomic<std::size_t> next_index{0};
+    const auto DecodeWorker = [&] {
+        for (std::size_t i = next_index++; i < hashes.size(); i = next_index++) {
+            succeeded[i] = DecodeTexture(hashes[i], decoded[i]);
+        }
+    };
+
+    const std::size_t num_workers =
+        std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), hashes.size());
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < num_workers; ++i) {
+        workers.emplace_back(DecodeWorker);
+    }
+    DecodeWorker();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        if (succeeded[i]) {
+            custom_textures[hashes[i]] = std::move(decoded[i]);
+        }
+    }
+    LOG_INFO(Render_OpenGL, "Preloaded {} custom textures with {} threads",
+             custom_textures.size(), num_workers);
 }
 
 bool CustomTexCache::CustomTextureExists(u64 hash) const {
-    return custom_texture_paths.count(hash);
+    return custom_texture_paths.count(hash) ||
+           (texture_pack != nullptr && texture_pack->Contains(hash));
 }
 
 const CustomTexPathInfo& CustomTexCache::LookupTexturePathInfo(u64 hash) const {
@@ -106,6 +282,7 @@ const CustomTexPathInfo& CustomTexCache::LookupTexturePathInfo(u64 hash) const {
 }
 
 bool CustomTexCache::IsTexturePathMapEmpty() const {
-    return custom_texture_paths.size() == 0;
+    return custom_texture_paths.size() == 0 &&
+           (texture_pack == nullptr || texture_pack->GetEntries().empty());
 }
 } // namespace Core
@@ -4,13 +4,20 @@
 
 #pragma once
 
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include "common/common_types.h"
+#include "common/file_util.h"
 
 namespace Core {
+class CustomTexDumper;
+class CustomTexPack;
+
 struct CustomTexInfo {
     u32 width;
     u32 height;
@@ -29,13 +36,28 @@ public:
     explicit CustomTexCache();
     ~CustomTexCache();
 
+    /// Extracts the texture hash from a dumped texture file name, tex1_[w]x[h]_[hash]_[format].png
+    static bool ParseTextureFileName(const std::string& file_name, u64& hash);
+
     bool IsTextureDumped(u64 hash) const;
     void SetTextureDumped(u64 hash);
 
+    /// Returns the directory textures of the running title are dumped to, with a trailing slash
+    static std::string GetDumpPath();
+
+    /// Loads the textures dumped in earlier sessions and starts the dump workers
+    void StartDumping();
+
+    /// Hands a texture read back as RGBA8 to the dump workers, marking it dumped once queued
+    void DumpTexture(u64 hash, std::string path, std::vector<u8> tex, u32 width, u32 height);
+
     bool IsTextureCached(u64 hash) const;
-    const CustomTexInfo& LookupTexture(u64 hash) const;
+    const CustomTexInfo& LookupTexture(u64 hash);
     void CacheTexture(u64 hash, const std::vector<u8>& tex, u32 width, u32 height);
 
+    /// Returns the texture with the given hash, decoding it from disk if it isn't cached yet
+    const CustomTexInfo* LoadTexture(u64 hash);
+
     void AddTexturePath(u64 hash, const std::string& path);
     void FindCustomTextures();
     void PreloadTextures();
@@ -44,8 +66,24 @@ public:
     bool IsTexturePathMapEmpty() const;
 
 private:
+    bool DecodeTexture(u64 hash, CustomTexInfo& tex_info);
+    void EvictTextures();
+
+    /// Textures dumped or queued to be, the dump workers remove the ones they fail to write
     std::unordered_set<u64> dumped_textures;
+    mutable std::mutex dumped_textures_mutex;
     std::unordered_map<u64, CustomTexInfo> custom_textures;
     std::unordered_map<u64, CustomTexPathInfo> custom_texture_paths;
+    std::unique_ptr<CustomTexPack> texture_pack;
+
+    /// Hashes written by previous sessions, appended to as the workers finish textures
+    FileUtil::IOFile dumped_list;
+    std::mutex dumped_list_mutex;
+    std::unique_ptr<CustomTexDumper> texture_dumper;
+
+    /// Lazily loaded textures, most recently used first. Preloaded textures are never evicted.
+    std::list<u64> lru_textures;
+    std::unordered_map<u64, std::list<u64>::iterator> lru_positions;
+    std::size_t lru_size = 0;
 };
 } // namespace Core
@@ -0,0 +1,97 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/logging/log.h"
+#include "common/texture.h"
+#include "core/custom_tex_dumper.h"
+#include "core/frontend/image_interface.h"
+
+namespace Core {
+
+CustomTexDumper::CustomTexDumper(std::shared_ptr<Frontend::ImageInterface> image_interface,
+                                 std::size_t max_queue_size, bool block_when_full,
+                                 DumpedCallback on_dumped, FailedCallback on_failed)
+    : image_interface(std::move(image_interface)), max_queue_size(max_queue_size),
+      block_when_full(block_when_full), on_dumped(std::move(on_dumped)),
+      on_failed(std::move(on_failed)) {
+    // Leave a core for the emulation itself, PNG encoding easily saturates everything else
+    const std::size_t num_workers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&CustomTexDumper::WorkerLoop, this);
+    }
+}
+
+CustomTexDumper::~CustomTexDumper() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    job_available.notify_all();
+    space_available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    LOG_INFO(Render,
+             "Dumped {} textures, dropped {} because the dump queue was full, failed to write {}. "
+             "Up to {} textures were waiting to be encoded.",
+             dumped, dropped, failed, max_queue_depth);
+}
+
+bool CustomTexDumper::Enqueue(u64 hash, std::string path, std::vector<u8> tex, u32 width,
+                              u32 height) {
+    {
+        std::unique_lock lock{mutex};
+        if (queue.size() >= max_queue_size) {
+            if (!block_when_full) {
+                ++dropped;
+                LOG_DEBUG(Render, "Texture dump queue full ({} queued), dropped {:016X}",
+                          queue.size(), hash);
+                return false;
+            }
+            space_available.wait(lock, [this] { return queue.size() < max_queue_size || stop; });
+        }
+        queue.push_back({hash, std::move(path), std::move(tex), width, height});
+        max_queue_depth = std::max(max_queue_depth, queue.size());
+    }
+    job_available.notify_one();
+    return true;
+}
+
+void CustomTexDumper::WorkerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock{mutex};
+            // Keep going until the queue is drained so nothing queued is lost on shutdown
+            job_available.wait(lock, [this] { return !queue.empty() || stop; });
+            if (queue.empty()) {
+                return;
+            }
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        space_available.notify_one();
+
+        LOG_INFO(Render, "Dumping texture to {}", job.path);
+        Common::FlipRGBA8Texture(job.tex, job.width, job.height);
+        if (!image_interface->EncodePNG(job.path, job.tex, job.width, job.height)) {
+            LOG_ERROR(Render, "Failed to save decoded texture {}", job.path);
+            {
+                std::lock_guard lock{mutex};
+                ++failed;
+            }
+            on_failed(job.hash);
+            continue;
+        }
+
+        {
+            std::lock_guard lock{mutex};
+            ++dumped;
+        }
+        on_dumped(job.hash);
+    }
+}
+
+} // namespace Core
@@ -0,0 +1,84 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Frontend {
+class ImageInterface;
+}
+
+namespace Core {
+
+/**
+ * Encodes dumped textures as PNG on worker threads so that the thread reading them back from the
+ * GPU only pays for a copy. The queue is bounded, a full queue either blocks the producer or drops
+ * the texture depending on the configuration. How many textures were dumped, dropped or failed,
+ * and how deep the queue got, is logged when the dumper is destroyed.
+ */
+class CustomTexDumper {
+public:
+    using DumpedCallback = std::function<void(u64 hash)>;
+    using FailedCallback = std::function<void(u64 hash)>;
+
+    /**
+     * @param image_interface frontend used to encode the PNGs, has to be thread safe
+     * @param max_queue_size maximum number of textures waiting to be encoded
+     * @param block_when_full whether Enqueue waits for space instead of dropping the texture
+     * @param on_dumped called from a worker thread once a texture has been written
+     * @param on_failed called from a worker thread when a texture could not be encoded or written
+     */
+    CustomTexDumper(std::shared_ptr<Frontend::ImageInterface> image_interface,
+                    std::size_t max_queue_size, bool block_when_full, DumpedCallback on_dumped,
+                    FailedCallback on_failed);
+
+    /// Waits for every queued texture to be written
+    ~CustomTexDumper();
+
+    /**
+     * Queues an RGBA8 texture as read back from OpenGL, flipping it is left to the workers.
+     * @returns false if the texture was dropped because the queue is full
+     */
+    bool Enqueue(u64 hash, std::string path, std::vector<u8> tex, u32 width, u32 height);
+
+private:
+    struct Job {
+        u64 hash;
+        std::string path;
+        std::vector<u8> tex;
+        u32 width;
+        u32 height;
+    };
+
+    void WorkerLoop();
+
+    std::shared_ptr<Frontend::ImageInterface> image_interface;
+    std::size_t max_queue_size;
+    bool block_when_full;
+    DumpedCallback on_dumped;
+    FailedCallback on_failed;
+
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::condition_variable space_available;
+    std::deque<Job> queue;
+    bool stop = false;
+    u64 dumped = 0;
+    u64 dropped = 0;
+    u64 failed = 0;
+    std::size_t max_queue_depth = 0;
+
+    std::vector<std::thread> workers;
+};
+
+} // namespace Core
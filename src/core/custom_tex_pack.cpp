@@ -0,0 +1,168 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/logging/log.h"
+#include "common/zstd_compression.h"
+#include "core/custom_tex_cache.h"
+#include "core/custom_tex_pack.h"
+
+namespace Core {
+
+bool CustomTexPack::Open(const std::string& path) {
+    FileUtil::IOFile pack_file(path, "rb");
+    if (!pack_file.IsOpen()) {
+        return false;
+    }
+
+    Header header{};
+    if (pack_file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != MAGIC) {
+        LOG_ERROR(Core, "{} is not a custom texture pack", path);
+        return false;
+    }
+    if (header.version != VERSION) {
+        LOG_ERROR(Core, "Custom texture pack {} has unsupported version {}", path,
+                  static_cast<u32>(header.version));
+        return false;
+    }
+
+    // Sizes come straight from the file, a corrupted pack must not make us allocate gigabytes
+    const u64 file_size = pack_file.GetSize();
+    if (header.index_offset > file_size ||
+        header.entry_count > (file_size - header.index_offset) / sizeof(Entry)) {
+        LOG_ERROR(Core, "Custom texture pack {} is truncated", path);
+        return false;
+    }
+
+    std::vector<Entry> pack_entries(header.entry_count);
+    if (!pack_file.Seek(header.index_offset, SEEK_SET) ||
+        pack_file.ReadArray(pack_entries.data(), pack_entries.size()) != pack_entries.size()) {
+        LOG_ERROR(Core, "Failed to read the index of custom texture pack {}", path);
+        return false;
+    }
+    if (!std::is_sorted(pack_entries.begin(), pack_entries.end(),
+                        [](const Entry& lhs, const Entry& rhs) { return lhs.hash < rhs.hash; })) {
+        LOG_ERROR(Core, "Custom texture pack {} has an unsorted index", path);
+        return false;
+    }
+    if (std::any_of(pack_entries.begin(), pack_entries.end(), [file_size](const Entry& entry) {
+            return entry.offset > file_size || entry.size > file_size - entry.offset;
+        })) {
+        LOG_ERROR(Core, "Custom texture pack {} has entries past the end of the file", path);
+        return false;
+    }
+
+    file = std::move(pack_file);
+    entries = std::move(pack_entries);
+    LOG_INFO(Core, "Opened custom texture pack {} with {} textures", path, entries.size());
+    return true;
+}
+
+const CustomTexPack::Entry* CustomTexPack::FindEntry(u64 hash) const {
+    const auto it = std::lower_bound(
+        entries.begin(), entries.end(), hash,
+        [](const Entry& entry, u64 value) { return entry.hash < value; });
+    if (it == entries.end() || it->hash != hash) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+bool CustomTexPack::Contains(u64 hash) const {
+    return FindEntry(hash) != nullptr;
+}
+
+bool CustomTexPack::Read(u64 hash, CustomTexInfo& tex_info) {
+    const Entry* entry = FindEntry(hash);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    std::vector<u8> compressed(entry->size);
+    {
+        std::lock_guard lock{file_mutex};
+        if (!file.Seek(entry->offset, SEEK_SET) ||
+            file.ReadBytes(compressed.data(), compressed.size()) != compressed.size()) {
+            LOG_ERROR(Core, "Failed to read custom texture {:016X} from pack", hash);
+            return false;
+        }
+    }
+
+    std::vector<u8> tex = Common::Compression::DecompressDataZSTD(compressed);
+    if (tex.size() != static_cast<std::size_t>(entry->width) * entry->height * 4) {
+        LOG_ERROR(Core, "Custom texture {:016X} in pack is corrupted", hash);
+        return false;
+    }
+
+    tex_info.width = entry->width;
+    tex_info.height = entry->height;
+    tex_info.tex = std::move(tex);
+    return true;
+}
+
+CustomTexPackWriter::CustomTexPackWriter(s32 compression_level)
+    : compression_level(compression_level) {}
+
+bool CustomTexPackWriter::Open(const std::string& path) {
+    entries.clear();
+    if (!file.Open(path, "wb")) {
+        return false;
+    }
+
+    // The header is rewritten by Finish once the index offset is known
+    const CustomTexPack::Header header{};
+    return file.WriteObject(header) == 1;
+}
+
+bool CustomTexPackWriter::AddTexture(u64 hash, u32 width, u32 height, const std::vector<u8>& tex) {
+    const std::vector<u8> compressed =
+        Common::Compression::CompressDataZSTD(tex.data(), tex.size(), compression_level);
+    if (compressed.empty()) {
+        return false;
+    }
+
+    std::lock_guard lock{file_mutex};
+    CustomTexPack::Entry entry{};
+    entry.hash = hash;
+    entry.width = width;
+    entry.height = height;
+    entry.offset = file.Tell();
+    entry.size = compressed.size();
+    if (file.WriteBytes(compressed.data(), compressed.size()) != compressed.size()) {
+        return false;
+    }
+
+    entries.push_back(entry);
+    return true;
+}
+
+bool CustomTexPackWriter::Finish() {
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& lhs, const auto& rhs) { return lhs.hash < rhs.hash; });
+    const auto duplicate = std::adjacent_find(
+        entries.begin(), entries.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.hash == rhs.hash; });
+    if (duplicate != entries.end()) {
+        LOG_ERROR(Core, "Texture {:016X} was added to the pack twice",
+                  static_cast<u64>(duplicate->hash));
+        return false;
+    }
+
+    CustomTexPack::Header header{};
+    header.magic = CustomTexPack::MAGIC;
+    header.version = CustomTexPack::VERSION;
+    header.entry_count = entries.size();
+    header.index_offset = file.Tell();
+
+    if (file.WriteArray(entries.data(), entries.size()) != entries.size()) {
+        return false;
+    }
+    if (!file.Seek(0, SEEK_SET) || file.WriteObject(header) != 1) {
+        return false;
+    }
+    return file.Close();
+}
+
+} // namespace Core
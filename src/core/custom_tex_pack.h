@@ -0,0 +1,96 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/swap.h"
+
+namespace Core {
+
+struct CustomTexInfo;
+
+/**
+ * A custom texture pack bundles the replacement textures of a title in a single file. The
+ * textures are stored flipped and decoded to RGBA8, compressed with zstd, so loading one only
+ * costs a read and a decompression instead of a PNG decode.
+ *
+ * Layout: a header, the compressed payloads, and an index of entries sorted by texture hash at
+ * the end of the file. The index is read once when the pack is opened, the payloads on demand.
+ */
+class CustomTexPack {
+public:
+    struct Header {
+        u32_le magic;
+        u32_le version;
+        u64_le entry_count;
+        u64_le index_offset;
+    };
+    static_assert(sizeof(Header) == 24, "Header has incorrect size");
+
+    struct Entry {
+        u64_le hash;
+        u32_le width;
+        u32_le height;
+        u64_le offset;
+        u64_le size;
+    };
+    static_assert(sizeof(Entry) == 32, "Entry has incorrect size");
+
+    static constexpr u32 MAGIC = 0x4B505443; // "CTPK"
+    static constexpr u32 VERSION = 1;
+
+    /// Opens the pack at the given path and reads its index
+    bool Open(const std::string& path);
+
+    bool IsOpen() const {
+        return file.IsOpen();
+    }
+
+    /// Returns the entries of the pack, sorted by texture hash
+    const std::vector<Entry>& GetEntries() const {
+        return entries;
+    }
+
+    bool Contains(u64 hash) const;
+
+    /// Reads and decompresses the texture with the given hash. Safe to call from several threads.
+    bool Read(u64 hash, CustomTexInfo& tex_info);
+
+private:
+    const Entry* FindEntry(u64 hash) const;
+
+    FileUtil::IOFile file;
+    std::mutex file_mutex;
+    std::vector<Entry> entries;
+};
+
+/// Writes a custom texture pack one texture at a time
+class CustomTexPackWriter {
+public:
+    explicit CustomTexPackWriter(s32 compression_level);
+
+    bool Open(const std::string& path);
+
+    /**
+     * Compresses and appends a texture. The data has to be RGBA8 and already flipped for upload.
+     * Safe to call from several threads, only the write itself is serialized.
+     */
+    bool AddTexture(u64 hash, u32 width, u32 height, const std::vector<u8>& tex);
+
+    /// Writes the index and the header, the pack isn't valid until this succeeded
+    bool Finish();
+
+private:
+    s32 compression_level;
+    FileUtil::IOFile file;
+    std::mutex file_mutex;
+    std::vector<CustomTexPack::Entry> entries;
+};
+
+} // namespace Core
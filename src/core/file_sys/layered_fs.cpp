@@ -4,10 +4,12 @@
 
 #include <algorithm>
 #include <cstring>
+#include <type_traits>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/string_util.h"
 #include "common/swap.h"
 #include "core/file_sys/layered_fs.h"
@@ -18,8 +20,10 @@ namespace FileSys {
 struct FileRelocationInfo {
     int type;                      // 0 - none, 1 - replaced / created, 2 - patched, 3 - removed
     u64 original_offset;           // Type 0. Offset is absolute
+    u64 original_size;             // Type 0 and 2
     std::string replace_file_path; // Type 1
-    std::vector<u8> patched_file;  // Type 2
+    std::string patch_file_path;   // Type 2
+    std::vector<u8> patched_file;  // Type 2, applied lazily when restored from the cache
     u64 size;                      // Relocated file size
 };
 struct LayeredFS::File {
@@ -27,6 +31,7 @@ struct LayeredFS::File {
     std::string path;
     FileRelocationInfo relocation{};
     Directory* parent;
+    bool created{}; // Created by a mod, not part of the base RomFS
 };
 
 struct DirectoryMetadata {
@@ -51,18 +56,94 @@ struct FileMetadata {
 };
 static_assert(sizeof(FileMetadata) == 0x20, "Size of FileMetadata is not correct");
 
+constexpr u32 CacheMagic = 0x4353464C; // "LFSC"
+constexpr u32 CacheVersion = 2;
+
+struct CacheHeader {
+    u32_le magic;
+    u32_le version;
+    u64_le base_hash;
+    u64_le manifest_hash;
+};
+static_assert(sizeof(CacheHeader) == 0x18, "Size of CacheHeader is not correct");
+
+class LayeredFS::CacheWriter {
+public:
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Written values must be trivially copyable");
+        WriteBytes(&value, sizeof(value));
+    }
+
+    void WriteBytes(const void* bytes, std::size_t size) {
+        const auto* begin = static_cast<const u8*>(bytes);
+        data.insert(data.end(), begin, begin + size);
+    }
+
+    void WriteString(const std::string& str) {
+        Write<u32_le>(static_cast<u32>(str.size()));
+        WriteBytes(str.data(), str.size());
+    }
+
+    std::vector<u8> data;
+};
+
+class LayeredFS::CacheReader {
+public:
+    explicit CacheReader(std::vector<u8> data) : data(std::move(data)) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Read values must be trivially copyable");
+        return ReadBytes(&value, sizeof(value));
+    }
+
+    bool ReadBytes(void* bytes, std::size_t size) {
+        if (data.size() - position < size) {
+            return false;
+        }
+        std::memcpy(bytes, data.data() + position, size);
+        position += size;
+        return true;
+    }
+
+    bool ReadString(std::string& str) {
+        u32_le size;
+        if (!Read(size) || data.size() - position < size) {
+            return false;
+        }
+        str.assign(reinterpret_cast<const char*>(data.data() + position), size);
+        position += size;
+        return true;
+    }
+
+private:
+    std::vector<u8> data;
+    std::size_t position = 0;
+};
+
 LayeredFS::LayeredFS(std::shared_ptr<RomFSReader> romfs_, std::string patch_path_,
-                     std::string patch_ext_path_, bool load_relocations)
+                     std::string patch_ext_path_, bool load_relocations, std::string cache_path_)
     : romfs(std::move(romfs_)), patch_path(std::move(patch_path_)),
-      patch_ext_path(std::move(patch_ext_path_)) {
+      patch_ext_path(std::move(patch_ext_path_)), cache_path(std::move(cache_path_)) {
 
     romfs->ReadFile(0, sizeof(header), reinterpret_cast<u8*>(&header));
 
     ASSERT_MSG(header.header_length == sizeof(header), "Header size is incorrect");
 
-    // TODO: is root always the first directory in table?
-    root.parent = &root;
-    LoadDirectory(root, 0);
+    const bool use_cache = load_relocations && !cache_path.empty();
+    if (use_cache) {
+        base_hash = HashBaseMetadata();
+        BuildManifest();
+        if (LoadCache()) {
+            LOG_INFO(Service_FS, "LayeredFS layout restored from {}", cache_path);
+            return;
+        }
+    }
+
+    if (!tree_loaded) {
+        LoadBaseTree();
+    }
 
     if (load_relocations) {
         LoadRelocations();
@@ -70,10 +151,21 @@ LayeredFS::LayeredFS(std::shared_ptr<RomFSReader> romfs_, std::string patch_path
     }
 
     RebuildMetadata();
+
+    if (use_cache) {
+        SaveCache();
+    }
 }
 
 LayeredFS::~LayeredFS() = default;
 
+void LayeredFS::LoadBaseTree() {
+    // TODO: is root always the first directory in table?
+    root.parent = &root;
+    LoadDirectory(root, 0);
+    tree_loaded = true;
+}
+
 void LayeredFS::LoadDirectory(Directory& current, u32 offset) {
     DirectoryMetadata metadata;
     romfs->ReadFile(header.directory_metadata_table.offset + offset, sizeof(metadata),
@@ -115,6 +207,7 @@ void LayeredFS::LoadFile(Directory& parent, u32 offset) {
                           metadata.name_length);
     file->path = parent.path + file->name;
     file->relocation.original_offset = header.file_data_offset + metadata.file_data_offset;
+    file->relocation.original_size = metadata.file_data_length;
     file->relocation.size = metadata.file_data_length;
     file->parent = &parent;
 
@@ -155,6 +248,7 @@ void LayeredFS::LoadRelocations() {
                 directory->name = virtual_name;
                 directory->path = path;
                 directory->parent = parent;
+                directory->created = true;
                 directory_path_map.emplace(path, directory.get());
                 parent->directories.emplace_back(std::move(directory));
                 LOG_INFO(Service_FS, "LayeredFS created directory {}", path);
@@ -169,6 +263,7 @@ void LayeredFS::LoadRelocations() {
             file->name = virtual_name;
             file->path = path;
             file->parent = parent;
+            file->created = true;
             file_path_map.emplace(path, file.get());
             parent->files.emplace_back(std::move(file));
             LOG_INFO(Service_FS, "LayeredFS created file {}", path);
@@ -228,35 +323,26 @@ void LayeredFS::LoadExtRelocations() {
                 continue;
             }
 
-            FileUtil::IOFile patch_file(entry.physicalName, "rb");
-            if (!patch_file) {
-                LOG_ERROR(Service_FS, "LayeredFS Could not open file {}", entry.physicalName);
-                continue;
-            }
-
-            const auto size = patch_file.GetSize();
-            std::vector<u8> patch(size);
-            if (patch_file.ReadBytes(patch.data(), size) != size) {
-                LOG_ERROR(Service_FS, "LayeredFS Could not read file {}", entry.physicalName);
-                continue;
-            }
-
             auto& file = *file_path_map[file_path];
-            std::vector<u8> buffer(file.relocation.size); // Original size
-            romfs->ReadFile(file.relocation.original_offset, buffer.size(), buffer.data());
+            const auto cached = reusable_patches.find(file_path);
+            if (cached != reusable_patches.end() &&
+                cached->second.patch_path == entry.physicalName) {
+                // The patch is unchanged, only its size is needed now. It is applied on first read.
+                LOG_INFO(Service_FS, "LayeredFS patched file {} (cached)", file_path);
 
-            bool ret = false;
-            if (extension == ".ips") {
-                ret = Patch::ApplyIpsPatch(patch, buffer);
-            } else {
-                ret = Patch::ApplyBpsPatch(patch, buffer);
+                file.relocation.type = 2;
+                file.relocation.size = cached->second.size;
+                file.relocation.patch_file_path = entry.physicalName;
+                continue;
             }
 
-            if (ret) {
+            std::vector<u8> buffer;
+            if (ApplyPatch(file, entry.physicalName, buffer)) {
                 LOG_INFO(Service_FS, "LayeredFS patched file {}", file_path);
 
                 file.relocation.type = 2;
                 file.relocation.size = buffer.size();
+                file.relocation.patch_file_path = entry.physicalName;
                 file.relocation.patched_file = std::move(buffer);
             } else {
                 LOG_ERROR(Service_FS, "LayeredFS failed to patch file {}", file_path);
@@ -267,6 +353,30 @@ void LayeredFS::LoadExtRelocations() {
     }
 }
 
+bool LayeredFS::ApplyPatch(const File& file, const std::string& patch_file_path,
+                           std::vector<u8>& buffer) {
+    FileUtil::IOFile patch_file(patch_file_path, "rb");
+    if (!patch_file) {
+        LOG_ERROR(Service_FS, "LayeredFS Could not open file {}", patch_file_path);
+        return false;
+    }
+
+    const auto size = patch_file.GetSize();
+    std::vector<u8> patch(size);
+    if (patch_file.ReadBytes(patch.data(), size) != size) {
+        LOG_ERROR(Service_FS, "LayeredFS Could not read file {}", patch_file_path);
+        return false;
+    }
+
+    buffer.resize(file.relocation.original_size);
+    romfs->ReadFile(file.relocation.original_offset, buffer.size(), buffer.data());
+
+    if (patch_file_path.substr(patch_file_path.size() - 4) == ".ips") {
+        return Patch::ApplyIpsPatch(patch, buffer);
+    }
+    return Patch::ApplyBpsPatch(patch, buffer);
+}
+
 std::size_t GetNameSize(const std::string& name) {
     std::u16string u16name = Common::UTF8ToUTF16(name);
     return Common::AlignUp(u16name.size() * 2, 4);
@@ -481,6 +591,317 @@ void LayeredFS::RebuildMetadata() {
                 header.file_metadata_table.length);
 }
 
+u64 LayeredFS::HashBaseMetadata() {
+    std::vector<u8> buffer(header.file_data_offset);
+    romfs->ReadFile(0, buffer.size(), buffer.data());
+
+    const u64 size = romfs->GetSize();
+    const auto* size_bytes = reinterpret_cast<const u8*>(&size);
+    buffer.insert(buffer.end(), size_bytes, size_bytes + sizeof(size));
+    return Common::ComputeHash64(buffer.data(), buffer.size());
+}
+
+void LayeredFS::BuildManifest() {
+    const auto add_tree = [this](const std::string& base) {
+        if (!FileUtil::Exists(base)) {
+            return;
+        }
+        const FileUtil::DirectoryEntryCallable callback =
+            [this, &callback](u64* /*num_entries_out*/, const std::string& directory,
+                              const std::string& virtual_name) {
+                const auto path = directory + virtual_name;
+                if (FileUtil::IsDirectory(path)) {
+                    manifest.push_back({path + DIR_SEP, 0, 0});
+                    return FileUtil::ForeachDirectoryEntry(nullptr, path + DIR_SEP, callback);
+                }
+                manifest.push_back(
+                    {path, FileUtil::GetSize(path), FileUtil::GetModificationTime(path)});
+                return true;
+            };
+        FileUtil::ForeachDirectoryEntry(nullptr, base, callback);
+    };
+    add_tree(patch_path);
+    add_tree(patch_ext_path);
+
+    std::sort(manifest.begin(), manifest.end(),
+              [](const ManifestEntry& a, const ManifestEntry& b) { return a.path < b.path; });
+
+    CacheWriter writer;
+    writer.WriteString(patch_path);
+    writer.WriteString(patch_ext_path);
+    for (const auto& entry : manifest) {
+        writer.WriteString(entry.path);
+        writer.Write<u64_le>(entry.size);
+        writer.Write<s64_le>(entry.mtime);
+    }
+    manifest_hash = Common::ComputeHash64(writer.data.data(), writer.data.size());
+}
+
+void LayeredFS::WriteDirectory(CacheWriter& writer, const Directory& current) const {
+    // Only the base tree is written. Files and directories created by mods would otherwise come
+    // back as empty entries once the mod that created them is removed.
+    const auto is_base = [](const auto& entry) { return !entry->created; };
+
+    writer.WriteString(current.name);
+
+    writer.Write<u32_le>(static_cast<u32>(
+        std::count_if(current.files.begin(), current.files.end(), is_base)));
+    for (const auto& file : current.files) {
+        if (!is_base(file)) {
+            continue;
+        }
+        writer.WriteString(file->name);
+        writer.Write<u64_le>(file->relocation.original_offset);
+        writer.Write<u64_le>(file->relocation.original_size);
+    }
+
+    writer.Write<u32_le>(static_cast<u32>(
+        std::count_if(current.directories.begin(), current.directories.end(), is_base)));
+    for (const auto& directory : current.directories) {
+        if (is_base(directory)) {
+            WriteDirectory(writer, *directory);
+        }
+    }
+}
+
+bool LayeredFS::ReadDirectory(CacheReader& reader, Directory& current) {
+    if (!reader.ReadString(current.name)) {
+        return false;
+    }
+    current.path = current.parent->path + current.name + DIR_SEP;
+    directory_path_map.emplace(current.path, &current);
+
+    u32_le file_count;
+    if (!reader.Read(file_count)) {
+        return false;
+    }
+    for (u32 i = 0; i < file_count; ++i) {
+        auto file = std::make_unique<File>();
+        u64_le original_offset;
+        u64_le original_size;
+        if (!reader.ReadString(file->name) || !reader.Read(original_offset) ||
+            !reader.Read(original_size)) {
+            return false;
+        }
+        file->path = current.path + file->name;
+        file->relocation.original_offset = original_offset;
+        file->relocation.original_size = original_size;
+        file->relocation.size = original_size;
+        file->parent = &current;
+
+        file_path_map.emplace(file->path, file.get());
+        current.files.emplace_back(std::move(file));
+    }
+
+    u32_le directory_count;
+    if (!reader.Read(directory_count)) {
+        return false;
+    }
+    for (u32 i = 0; i < directory_count; ++i) {
+        auto directory = std::make_unique<Directory>();
+        directory->parent = &current;
+        auto& child = *directory;
+        current.directories.emplace_back(std::move(directory));
+        if (!ReadDirectory(reader, child)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Cache layout, all values little endian and strings prefixed with their u32 length:
+ *  - CacheHeader
+ *  - Base directory tree: name, files (name, original offset, original size), subdirectories
+ *  - Manifest: entry count, then path, size and mtime of each entry
+ *  - Layout: metadata size and bytes, data size, file count, then for each file with data its
+ *    data offset, path, relocation type, original offset and size, original size, and the
+ *    replacement or patch file path
+ */
+bool LayeredFS::LoadCache() {
+    FileUtil::IOFile file(cache_path, "rb");
+    if (!file) {
+        return false;
+    }
+    std::vector<u8> data(file.GetSize());
+    if (file.ReadBytes(data.data(), data.size()) != data.size()) {
+        LOG_WARNING(Service_FS, "LayeredFS could not read cache {}", cache_path);
+        return false;
+    }
+    file.Close();
+
+    CacheReader reader(std::move(data));
+    CacheHeader cache_header;
+    if (!reader.Read(cache_header) || cache_header.magic != CacheMagic ||
+        cache_header.version != CacheVersion || cache_header.base_hash != base_hash) {
+        return false;
+    }
+
+    const auto invalid = [this] {
+        LOG_WARNING(Service_FS, "LayeredFS cache {} is corrupted", cache_path);
+        root.files.clear();
+        root.directories.clear();
+        directory_path_map.clear();
+        file_path_map.clear();
+        reusable_patches.clear();
+        cached_files.clear();
+        data_offset_map.clear();
+        tree_loaded = false;
+        return false;
+    };
+
+    root.parent = &root;
+    if (!ReadDirectory(reader, root)) {
+        return invalid();
+    }
+    tree_loaded = true;
+
+    u32_le manifest_count;
+    if (!reader.Read(manifest_count)) {
+        return invalid();
+    }
+    std::unordered_map<std::string, std::pair<u64, s64>> cached_manifest;
+    for (u32 i = 0; i < manifest_count; ++i) {
+        std::string path;
+        u64_le size;
+        s64_le mtime;
+        if (!reader.ReadString(path) || !reader.Read(size) || !reader.Read(mtime)) {
+            return invalid();
+        }
+        cached_manifest.emplace(std::move(path),
+                                std::make_pair(static_cast<u64>(size), static_cast<s64>(mtime)));
+    }
+    const bool manifest_matches = cache_header.manifest_hash == manifest_hash;
+
+    std::vector<u8> cached_metadata;
+    u64_le data_size;
+    u32_le metadata_size;
+    u32_le file_count;
+    if (!reader.Read(metadata_size)) {
+        return invalid();
+    }
+    cached_metadata.resize(metadata_size);
+    if (!reader.ReadBytes(cached_metadata.data(), cached_metadata.size()) ||
+        !reader.Read(data_size) || !reader.Read(file_count)) {
+        return invalid();
+    }
+
+    for (u32 i = 0; i < file_count; ++i) {
+        auto file = std::make_unique<File>();
+        u64_le data_offset;
+        u32_le type;
+        u64_le original_offset;
+        u64_le original_size;
+        u64_le size;
+        std::string relocation_path;
+        if (!reader.Read(data_offset) || !reader.ReadString(file->path) || !reader.Read(type) ||
+            !reader.Read(original_offset) || !reader.Read(original_size) || !reader.Read(size) ||
+            !reader.ReadString(relocation_path) || type > 2) {
+            return invalid();
+        }
+        file->relocation.type = static_cast<int>(type);
+        file->relocation.original_offset = original_offset;
+        file->relocation.original_size = original_size;
+        file->relocation.size = size;
+        if (type == 1) {
+            file->relocation.replace_file_path = std::move(relocation_path);
+        } else if (type == 2) {
+            // A patch can be reused when neither the base RomFS nor the patch file changed
+            const auto patch = cached_manifest.find(relocation_path);
+            const auto current = std::lower_bound(
+                manifest.begin(), manifest.end(), relocation_path,
+                [](const ManifestEntry& entry, const std::string& path) {
+                    return entry.path < path;
+                });
+            if (patch != cached_manifest.end() && current != manifest.end() &&
+                current->path == relocation_path && current->size == patch->second.first &&
+                current->mtime == patch->second.second) {
+                reusable_patches.emplace(file->path, CachedPatch{relocation_path, size});
+            }
+            file->relocation.patch_file_path = std::move(relocation_path);
+        }
+        if (manifest_matches) {
+            data_offset_map.emplace(data_offset, file.get());
+            cached_files.emplace_back(std::move(file));
+        }
+    }
+
+    if (!manifest_matches) {
+        // Only the mods changed, the base tree and the unchanged patches are rebuilt upon
+        LOG_INFO(Service_FS, "LayeredFS mods changed, rebuilding layout");
+        return false;
+    }
+
+    // The whole layout is valid, the tree is only needed again to dump the RomFS
+    metadata = std::move(cached_metadata);
+    current_data_offset = data_size;
+    reusable_patches.clear();
+    root.files.clear();
+    root.directories.clear();
+    directory_path_map.clear();
+    file_path_map.clear();
+    tree_loaded = false;
+    return true;
+}
+
+void LayeredFS::SaveCache() const {
+    CacheWriter writer;
+
+    CacheHeader cache_header{};
+    cache_header.magic = CacheMagic;
+    cache_header.version = CacheVersion;
+    cache_header.base_hash = base_hash;
+    cache_header.manifest_hash = manifest_hash;
+    writer.Write(cache_header);
+
+    WriteDirectory(writer, root);
+
+    writer.Write<u32_le>(static_cast<u32>(manifest.size()));
+    for (const auto& entry : manifest) {
+        writer.WriteString(entry.path);
+        writer.Write<u64_le>(entry.size);
+        writer.Write<s64_le>(entry.mtime);
+    }
+
+    writer.Write<u32_le>(static_cast<u32>(metadata.size()));
+    writer.WriteBytes(metadata.data(), metadata.size());
+    writer.Write<u64_le>(current_data_offset);
+    writer.Write<u32_le>(static_cast<u32>(data_offset_map.size()));
+    for (const auto& [data_offset, file] : data_offset_map) {
+        const auto& relocation = file->relocation;
+        writer.Write<u64_le>(data_offset);
+        writer.WriteString(file->path);
+        writer.Write<u32_le>(static_cast<u32>(relocation.type));
+        writer.Write<u64_le>(relocation.original_offset);
+        writer.Write<u64_le>(relocation.original_size);
+        writer.Write<u64_le>(relocation.size);
+        writer.WriteString(relocation.type == 1 ? relocation.replace_file_path
+                                                : relocation.patch_file_path);
+    }
+
+    // Written next to the cache and renamed, so that an interrupted write can't leave a
+    // truncated cache behind
+    const auto temp_path = cache_path + ".tmp";
+    if (!FileUtil::CreateFullPath(cache_path)) {
+        LOG_WARNING(Service_FS, "LayeredFS could not create path for cache {}", cache_path);
+        return;
+    }
+    {
+        FileUtil::IOFile file(temp_path, "wb");
+        if (!file ||
+            file.WriteBytes(writer.data.data(), writer.data.size()) != writer.data.size()) {
+            LOG_WARNING(Service_FS, "LayeredFS could not write cache {}", cache_path);
+            return;
+        }
+    }
+    if (FileUtil::Exists(cache_path)) {
+        FileUtil::Delete(cache_path);
+    }
+    if (!FileUtil::Rename(temp_path, cache_path)) {
+        LOG_WARNING(Service_FS, "LayeredFS could not write cache {}", cache_path);
+    }
+}
+
 std::size_t LayeredFS::GetSize() const {
     return metadata.size() + current_data_offset;
 }
@@ -529,6 +950,20 @@ std::size_t LayeredFS::ReadFile(std::size_t offset, std::size_t length, u8* buff
                           current->second->path);
             }
         } else if (relocation.type == 2) { // patch
+            if (relocation.patched_file.size() != relocation.size) {
+                // Restored from the cache, apply the patch now that the file is needed
+                if (!ApplyPatch(*current->second, relocation.patch_file_path,
+                                relocation.patched_file) ||
+                    relocation.patched_file.size() != relocation.size) {
+                    LOG_ERROR(Service_FS, "LayeredFS failed to patch file {}, using the original",
+                              current->second->path);
+                    // The layout already has the size of the patched file, fit the original to it
+                    relocation.patched_file.resize(relocation.original_size);
+                    romfs->ReadFile(relocation.original_offset, relocation.original_size,
+                                    relocation.patched_file.data());
+                    relocation.patched_file.resize(relocation.size);
+                }
+            }
             std::memcpy(buffer + read_size, relocation.patched_file.data() + relative_offset,
                         to_read);
         } else {
@@ -598,6 +1033,9 @@ bool LayeredFS::DumpRomFS(const std::string& target_path) {
         path.erase(path.size() - 1, 1);
     }
 
+    if (!tree_loaded) {
+        LoadBaseTree();
+    }
     return ExtractDirectory(root, path);
 }
 
@@ -37,11 +37,17 @@ static_assert(sizeof(RomFSHeader) == 0x28, "Size of RomFSHeader is not correct")
  * patch_ext_path: Path for RomFS extensions. Files present in this path:
  *  - When with an extension of ".stub", remove the corresponding file in the RomFS.
  *  - When with an extension of ".ips" or ".bps", patch the file in the RomFS.
+ * cache_path: Where to keep the rebuilt layout between runs, empty to always rebuild it. The
+ * cache is keyed by a hash of the base RomFS metadata and a manifest of the mod files (paths,
+ * sizes and modification times). When both match, the layout is restored as is and the base
+ * RomFS isn't walked at all. When only the mods changed, the base directory tree and the sizes
+ * of untouched patches are reused and only the mod layer is rebuilt.
  */
 class LayeredFS : public RomFSReader {
 public:
     explicit LayeredFS(std::shared_ptr<RomFSReader> romfs, std::string patch_path,
-                       std::string patch_ext_path, bool load_relocations = true);
+                       std::string patch_ext_path, bool load_relocations = true,
+                       std::string cache_path = "");
     ~LayeredFS() override;
 
     std::size_t GetSize() const override;
@@ -51,16 +57,34 @@ public:
 
 private:
     struct File;
+    class CacheWriter;
+    class CacheReader;
     struct Directory {
         std::string name;
         std::string path; // with trailing '/'
         std::vector<std::unique_ptr<File>> files;
         std::vector<std::unique_ptr<Directory>> directories;
         Directory* parent;
+        bool created{}; // Created by a mod, not part of the base RomFS
+    };
+
+    struct ManifestEntry {
+        std::string path; // physical path, directories with trailing '/'
+        u64 size;
+        s64 mtime;
+    };
+
+    // Reusable result of a patch from a previous run: patch file and size of the patched file
+    struct CachedPatch {
+        std::string patch_path;
+        u64 size;
     };
 
     std::string ReadName(u32 offset, u32 name_length);
 
+    // Loads the directory tree of the base RomFS
+    void LoadBaseTree();
+
     // Loads the current directory, then its siblings, and then its children.
     void LoadDirectory(Directory& current, u32 offset);
 
@@ -73,6 +97,24 @@ private:
     // Load patch/remove relocations
     void LoadExtRelocations();
 
+    // Applies the patch at patch_file_path to the original contents of file
+    bool ApplyPatch(const File& file, const std::string& patch_file_path,
+                    std::vector<u8>& buffer);
+
+    // Hash of the base RomFS header, hash tables and metadata tables
+    u64 HashBaseMetadata();
+
+    // Lists every file and directory under the patch paths and hashes the list
+    void BuildManifest();
+
+    void WriteDirectory(CacheWriter& writer, const Directory& current) const;
+    bool ReadDirectory(CacheReader& reader, Directory& current);
+
+    // Returns true if the whole layout was restored. Otherwise the base directory tree and the
+    // reusable patches may still have been loaded.
+    bool LoadCache();
+    void SaveCache() const;
+
     // Calculate the offset of a single directory add it to the map and list of directories
     void PrepareBuildDirectory(Directory& current);
 
@@ -95,9 +137,17 @@ private:
     std::shared_ptr<RomFSReader> romfs;
     std::string patch_path;
     std::string patch_ext_path;
+    std::string cache_path;
+
+    u64 base_hash{};
+    u64 manifest_hash{};
+    std::vector<ManifestEntry> manifest; // sorted by path
+    std::unordered_map<std::string, CachedPatch> reusable_patches; // file path -> patch
+    std::vector<std::unique_ptr<File>> cached_files; // files of a layout restored from the cache
 
     RomFSHeader header;
     Directory root;
+    bool tree_loaded{}; // Whether root holds the directory tree, only needed to rebuild or dump
     std::unordered_map<std::string, File*> file_path_map;
     std::unordered_map<std::string, Directory*> directory_path_map;
     std::map<u64, File*> data_offset_map; // assigned data offset -> file
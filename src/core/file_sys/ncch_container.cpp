@@ -48,7 +48,7 @@ static u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
 
 /**
  * Decompress ExeFS file (compressed with LZSS)
- * @param compressed Compressed buffer
+ * @param compressed Compressed buffer, can be the start of the decompressed buffer
  * @param compressed_size Size of compressed buffer
  * @param decompressed Decompressed buffer
  * @param decompressed_size Size of decompressed buffer
@@ -65,8 +65,13 @@ static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decom
     u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
     u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
 
-    memset(decompressed, 0, decompressed_size);
-    memcpy(decompressed, compressed, compressed_size);
+    if (decompressed_size < compressed_size)
+        return false;
+
+    // The format is meant to be decompressed in place, so compressed and decompressed may be the
+    // same buffer
+    std::memmove(decompressed, compressed, compressed_size);
+    std::memset(decompressed + compressed_size, 0, decompressed_size - compressed_size);
 
     while (index > stop_index) {
         u8 control = compressed[--index];
@@ -384,6 +389,8 @@ Loader::ResultStatus NCCHContainer::Load() {
             }
 
             exefs_file = FileUtil::IOFile(filepath, "rb");
+            mapped_file = std::make_shared<FileUtil::MappedFile>(filepath);
+            mapped_exefs = mapped_file;
             has_exefs = true;
         }
 
@@ -419,6 +426,7 @@ Loader::ResultStatus NCCHContainer::LoadOverrides() {
             exefs_offset = 0;
             is_tainted = true;
             has_exefs = true;
+            mapped_exefs = std::make_shared<FileUtil::MappedFile>(exefs_override);
         } else {
             exefs_file = FileUtil::IOFile(filepath, "rb");
         }
@@ -451,6 +459,14 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             std::size_t logo_offset = ncch_header.logo_region_offset * kBlockSize;
             std::size_t logo_size = ncch_header.logo_region_size * kBlockSize;
 
+            // The logo is never encrypted
+            if (mapped_file) {
+                if (const u8* view = mapped_file->View(ncch_offset + logo_offset, logo_size)) {
+                    buffer.assign(view, view + logo_size);
+                    return Loader::ResultStatus::Success;
+                }
+            }
+
             buffer.resize(logo_size);
             file.Seek(ncch_offset + logo_offset, SEEK_SET);
 
@@ -480,7 +496,12 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
 
             s64 section_offset =
                 (section.offset + exefs_offset + sizeof(ExeFs_Header) + ncch_offset);
-            exefs_file.Seek(section_offset, SEEK_SET);
+
+            // Unencrypted sections are copied straight out of the mapped file
+            const u8* view = nullptr;
+            if (!is_encrypted && mapped_exefs) {
+                view = mapped_exefs->View(section_offset, section.size);
+            }
 
             std::array<u8, 16> key;
             if (strcmp(section.name, "icon") == 0 || strcmp(section.name, "banner") == 0) {
@@ -491,35 +512,60 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
 
             CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(key.data(), key.size(),
                                                               exefs_ctr.data());
-            dec.Seek(section.offset + sizeof(ExeFs_Header));
 
             if (strcmp(section.name, ".code") == 0 && is_compressed) {
-                // Section is compressed, read compressed .code section...
-                std::unique_ptr<u8[]> temp_buffer;
+                if (section.size < 8)
+                    return Loader::ResultStatus::ErrorInvalidFormat;
+
+                if (view) {
+                    u32 decompressed_size = LZSS_GetDecompressedSize(view, section.size);
+                    buffer.resize(decompressed_size);
+                    if (!LZSS_Decompress(view, section.size, buffer.data(), decompressed_size))
+                        return Loader::ResultStatus::ErrorInvalidFormat;
+                    return Loader::ResultStatus::Success;
+                }
+
+                // Read the footer first to size the buffer, the section is then read and
+                // decompressed in place like the 3DS does, without an intermediate copy
+                u32_le size_footer;
+                exefs_file.Seek(section_offset + section.size - sizeof(size_footer), SEEK_SET);
+                if (exefs_file.ReadBytes(&size_footer, sizeof(size_footer)) != sizeof(size_footer))
+                    return Loader::ResultStatus::Error;
+                if (is_encrypted) {
+                    dec.Seek(section.offset + sizeof(ExeFs_Header) + section.size -
+                             sizeof(size_footer));
+                    dec.ProcessData(reinterpret_cast<u8*>(&size_footer),
+                                    reinterpret_cast<u8*>(&size_footer), sizeof(size_footer));
+                }
+                const u32 decompressed_size = size_footer + section.size;
+
                 try {
-                    temp_buffer.reset(new u8[section.size]);
+                    buffer.resize(decompressed_size);
                 } catch (std::bad_alloc&) {
                     return Loader::ResultStatus::ErrorMemoryAllocationFailed;
                 }
 
-                if (exefs_file.ReadBytes(&temp_buffer[0], section.size) != section.size)
+                exefs_file.Seek(section_offset, SEEK_SET);
+                if (exefs_file.ReadBytes(buffer.data(), section.size) != section.size)
                     return Loader::ResultStatus::Error;
 
                 if (is_encrypted) {
-                    dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
+                    dec.Seek(section.offset + sizeof(ExeFs_Header));
+                    dec.ProcessData(buffer.data(), buffer.data(), section.size);
                 }
 
-                // Decompress .code section...
-                u32 decompressed_size = LZSS_GetDecompressedSize(&temp_buffer[0], section.size);
-                buffer.resize(decompressed_size);
-                if (!LZSS_Decompress(&temp_buffer[0], section.size, &buffer[0], decompressed_size))
+                if (!LZSS_Decompress(buffer.data(), section.size, buffer.data(), decompressed_size))
                     return Loader::ResultStatus::ErrorInvalidFormat;
+            } else if (view) {
+                buffer.assign(view, view + section.size);
             } else {
                 // Section is uncompressed...
+                exefs_file.Seek(section_offset, SEEK_SET);
                 buffer.resize(section.size);
                 if (exefs_file.ReadBytes(&buffer[0], section.size) != section.size)
                     return Loader::ResultStatus::Error;
                 if (is_encrypted) {
+                    dec.Seek(section.offset + sizeof(ExeFs_Header));
                     dec.ProcessData(&buffer[0], &buffer[0], section.size);
                 }
             }
@@ -655,8 +701,11 @@ Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romf
     if (use_layered_fs &&
         (FileUtil::Exists(path + "romfs/") || FileUtil::Exists(path + "romfs_ext/"))) {
 
+        const auto cache_path =
+            fmt::format("{}layeredfs/{:016X}.bin",
+                        FileUtil::GetUserPath(FileUtil::UserPath::CacheDir), ncch_header.program_id);
         romfs_file = std::make_shared<LayeredFS>(std::move(direct_romfs), path + "romfs/",
-                                                 path + "romfs_ext/");
+                                                 path + "romfs_ext/", true, cache_path);
     } else {
         romfs_file = std::move(direct_romfs);
     }
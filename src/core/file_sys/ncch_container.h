@@ -333,6 +333,11 @@ private:
     std::string filepath;
     FileUtil::IOFile file;
     FileUtil::IOFile exefs_file;
+
+    // Mappings of the file and of the file holding the ExeFS, which is either the same mapping or
+    // the one of an .exefs override. Unencrypted sections are copied from them directly.
+    std::shared_ptr<FileUtil::MappedFile> mapped_file;
+    std::shared_ptr<FileUtil::MappedFile> mapped_exefs;
 };
 
 } // namespace FileSys
@@ -1,22 +1,243 @@
 #include <algorithm>
+#include <cstring>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include "common/logging/log.h"
+#include "common/thread_pool.h"
 #include "core/file_sys/romfs_reader.h"
 
 namespace FileSys {
 
+namespace {
+/// Size of a cached block of decrypted RomFS data
+constexpr std::size_t BlockSize = 0x40000;
+/// Maximum number of cached blocks, 16 MiB per RomFS
+constexpr std::size_t MaxCachedBlocks = 64;
+/// Number of blocks read ahead when the reads are sequential
+constexpr std::size_t ReadAheadBlocks = 2;
+/// Reads of at least this size bypass the cache
+constexpr std::size_t DirectReadSize = 4 * BlockSize;
+/// Minimum amount of data decrypted by each thread of a direct read
+constexpr std::size_t MinDecryptPerThread = BlockSize;
+/// Maximum number of threads decrypting a direct read
+constexpr std::size_t MaxDecryptThreads = 4;
+
+/// Workers the direct reads of every RomFS are decrypted on, started on first use
+Common::ThreadPool& GetDecryptPool() {
+    static Common::ThreadPool pool(
+        std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, MaxDecryptThreads) - 1);
+    return pool;
+}
+} // namespace
+
+DirectRomFSReader::DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset,
+                                     std::size_t data_size)
+    : is_encrypted(false), file(std::move(file)), file_offset(file_offset), data_size(data_size) {}
+
+DirectRomFSReader::DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset,
+                                     std::size_t data_size, const std::array<u8, 16>& key,
+                                     const std::array<u8, 16>& ctr, std::size_t crypto_offset)
+    : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
+      crypto_offset(crypto_offset), data_size(data_size) {}
+
+DirectRomFSReader::~DirectRomFSReader() {
+    {
+        std::lock_guard lock{cache_mutex};
+        stop_read_ahead = true;
+    }
+    read_ahead_cv.notify_one();
+    if (read_ahead_thread.joinable()) {
+        read_ahead_thread.join();
+    }
+
+    const u64 lookups = stats.hits + stats.misses;
+    if (lookups != 0) {
+        LOG_INFO(Service_FS,
+                 "RomFS cache: {} hits, {} misses ({:.1f}% hit rate), {} prefetched, "
+                 "{} direct reads",
+                 stats.hits, stats.misses, stats.hits * 100.0 / lookups, stats.prefetched,
+                 stats.direct);
+    }
+}
+
 std::size_t DirectRomFSReader::ReadFile(std::size_t offset, std::size_t length, u8* buffer) {
-    if (length == 0)
+    if (length == 0 || offset >= data_size)
         return 0; // Crypto++ does not like zero size buffer
-    file.Seek(file_offset + offset, SEEK_SET);
-    std::size_t read_length = std::min(length, data_size - offset);
-    read_length = file.ReadBytes(buffer, read_length);
-    if (is_encrypted) {
-        CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption d(key.data(), key.size(), ctr.data());
-        d.Seek(crypto_offset + offset);
-        d.ProcessData(buffer, buffer, read_length);
+    length = std::min(length, data_size - offset);
+
+    if (length >= DirectReadSize) {
+        {
+            std::lock_guard lock{cache_mutex};
+            ++stats.direct;
+            last_read_end = offset + length;
+        }
+        return ReadDirect(offset, length, buffer);
+    }
+
+    bool sequential;
+    {
+        std::lock_guard lock{cache_mutex};
+        sequential = offset == last_read_end;
+        last_read_end = offset + length;
+    }
+
+    std::size_t read_length = 0;
+    std::size_t index = offset / BlockSize;
+    while (read_length < length) {
+        const Block block = GetBlock(index);
+        const std::size_t block_offset = (offset + read_length) - index * BlockSize;
+        if (block_offset >= block->size()) {
+            break; // The file is shorter than the RomFS claims
+        }
+        const std::size_t to_copy = std::min(block->size() - block_offset, length - read_length);
+        std::memcpy(buffer + read_length, block->data() + block_offset, to_copy);
+        read_length += to_copy;
+        ++index;
+    }
+
+    if (sequential) {
+        QueueReadAhead(index);
     }
     return read_length;
 }
 
+DirectRomFSReader::Block DirectRomFSReader::GetBlock(std::size_t index) {
+    std::unique_lock lock{cache_mutex};
+    while (true) {
+        const auto iter = block_map.find(index);
+        if (iter != block_map.end()) {
+            ++stats.hits;
+            lru_blocks.splice(lru_blocks.begin(), lru_blocks, iter->second);
+            return iter->second->second;
+        }
+        if (loading_blocks.count(index) == 0) {
+            break;
+        }
+        // Being read ahead, waiting for it is cheaper than reading it twice
+        block_loaded.wait(lock);
+    }
+    ++stats.misses;
+    loading_blocks.insert(index);
+    lock.unlock();
+
+    Block block = LoadBlock(index);
+
+    lock.lock();
+    loading_blocks.erase(index);
+    InsertBlock(index, block);
+    block_loaded.notify_all();
+    return block;
+}
+
+DirectRomFSReader::Block DirectRomFSReader::LoadBlock(std::size_t index) {
+    const std::size_t offset = index * BlockSize;
+    auto data = std::make_shared<std::vector<u8>>(std::min(BlockSize, data_size - offset));
+    {
+        std::lock_guard lock{file_mutex};
+        file.Seek(file_offset + offset, SEEK_SET);
+        data->resize(file.ReadBytes(data->data(), data->size()));
+    }
+    if (is_encrypted && !data->empty()) {
+        Decrypt(data->data(), offset, data->size());
+    }
+    return data;
+}
+
+void DirectRomFSReader::InsertBlock(std::size_t index, Block block) {
+    if (block_map.count(index)) {
+        return;
+    }
+    lru_blocks.emplace_front(index, std::move(block));
+    block_map.emplace(index, lru_blocks.begin());
+    while (lru_blocks.size() > MaxCachedBlocks) {
+        block_map.erase(lru_blocks.back().first);
+        lru_blocks.pop_back();
+    }
+}
+
+std::size_t DirectRomFSReader::ReadDirect(std::size_t offset, std::size_t length, u8* buffer) {
+    std::size_t read_length;
+    {
+        std::lock_guard lock{file_mutex};
+        file.Seek(file_offset + offset, SEEK_SET);
+        read_length = file.ReadBytes(buffer, length);
+    }
+    if (!is_encrypted || read_length == 0) {
+        return read_length;
+    }
+
+    // CTR mode can start anywhere in the stream, so each thread decrypts its own range
+    Common::ThreadPool& pool = GetDecryptPool();
+    const std::size_t num_threads =
+        std::clamp<std::size_t>(read_length / MinDecryptPerThread, 1, pool.GetThreadCount());
+    // Keep the ranges aligned to the AES block size so that no thread starts mid block
+    const std::size_t range_size =
+        (read_length / num_threads + CryptoPP::AES::BLOCKSIZE - 1) &
+        ~static_cast<std::size_t>(CryptoPP::AES::BLOCKSIZE - 1);
+    const std::size_t num_ranges = (read_length + range_size - 1) / range_size;
+
+    pool.ParallelFor(num_ranges, [&](std::size_t range) {
+        const std::size_t begin = range * range_size;
+        Decrypt(buffer + begin, offset + begin, std::min(range_size, read_length - begin));
+    });
+    return read_length;
+}
+
+void DirectRomFSReader::Decrypt(u8* data, std::size_t offset, std::size_t length) const {
+    // Crypto++ picks the AES-NI implementation when the CPU has it, and processes large buffers
+    // several counter blocks at a time
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption d(key.data(), key.size(), ctr.data());
+    d.Seek(crypto_offset + offset);
+    d.ProcessData(data, data, length);
+}
+
+void DirectRomFSReader::QueueReadAhead(std::size_t first_index) {
+    const std::size_t num_blocks = (data_size + BlockSize - 1) / BlockSize;
+    {
+        std::lock_guard lock{cache_mutex};
+        for (std::size_t index = first_index;
+             index < std::min(first_index + ReadAheadBlocks, num_blocks); ++index) {
+            if (block_map.count(index) == 0 && loading_blocks.count(index) == 0 &&
+                std::find(read_ahead_queue.begin(), read_ahead_queue.end(), index) ==
+                    read_ahead_queue.end()) {
+                read_ahead_queue.push_back(index);
+            }
+        }
+        if (read_ahead_queue.empty()) {
+            return;
+        }
+        // Only titles that actually stream their data get a thread
+        if (!read_ahead_thread.joinable()) {
+            read_ahead_thread = std::thread(&DirectRomFSReader::ReadAheadLoop, this);
+        }
+    }
+    read_ahead_cv.notify_one();
+}
+
+void DirectRomFSReader::ReadAheadLoop() {
+    std::unique_lock lock{cache_mutex};
+    while (true) {
+        read_ahead_cv.wait(lock, [this] { return stop_read_ahead || !read_ahead_queue.empty(); });
+        if (stop_read_ahead) {
+            return;
+        }
+
+        const std::size_t index = read_ahead_queue.front();
+        read_ahead_queue.pop_front();
+        if (block_map.count(index) || loading_blocks.count(index)) {
+            continue;
+        }
+        loading_blocks.insert(index);
+        lock.unlock();
+
+        Block block = LoadBlock(index);
+
+        lock.lock();
+        loading_blocks.erase(index);
+        ++stats.prefetched;
+        InsertBlock(index, std::move(block));
+        block_loaded.notify_all();
+    }
+}
+
 } // namespace FileSys
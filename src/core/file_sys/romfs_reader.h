@@ -1,6 +1,15 @@
 #pragma once
 
 #include <array>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "common/common_types.h"
 #include "common/file_util.h"
 
@@ -19,20 +28,21 @@ public:
 
 /**
  * A RomFS reader that directly reads the RomFS file.
+ *
+ * Small reads go through a cache of decrypted blocks with an LRU budget, so that titles streaming
+ * many small assets don't pay a seek, a read and a decryptor setup for each of them. Sequential
+ * reads prefetch the following blocks on a background thread. Large reads bypass the cache and
+ * are decrypted on several threads. The hit rate of the cache is logged when the reader is closed.
  */
 class DirectRomFSReader : public RomFSReader {
 public:
-    DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size)
-        : is_encrypted(false), file(std::move(file)), file_offset(file_offset),
-          data_size(data_size) {}
+    DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size);
 
     DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
                       const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
-                      std::size_t crypto_offset)
-        : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
-          crypto_offset(crypto_offset), data_size(data_size) {}
+                      std::size_t crypto_offset);
 
-    ~DirectRomFSReader() override = default;
+    ~DirectRomFSReader() override;
 
     std::size_t GetSize() const override {
         return data_size;
@@ -41,6 +51,32 @@ public:
     std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer) override;
 
 private:
+    struct CacheStats {
+        u64 hits;       ///< Blocks found in the cache, including ones being prefetched
+        u64 misses;     ///< Blocks read on demand
+        u64 prefetched; ///< Blocks read ahead of time
+        u64 direct;     ///< Reads that were too large for the cache
+    };
+
+    using Block = std::shared_ptr<const std::vector<u8>>;
+
+    /// Returns the block with the given index, from the cache or read on demand
+    Block GetBlock(std::size_t index);
+
+    /// Reads and decrypts a block
+    Block LoadBlock(std::size_t index);
+
+    /// Inserts a block at the front of the LRU list and evicts blocks over the budget
+    void InsertBlock(std::size_t index, Block block);
+
+    /// Reads straight into buffer, decrypting it on the shared decryption threads
+    std::size_t ReadDirect(std::size_t offset, std::size_t length, u8* buffer);
+
+    void Decrypt(u8* data, std::size_t offset, std::size_t length) const;
+
+    void QueueReadAhead(std::size_t first_index);
+    void ReadAheadLoop();
+
     bool is_encrypted;
     FileUtil::IOFile file;
     std::array<u8, 16> key;
@@ -48,6 +84,21 @@ private:
     std::size_t file_offset;
     std::size_t crypto_offset;
     std::size_t data_size;
+
+    std::mutex file_mutex;
+
+    mutable std::mutex cache_mutex;
+    std::list<std::pair<std::size_t, Block>> lru_blocks; // most recently used first
+    std::unordered_map<std::size_t, decltype(lru_blocks)::iterator> block_map;
+    std::unordered_set<std::size_t> loading_blocks;
+    std::condition_variable block_loaded;
+    CacheStats stats{};
+    std::size_t last_read_end = 0;
+
+    std::thread read_ahead_thread;
+    std::condition_variable read_ahead_cv;
+    std::deque<std::size_t> read_ahead_queue;
+    bool stop_read_ahead = false;
 };
 
 } // namespace FileSys
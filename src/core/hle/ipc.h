@@ -17,6 +17,10 @@ constexpr std::size_t COMMAND_BUFFER_LENGTH = 0x100 / sizeof(u32);
 // Maximum number of static buffers per thread.
 constexpr std::size_t MAX_STATIC_BUFFERS = 16;
 
+/// Size of the command buffer area followed by the static buffer descriptors, in 32-bit words.
+constexpr std::size_t COMMAND_BUFFER_WITH_STATIC_BUFFERS_LENGTH =
+    COMMAND_BUFFER_LENGTH + 2 * MAX_STATIC_BUFFERS;
+
 // These errors are commonly returned by invalid IPC translations, so alias them here for
 // convenience.
 // TODO(yuriks): These will probably go away once translation is implemented inside the kernel.
@@ -69,7 +69,7 @@ AddressArbiter::AddressArbiter(KernelSystem& kernel) : Object(kernel), kernel(ke
 AddressArbiter::~AddressArbiter() {}
 
 std::shared_ptr<AddressArbiter> KernelSystem::CreateAddressArbiter(std::string name) {
-    auto address_arbiter{std::make_shared<AddressArbiter>(*this)};
+    auto address_arbiter{MakeObject<AddressArbiter>()};
 
     address_arbiter->name = std::move(name);
 
@@ -74,6 +74,19 @@ ResultCode HandleTable::Close(Handle handle) {
     return RESULT_SUCCESS;
 }
 
+std::shared_ptr<Object> HandleTable::Take(Handle handle) {
+    if (!IsValid(handle)) {
+        return GetGeneric(handle);
+    }
+
+    u16 slot = GetSlot(handle);
+    std::shared_ptr<Object> object = std::move(objects[slot]);
+
+    generations[slot] = next_free_slot;
+    next_free_slot = slot;
+    return object;
+}
+
 bool HandleTable::IsValid(Handle handle) const {
     std::size_t slot = GetSlot(handle);
     u16 generation = GetGeneration(handle);
@@ -94,6 +107,19 @@ std::shared_ptr<Object> HandleTable::GetGeneric(Handle handle) const {
     return objects[GetSlot(handle)];
 }
 
+Object* HandleTable::GetGenericBorrowed(Handle handle) const {
+    if (handle == CurrentThread) {
+        return kernel.GetCurrentThreadManager().GetCurrentThread();
+    } else if (handle == CurrentProcess) {
+        return kernel.GetCurrentProcess().get();
+    }
+
+    if (!IsValid(handle)) {
+        return nullptr;
+    }
+    return objects[GetSlot(handle)].get();
+}
+
 void HandleTable::Clear() {
     for (u16 i = 0; i < MAX_COUNT; ++i) {
         generations[i] = i + 1;
@@ -68,6 +68,13 @@ public:
      */
     ResultCode Close(Handle handle);
 
+    /**
+     * Closes a handle and hands its reference to the object over to the caller, used to move
+     * handles between tables. Pseudo-handles are looked up without closing anything.
+     * @return Pointer to the object, or `nullptr` if the handle is not valid.
+     */
+    std::shared_ptr<Object> Take(Handle handle);
+
     /// Checks if a handle is valid and points to an existing object.
     bool IsValid(Handle handle) const;
 
@@ -87,6 +94,24 @@ public:
         return DynamicObjectCast<T>(GetGeneric(handle));
     }
 
+    /**
+     * Looks up a handle without taking a reference to the object. The pointer is only valid as
+     * long as the handle stays open, so it must not be kept past the current SVC or request.
+     * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid.
+     */
+    Object* GetGenericBorrowed(Handle handle) const;
+
+    /**
+     * Looks up a handle while verifying its type, without taking a reference to the object. See
+     * GetGenericBorrowed.
+     * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid or its
+     *         type differs from the requested one.
+     */
+    template <class T>
+    T* GetBorrowed(Handle handle) const {
+        return DynamicObjectCast<T>(GetGenericBorrowed(handle));
+    }
+
     /// Closes all handles held in this table.
     void Clear();
 
@@ -44,17 +44,24 @@ std::shared_ptr<Event> HLERequestContext::SleepClientThread(const std::string& r
         callback(thread, context, reason);
 
         auto& process = thread->owner_process;
-        // We must copy the entire command buffer *plus* the entire static buffers area, since
-        // the translation might need to read from it in order to retrieve the StaticBuffer
-        // target addresses.
-        std::array<u32_le, IPC::COMMAND_BUFFER_LENGTH + 2 * IPC::MAX_STATIC_BUFFERS> cmd_buff;
         Memory::MemorySystem& memory = context.kernel.memory;
+        // The translation might need to read the entire static buffers area after the command
+        // buffer in order to retrieve the StaticBuffer target addresses.
+        constexpr std::size_t buffer_size =
+            IPC::COMMAND_BUFFER_WITH_STATIC_BUFFERS_LENGTH * sizeof(u32);
+        if (u8* cmd_buff = memory.GetContiguousPointer(
+                *process, thread->GetCommandBufferAddress(), buffer_size)) {
+            context.WriteToOutgoingCommandBuffer(reinterpret_cast<u32_le*>(cmd_buff), *process);
+            return;
+        }
+
+        std::array<u32_le, IPC::COMMAND_BUFFER_WITH_STATIC_BUFFERS_LENGTH> cmd_buff;
         memory.ReadBlock(*process, thread->GetCommandBufferAddress(), cmd_buff.data(),
-                         cmd_buff.size() * sizeof(u32));
+                         buffer_size);
         context.WriteToOutgoingCommandBuffer(cmd_buff.data(), *process);
         // Copy the translated command buffer back into the thread's command buffer area.
         memory.WriteBlock(*process, thread->GetCommandBufferAddress(), cmd_buff.data(),
-                          cmd_buff.size() * sizeof(u32));
+                          buffer_size);
     };
 
     auto event = kernel.CreateEvent(Kernel::ResetType::OneShot, "HLE Pause Event: " + reason);
@@ -129,11 +136,12 @@ ResultCode HLERequestContext::PopulateFromIncomingCommandBuffer(const u32_le* sr
                 Handle handle = src_cmdbuf[i];
                 std::shared_ptr<Object> object = nullptr;
                 if (handle != 0) {
-                    object = src_process.handle_table.GetGeneric(handle);
-                    ASSERT(object != nullptr); // TODO(yuriks): Return error
                     if (descriptor == IPC::DescriptorType::MoveHandle) {
-                        src_process.handle_table.Close(handle);
+                        object = src_process.handle_table.Take(handle);
+                    } else {
+                        object = src_process.handle_table.GetGeneric(handle);
                     }
+                    ASSERT(object != nullptr); // TODO(yuriks): Return error
                 }
 
                 cmd_buf[i++] = AddOutgoingHandle(std::move(object));
@@ -210,7 +218,7 @@ ResultCode HLERequestContext::WriteToOutgoingCommandBuffer(u32_le* dst_cmdbuf,
                 Handle handle = 0;
                 if (object != nullptr) {
                     // TODO(yuriks): Figure out the proper error handling for if this fails
-                    handle = dst_process.handle_table.Create(object).Unwrap();
+                    handle = dst_process.handle_table.Create(std::move(object)).Unwrap();
                 }
                 dst_cmdbuf[i++] = handle;
             }
@@ -266,6 +274,22 @@ void HLERequestContext::ReportUnimplemented() const {
     }
 }
 
+std::size_t HLERequestContext::GetRequestPayloadSize() const {
+    IPC::Header header{cmd_buf[0]};
+    std::size_t size = (1u + header.normal_params_size + header.translate_params_size) * sizeof(u32);
+    for (const auto& buffer : static_buffers) {
+        size += buffer.size();
+    }
+    for (const auto& buffer : request_mapped_buffers) {
+        size += buffer.GetSize();
+    }
+    return size;
+}
+
+IPCDebugger::Profiler& HLERequestContext::GetIPCProfiler() const {
+    return kernel.GetIPCProfiler();
+}
+
 MappedBuffer::MappedBuffer(Memory::MemorySystem& memory, const Process& process, u32 descriptor,
                            VAddr address, u32 id)
     : memory(&memory), id(id), address(address), process(&process) {
@@ -286,4 +310,8 @@ void MappedBuffer::Write(const void* src_buffer, std::size_t offset, std::size_t
     memory->WriteBlock(*process, address + static_cast<VAddr>(offset), src_buffer, size);
 }
 
+u8* MappedBuffer::GetPointer() {
+    return memory->GetContiguousPointer(*process, address, size);
+}
+
 } // namespace Kernel
@@ -25,6 +25,10 @@ namespace Memory {
 class MemorySystem;
 }
 
+namespace IPCDebugger {
+class Profiler;
+}
+
 namespace Kernel {
 
 class HandleTable;
@@ -104,6 +108,12 @@ public:
     // interface for service
     void Read(void* dest_buffer, std::size_t offset, std::size_t size);
     void Write(const void* src_buffer, std::size_t offset, std::size_t size);
+    /**
+     * Returns the buffer contents in guest memory, to be accessed in place according to the buffer
+     * permissions. Returns nullptr if the buffer is not contiguous in host memory, Read and Write
+     * have to be used then.
+     */
+    u8* GetPointer();
     std::size_t GetSize() const {
         return size;
     }
@@ -237,6 +247,12 @@ public:
     /// Reports an unimplemented function.
     void ReportUnimplemented() const;
 
+    /// Returns the size of the request: its command buffer plus its static and mapped buffers.
+    std::size_t GetRequestPayloadSize() const;
+
+    /// Returns the profiler of the HLE service requests.
+    IPCDebugger::Profiler& GetIPCProfiler() const;
+
 private:
     KernelSystem& kernel;
     std::array<u32, IPC::COMMAND_BUFFER_LENGTH> cmd_buf;
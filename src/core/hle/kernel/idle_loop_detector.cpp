@@ -0,0 +1,35 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/hle/kernel/idle_loop_detector.h"
+
+namespace Kernel {
+
+IdleLoopDetector::IdleLoopDetector(u32 num_cores) : cores(num_cores) {}
+
+void IdleLoopDetector::OnSVC(u32 core_id, u32 thread_id, u32 svc_id, u32 pc,
+                             const std::array<u32, 4>& args, u64 ticks) {
+    CoreState& core = cores[core_id];
+    const bool repeated = core.thread_id == thread_id && core.svc_id == svc_id && core.pc == pc &&
+                          core.args == args && ticks >= core.last_ticks &&
+                          ticks - core.last_ticks <= MaxSpinGap;
+    core.repeats = repeated ? core.repeats + 1 : 0;
+    core.thread_id = thread_id;
+    core.svc_id = svc_id;
+    core.pc = pc;
+    core.args = args;
+    core.last_ticks = ticks;
+}
+
+bool IdleLoopDetector::IsSpinning(u32 core_id) const {
+    return cores[core_id].repeats >= SpinRepeatThreshold;
+}
+
+void IdleLoopDetector::RecordSkip(u32 core_id, u64 ticks) {
+    cores[core_id].last_ticks += ticks;
+    ++stats.skipped_loops;
+    stats.skipped_ticks += ticks;
+}
+
+} // namespace Kernel
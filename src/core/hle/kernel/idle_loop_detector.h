@@ -0,0 +1,71 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Kernel {
+
+/**
+ * Spots guest threads spinning on an SVC that can't make progress by itself, like
+ * svcSleepThread(0) with no other thread ready to run. What such a loop waits for can only change
+ * with the next timing event (a GSP or DSP interrupt, a timer, ...), so the core can idle until
+ * then instead of running the loop for the rest of its slice.
+ *
+ * A thread counts as spinning once it has made the same call several times in a row: the same
+ * SVC from the same PC with the same arguments in r0-r3, each call within a few hundred cycles of
+ * the previous one. Any other SVC, a different call site or argument, another thread or a longer
+ * gap starts the detection over. The check can't see memory writes between the calls, so it is
+ * only used on SVCs that yield, where skipping ahead is what real hardware would do anyway.
+ */
+class IdleLoopDetector {
+public:
+    /// Number of back to back calls after which a thread is considered to be spinning
+    static constexpr u32 SpinRepeatThreshold = 4;
+    /// Maximum number of ticks between two calls of a spin loop
+    static constexpr u64 MaxSpinGap = 500;
+
+    struct Stats {
+        u64 skipped_loops = 0; ///< Number of times a core idled instead of running a spin loop
+        u64 skipped_ticks = 0; ///< Emulated CPU ticks skipped that way
+    };
+
+    explicit IdleLoopDetector(u32 num_cores);
+
+    /// Notes an SVC made by a thread on a core from the given PC with the given r0-r3, at the
+    /// given tick count of that core.
+    void OnSVC(u32 core_id, u32 thread_id, u32 svc_id, u32 pc, const std::array<u32, 4>& args,
+               u64 ticks);
+
+    /// Returns whether the last SVC made on the core is part of a spin loop.
+    bool IsSpinning(u32 core_id) const;
+
+    /**
+     * Counts ticks skipped on a core for a spin loop. The skipped ticks don't count as a gap
+     * between calls, so the loop is skipped again right away if it keeps spinning.
+     */
+    void RecordSkip(u32 core_id, u64 ticks);
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+private:
+    struct CoreState {
+        u32 thread_id = 0;
+        u32 svc_id = 0;
+        u32 pc = 0;
+        std::array<u32, 4> args{};
+        u64 last_ticks = 0;
+        u32 repeats = 0;
+    };
+
+    std::vector<CoreState> cores;
+    Stats stats;
+};
+
+} // namespace Kernel
@@ -73,9 +73,10 @@ ResultCode TranslateCommandBuffer(Kernel::KernelSystem& kernel, Memory::MemorySy
                 } else if (handle == CurrentProcess) {
                     object = SharedFrom(src_process);
                 } else if (handle != 0) {
-                    object = src_process->handle_table.GetGeneric(handle);
                     if (descriptor == IPC::DescriptorType::MoveHandle) {
-                        src_process->handle_table.Close(handle);
+                        object = src_process->handle_table.Take(handle);
+                    } else {
+                        object = src_process->handle_table.GetGeneric(handle);
                     }
                 }
 
@@ -0,0 +1,173 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/microprofile.h"
+#include "core/hle/kernel/ipc_debugger/profiler.h"
+
+namespace IPCDebugger {
+
+namespace {
+
+std::size_t GetBucket(u64 ns) {
+    std::size_t bucket = 0;
+    while (ns != 0 && bucket < HistogramBuckets - 1) {
+        ns >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::string EscapeJSON(const std::string& str) {
+    std::string escaped;
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+Profiler::CallScope::CallScope(Profiler& profiler, const std::string& service_name,
+                               const char* function_name, u32 header_code,
+                               std::size_t payload_size)
+    : profiler(profiler), profile(profiler.GetProfile(service_name, function_name, header_code)) {
+    {
+        std::lock_guard lock{profiler.mutex};
+        profile.payload_bytes += payload_size;
+    }
+#if MICROPROFILE_ENABLED
+    microprofile_tick = MicroProfileEnter(profile.microprofile_token);
+#endif
+    start = std::chrono::steady_clock::now();
+}
+
+Profiler::CallScope::~CallScope() {
+    const u64 ns = static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now() - start)
+                                        .count());
+#if MICROPROFILE_ENABLED
+    MicroProfileLeave(profile.microprofile_token, microprofile_tick);
+#endif
+
+    std::lock_guard lock{profiler.mutex};
+    profile.min_ns = profile.calls == 0 ? ns : std::min(profile.min_ns, ns);
+    profile.max_ns = std::max(profile.max_ns, ns);
+    profile.total_ns += ns;
+    ++profile.calls;
+    ++profile.histogram[GetBucket(ns)];
+}
+
+Profiler::Profiler() = default;
+
+Profiler::~Profiler() = default;
+
+void Profiler::SetEnabled(bool enabled_) {
+    enabled.store(enabled_, std::memory_order_relaxed);
+}
+
+void Profiler::Reset() {
+    std::lock_guard lock{mutex};
+    // Requests being handled still reference their profile, so only clear the statistics
+    for (auto& [key, profile] : profiles) {
+        profile.calls = 0;
+        profile.total_ns = 0;
+        profile.min_ns = 0;
+        profile.max_ns = 0;
+        profile.payload_bytes = 0;
+        profile.histogram.fill(0);
+    }
+}
+
+std::vector<CommandProfile> Profiler::GetProfiles() const {
+    std::lock_guard lock{mutex};
+    std::vector<CommandProfile> ret;
+    for (const auto& [key, profile] : profiles) {
+        if (profile.calls != 0) {
+            ret.push_back(profile);
+        }
+    }
+    return ret;
+}
+
+std::string Profiler::DumpJSON() const {
+    std::string json = "[\n";
+    const auto dump = GetProfiles();
+    for (std::size_t i = 0; i < dump.size(); ++i) {
+        const auto& profile = dump[i];
+        // Only the non-empty tail of the histogram, as upper bound in nanoseconds and count. The
+        // last bucket counts every slower call, so its bound is null.
+        std::string histogram;
+        const auto last = std::find_if(profile.histogram.rbegin(), profile.histogram.rend(),
+                                       [](u64 count) { return count != 0; });
+        const std::size_t num_buckets = profile.histogram.rend() - last;
+        for (std::size_t bucket = 0; bucket < num_buckets; ++bucket) {
+            const std::string upper_bound =
+                bucket == HistogramBuckets - 1 ? "null" : std::to_string(u64{1} << bucket);
+            histogram += fmt::format("{}[{}, {}]", bucket == 0 ? "" : ", ", upper_bound,
+                                     profile.histogram[bucket]);
+        }
+        json += fmt::format(
+            "  {{\"service\": \"{}\", \"function\": \"{}\", \"header\": \"0x{:08X}\", "
+            "\"calls\": {}, \"total_ns\": {}, \"min_ns\": {}, \"max_ns\": {}, \"mean_ns\": {}, "
+            "\"payload_bytes\": {}, \"histogram\": [{}]}}{}\n",
+            EscapeJSON(profile.service_name), EscapeJSON(profile.function_name),
+            profile.header_code, profile.calls, profile.total_ns, profile.min_ns, profile.max_ns,
+            profile.total_ns / profile.calls, profile.payload_bytes, histogram,
+            i + 1 == dump.size() ? "" : ",");
+    }
+    return json + "]\n";
+}
+
+std::string Profiler::DumpCSV() const {
+    std::string csv = "service,function,header,calls,total_ns,min_ns,max_ns,mean_ns,payload_bytes";
+    for (std::size_t bucket = 0; bucket < HistogramBuckets - 1; ++bucket) {
+        csv += fmt::format(",lt_{}ns", u64{1} << bucket);
+    }
+    csv += ",slower\n";
+
+    for (const auto& profile : GetProfiles()) {
+        csv += fmt::format("{},{},0x{:08X},{},{},{},{},{},{}", profile.service_name,
+                           profile.function_name, profile.header_code, profile.calls,
+                           profile.total_ns, profile.min_ns, profile.max_ns,
+                           profile.total_ns / profile.calls, profile.payload_bytes);
+        for (const u64 count : profile.histogram) {
+            csv += fmt::format(",{}", count);
+        }
+        csv += '\n';
+    }
+    return csv;
+}
+
+bool Profiler::DumpToFile(const std::string& path) const {
+    const bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    const std::string dump = csv ? DumpCSV() : DumpJSON();
+    return FileUtil::WriteStringToFile(true, path, dump) == dump.size();
+}
+
+CommandProfile& Profiler::GetProfile(const std::string& service_name, const char* function_name,
+                                     u32 header_code) {
+    std::lock_guard lock{mutex};
+    auto [iter, inserted] = profiles.try_emplace({service_name, header_code});
+    CommandProfile& profile = iter->second;
+    if (inserted) {
+        // Sessions to files and directories have no service name
+        profile.service_name = service_name.empty() ? "(session)" : service_name;
+        profile.function_name = function_name;
+        profile.header_code = header_code;
+#if MICROPROFILE_ENABLED
+        profile.microprofile_token =
+            MicroProfileGetToken(("IPC " + profile.service_name).c_str(), function_name,
+                                 MP_RGB(200, 150, 70), MicroProfileTokenTypeCpu);
+#endif
+    }
+    return profile;
+}
+
+} // namespace IPCDebugger
@@ -0,0 +1,107 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+
+namespace IPCDebugger {
+
+/**
+ * Number of buckets of the host time histograms. Bucket 0 counts the calls that took no time,
+ * bucket i the calls that took [2^(i-1), 2^i) nanoseconds and the last one every slower call.
+ */
+constexpr std::size_t HistogramBuckets = 24;
+
+/**
+ * Statistics of the requests handled for one command of an HLE service.
+ */
+struct CommandProfile {
+    std::string service_name;
+    std::string function_name;
+    u32 header_code = 0;
+    u64 calls = 0;
+    u64 total_ns = 0;
+    u64 min_ns = 0;
+    u64 max_ns = 0;
+    u64 payload_bytes = 0; ///< Request command buffers plus their static and mapped buffers
+    std::array<u64, HistogramBuckets> histogram{};
+    u64 microprofile_token = 0;
+};
+
+/**
+ * Measures the host time spent in the handlers of HLE service requests. This is opt-in, when
+ * disabled the dispatcher only pays for checking IsEnabled.
+ */
+class Profiler {
+public:
+    /**
+     * Times a request for as long as it is alive, and shows it under the service group of
+     * MicroProfile.
+     */
+    class CallScope {
+    public:
+        CallScope(Profiler& profiler, const std::string& service_name, const char* function_name,
+                  u32 header_code, std::size_t payload_size);
+        ~CallScope();
+
+    private:
+        Profiler& profiler;
+        CommandProfile& profile;
+        std::chrono::steady_clock::time_point start;
+        u64 microprofile_tick = 0;
+    };
+
+    Profiler();
+    ~Profiler();
+
+    /**
+     * Returns whether the profiler is enabled.
+     */
+    bool IsEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Set the status of the profiler (enabled/disabled). The collected statistics are kept.
+     */
+    void SetEnabled(bool enabled);
+
+    /**
+     * Discards the collected statistics.
+     */
+    void Reset();
+
+    /**
+     * Returns a copy of the statistics, sorted by service name and header code.
+     */
+    std::vector<CommandProfile> GetProfiles() const;
+
+    std::string DumpJSON() const;
+    std::string DumpCSV() const;
+
+    /**
+     * Writes the statistics to a file, as CSV if its extension is .csv and as JSON otherwise.
+     */
+    bool DumpToFile(const std::string& path) const;
+
+private:
+    CommandProfile& GetProfile(const std::string& service_name, const char* function_name,
+                               u32 header_code);
+
+    std::map<std::pair<std::string, u32>, CommandProfile> profiles;
+    mutable std::mutex mutex;
+
+    std::atomic_bool enabled{false};
+};
+
+} // namespace IPCDebugger
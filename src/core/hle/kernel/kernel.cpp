@@ -5,12 +5,16 @@
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/config_mem.h"
 #include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/idle_loop_detector.h"
+#include "core/hle/kernel/ipc_debugger/profiler.h"
 #include "core/hle/kernel/ipc_debugger/recorder.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/resource_limit.h"
 #include "core/hle/kernel/shared_page.h"
+#include "core/hle/kernel/slab_heap.h"
+#include "core/hle/kernel/svc_trace.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/timer.h"
 
@@ -25,11 +29,15 @@ KernelSystem::KernelSystem(Memory::MemorySystem& memory, Core::Timing& timing,
     MemoryInit(system_mode, n3ds_mode);
 
     resource_limits = std::make_unique<ResourceLimitList>(*this);
+    CreateObjectSlabs();
     for (u32 core_id = 0; core_id < num_cores; ++core_id) {
         thread_managers.push_back(std::make_unique<ThreadManager>(*this, core_id));
     }
     timer_manager = std::make_unique<TimerManager>(timing);
     ipc_recorder = std::make_unique<IPCDebugger::Recorder>();
+    ipc_profiler = std::make_unique<IPCDebugger::Profiler>();
+    svc_trace_recorder = std::make_unique<SVCTraceRecorder>();
+    idle_loop_detector = std::make_unique<IdleLoopDetector>(num_cores);
     stored_processes.assign(num_cores, nullptr);
 
     next_thread_id = 1;
@@ -40,6 +48,39 @@ KernelSystem::~KernelSystem() {
     ResetThreadIDs();
 };
 
+void KernelSystem::CreateObjectSlabs() {
+    // Size the slabs of the limited object types so that every category can reach its limit
+    // without growing them
+    const auto total_limit = [this](s32 Kernel::ResourceLimit::*max_objects) {
+        std::size_t total = 0;
+        for (const auto category :
+             {ResourceLimitCategory::APPLICATION, ResourceLimitCategory::SYS_APPLET,
+              ResourceLimitCategory::LIB_APPLET, ResourceLimitCategory::OTHER}) {
+            total += static_cast<std::size_t>(resource_limits->GetForCategory(category).get()->*
+                                              max_objects);
+        }
+        return total;
+    };
+    const auto create_slab = [this](HandleType type, std::size_t objects_per_chunk) {
+        object_slabs[static_cast<std::size_t>(type)] =
+            std::make_shared<SlabHeap>(objects_per_chunk);
+    };
+
+    object_slabs.resize(NumHandleTypes);
+    create_slab(HandleType::Thread, total_limit(&Kernel::ResourceLimit::max_threads));
+    create_slab(HandleType::Event, total_limit(&Kernel::ResourceLimit::max_events));
+    create_slab(HandleType::Mutex, total_limit(&Kernel::ResourceLimit::max_mutexes));
+    create_slab(HandleType::Semaphore, total_limit(&Kernel::ResourceLimit::max_semaphores));
+    create_slab(HandleType::Timer, total_limit(&Kernel::ResourceLimit::max_timers));
+    create_slab(HandleType::SharedMemory, total_limit(&Kernel::ResourceLimit::max_shared_mems));
+    create_slab(HandleType::AddressArbiter,
+                total_limit(&Kernel::ResourceLimit::max_address_arbiters));
+    // Sessions aren't limited, every service connection creates a pair of them
+    constexpr std::size_t SessionsPerChunk = 64;
+    create_slab(HandleType::ServerSession, SessionsPerChunk);
+    create_slab(HandleType::ClientSession, SessionsPerChunk);
+}
+
 ResourceLimitList& KernelSystem::ResourceLimit() {
     return *resource_limits;
 }
@@ -52,7 +93,7 @@ u32 KernelSystem::GenerateObjectID() {
     return next_object_id++;
 }
 
-std::shared_ptr<Process> KernelSystem::GetCurrentProcess() const {
+const std::shared_ptr<Process>& KernelSystem::GetCurrentProcess() const {
     return current_process;
 }
 
@@ -136,6 +177,30 @@ const IPCDebugger::Recorder& KernelSystem::GetIPCRecorder() const {
     return *ipc_recorder;
 }
 
+IPCDebugger::Profiler& KernelSystem::GetIPCProfiler() {
+    return *ipc_profiler;
+}
+
+const IPCDebugger::Profiler& KernelSystem::GetIPCProfiler() const {
+    return *ipc_profiler;
+}
+
+SVCTraceRecorder& KernelSystem::GetSVCTraceRecorder() {
+    return *svc_trace_recorder;
+}
+
+const SVCTraceRecorder& KernelSystem::GetSVCTraceRecorder() const {
+    return *svc_trace_recorder;
+}
+
+IdleLoopDetector& KernelSystem::GetIdleLoopDetector() {
+    return *idle_loop_detector;
+}
+
+const IdleLoopDetector& KernelSystem::GetIdleLoopDetector() const {
+    return *idle_loop_detector;
+}
+
 void KernelSystem::AddNamedPort(std::string name, std::shared_ptr<ClientPort> port) {
     named_ports.emplace(std::move(name), std::move(port));
 }
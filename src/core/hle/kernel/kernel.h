@@ -33,13 +33,15 @@ class Timing;
 }
 
 namespace IPCDebugger {
+class Profiler;
 class Recorder;
-}
+} // namespace IPCDebugger
 
 namespace Kernel {
 
 class AddressArbiter;
 class Event;
+class IdleLoopDetector;
 class Mutex;
 class CodeSet;
 class Process;
@@ -52,6 +54,8 @@ class ClientSession;
 class ServerSession;
 class ResourceLimitList;
 class SharedMemory;
+class SlabHeap;
+class SVCTraceRecorder;
 class ThreadManager;
 class TimerManager;
 class VMManager;
@@ -209,7 +213,7 @@ public:
     /// Retrieves a process from the current list of processes.
     std::shared_ptr<Process> GetProcessById(u32 process_id) const;
 
-    std::shared_ptr<Process> GetCurrentProcess() const;
+    const std::shared_ptr<Process>& GetCurrentProcess() const;
     void SetCurrentProcess(std::shared_ptr<Process> process);
     void SetCurrentProcessForCPU(std::shared_ptr<Process> process, u32 core_id);
 
@@ -236,6 +240,15 @@ public:
     IPCDebugger::Recorder& GetIPCRecorder();
     const IPCDebugger::Recorder& GetIPCRecorder() const;
 
+    IPCDebugger::Profiler& GetIPCProfiler();
+    const IPCDebugger::Profiler& GetIPCProfiler() const;
+
+    SVCTraceRecorder& GetSVCTraceRecorder();
+    const SVCTraceRecorder& GetSVCTraceRecorder() const;
+
+    IdleLoopDetector& GetIdleLoopDetector();
+    const IdleLoopDetector& GetIdleLoopDetector() const;
+
     MemoryRegionInfo* GetMemoryRegion(MemoryRegion region);
 
     void HandleSpecialMapping(VMManager& address_space, const AddressMapping& mapping);
@@ -245,6 +258,13 @@ public:
     /// Adds a port to the named port table
     void AddNamedPort(std::string name, std::shared_ptr<ClientPort> port);
 
+    /**
+     * Creates a kernel object in the slab heap of its type, passing this kernel and args to its
+     * constructor. Defined in object.h.
+     */
+    template <typename T, typename... Args>
+    std::shared_ptr<T> MakeObject(Args&&... args);
+
     void PrepareReschedule() {
         prepare_reschedule_callback();
     }
@@ -264,12 +284,16 @@ public:
 
 private:
     void MemoryInit(u32 mem_type, u8 n3ds_mode);
+    void CreateObjectSlabs();
 
     std::function<void()> prepare_reschedule_callback;
 
     std::unique_ptr<ResourceLimitList> resource_limits;
     std::atomic<u32> next_object_id{0};
 
+    /// Slab heaps of the object types created by MakeObject, indexed by HandleType
+    std::vector<std::shared_ptr<SlabHeap>> object_slabs;
+
     // Note: keep the member order below in order to perform correct destruction.
     // Thread manager is destructed before process list in order to Stop threads and clear thread
     // info from their parent processes first. Timer manager is destructed after process list
@@ -295,6 +319,9 @@ private:
     std::unique_ptr<SharedPage::Handler> shared_page_handler;
 
     std::unique_ptr<IPCDebugger::Recorder> ipc_recorder;
+    std::unique_ptr<IPCDebugger::Profiler> ipc_profiler;
+    std::unique_ptr<SVCTraceRecorder> svc_trace_recorder;
+    std::unique_ptr<IdleLoopDetector> idle_loop_detector;
 
     u32 next_thread_id;
 };
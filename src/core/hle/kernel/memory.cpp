@@ -8,6 +8,7 @@
 #include <memory>
 #include <utility>
 #include <vector>
+#include "common/alignment.h"
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -181,71 +182,91 @@ void MemoryRegionInfo::Reset(u32 base, u32 size) {
     this->base = base;
     this->size = size;
     used = 0;
-    free_blocks.clear();
 
     // mark the entire region as free
-    free_blocks.insert(Interval::right_open(base, base + size));
+    free_pages.Reset(size / Memory::PAGE_SIZE);
+}
+
+/// Returns the pages of the region that contain the given range
+static std::pair<u32, u32> GetPageRange(u32 base, u32 offset, u32 size) {
+    const u32 first = (offset - base) / Memory::PAGE_SIZE;
+    const u32 end = Common::AlignUp(offset - base + size, Memory::PAGE_SIZE) / Memory::PAGE_SIZE;
+    return {first, end - first};
 }
 
 MemoryRegionInfo::IntervalSet MemoryRegionInfo::HeapAllocate(u32 size) {
+    const u32 num_pages = Common::AlignUp(size, Memory::PAGE_SIZE) / Memory::PAGE_SIZE;
+    if (num_pages > free_pages.GetFreeCount()) {
+        // There is no enough free space
+        return {};
+    }
+
+    // Allocate from the higher address, taking whole free blocks until the rest fits in one
     IntervalSet result;
-    u32 rest = size;
-
-    // Try allocating from the higher address
-    for (auto iter = free_blocks.rbegin(); iter != free_blocks.rend(); ++iter) {
-        ASSERT(iter->bounds() == boost::icl::interval_bounds::right_open());
-        if (iter->upper() - iter->lower() >= rest) {
-            // Requested size is fulfilled with this block
-            result += Interval(iter->upper() - rest, iter->upper());
-            rest = 0;
-            break;
+    u32 rest = num_pages;
+    u32 limit = free_pages.GetPageCount();
+    while (rest != 0) {
+        auto [first, end] = *free_pages.FindLastFreeRun(limit);
+        if (end - first > rest) {
+            first = end - rest;
         }
-        result += *iter;
-        rest -= iter->upper() - iter->lower();
+        free_pages.MarkUsed(first, end - first);
+        result += Interval(base + first * Memory::PAGE_SIZE, base + end * Memory::PAGE_SIZE);
+        rest -= end - first;
+        limit = first;
     }
 
-    if (rest != 0) {
-        // There is no enough free space
-        return {};
+    // Only hand out the requested size, the rest of its lowest page stays unused
+    const u32 slack = num_pages * Memory::PAGE_SIZE - size;
+    if (slack != 0) {
+        const u32 lowest = result.begin()->lower();
+        result -= Interval(lowest, lowest + slack);
     }
 
-    free_blocks -= result;
     used += size;
     return result;
 }
 
 bool MemoryRegionInfo::LinearAllocate(u32 offset, u32 size) {
-    Interval interval(offset, offset + size);
-    if (!boost::icl::contains(free_blocks, interval)) {
+    if (offset < base || offset - base > this->size || size > this->size - (offset - base)) {
+        // The requested range is outside of the region
+        return false;
+    }
+    const auto [first, count] = GetPageRange(base, offset, size);
+    if (!free_pages.IsFree(first, count)) {
         // The requested range is already allocated
         return false;
     }
-    free_blocks -= interval;
+    free_pages.MarkUsed(first, count);
     used += size;
     return true;
 }
 
 std::optional<u32> MemoryRegionInfo::LinearAllocate(u32 size) {
     // Find the first sufficient continuous block from the lower address
-    for (const auto& interval : free_blocks) {
-        ASSERT(interval.bounds() == boost::icl::interval_bounds::right_open());
-        if (interval.upper() - interval.lower() >= size) {
-            Interval allocated(interval.lower(), interval.lower() + size);
-            free_blocks -= allocated;
-            used += size;
-            return allocated.lower();
-        }
+    const u32 num_pages = Common::AlignUp(size, Memory::PAGE_SIZE) / Memory::PAGE_SIZE;
+    const auto first = free_pages.FindFirstFit(num_pages);
+    if (!first) {
+        // No sufficient block found
+        return {};
     }
 
-    // No sufficient block found
-    return {};
+    free_pages.MarkUsed(*first, num_pages);
+    used += size;
+    return base + *first * Memory::PAGE_SIZE;
 }
 
 void MemoryRegionInfo::Free(u32 offset, u32 size) {
-    Interval interval(offset, offset + size);
-    ASSERT(!boost::icl::intersects(free_blocks, interval)); // must be allocated blocks
-    free_blocks += interval;
+    ASSERT(offset >= base && offset - base <= this->size &&
+           size <= this->size - (offset - base));
+    const auto [first, count] = GetPageRange(base, offset, size);
+    free_pages.MarkFree(first, count); // must be allocated blocks
     used -= size;
 }
 
+MemoryRegionInfo::FragmentationInfo MemoryRegionInfo::GetFragmentationInfo() const {
+    return {free_pages.GetFreeCount() * Memory::PAGE_SIZE,
+            free_pages.GetLargestFreeRun() * Memory::PAGE_SIZE, free_pages.GetFreeRunCount()};
+}
+
 } // namespace Kernel
@@ -7,6 +7,7 @@
 #include <optional>
 #include <boost/icl/interval_set.hpp>
 #include "common/common_types.h"
+#include "core/hle/kernel/page_bitmap.h"
 
 namespace Kernel {
 
@@ -22,7 +23,15 @@ struct MemoryRegionInfo {
     using IntervalSet = boost::icl::interval_set<u32>;
     using Interval = IntervalSet::interval_type;
 
-    IntervalSet free_blocks;
+    /// Free pages of the region, page 0 is at the base of the region. Allocations are rounded up
+    /// to whole pages.
+    PageBitmap free_pages;
+
+    struct FragmentationInfo {
+        u32 free_size;          ///< Free bytes in the region
+        u32 largest_free_block; ///< Size of the largest contiguous free block
+        u32 free_block_count;   ///< Number of separate free blocks
+    };
 
     /**
      * Reset the allocator state
@@ -60,6 +69,12 @@ struct MemoryRegionInfo {
      * @param size the size of the region to free.
      */
     void Free(u32 offset, u32 size);
+
+    /**
+     * Gets statistics about how the free memory of the region is split up. Counting the free
+     * blocks scans the whole region.
+     */
+    FragmentationInfo GetFragmentationInfo() const;
 };
 
 } // namespace Kernel
@@ -27,7 +27,7 @@ Mutex::Mutex(KernelSystem& kernel) : WaitObject(kernel), kernel(kernel) {}
 Mutex::~Mutex() {}
 
 std::shared_ptr<Mutex> KernelSystem::CreateMutex(bool initial_locked, std::string name) {
-    auto mutex{std::make_shared<Mutex>(*this)};
+    auto mutex{MakeObject<Mutex>()};
 
     mutex->lock_count = 0;
     mutex->name = std::move(name);
@@ -109,10 +109,10 @@ void Mutex::UpdatePriority() {
         return;
 
     u32 best_priority = ThreadPrioLowest;
-    for (auto& waiter : GetWaitingThreads()) {
-        if (waiter->current_priority < best_priority)
-            best_priority = waiter->current_priority;
-    }
+    ForEachWaitingThread([&best_priority](const Thread& waiter) {
+        if (waiter.current_priority < best_priority)
+            best_priority = waiter.current_priority;
+    });
 
     if (best_priority != priority) {
         priority = best_priority;
@@ -9,6 +9,7 @@
 #include <string>
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/slab_heap.h"
 
 namespace Kernel {
 
@@ -34,6 +35,8 @@ enum class HandleType : u32 {
     ServerSession,
 };
 
+constexpr std::size_t NumHandleTypes = static_cast<std::size_t>(HandleType::ServerSession) + 1;
+
 enum {
     DEFAULT_STACK_SIZE = 0x4000,
 };
@@ -86,4 +89,23 @@ inline std::shared_ptr<T> DynamicObjectCast(std::shared_ptr<Object> object) {
     return nullptr;
 }
 
+/**
+ * Attempts to downcast the given borrowed Object pointer to a pointer to T, without touching its
+ * reference count.
+ * @return Derived pointer to the object, or `nullptr` if `object` isn't of type T.
+ */
+template <typename T>
+inline T* DynamicObjectCast(Object* object) {
+    if (object != nullptr && object->GetHandleType() == T::HANDLE_TYPE) {
+        return static_cast<T*>(object);
+    }
+    return nullptr;
+}
+
+template <typename T, typename... Args>
+std::shared_ptr<T> KernelSystem::MakeObject(Args&&... args) {
+    const auto& slab = object_slabs[static_cast<std::size_t>(T::HANDLE_TYPE)];
+    return std::allocate_shared<T>(SlabAllocator<T>(slab), *this, std::forward<Args>(args)...);
+}
+
 } // namespace Kernel
@@ -0,0 +1,249 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "common/bit_set.h"
+#include "core/hle/kernel/page_bitmap.h"
+
+namespace Kernel {
+
+namespace {
+
+constexpr u32 PagesPerWord = 64;
+
+/// Mask of the bits [first, end) of a word
+constexpr u64 RangeMask(u32 first, u32 end) {
+    const u64 below_end = end == PagesPerWord ? ~u64{0} : (u64{1} << end) - 1;
+    return below_end & (~u64{0} << first);
+}
+
+} // namespace
+
+PageBitmap::PageBitmap() {
+    Reset(0);
+}
+
+void PageBitmap::Reset(u32 num_pages_) {
+    num_pages = num_pages_;
+    const std::size_t num_words = (num_pages + PagesPerWord - 1) / PagesPerWord;
+    leaf_count = 1;
+    while (leaf_count < num_words) {
+        leaf_count *= 2;
+    }
+
+    words.assign(leaf_count, 0);
+    for (std::size_t i = 0; i < num_words; ++i) {
+        const u32 first_page = static_cast<u32>(i * PagesPerWord);
+        words[i] = RangeMask(0, std::min(PagesPerWord, num_pages - first_page));
+    }
+    tree.assign(leaf_count * 2, {});
+    UpdateTree(0, leaf_count - 1);
+}
+
+u32 PageBitmap::GetFreeRunCount() const {
+    u32 runs = 0;
+    u64 carry = 0;
+    for (const u64 word : words) {
+        // A run starts at every free page whose previous page isn't free
+        runs += Common::CountSetBits(word & ~((word << 1) | carry));
+        carry = word >> (PagesPerWord - 1);
+    }
+    return runs;
+}
+
+bool PageBitmap::IsFree(u32 first, u32 count) const {
+    if (count == 0) {
+        return true;
+    }
+    const u32 end = first + count;
+    if (end < first || end > num_pages) {
+        return false;
+    }
+
+    const std::size_t first_word = first / PagesPerWord;
+    const std::size_t last_word = (end - 1) / PagesPerWord;
+    const u32 first_bit = first % PagesPerWord;
+    const u32 end_bit = end - static_cast<u32>(last_word * PagesPerWord);
+    if (first_word == last_word) {
+        const u64 mask = RangeMask(first_bit, end_bit);
+        return (words[first_word] & mask) == mask;
+    }
+
+    const u64 first_mask = RangeMask(first_bit, PagesPerWord);
+    const u64 last_mask = RangeMask(0, end_bit);
+    if ((words[first_word] & first_mask) != first_mask ||
+        (words[last_word] & last_mask) != last_mask) {
+        return false;
+    }
+
+    // Sum up the free pages of the words in between, from the tree
+    u32 free = 0;
+    std::size_t left = leaf_count + first_word + 1;
+    std::size_t right = leaf_count + last_word;
+    for (; left < right; left /= 2, right /= 2) {
+        if (left & 1) {
+            free += tree[left++].free;
+        }
+        if (right & 1) {
+            free += tree[--right].free;
+        }
+    }
+    return free == (last_word - first_word - 1) * PagesPerWord;
+}
+
+void PageBitmap::MarkUsed(u32 first, u32 count) {
+    Mark(first, count, false);
+}
+
+void PageBitmap::MarkFree(u32 first, u32 count) {
+    Mark(first, count, true);
+}
+
+std::optional<u32> PageBitmap::FindFirstFit(u32 count) const {
+    if (count == 0) {
+        return 0;
+    }
+    if (tree[1].longest < count) {
+        return std::nullopt;
+    }
+
+    std::size_t node = 1;
+    u32 node_first = 0;
+    u32 child_pages = static_cast<u32>(leaf_count * PagesPerWord / 2);
+    while (node < leaf_count) {
+        const Summary& left = tree[node * 2];
+        const Summary& right = tree[node * 2 + 1];
+        if (left.longest >= count) {
+            node = node * 2;
+        } else if (left.suffix + right.prefix >= count) {
+            // The run straddles both children
+            return node_first + child_pages - left.suffix;
+        } else {
+            node = node * 2 + 1;
+            node_first += child_pages;
+        }
+        child_pages /= 2;
+    }
+
+    // The run fits in this word: find the first bit starting count free bits
+    const u64 word = words[node - leaf_count];
+    u64 starts = word;
+    for (u32 i = 1; i < count; ++i) {
+        starts &= word >> i;
+    }
+    return node_first + Common::LeastSignificantSetBit(starts);
+}
+
+std::optional<std::pair<u32, u32>> PageBitmap::FindLastFreeRun(u32 limit) const {
+    limit = std::min(limit, num_pages);
+    const auto last = FindLastFree(1, 0, static_cast<u32>(leaf_count * PagesPerWord), limit);
+    if (!last) {
+        return std::nullopt;
+    }
+
+    // Walk down to the first page of the run, a whole word at a time where possible
+    const u32 end = *last + 1;
+    std::size_t word_index = *last / PagesPerWord;
+    u32 bit = *last % PagesPerWord;
+    while (true) {
+        const u64 below = words[word_index] | ~RangeMask(0, bit + 1);
+        if (below != ~u64{0}) {
+            const u32 first_page = Common::MostSignificantSetBit(~below) + 1;
+            return std::make_pair(static_cast<u32>(word_index * PagesPerWord) + first_page, end);
+        }
+        if (word_index == 0) {
+            return std::make_pair(0u, end);
+        }
+        --word_index;
+        bit = PagesPerWord - 1;
+    }
+}
+
+PageBitmap::Summary PageBitmap::Summarize(u64 word) {
+    Summary summary;
+    summary.free = Common::CountSetBits(word);
+    summary.prefix = word == ~u64{0} ? PagesPerWord : Common::LeastSignificantSetBit(~word);
+    summary.suffix =
+        word == ~u64{0} ? PagesPerWord : PagesPerWord - 1 - Common::MostSignificantSetBit(~word);
+    // Every step shortens all the runs by one page
+    for (u64 runs = word; runs != 0; runs &= runs << 1) {
+        ++summary.longest;
+    }
+    return summary;
+}
+
+PageBitmap::Summary PageBitmap::Combine(const Summary& left, const Summary& right,
+                                        u32 child_pages) {
+    Summary summary;
+    summary.free = left.free + right.free;
+    summary.prefix = left.prefix == child_pages ? child_pages + right.prefix : left.prefix;
+    summary.suffix = right.suffix == child_pages ? child_pages + left.suffix : right.suffix;
+    summary.longest = std::max({left.longest, right.longest, left.suffix + right.prefix});
+    return summary;
+}
+
+void PageBitmap::Mark(u32 first, u32 count, bool free) {
+    if (count == 0) {
+        return;
+    }
+    const u32 end = first + count;
+    ASSERT(end > first && end <= num_pages);
+
+    const std::size_t first_word = first / PagesPerWord;
+    const std::size_t last_word = (end - 1) / PagesPerWord;
+    for (std::size_t i = first_word; i <= last_word; ++i) {
+        const u32 word_first = static_cast<u32>(i * PagesPerWord);
+        const u64 mask = RangeMask(std::max(first, word_first) - word_first,
+                                   std::min(end - word_first, PagesPerWord));
+        if (free) {
+            ASSERT_MSG((words[i] & mask) == 0, "Freeing pages that are already free");
+            words[i] |= mask;
+        } else {
+            ASSERT_MSG((words[i] & mask) == mask, "Allocating pages that are already in use");
+            words[i] &= ~mask;
+        }
+    }
+    UpdateTree(first_word, last_word);
+}
+
+void PageBitmap::UpdateTree(std::size_t first_word, std::size_t last_word) {
+    for (std::size_t i = first_word; i <= last_word; ++i) {
+        tree[leaf_count + i] = Summarize(words[i]);
+    }
+
+    u32 child_pages = PagesPerWord;
+    for (std::size_t first = (leaf_count + first_word) / 2, last = (leaf_count + last_word) / 2;
+         first != 0; first /= 2, last /= 2) {
+        for (std::size_t node = first; node <= last; ++node) {
+            tree[node] = Combine(tree[node * 2], tree[node * 2 + 1], child_pages);
+        }
+        child_pages *= 2;
+    }
+}
+
+std::optional<u32> PageBitmap::FindLastFree(std::size_t node, u32 node_first, u32 node_pages,
+                                            u32 limit) const {
+    if (tree[node].free == 0 || node_first >= limit) {
+        return std::nullopt;
+    }
+
+    if (node >= leaf_count) {
+        const u64 word =
+            words[node - leaf_count] & RangeMask(0, std::min(limit - node_first, PagesPerWord));
+        if (word == 0) {
+            return std::nullopt;
+        }
+        return node_first + Common::MostSignificantSetBit(word);
+    }
+
+    const u32 child_pages = node_pages / 2;
+    const auto last = FindLastFree(node * 2 + 1, node_first + child_pages, child_pages, limit);
+    if (last) {
+        return last;
+    }
+    return FindLastFree(node * 2, node_first, child_pages, limit);
+}
+
+} // namespace Kernel
@@ -0,0 +1,88 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <optional>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Kernel {
+
+/**
+ * Bitmap of the free pages of a memory region, with a summary tree over its 64-page words. Every
+ * node of the tree knows how many pages are free below it and the longest free run, so finding a
+ * place for an allocation is O(log n). Marking a range touches one word per 64 pages, plus their
+ * ancestors in the tree.
+ */
+class PageBitmap {
+public:
+    PageBitmap();
+
+    /// Resizes the bitmap to the given number of pages, all of them free.
+    void Reset(u32 num_pages);
+
+    u32 GetPageCount() const {
+        return num_pages;
+    }
+
+    u32 GetFreeCount() const {
+        return tree[1].free;
+    }
+
+    u32 GetLargestFreeRun() const {
+        return tree[1].longest;
+    }
+
+    /// Returns the number of separate runs of free pages. O(n), meant for statistics.
+    u32 GetFreeRunCount() const;
+
+    /// Checks whether all the pages in [first, first + count) are free.
+    bool IsFree(u32 first, u32 count) const;
+
+    /// Marks the pages in [first, first + count) as allocated. They must all be free.
+    void MarkUsed(u32 first, u32 count);
+
+    /// Marks the pages in [first, first + count) as free. They must all be allocated.
+    void MarkFree(u32 first, u32 count);
+
+    /**
+     * Finds the lowest run of at least count free pages.
+     * @returns the first page of the run, or nothing if there is no such run.
+     */
+    std::optional<u32> FindFirstFit(u32 count) const;
+
+    /**
+     * Finds the highest run of free pages below limit.
+     * @returns the run as [first, end) with end <= limit, or nothing if there is no free page.
+     */
+    std::optional<std::pair<u32, u32>> FindLastFreeRun(u32 limit) const;
+
+private:
+    struct Summary {
+        u32 free = 0;    ///< Number of free pages
+        u32 prefix = 0;  ///< Length of the free run starting at the first page
+        u32 suffix = 0;  ///< Length of the free run ending at the last page
+        u32 longest = 0; ///< Length of the longest free run
+    };
+
+    static Summary Summarize(u64 word);
+    static Summary Combine(const Summary& left, const Summary& right, u32 child_pages);
+
+    void Mark(u32 first, u32 count, bool free);
+    void UpdateTree(std::size_t first_word, std::size_t last_word);
+    std::optional<u32> FindLastFree(std::size_t node, u32 node_first, u32 node_pages,
+                                    u32 limit) const;
+
+    u32 num_pages = 0;
+    /// Number of leaves of the tree, a power of two. Words past the bitmap have no free page.
+    std::size_t leaf_count = 0;
+    /// One bit per page, set when the page is free. Bit 0 of word 0 is the first page.
+    std::vector<u64> words;
+    /// Summaries of the words, as a binary heap: node 1 is the root, leaves start at leaf_count.
+    std::vector<Summary> tree;
+};
+
+} // namespace Kernel
@@ -129,6 +129,9 @@ void Process::Run(s32 main_thread_priority, u32 stack_size) {
     MapSegment(codeset->RODataSegment(), VMAPermission::Read, MemoryState::Code);
     MapSegment(codeset->DataSegment(), VMAPermission::ReadWrite, MemoryState::Private);
 
+    // The image now lives in the process memory, don't keep a second copy of it around
+    std::vector<u8>().swap(codeset->memory);
+
     // Allocate and map stack
     HeapAllocate(Memory::HEAP_VADDR_END - stack_size, stack_size, VMAPermission::ReadWrite,
                  MemoryState::Locked, true);
@@ -237,7 +240,9 @@ ResultVal<VAddr> Process::LinearAllocate(VAddr target, u32 size, VMAPermission p
     if (target == 0) {
         auto offset = memory_region->LinearAllocate(size);
         if (!offset) {
-            LOG_ERROR(Kernel, "Not enough space");
+            const auto info = memory_region->GetFragmentationInfo();
+            LOG_ERROR(Kernel, "Not enough space, free={:08X} in {} blocks, largest block={:08X}",
+                      info.free_size, info.free_block_count, info.largest_free_block);
             return ERR_OUT_OF_HEAP_MEMORY;
         }
         physical_offset = *offset;
@@ -30,7 +30,7 @@ ServerSession::~ServerSession() {
 
 ResultVal<std::shared_ptr<ServerSession>> ServerSession::Create(KernelSystem& kernel,
                                                                 std::string name) {
-    auto server_session{std::make_shared<ServerSession>(kernel)};
+    auto server_session{kernel.MakeObject<ServerSession>()};
 
     server_session->name = std::move(name);
     server_session->parent = nullptr;
@@ -67,13 +67,23 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
 
     // If this ServerSession has an associated HLE handler, forward the request to it.
     if (hle_handler != nullptr) {
-        std::array<u32_le, IPC::COMMAND_BUFFER_LENGTH + 2 * IPC::MAX_STATIC_BUFFERS> cmd_buf;
         Kernel::Process* current_process = thread->owner_process;
-        kernel.memory.ReadBlock(*current_process, thread->GetCommandBufferAddress(), cmd_buf.data(),
-                                cmd_buf.size() * sizeof(u32));
+        constexpr std::size_t buffer_size =
+            IPC::COMMAND_BUFFER_WITH_STATIC_BUFFERS_LENGTH * sizeof(u32);
+
+        // The command buffer lives in the TLS page, translate it in place when it is plain memory
+        std::array<u32_le, IPC::COMMAND_BUFFER_WITH_STATIC_BUFFERS_LENGTH> cmd_buf_copy;
+        u32_le* cmd_buf = reinterpret_cast<u32_le*>(kernel.memory.GetContiguousPointer(
+            *current_process, thread->GetCommandBufferAddress(), buffer_size));
+        const bool in_place = cmd_buf != nullptr;
+        if (!in_place) {
+            cmd_buf = cmd_buf_copy.data();
+            kernel.memory.ReadBlock(*current_process, thread->GetCommandBufferAddress(), cmd_buf,
+                                    buffer_size);
+        }
 
         Kernel::HLERequestContext context(kernel, SharedFrom(this), thread.get());
-        context.PopulateFromIncomingCommandBuffer(cmd_buf.data(), *current_process);
+        context.PopulateFromIncomingCommandBuffer(cmd_buf, *current_process);
 
         hle_handler->HandleSyncRequest(context);
 
@@ -83,9 +93,11 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
         // put the thread to sleep then the writing of the command buffer will be deferred to the
         // wakeup callback.
         if (thread->status == Kernel::ThreadStatus::Running) {
-            context.WriteToOutgoingCommandBuffer(cmd_buf.data(), *current_process);
-            kernel.memory.WriteBlock(*current_process, thread->GetCommandBufferAddress(),
-                                     cmd_buf.data(), cmd_buf.size() * sizeof(u32));
+            context.WriteToOutgoingCommandBuffer(cmd_buf, *current_process);
+            if (!in_place) {
+                kernel.memory.WriteBlock(*current_process, thread->GetCommandBufferAddress(),
+                                         cmd_buf, buffer_size);
+            }
         }
     }
 
@@ -123,7 +135,7 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
 KernelSystem::SessionPair KernelSystem::CreateSessionPair(const std::string& name,
                                                           std::shared_ptr<ClientPort> port) {
     auto server_session = ServerSession::Create(*this, name + "_Server").Unwrap();
-    auto client_session{std::make_shared<ClientSession>(*this)};
+    auto client_session{MakeObject<ClientSession>()};
     client_session->name = name + "_Client";
 
     std::shared_ptr<Session> parent(new Session);
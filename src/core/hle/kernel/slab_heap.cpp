@@ -0,0 +1,78 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <new>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "core/hle/kernel/slab_heap.h"
+
+namespace Kernel {
+
+namespace {
+
+std::size_t GetBlockSize(std::size_t size) {
+    return Common::AlignUp(std::max(size, sizeof(void*)), alignof(std::max_align_t));
+}
+
+} // namespace
+
+SlabHeap::SlabHeap(std::size_t objects_per_chunk) : objects_per_chunk(objects_per_chunk) {
+    ASSERT(objects_per_chunk != 0);
+}
+
+SlabHeap::~SlabHeap() {
+    // The allocators keep the heap alive, so every block has been returned by now
+    ASSERT(used_count == 0);
+}
+
+void* SlabHeap::Allocate(std::size_t size) {
+    std::lock_guard lock{mutex};
+    if (block_size == 0) {
+        block_size = GetBlockSize(size);
+    } else if (GetBlockSize(size) != block_size) {
+        return ::operator new(size);
+    }
+
+    if (free_list == nullptr) {
+        Grow();
+    }
+    FreeBlock* block = free_list;
+    free_list = block->next;
+    ++used_count;
+    return block;
+}
+
+void SlabHeap::Free(void* block, std::size_t size) {
+    std::lock_guard lock{mutex};
+    if (GetBlockSize(size) != block_size) {
+        ::operator delete(block);
+        return;
+    }
+
+    FreeBlock* free_block = new (block) FreeBlock{free_list};
+    free_list = free_block;
+    --used_count;
+}
+
+std::size_t SlabHeap::GetUsedCount() const {
+    std::lock_guard lock{mutex};
+    return used_count;
+}
+
+std::size_t SlabHeap::GetCapacity() const {
+    std::lock_guard lock{mutex};
+    return chunks.size() * objects_per_chunk;
+}
+
+void SlabHeap::Grow() {
+    // new[] aligns to alignof(std::max_align_t), which the block size is a multiple of
+    auto& chunk = chunks.emplace_back(new u8[block_size * objects_per_chunk]);
+    // Link the blocks in address order, so that consecutive objects end up next to each other
+    for (std::size_t i = objects_per_chunk; i-- > 0;) {
+        free_list = new (chunk.get() + i * block_size) FreeBlock{free_list};
+    }
+}
+
+} // namespace Kernel
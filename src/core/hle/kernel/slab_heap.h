@@ -0,0 +1,96 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Kernel {
+
+/**
+ * Free list of fixed size blocks, carved out of chunks that are only released along with the heap.
+ * Every kernel object type gets its own heap, so creating and destroying objects recycles their
+ * memory instead of going through the system allocator.
+ * The block size is set by the first allocation. Requests of any other size, like the ones of
+ * objects that derive from the heap's type, go to the system allocator.
+ */
+class SlabHeap final : NonCopyable {
+public:
+    /**
+     * @param objects_per_chunk Number of blocks allocated at once, the first chunk is only
+     *                          allocated by the first allocation.
+     */
+    explicit SlabHeap(std::size_t objects_per_chunk);
+    ~SlabHeap();
+
+    void* Allocate(std::size_t size);
+    void Free(void* block, std::size_t size);
+
+    /// Returns the number of blocks in use, for debugging purposes.
+    std::size_t GetUsedCount() const;
+
+    /// Returns the number of blocks allocated so far, used or not.
+    std::size_t GetCapacity() const;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    void Grow();
+
+    const std::size_t objects_per_chunk;
+    std::size_t block_size = 0;
+    std::size_t used_count = 0;
+    std::vector<std::unique_ptr<u8[]>> chunks;
+    FreeBlock* free_list = nullptr;
+    mutable std::mutex mutex;
+};
+
+/**
+ * Allocator handing out the blocks of a SlabHeap, to be used with std::allocate_shared so that
+ * the object and its reference counts share one block. The control block of the shared_ptr keeps
+ * the heap alive until the last object is gone.
+ */
+template <typename T>
+class SlabAllocator {
+public:
+    using value_type = T;
+
+    explicit SlabAllocator(std::shared_ptr<SlabHeap> heap) : heap(std::move(heap)) {}
+
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U>& other) : heap(other.heap) {}
+
+    T* allocate(std::size_t n) {
+        static_assert(alignof(T) <= alignof(std::max_align_t));
+        return static_cast<T*>(heap->Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        heap->Free(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const SlabAllocator<U>& other) const {
+        return heap == other.heap;
+    }
+
+    template <typename U>
+    bool operator!=(const SlabAllocator<U>& other) const {
+        return heap != other.heap;
+    }
+
+private:
+    template <typename U>
+    friend class SlabAllocator;
+
+    std::shared_ptr<SlabHeap> heap;
+};
+
+} // namespace Kernel
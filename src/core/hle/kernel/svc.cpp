@@ -3,8 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cinttypes>
+#include <limits>
 #include <map>
+#include <boost/container/small_vector.hpp>
 #include <fmt/format.h>
 #include "common/logging/log.h"
 #include "common/microprofile.h"
@@ -18,6 +22,7 @@
 #include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/idle_loop_detector.h"
 #include "core/hle/kernel/ipc.h"
 #include "core/hle/kernel/ipc_debugger/recorder.h"
 #include "core/hle/kernel/memory.h"
@@ -30,6 +35,7 @@
 #include "core/hle/kernel/session.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/kernel/svc.h"
+#include "core/hle/kernel/svc_trace.h"
 #include "core/hle/kernel/svc_wrapper.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/timer.h"
@@ -38,6 +44,7 @@
 #include "core/hle/lock.h"
 #include "core/hle/result.h"
 #include "core/hle/service/service.h"
+#include "core/settings.h"
 
 namespace Kernel {
 
@@ -100,11 +107,10 @@ enum class SystemInfoMemUsageRegion {
 
 class SVC : public SVCWrapper<SVC> {
 public:
-    SVC(Core::System& system);
+    explicit SVC(KernelSystem& kernel);
     void CallSVC(u32 immediate);
 
 private:
-    Core::System& system;
     Kernel::KernelSystem& kernel;
     Memory::MemorySystem& memory;
 
@@ -112,6 +118,7 @@ private:
 
     // ARM interfaces
 
+    ARM_Interface& GetRunningCore();
     u32 GetReg(std::size_t n);
     void SetReg(std::size_t n, u32 value);
 
@@ -184,6 +191,14 @@ private:
 
     static const FunctionDef SVC_Table[];
     static const FunctionDef* GetSVCInfo(u32 func_num);
+
+    /// Calls an SVC handler and records the call in the SVC trace.
+    void CallTraced(u32 immediate, FunctionDef::Func func);
+
+    /// Idles the running core until its next event if the calling thread is in a spin loop.
+    void SkipIdleLoop();
+
+    friend const char* GetSVCName(u32 svc_id);
 };
 
 /// Map application or GSP heap memory
@@ -299,7 +314,7 @@ void SVC::ExitProcess() {
     // Kill the current thread
     kernel.GetCurrentThreadManager().GetCurrentThread()->Stop();
 
-    system.PrepareReschedule();
+    kernel.PrepareReschedule();
 }
 
 /// Maps a memory block to specified address
@@ -378,6 +393,7 @@ ResultCode SVC::ConnectToPort(Handle* out_handle, VAddr port_name_address) {
 
 /// Makes a blocking IPC call to an OS service.
 ResultCode SVC::SendSyncRequest(Handle handle) {
+    // Keep a reference: the HLE handler may close the handle while the request is running
     std::shared_ptr<ClientSession> session =
         kernel.GetCurrentProcess()->handle_table.Get<ClientSession>(handle);
     if (session == nullptr) {
@@ -386,7 +402,7 @@ ResultCode SVC::SendSyncRequest(Handle handle) {
 
     LOG_TRACE(Kernel_SVC, "called handle=0x{:08X}({})", handle, session->GetName());
 
-    system.PrepareReschedule();
+    kernel.PrepareReschedule();
 
     auto thread = SharedFrom(kernel.GetCurrentThreadManager().GetCurrentThread());
 
@@ -403,9 +419,23 @@ ResultCode SVC::CloseHandle(Handle handle) {
     return kernel.GetCurrentProcess()->handle_table.Close(handle);
 }
 
+/// Wait objects looked up for a wait, borrowed from the handle table of the current process
+using BorrowedWaitObjects = boost::container::small_vector<WaitObject*, 16>;
+
+/// Takes references to the objects that a thread is about to sleep on
+static std::vector<std::shared_ptr<WaitObject>> ShareWaitObjects(
+    const BorrowedWaitObjects& objects) {
+    std::vector<std::shared_ptr<WaitObject>> shared_objects;
+    shared_objects.reserve(objects.size());
+    for (WaitObject* object : objects) {
+        shared_objects.push_back(SharedFrom(object));
+    }
+    return shared_objects;
+}
+
 /// Wait for a handle to synchronize, timeout after the specified nanoseconds
 ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
-    auto object = kernel.GetCurrentProcess()->handle_table.Get<WaitObject>(handle);
+    WaitObject* object = kernel.GetCurrentProcess()->handle_table.GetBorrowed<WaitObject>(handle);
     Thread* thread = kernel.GetCurrentThreadManager().GetCurrentThread();
 
     if (object == nullptr)
@@ -419,7 +449,7 @@ ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
         if (nano_seconds == 0)
             return RESULT_TIMEOUT;
 
-        thread->wait_objects = {object};
+        thread->wait_objects = {SharedFrom(object)};
         object->AddWaitingThread(SharedFrom(thread));
         thread->status = ThreadStatus::WaitSynchAny;
 
@@ -442,7 +472,7 @@ ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
             // don't have to do anything else here.
         };
 
-        system.PrepareReschedule();
+        kernel.PrepareReschedule();
 
         // Note: The output of this SVC will be set to RESULT_SUCCESS if the thread
         // resumes due to a signal in its wait objects.
@@ -471,12 +501,12 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
     if (handle_count < 0)
         return ERR_OUT_OF_RANGE;
 
-    using ObjectPtr = std::shared_ptr<WaitObject>;
-    std::vector<ObjectPtr> objects(handle_count);
+    using ObjectPtr = WaitObject*;
+    BorrowedWaitObjects objects(handle_count);
 
     for (int i = 0; i < handle_count; ++i) {
         Handle handle = memory.Read32(handles_address + i * sizeof(Handle));
-        auto object = kernel.GetCurrentProcess()->handle_table.Get<WaitObject>(handle);
+        auto object = kernel.GetCurrentProcess()->handle_table.GetBorrowed<WaitObject>(handle);
         if (object == nullptr)
             return ERR_INVALID_HANDLE;
         objects[i] = object;
@@ -510,7 +540,7 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
             object->AddWaitingThread(SharedFrom(thread));
         }
 
-        thread->wait_objects = std::move(objects);
+        thread->wait_objects = ShareWaitObjects(objects);
 
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
@@ -530,7 +560,7 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
             // The wait_all case does not update the output index.
         };
 
-        system.PrepareReschedule();
+        kernel.PrepareReschedule();
 
         // This value gets set to -1 by default in this case, it is not modified after this.
         *out = -1;
@@ -545,7 +575,7 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
 
         if (itr != objects.end()) {
             // We found a ready object, acquire it and set the result value
-            WaitObject* object = itr->get();
+            WaitObject* object = *itr;
             object->Acquire(thread);
             *out = static_cast<s32>(std::distance(objects.begin(), itr));
             return RESULT_SUCCESS;
@@ -563,11 +593,11 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
 
         // Add the thread to each of the objects' waiting threads.
         for (std::size_t i = 0; i < objects.size(); ++i) {
-            WaitObject* object = objects[i].get();
+            WaitObject* object = objects[i];
             object->AddWaitingThread(SharedFrom(thread));
         }
 
-        thread->wait_objects = std::move(objects);
+        thread->wait_objects = ShareWaitObjects(objects);
 
         // Note: If no handles and no timeout were given, then the thread will deadlock, this is
         // consistent with hardware behavior.
@@ -590,7 +620,7 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
             thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
         };
 
-        system.PrepareReschedule();
+        kernel.PrepareReschedule();
 
         // Note: The output of this SVC will be set to RESULT_SUCCESS if the thread resumes due to a
         // signal in one of its wait objects.
@@ -639,14 +669,14 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
     if (handle_count < 0)
         return ERR_OUT_OF_RANGE;
 
-    using ObjectPtr = std::shared_ptr<WaitObject>;
-    std::vector<ObjectPtr> objects(handle_count);
+    using ObjectPtr = WaitObject*;
+    BorrowedWaitObjects objects(handle_count);
 
-    std::shared_ptr<Process> current_process = kernel.GetCurrentProcess();
+    Process* current_process = kernel.GetCurrentProcess().get();
 
     for (int i = 0; i < handle_count; ++i) {
         Handle handle = memory.Read32(handles_address + i * sizeof(Handle));
-        auto object = current_process->handle_table.Get<WaitObject>(handle);
+        auto object = current_process->handle_table.GetBorrowed<WaitObject>(handle);
         if (object == nullptr)
             return ERR_INVALID_HANDLE;
         objects[i] = object;
@@ -658,7 +688,7 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
     u32 cmd_buff_header = memory.Read32(thread->GetCommandBufferAddress());
     IPC::Header header{cmd_buff_header};
     if (reply_target != 0 && header.command_id != 0xFFFF) {
-        auto session = current_process->handle_table.Get<ServerSession>(reply_target);
+        auto session = current_process->handle_table.GetBorrowed<ServerSession>(reply_target);
         if (session == nullptr)
             return ERR_INVALID_HANDLE;
 
@@ -706,7 +736,7 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
 
     if (itr != objects.end()) {
         // We found a ready object, acquire it and set the result value
-        WaitObject* object = itr->get();
+        WaitObject* object = *itr;
         object->Acquire(thread);
         *index = static_cast<s32>(std::distance(objects.begin(), itr));
 
@@ -724,11 +754,11 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
 
     // Add the thread to each of the objects' waiting threads.
     for (std::size_t i = 0; i < objects.size(); ++i) {
-        WaitObject* object = objects[i].get();
+        WaitObject* object = objects[i];
         object->AddWaitingThread(SharedFrom(thread));
     }
 
-    thread->wait_objects = std::move(objects);
+    thread->wait_objects = ShareWaitObjects(objects);
 
     thread->wakeup_callback = [& kernel = this->kernel, &memory = this->memory](
                                   ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
@@ -747,7 +777,7 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
         thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
     };
 
-    system.PrepareReschedule();
+    kernel.PrepareReschedule();
 
     // Note: The output of this SVC will be set to RESULT_SUCCESS if the thread resumes due to a
     // signal in one of its wait objects, or to 0xC8A01836 if there was a translation error.
@@ -770,8 +800,8 @@ ResultCode SVC::ArbitrateAddress(Handle handle, u32 address, u32 type, u32 value
     LOG_TRACE(Kernel_SVC, "called handle=0x{:08X}, address=0x{:08X}, type=0x{:08X}, value=0x{:08X}",
               handle, address, type, value);
 
-    std::shared_ptr<AddressArbiter> arbiter =
-        kernel.GetCurrentProcess()->handle_table.Get<AddressArbiter>(handle);
+    AddressArbiter* arbiter =
+        kernel.GetCurrentProcess()->handle_table.GetBorrowed<AddressArbiter>(handle);
     if (arbiter == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -780,7 +810,7 @@ ResultCode SVC::ArbitrateAddress(Handle handle, u32 address, u32 type, u32 value
                                   static_cast<ArbitrationType>(type), address, value, nanoseconds);
 
     // TODO(Subv): Identify in which specific cases this call should cause a reschedule.
-    system.PrepareReschedule();
+    kernel.PrepareReschedule();
 
     return res;
 }
@@ -923,7 +953,7 @@ ResultCode SVC::CreateThread(Handle* out_handle, u32 entry_point, u32 arg, VAddr
 
     CASCADE_RESULT(*out_handle, current_process->handle_table.Create(std::move(thread)));
 
-    system.PrepareReschedule();
+    kernel.PrepareReschedule();
 
     LOG_TRACE(Kernel_SVC,
               "called entrypoint=0x{:08X} ({}), arg=0x{:08X}, stacktop=0x{:08X}, "
@@ -935,16 +965,15 @@ ResultCode SVC::CreateThread(Handle* out_handle, u32 entry_point, u32 arg, VAddr
 
 /// Called when a thread exits
 void SVC::ExitThread() {
-    LOG_TRACE(Kernel_SVC, "called, pc=0x{:08X}", system.GetRunningCore().GetPC());
+    LOG_TRACE(Kernel_SVC, "called, pc=0x{:08X}", GetRunningCore().GetPC());
 
     kernel.GetCurrentThreadManager().ExitCurrentThread();
-    system.PrepareReschedule();
+    kernel.PrepareReschedule();
 }
 
 /// Gets the priority for the specified thread
 ResultCode SVC::GetThreadPriority(u32* priority, Handle handle) {
-    const std::shared_ptr<Thread> thread =
-        kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle);
+    const Thread* thread = kernel.GetCurrentProcess()->handle_table.GetBorrowed<Thread>(handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -958,7 +987,7 @@ ResultCode SVC::SetThreadPriority(Handle handle, u32 priority) {
         return ERR_OUT_OF_RANGE;
     }
 
-    std::shared_ptr<Thread> thread = kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle);
+    Thread* thread = kernel.GetCurrentProcess()->handle_table.GetBorrowed<Thread>(handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -976,14 +1005,14 @@ ResultCode SVC::SetThreadPriority(Handle handle, u32 priority) {
     for (auto& mutex : thread->pending_mutexes)
         mutex->UpdatePriority();
 
-    system.PrepareReschedule();
+    kernel.PrepareReschedule();
     return RESULT_SUCCESS;
 }
 
 /// Create a mutex
 ResultCode SVC::CreateMutex(Handle* out_handle, u32 initial_locked) {
     std::shared_ptr<Mutex> mutex = kernel.CreateMutex(initial_locked != 0);
-    mutex->name = fmt::format("mutex-{:08x}", system.GetRunningCore().GetReg(14));
+    mutex->name = fmt::format("mutex-{:08x}", GetRunningCore().GetReg(14));
     CASCADE_RESULT(*out_handle, kernel.GetCurrentProcess()->handle_table.Create(std::move(mutex)));
 
     LOG_TRACE(Kernel_SVC, "called initial_locked={} : created handle=0x{:08X}",
@@ -996,7 +1025,7 @@ ResultCode SVC::CreateMutex(Handle* out_handle, u32 initial_locked) {
 ResultCode SVC::ReleaseMutex(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called handle=0x{:08X}", handle);
 
-    std::shared_ptr<Mutex> mutex = kernel.GetCurrentProcess()->handle_table.Get<Mutex>(handle);
+    Mutex* mutex = kernel.GetCurrentProcess()->handle_table.GetBorrowed<Mutex>(handle);
     if (mutex == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1037,8 +1066,7 @@ ResultCode SVC::GetProcessIdOfThread(u32* process_id, Handle thread_handle) {
 ResultCode SVC::GetThreadId(u32* thread_id, Handle handle) {
     LOG_TRACE(Kernel_SVC, "called thread=0x{:08X}", handle);
 
-    const std::shared_ptr<Thread> thread =
-        kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle);
+    const Thread* thread = kernel.GetCurrentProcess()->handle_table.GetBorrowed<Thread>(handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1050,7 +1078,7 @@ ResultCode SVC::GetThreadId(u32* thread_id, Handle handle) {
 ResultCode SVC::CreateSemaphore(Handle* out_handle, s32 initial_count, s32 max_count) {
     CASCADE_RESULT(std::shared_ptr<Semaphore> semaphore,
                    kernel.CreateSemaphore(initial_count, max_count));
-    semaphore->name = fmt::format("semaphore-{:08x}", system.GetRunningCore().GetReg(14));
+    semaphore->name = fmt::format("semaphore-{:08x}", GetRunningCore().GetReg(14));
     CASCADE_RESULT(*out_handle,
                    kernel.GetCurrentProcess()->handle_table.Create(std::move(semaphore)));
 
@@ -1063,8 +1091,7 @@ ResultCode SVC::CreateSemaphore(Handle* out_handle, s32 initial_count, s32 max_c
 ResultCode SVC::ReleaseSemaphore(s32* count, Handle handle, s32 release_count) {
     LOG_TRACE(Kernel_SVC, "called release_count={}, handle=0x{:08X}", release_count, handle);
 
-    std::shared_ptr<Semaphore> semaphore =
-        kernel.GetCurrentProcess()->handle_table.Get<Semaphore>(handle);
+    Semaphore* semaphore = kernel.GetCurrentProcess()->handle_table.GetBorrowed<Semaphore>(handle);
     if (semaphore == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1122,7 +1149,7 @@ ResultCode SVC::QueryMemory(MemoryInfo* memory_info, PageInfo* page_info, u32 ad
 ResultCode SVC::CreateEvent(Handle* out_handle, u32 reset_type) {
     std::shared_ptr<Event> evt =
         kernel.CreateEvent(static_cast<ResetType>(reset_type),
-                           fmt::format("event-{:08x}", system.GetRunningCore().GetReg(14)));
+                           fmt::format("event-{:08x}", GetRunningCore().GetReg(14)));
     CASCADE_RESULT(*out_handle, kernel.GetCurrentProcess()->handle_table.Create(std::move(evt)));
 
     LOG_TRACE(Kernel_SVC, "called reset_type=0x{:08X} : created handle=0x{:08X}", reset_type,
@@ -1141,7 +1168,7 @@ ResultCode SVC::DuplicateHandle(Handle* out, Handle handle) {
 ResultCode SVC::SignalEvent(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called event=0x{:08X}", handle);
 
-    std::shared_ptr<Event> evt = kernel.GetCurrentProcess()->handle_table.Get<Event>(handle);
+    Event* evt = kernel.GetCurrentProcess()->handle_table.GetBorrowed<Event>(handle);
     if (evt == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1154,7 +1181,7 @@ ResultCode SVC::SignalEvent(Handle handle) {
 ResultCode SVC::ClearEvent(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called event=0x{:08X}", handle);
 
-    std::shared_ptr<Event> evt = kernel.GetCurrentProcess()->handle_table.Get<Event>(handle);
+    Event* evt = kernel.GetCurrentProcess()->handle_table.GetBorrowed<Event>(handle);
     if (evt == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1166,7 +1193,7 @@ ResultCode SVC::ClearEvent(Handle handle) {
 ResultCode SVC::CreateTimer(Handle* out_handle, u32 reset_type) {
     std::shared_ptr<Timer> timer =
         kernel.CreateTimer(static_cast<ResetType>(reset_type),
-                           fmt ::format("timer-{:08x}", system.GetRunningCore().GetReg(14)));
+                           fmt ::format("timer-{:08x}", GetRunningCore().GetReg(14)));
     CASCADE_RESULT(*out_handle, kernel.GetCurrentProcess()->handle_table.Create(std::move(timer)));
 
     LOG_TRACE(Kernel_SVC, "called reset_type=0x{:08X} : created handle=0x{:08X}", reset_type,
@@ -1178,7 +1205,7 @@ ResultCode SVC::CreateTimer(Handle* out_handle, u32 reset_type) {
 ResultCode SVC::ClearTimer(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called timer=0x{:08X}", handle);
 
-    std::shared_ptr<Timer> timer = kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle);
+    Timer* timer = kernel.GetCurrentProcess()->handle_table.GetBorrowed<Timer>(handle);
     if (timer == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1194,7 +1221,7 @@ ResultCode SVC::SetTimer(Handle handle, s64 initial, s64 interval) {
         return ERR_OUT_OF_RANGE_KERNEL;
     }
 
-    std::shared_ptr<Timer> timer = kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle);
+    Timer* timer = kernel.GetCurrentProcess()->handle_table.GetBorrowed<Timer>(handle);
     if (timer == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1207,7 +1234,7 @@ ResultCode SVC::SetTimer(Handle handle, s64 initial, s64 interval) {
 ResultCode SVC::CancelTimer(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called timer=0x{:08X}", handle);
 
-    std::shared_ptr<Timer> timer = kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle);
+    Timer* timer = kernel.GetCurrentProcess()->handle_table.GetBorrowed<Timer>(handle);
     if (timer == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1224,8 +1251,10 @@ void SVC::SleepThread(s64 nanoseconds) {
 
     // Don't attempt to yield execution if there are no available threads to run,
     // this way we avoid a useless reschedule to the idle thread.
-    if (nanoseconds == 0 && !thread_manager.HaveReadyThreads())
+    if (nanoseconds == 0 && !thread_manager.HaveReadyThreads()) {
+        SkipIdleLoop();
         return;
+    }
 
     // Sleep current thread and check for next thread to schedule
     thread_manager.WaitCurrentThread_Sleep();
@@ -1233,16 +1262,16 @@ void SVC::SleepThread(s64 nanoseconds) {
     // Create an event to wake the thread up after the specified nanosecond delay has passed
     thread_manager.GetCurrentThread()->WakeAfterDelay(nanoseconds);
 
-    system.PrepareReschedule();
+    kernel.PrepareReschedule();
 }
 
 /// This returns the total CPU ticks elapsed since the CPU was powered-on
 s64 SVC::GetSystemTick() {
     // TODO: Use globalTicks here?
-    s64 result = system.GetRunningCore().GetTimer()->GetTicks();
+    s64 result = GetRunningCore().GetTimer()->GetTicks();
     // Advance time to defeat dumb games (like Cubic Ninja) that busy-wait for the frame to end.
     // Measured time between two calls on a 9.2 o3DS with Ninjhax 1.1b
-    system.GetRunningCore().GetTimer()->AddTicks(150);
+    GetRunningCore().GetTimer()->AddTicks(150);
     return result;
 }
 
@@ -1572,6 +1601,13 @@ const SVC::FunctionDef SVC::SVC_Table[] = {
     {0x7D, &SVC::Wrap<&SVC::QueryProcessMemory>, "QueryProcessMemory"},
 };
 
+const char* GetSVCName(u32 svc_id) {
+    if (svc_id >= ARRAY_SIZE(SVC::SVC_Table)) {
+        return nullptr;
+    }
+    return SVC::SVC_Table[svc_id].name;
+}
+
 const SVC::FunctionDef* SVC::GetSVCInfo(u32 func_num) {
     if (func_num >= ARRAY_SIZE(SVC_Table)) {
         LOG_ERROR(Kernel_SVC, "unknown svc=0x{:02X}", func_num);
@@ -1591,27 +1627,86 @@ void SVC::CallSVC(u32 immediate) {
     DEBUG_ASSERT_MSG(kernel.GetCurrentProcess()->status == ProcessStatus::Running,
                      "Running threads from exiting processes is unimplemented");
 
+    if (Settings::values.skip_idle_loops) {
+        ARM_Interface& core = GetRunningCore();
+        const std::array<u32, 4> args{core.GetReg(0), core.GetReg(1), core.GetReg(2),
+                                      core.GetReg(3)};
+        kernel.GetIdleLoopDetector().OnSVC(
+            core.GetID(), kernel.GetCurrentThreadManager().GetCurrentThread()->GetThreadId(),
+            immediate, core.GetPC(), args, core.GetTimer()->GetTicks());
+    }
+
     const FunctionDef* info = GetSVCInfo(immediate);
     if (info) {
         if (info->func) {
-            (this->*(info->func))();
+            if (kernel.GetSVCTraceRecorder().IsEnabled()) {
+                CallTraced(immediate, info->func);
+            } else {
+                (this->*(info->func))();
+            }
         } else {
             LOG_ERROR(Kernel_SVC, "unimplemented SVC function {}(..)", info->name);
         }
     }
 }
 
-SVC::SVC(Core::System& system) : system(system), kernel(system.Kernel()), memory(system.Memory()) {}
+void SVC::CallTraced(u32 immediate, FunctionDef::Func func) {
+    SVCTraceRecord record{};
+    record.ticks = kernel.timing.GetTicks();
+    record.thread_id = kernel.GetCurrentThreadManager().GetCurrentThread()->GetThreadId();
+    record.process_id = kernel.GetCurrentProcess()->process_id;
+    record.svc_id = immediate;
+    for (std::size_t i = 0; i < record.args.size(); ++i) {
+        record.args[i] = GetReg(i);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    (this->*func)();
+    record.host_ns = static_cast<u32>(std::min<s64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                             start)
+            .count(),
+        std::numeric_limits<u32>::max()));
+
+    for (std::size_t i = 0; i < record.results.size(); ++i) {
+        record.results[i] = GetReg(i);
+    }
+    kernel.GetSVCTraceRecorder().Record(record);
+}
+
+void SVC::SkipIdleLoop() {
+    if (!Settings::values.skip_idle_loops) {
+        return;
+    }
+    ARM_Interface& core = GetRunningCore();
+    IdleLoopDetector& detector = kernel.GetIdleLoopDetector();
+    Core::Timing::Timer& timer = *core.GetTimer();
+    if (!detector.IsSpinning(core.GetID()) || timer.GetDowncount() <= 0) {
+        return;
+    }
+
+    // Nothing the loop waits for can change before the next event, which ends the slice
+    detector.RecordSkip(core.GetID(), static_cast<u64>(timer.GetDowncount()));
+    timer.Idle();
+    kernel.PrepareReschedule();
+}
+
+SVC::SVC(KernelSystem& kernel) : kernel(kernel), memory(kernel.memory) {}
+
+ARM_Interface& SVC::GetRunningCore() {
+    return *kernel.current_cpu;
+}
 
 u32 SVC::GetReg(std::size_t n) {
-    return system.GetRunningCore().GetReg(static_cast<int>(n));
+    return GetRunningCore().GetReg(static_cast<int>(n));
 }
 
 void SVC::SetReg(std::size_t n, u32 value) {
-    system.GetRunningCore().SetReg(static_cast<int>(n), value);
+    GetRunningCore().SetReg(static_cast<int>(n), value);
 }
 
-SVCContext::SVCContext(Core::System& system) : impl(std::make_unique<SVC>(system)) {}
+SVCContext::SVCContext(Core::System& system) : SVCContext(system.Kernel()) {}
+SVCContext::SVCContext(KernelSystem& kernel) : impl(std::make_unique<SVC>(kernel)) {}
 SVCContext::~SVCContext() = default;
 
 void SVCContext::CallSVC(u32 immediate) {
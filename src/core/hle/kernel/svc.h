@@ -13,11 +13,14 @@ class System;
 
 namespace Kernel {
 
+class KernelSystem;
 class SVC;
 
 class SVCContext {
 public:
     SVCContext(Core::System& system);
+    /// Runs the SVCs on the registers of the kernel's running CPU, which needn't be a real core.
+    explicit SVCContext(KernelSystem& kernel);
     ~SVCContext();
     void CallSVC(u32 immediate);
 
@@ -25,4 +28,7 @@ private:
     std::unique_ptr<SVC> impl;
 };
 
+/// Returns the name of an SVC, or nullptr if there is no SVC with that ID.
+const char* GetSVCName(u32 svc_id);
+
 } // namespace Kernel
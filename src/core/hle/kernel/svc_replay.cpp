@@ -0,0 +1,412 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fmt/format.h>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/arm/arm_interface.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/resource_limit.h"
+#include "core/hle/kernel/svc_replay.h"
+#include "core/hle/kernel/svc_trace.h"
+#include "core/hle/kernel/thread.h"
+#include "core/memory.h"
+#include "core/mmio.h"
+
+namespace Kernel {
+
+namespace {
+
+/// A CPU that only holds registers, for the SVC handlers to read their arguments from
+class ReplayCPU final : public ARM_Interface {
+public:
+    using ARM_Interface::ARM_Interface;
+
+    class Context final : public ThreadContext {
+    public:
+        void Reset() override {
+            cpu_registers = {};
+            cpsr = 0;
+            fpu_registers = {};
+            fpscr = 0;
+            fpexc = 0;
+        }
+
+        u32 GetCpuRegister(std::size_t index) const override {
+            return cpu_registers[index];
+        }
+        void SetCpuRegister(std::size_t index, u32 value) override {
+            cpu_registers[index] = value;
+        }
+        u32 GetCpsr() const override {
+            return cpsr;
+        }
+        void SetCpsr(u32 value) override {
+            cpsr = value;
+        }
+        u32 GetFpuRegister(std::size_t index) const override {
+            return fpu_registers[index];
+        }
+        void SetFpuRegister(std::size_t index, u32 value) override {
+            fpu_registers[index] = value;
+        }
+        u32 GetFpscr() const override {
+            return fpscr;
+        }
+        void SetFpscr(u32 value) override {
+            fpscr = value;
+        }
+        u32 GetFpexc() const override {
+            return fpexc;
+        }
+        void SetFpexc(u32 value) override {
+            fpexc = value;
+        }
+
+        std::array<u32, 16> cpu_registers{};
+        u32 cpsr = 0;
+        std::array<u32, 64> fpu_registers{};
+        u32 fpscr = 0;
+        u32 fpexc = 0;
+    };
+
+    void Run() override {
+        UNREACHABLE_MSG("The SVC trace replay can't run guest code");
+    }
+    void Step() override {
+        UNREACHABLE_MSG("The SVC trace replay can't run guest code");
+    }
+
+    void ClearInstructionCache() override {}
+    void InvalidateCacheRange(u32 start_address, std::size_t length) override {}
+    void PageTableChanged() override {}
+    void PrepareReschedule() override {}
+
+    void SetPC(u32 addr) override {
+        context.cpu_registers[15] = addr;
+    }
+    u32 GetPC() const override {
+        return context.cpu_registers[15];
+    }
+    u32 GetReg(int index) const override {
+        return context.cpu_registers[index];
+    }
+    void SetReg(int index, u32 value) override {
+        context.cpu_registers[index] = value;
+    }
+    u32 GetVFPReg(int index) const override {
+        return context.fpu_registers[index];
+    }
+    void SetVFPReg(int index, u32 value) override {
+        context.fpu_registers[index] = value;
+    }
+    u32 GetVFPSystemReg(VFPSystemRegister reg) const override {
+        return reg == VFP_FPSCR ? context.fpscr : reg == VFP_FPEXC ? context.fpexc : 0;
+    }
+    void SetVFPSystemReg(VFPSystemRegister reg, u32 value) override {
+        if (reg == VFP_FPSCR) {
+            context.fpscr = value;
+        } else if (reg == VFP_FPEXC) {
+            context.fpexc = value;
+        }
+    }
+    u32 GetCPSR() const override {
+        return context.cpsr;
+    }
+    void SetCPSR(u32 cpsr) override {
+        context.cpsr = cpsr;
+    }
+    u32 GetCP15Register(CP15Register reg) override {
+        return cp15[reg];
+    }
+    void SetCP15Register(CP15Register reg, u32 value) override {
+        cp15[reg] = value;
+    }
+
+    std::unique_ptr<ThreadContext> NewContext() const override {
+        return std::make_unique<Context>();
+    }
+    void SaveContext(const std::unique_ptr<ThreadContext>& ctx) override {
+        static_cast<Context&>(*ctx) = context;
+    }
+    void LoadContext(const std::unique_ptr<ThreadContext>& ctx) override {
+        context = static_cast<const Context&>(*ctx);
+    }
+
+private:
+    Context context;
+    std::array<u32, CP15_REGISTER_COUNT> cp15{};
+};
+
+/// Guest memory that reads as zeros and ignores writes
+class ReplayMemory final : public Memory::MMIORegion {
+public:
+    bool IsValidAddress(VAddr addr) override {
+        return true;
+    }
+
+    u8 Read8(VAddr addr) override {
+        return 0;
+    }
+    u16 Read16(VAddr addr) override {
+        return 0;
+    }
+    u32 Read32(VAddr addr) override {
+        return 0;
+    }
+    u64 Read64(VAddr addr) override {
+        return 0;
+    }
+
+    bool ReadBlock(VAddr src_addr, void* dest_buffer, std::size_t size) override {
+        std::memset(dest_buffer, 0, size);
+        return true;
+    }
+
+    void Write8(VAddr addr, u8 data) override {}
+    void Write16(VAddr addr, u16 data) override {}
+    void Write32(VAddr addr, u32 data) override {}
+    void Write64(VAddr addr, u64 data) override {}
+
+    bool WriteBlock(VAddr dest_addr, const void* src_buffer, std::size_t size) override {
+        return true;
+    }
+};
+
+constexpr u32 SVCCreateThread = 0x08;
+constexpr u32 SVCCloseHandle = 0x23;
+
+/// Registers holding handles on entry and on return of an SVC, as bit masks
+struct HandleRegisters {
+    u32 svc_id;
+    u8 in;
+    u8 out;
+};
+
+// clang-format off
+constexpr std::array<HandleRegisters, 31> HandleRegisterTable{{
+    {0x08, 0b000, 0b010}, // CreateThread
+    {0x0B, 0b010, 0b000}, // GetThreadPriority
+    {0x0C, 0b001, 0b000}, // SetThreadPriority
+    {0x13, 0b000, 0b010}, // CreateMutex
+    {0x14, 0b001, 0b000}, // ReleaseMutex
+    {0x15, 0b000, 0b010}, // CreateSemaphore
+    {0x16, 0b010, 0b000}, // ReleaseSemaphore
+    {0x17, 0b000, 0b010}, // CreateEvent
+    {0x18, 0b001, 0b000}, // SignalEvent
+    {0x19, 0b001, 0b000}, // ClearEvent
+    {0x1A, 0b000, 0b010}, // CreateTimer
+    {0x1B, 0b001, 0b000}, // SetTimer
+    {0x1C, 0b001, 0b000}, // CancelTimer
+    {0x1D, 0b001, 0b000}, // ClearTimer
+    {0x1E, 0b000, 0b010}, // CreateMemoryBlock
+    {0x1F, 0b001, 0b000}, // MapMemoryBlock
+    {0x20, 0b001, 0b000}, // UnmapMemoryBlock
+    {0x21, 0b000, 0b010}, // CreateAddressArbiter
+    {0x23, 0b001, 0b000}, // CloseHandle
+    {0x24, 0b001, 0b000}, // WaitSynchronization1
+    {0x27, 0b010, 0b010}, // DuplicateHandle
+    {0x2B, 0b010, 0b000}, // GetProcessInfo
+    {0x2C, 0b010, 0b000}, // GetThreadInfo
+    {0x35, 0b010, 0b000}, // GetProcessId
+    {0x36, 0b010, 0b000}, // GetProcessIdOfThread
+    {0x37, 0b010, 0b000}, // GetThreadId
+    {0x38, 0b010, 0b010}, // GetResourceLimit
+    {0x47, 0b000, 0b110}, // CreatePort
+    {0x48, 0b010, 0b010}, // CreateSessionToPort
+    {0x49, 0b000, 0b110}, // CreateSession
+    {0x4A, 0b010, 0b010}, // AcceptSession
+}};
+
+/// SVCs whose inputs live in guest memory, or that would end the replay process
+constexpr std::array<u32, 10> SkippedSVCs{
+    0x03, // ExitProcess
+    0x22, // ArbitrateAddress
+    0x25, // WaitSynchronizationN
+    0x2D, // ConnectToPort
+    0x32, // SendSyncRequest
+    0x39, // GetResourceLimitLimitValues
+    0x3A, // GetResourceLimitCurrentValues
+    0x3C, // Break
+    0x3D, // OutputDebugString
+    0x4F, // ReplyAndReceive
+};
+// clang-format on
+
+HandleRegisters GetHandleRegisters(u32 svc_id) {
+    const auto it = std::find_if(HandleRegisterTable.begin(), HandleRegisterTable.end(),
+                                 [svc_id](const auto& entry) { return entry.svc_id == svc_id; });
+    return it != HandleRegisterTable.end() ? *it : HandleRegisters{svc_id, 0, 0};
+}
+
+} // namespace
+
+SVCTraceReplayer::SVCTraceReplayer(KernelSystem& kernel)
+    : kernel(kernel), cpu(std::make_shared<ReplayCPU>(0, kernel.timing.GetTimer(0))),
+      svc(kernel) {
+    kernel.SetCPUs({cpu});
+    kernel.SetRunningCPU(cpu);
+
+    process = kernel.CreateProcess(kernel.CreateCodeSet("replay", 0));
+    process->resource_limit =
+        kernel.ResourceLimit().GetForCategory(ResourceLimitCategory::APPLICATION);
+    process->memory_region = kernel.GetMemoryRegion(MemoryRegion::APPLICATION);
+    process->vm_manager
+        .MapMMIO(Memory::PROCESS_IMAGE_VADDR, 0, Memory::PROCESS_IMAGE_MAX_SIZE,
+                 MemoryState::Code, std::make_shared<ReplayMemory>())
+        .Unwrap();
+    process->status = ProcessStatus::Running;
+    kernel.SetCurrentProcess(process);
+}
+
+SVCTraceReplayer::~SVCTraceReplayer() = default;
+
+bool SVCTraceReplayer::Replay(const SVCTraceRecord& record) {
+    if (!process_id) {
+        process_id = record.process_id;
+        start_ticks = record.ticks;
+        // Start a slice, as the CPU loop does before running anything
+        kernel.timing.GetTimer(0)->Advance();
+    }
+    AdvanceTo(record.ticks - start_ticks);
+
+    if (record.process_id != *process_id ||
+        std::find(SkippedSVCs.begin(), SkippedSVCs.end(), record.svc_id) != SkippedSVCs.end()) {
+        ++skipped_count;
+        return false;
+    }
+
+    Thread* thread = GetThread(record.thread_id);
+    if (thread == nullptr || !SwitchTo(*thread)) {
+        ++blocked_count;
+        return false;
+    }
+
+    const HandleRegisters handle_registers = GetHandleRegisters(record.svc_id);
+    for (std::size_t i = 0; i < record.args.size(); ++i) {
+        const bool is_handle = (handle_registers.in >> i) & 1;
+        cpu->SetReg(static_cast<int>(i), is_handle ? Translate(record.args[i]) : record.args[i]);
+    }
+    if (record.svc_id == SVCCreateThread &&
+        static_cast<s32>(record.args[4]) > ThreadProcessorId0) {
+        // Everything runs on core 0
+        cpu->SetReg(4, ThreadProcessorId0);
+    }
+    svc.CallSVC(record.svc_id);
+    ++replayed_count;
+
+    const u32 result = cpu->GetReg(0);
+    if (result != record.results[0]) {
+        ++mismatch_count;
+        return true;
+    }
+    if (result != RESULT_SUCCESS.raw) {
+        return true;
+    }
+
+    if (record.svc_id == SVCCloseHandle) {
+        handles.erase(record.args[0]);
+    }
+    for (std::size_t i = 0; i < record.results.size(); ++i) {
+        if ((handle_registers.out >> i) & 1) {
+            handles[record.results[i]] = cpu->GetReg(static_cast<int>(i));
+        }
+    }
+    if (record.svc_id == SVCCreateThread) {
+        unbound_threads.push_back(process->handle_table.Get<Thread>(cpu->GetReg(1)));
+    }
+    return true;
+}
+
+Handle SVCTraceReplayer::Translate(Handle handle) const {
+    if (handle == CurrentThread || handle == CurrentProcess) {
+        return handle;
+    }
+    const auto it = handles.find(handle);
+    return it != handles.end() ? it->second : 0;
+}
+
+Thread* SVCTraceReplayer::GetThread(u32 recorded_thread_id) {
+    const auto it = threads.find(recorded_thread_id);
+    if (it != threads.end()) {
+        return it->second.get();
+    }
+
+    std::shared_ptr<Thread> thread;
+    if (!unbound_threads.empty()) {
+        thread = std::move(unbound_threads.front());
+        unbound_threads.pop_front();
+    } else {
+        // A thread the trace didn't see being created, like the main thread
+        auto result = kernel.CreateThread(fmt::format("replay-{}", recorded_thread_id),
+                                          Memory::PROCESS_IMAGE_VADDR, ThreadPrioDefault, 0, 0,
+                                          Memory::HEAP_VADDR_END, *process);
+        if (result.Failed()) {
+            LOG_ERROR(Kernel, "Failed to create a thread for recorded thread {}",
+                      recorded_thread_id);
+            return nullptr;
+        }
+        thread = std::move(result).Unwrap();
+    }
+    return threads.emplace(recorded_thread_id, std::move(thread)).first->second.get();
+}
+
+bool SVCTraceReplayer::SwitchTo(Thread& thread) {
+    ThreadManager& thread_manager = kernel.GetThreadManager(0);
+    if (thread_manager.GetCurrentThread() == &thread && thread.status == ThreadStatus::Running) {
+        return true;
+    }
+    if (thread.status != ThreadStatus::Ready) {
+        return false;
+    }
+    thread_manager.SwitchContext(&thread);
+    return true;
+}
+
+void SVCTraceReplayer::AdvanceTo(u64 ticks) {
+    Core::Timing::Timer& timer = *kernel.timing.GetTimer(0);
+    while (timer.GetTicks() < ticks) {
+        const u64 step = std::min<u64>(std::max<s64>(timer.GetDowncount(), 1),
+                                       ticks - timer.GetTicks());
+        timer.AddTicks(step);
+        if (timer.GetDowncount() <= 0) {
+            timer.Advance();
+        }
+    }
+}
+
+bool BenchmarkSVCTrace(const std::string& path) {
+    const auto records = LoadSVCTrace(path);
+    if (!records) {
+        return false;
+    }
+
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+    SVCTraceReplayer replayer(kernel);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const SVCTraceRecord& record : *records) {
+        replayer.Replay(record);
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    LOG_INFO(Kernel,
+             "Replayed {} of {} SVCs in {} us, skipped {}, {} blocked, {} with another result",
+             replayer.GetReplayedCount(), records->size(), elapsed.count(),
+             replayer.GetSkippedCount(), replayer.GetBlockedCount(),
+             replayer.GetMismatchCount());
+    return true;
+}
+
+} // namespace Kernel
@@ -0,0 +1,117 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "common/common_types.h"
+#include "core/hle/kernel/object.h"
+#include "core/hle/kernel/svc.h"
+
+class ARM_Interface;
+
+namespace Kernel {
+
+class KernelSystem;
+class Process;
+class Thread;
+struct SVCTraceRecord;
+
+/**
+ * Replays an SVC trace through the real SVC handlers of a KernelSystem, without running any guest
+ * code, so that the kernel side of a title can be benchmarked reproducibly.
+ *
+ * The handlers run on a CPU that only holds registers: each record's r0-r7 are loaded into it and
+ * r0-r3 are compared with the recorded results afterwards. The replay process gets a memory region
+ * that reads as zeros over its code area, so that thread entry points are valid. The trace doesn't
+ * hold guest memory though, so the SVCs whose inputs live in it (IPC, port names, handle lists,
+ * arbitration and resource limit queries) are skipped, as are ExitProcess and Break.
+ *
+ * Each recorded thread gets a replay thread, which is switched to before each of its SVCs, so
+ * sleeps, waits and thread creation go through the scheduler. The threads created by a replayed
+ * svcCreateThread stand for the recorded threads in the order these first appear in the trace.
+ * A thread that is still waiting in the replay when the trace has it make an SVC is counted as
+ * blocked, and that SVC is skipped. Everything runs on core 0, and only the SVCs of the first
+ * recorded process are replayed.
+ *
+ * The handles created by the replay are different from the recorded ones, so handle arguments are
+ * translated. Emulated time is advanced to the tick of each record before replaying it, so that
+ * timers and sleeps end at the same points of the trace as when it was recorded.
+ */
+class SVCTraceReplayer {
+public:
+    /// The kernel must have a single core, and no process or CPU set up yet.
+    explicit SVCTraceReplayer(KernelSystem& kernel);
+    ~SVCTraceReplayer();
+
+    /**
+     * Replays one record of a trace, in the order they were recorded.
+     * @returns whether the SVC was run, rather than skipped.
+     */
+    bool Replay(const SVCTraceRecord& record);
+
+    u64 GetReplayedCount() const {
+        return replayed_count;
+    }
+
+    u64 GetSkippedCount() const {
+        return skipped_count;
+    }
+
+    /// Number of SVCs skipped because their thread was still waiting in the replay.
+    u64 GetBlockedCount() const {
+        return blocked_count;
+    }
+
+    /// Number of replayed SVCs that returned a different result code than when recorded.
+    u64 GetMismatchCount() const {
+        return mismatch_count;
+    }
+
+    /// Translates a recorded handle to the one the replay created for it, or 0 if there is none.
+    Handle Translate(Handle handle) const;
+
+    const std::shared_ptr<Process>& GetProcess() const {
+        return process;
+    }
+
+private:
+    /// Returns the replay thread standing for a recorded thread, creating it if needed.
+    Thread* GetThread(u32 recorded_thread_id);
+
+    /// Makes the thread the running one, if it is ready to run.
+    bool SwitchTo(Thread& thread);
+
+    /// Runs the emulated time forward to the given number of ticks since the start of the trace.
+    void AdvanceTo(u64 ticks);
+
+    KernelSystem& kernel;
+    std::shared_ptr<ARM_Interface> cpu;
+    std::shared_ptr<Process> process;
+    SVCContext svc;
+
+    std::unordered_map<Handle, Handle> handles;
+    std::unordered_map<u32, std::shared_ptr<Thread>> threads;
+    /// Threads created by svcCreateThread that no recorded thread stands for yet
+    std::deque<std::shared_ptr<Thread>> unbound_threads;
+    std::optional<u32> process_id;
+    u64 start_ticks = 0;
+
+    u64 replayed_count = 0;
+    u64 skipped_count = 0;
+    u64 blocked_count = 0;
+    u64 mismatch_count = 0;
+};
+
+/**
+ * Replays a trace file on a new kernel and logs how long the replay took, to benchmark the kernel.
+ * @returns whether the trace could be read.
+ */
+bool BenchmarkSVCTrace(const std::string& path);
+
+} // namespace Kernel
@@ -0,0 +1,183 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/hle/kernel/svc.h"
+#include "core/hle/kernel/svc_trace.h"
+
+namespace Kernel {
+
+namespace {
+
+constexpr u32 TraceMagic = 0x54565343; // "CSVT"
+constexpr u32 TraceVersion = 1;
+
+/// The writer is woken early once the buffer is this full, so that it rarely overflows.
+constexpr std::size_t WakeThreshold = 4096;
+
+} // namespace
+
+SVCTraceRecorder::SVCTraceRecorder() = default;
+
+SVCTraceRecorder::~SVCTraceRecorder() {
+    Stop();
+}
+
+bool SVCTraceRecorder::Start(const std::string& path) {
+    Stop();
+
+    file = std::make_unique<FileUtil::IOFile>(path, "wb");
+    const SVCTraceHeader header{TraceMagic, TraceVersion, sizeof(SVCTraceRecord), 0};
+    if (!file->IsGood() || file->WriteObject(header) != 1) {
+        LOG_ERROR(Kernel_SVC, "Could not create SVC trace {}", path);
+        file.reset();
+        return false;
+    }
+
+    if (!buffer) {
+        buffer = std::make_unique<Common::RingBuffer<SVCTraceRecord, BufferCapacity>>();
+    }
+    write_batch.resize(BufferCapacity);
+    record_count = 0;
+    dropped_count = 0;
+    {
+        std::lock_guard lock{summary_mutex};
+        summarizer = {};
+    }
+    stop_requested = false;
+    writer = std::thread([this] { WriterLoop(); });
+    enabled = true;
+    return true;
+}
+
+void SVCTraceRecorder::Stop() {
+    if (!writer.joinable()) {
+        return;
+    }
+    enabled = false;
+    {
+        std::lock_guard lock{mutex};
+        stop_requested = true;
+    }
+    cv.notify_one();
+    writer.join();
+    file.reset();
+}
+
+void SVCTraceRecorder::Record(const SVCTraceRecord& record) {
+    if (buffer->Push(&record, 1) == 0) {
+        dropped_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (buffer->Size() == WakeThreshold) {
+        cv.notify_one();
+    }
+}
+
+void SVCTraceRecorder::WriterLoop() {
+    std::unique_lock lock{mutex};
+    while (!stop_requested) {
+        cv.wait_for(lock, std::chrono::milliseconds(10));
+        lock.unlock();
+        Drain();
+        lock.lock();
+    }
+    // Whatever was recorded before Stop disabled the recorder
+    Drain();
+}
+
+void SVCTraceRecorder::Drain() {
+    const std::size_t count = buffer->Pop(write_batch.data(), write_batch.size());
+    if (count == 0) {
+        return;
+    }
+    if (file->WriteArray(write_batch.data(), count) != count) {
+        LOG_ERROR(Kernel_SVC, "Failed to write the SVC trace");
+        dropped_count.fetch_add(count, std::memory_order_relaxed);
+        return;
+    }
+    record_count.fetch_add(count, std::memory_order_relaxed);
+
+    std::lock_guard lock{summary_mutex};
+    for (std::size_t i = 0; i < count; ++i) {
+        summarizer.Add(write_batch[i]);
+    }
+}
+
+std::vector<SVCTraceSummary> SVCTraceRecorder::GetSummary() const {
+    std::lock_guard lock{summary_mutex};
+    return summarizer.GetSummary();
+}
+
+void SVCTraceSummarizer::Add(const SVCTraceRecord& record) {
+    SVCTraceSummary& summary = summaries[record.svc_id];
+    summary.svc_id = record.svc_id;
+    ++summary.calls;
+    summary.host_ns += record.host_ns;
+
+    const auto [last_call, first_call] = last_calls.try_emplace(record.thread_id, record);
+    if (!first_call) {
+        if (last_call->second.svc_id == record.svc_id && last_call->second.args == record.args) {
+            ++summary.repeated_calls;
+        }
+        last_call->second = record;
+    }
+}
+
+std::vector<SVCTraceSummary> SVCTraceSummarizer::GetSummary() const {
+    std::vector<SVCTraceSummary> sorted;
+    sorted.reserve(summaries.size());
+    for (const auto& [id, summary] : summaries) {
+        sorted.push_back(summary);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const auto& a, const auto& b) { return a.host_ns > b.host_ns; });
+    return sorted;
+}
+
+std::optional<std::vector<SVCTraceRecord>> LoadSVCTrace(const std::string& path) {
+    FileUtil::IOFile file(path, "rb");
+    SVCTraceHeader header;
+    if (!file || file.ReadArray(&header, 1) != 1 || header.magic != TraceMagic) {
+        LOG_ERROR(Kernel_SVC, "{} is not an SVC trace", path);
+        return std::nullopt;
+    }
+    if (header.version != TraceVersion || header.record_size != sizeof(SVCTraceRecord)) {
+        LOG_ERROR(Kernel_SVC, "Unsupported SVC trace version {}", header.version);
+        return std::nullopt;
+    }
+
+    std::vector<SVCTraceRecord> records((file.GetSize() - sizeof(header)) /
+                                        sizeof(SVCTraceRecord));
+    if (file.ReadArray(records.data(), records.size()) != records.size()) {
+        LOG_ERROR(Kernel_SVC, "Failed to read SVC trace {}", path);
+        return std::nullopt;
+    }
+    return records;
+}
+
+std::vector<SVCTraceSummary> SummarizeSVCTrace(const std::vector<SVCTraceRecord>& records) {
+    SVCTraceSummarizer summarizer;
+    for (const SVCTraceRecord& record : records) {
+        summarizer.Add(record);
+    }
+    return summarizer.GetSummary();
+}
+
+std::string FormatSVCTraceSummary(const std::vector<SVCTraceSummary>& summaries) {
+    std::string out = fmt::format("{:<4} {:<32} {:>10} {:>10} {:>14}\n", "id", "svc", "calls",
+                                  "repeated", "host ns");
+    for (const SVCTraceSummary& summary : summaries) {
+        const char* name = GetSVCName(summary.svc_id);
+        out += fmt::format("{:02X}   {:<32} {:>10} {:>10} {:>14}\n", summary.svc_id,
+                           name != nullptr ? name : "unknown", summary.calls,
+                           summary.repeated_calls, summary.host_ns);
+    }
+    return out;
+}
+
+} // namespace Kernel
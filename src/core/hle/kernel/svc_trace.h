@@ -0,0 +1,149 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "common/common_types.h"
+#include "common/ring_buffer.h"
+#include "common/swap.h"
+
+namespace FileUtil {
+class IOFile;
+}
+
+namespace Kernel {
+
+/// One SVC call, as stored in a trace file.
+struct SVCTraceRecord {
+    u64_le ticks;      ///< Emulated CPU ticks when the SVC was called
+    u32_le host_ns;    ///< Host time spent in the SVC handler
+    u32_le thread_id;  ///< ID of the calling thread
+    u32_le process_id; ///< ID of the calling process
+    u32_le svc_id;
+    std::array<u32_le, 8> args;    ///< Registers r0-r7 on entry
+    std::array<u32_le, 4> results; ///< Registers r0-r3 when the handler returned
+};
+static_assert(sizeof(SVCTraceRecord) == 72, "SVCTraceRecord has incorrect size");
+static_assert(std::is_trivial_v<SVCTraceRecord>, "SVCTraceRecord must be trivial");
+
+/// Header of a trace file. The records follow it, until the end of the file.
+struct SVCTraceHeader {
+    u32_le magic;
+    u32_le version;
+    u32_le record_size;
+    u32_le reserved;
+};
+static_assert(sizeof(SVCTraceHeader) == 16, "SVCTraceHeader has incorrect size");
+
+/// What a trace says about one SVC.
+struct SVCTraceSummary {
+    u32 svc_id = 0;
+    u64 calls = 0;
+    u64 host_ns = 0;
+    /// Calls with the same arguments as the previous call of the same thread, such as a thread
+    /// spinning on svcSleepThread(0).
+    u64 repeated_calls = 0;
+};
+
+/// Sums up a trace per SVC, one record at a time.
+class SVCTraceSummarizer {
+public:
+    void Add(const SVCTraceRecord& record);
+
+    /// The summary of the records added so far, the SVCs taking the most host time first.
+    std::vector<SVCTraceSummary> GetSummary() const;
+
+private:
+    std::map<u32, SVCTraceSummary> summaries;
+    std::map<u32, SVCTraceRecord> last_calls; ///< Last call of each thread
+};
+
+/**
+ * Streams every SVC call to a trace file. This is opt-in, when disabled the dispatcher only pays
+ * for checking IsEnabled. The SVCs are recorded under the HLE lock, so there is a single producer
+ * at a time, and a background thread moves the records from a lock-free ring buffer to the file.
+ * When the writer can't keep up the buffer fills and records are dropped, which GetDroppedCount
+ * reports.
+ */
+class SVCTraceRecorder {
+public:
+    SVCTraceRecorder();
+    ~SVCTraceRecorder();
+
+    bool IsEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Starts recording to the given file, replacing it.
+     * @returns whether the file could be created.
+     */
+    bool Start(const std::string& path);
+
+    /// Stops recording, once every buffered record has been written.
+    void Stop();
+
+    /// Queues a record to be written. Must not be called concurrently.
+    void Record(const SVCTraceRecord& record);
+
+    /// Number of records written to the file since the last Start.
+    u64 GetRecordCount() const {
+        return record_count.load(std::memory_order_relaxed);
+    }
+
+    /// Number of records lost because the buffer was full.
+    u64 GetDroppedCount() const {
+        return dropped_count.load(std::memory_order_relaxed);
+    }
+
+    /// Summary of the records written since the last Start, kept up to date by the writer.
+    std::vector<SVCTraceSummary> GetSummary() const;
+
+private:
+    static constexpr std::size_t BufferCapacity = 16384;
+
+    void WriterLoop();
+    void Drain();
+
+    std::atomic_bool enabled{false};
+    std::atomic<u64> record_count{0};
+    std::atomic<u64> dropped_count{0};
+
+    std::unique_ptr<Common::RingBuffer<SVCTraceRecord, BufferCapacity>> buffer;
+    std::unique_ptr<FileUtil::IOFile> file;
+    std::vector<SVCTraceRecord> write_batch;
+
+    SVCTraceSummarizer summarizer;
+    mutable std::mutex summary_mutex;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop_requested = false;
+};
+
+/**
+ * Reads a whole trace file written by SVCTraceRecorder into memory, for offline tools.
+ * @returns the records, or nothing if the file is missing or isn't a trace.
+ */
+std::optional<std::vector<SVCTraceRecord>> LoadSVCTrace(const std::string& path);
+
+/// Sums up a trace per SVC, the SVCs taking the most host time first.
+std::vector<SVCTraceSummary> SummarizeSVCTrace(const std::vector<SVCTraceRecord>& records);
+
+/// Formats the summary of a trace as a table, with the names of the SVCs.
+std::string FormatSVCTraceSummary(const std::vector<SVCTraceSummary>& summaries);
+
+} // namespace Kernel
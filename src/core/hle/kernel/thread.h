@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -140,6 +141,7 @@ private:
 
     friend class Thread;
     friend class KernelSystem;
+    friend class SVCTraceReplayer;
 };
 
 class Thread final : public WaitObject {
@@ -271,6 +273,9 @@ public:
 
     u64 last_running_ticks; ///< CPU tick when thread was last running
 
+    /// Links of the thread in the ready queue of its ThreadManager
+    Common::ThreadQueueListNode<Thread*> queue_node;
+
     s32 processor_id;
 
     VAddr tls_address; ///< Virtual address of the Thread Local Storage of the thread
@@ -287,6 +292,9 @@ public:
     // passed to WaitSynchronization1/N.
     std::vector<std::shared_ptr<WaitObject>> wait_objects;
 
+    /// Entries of the thread in the waiting lists of the objects it waits on
+    std::deque<WaitNode> wait_nodes;
+
     VAddr wait_address; ///< If waiting on an AddressArbiter, this is the arbitration address
 
     std::string name;
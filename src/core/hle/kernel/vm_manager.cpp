@@ -48,7 +48,8 @@ void VMManager::Reset() {
     // Initialize the map with a single free region covering the entire managed space.
     VirtualMemoryArea initial_vma;
     initial_vma.size = MAX_ADDRESS;
-    vma_map.emplace(initial_vma.base, initial_vma);
+    const VMAIter initial_iter = vma_map.emplace(initial_vma.base, initial_vma).first;
+    UpdatePageIndex(initial_vma.base, initial_vma.size, initial_iter);
 
     page_table.pointers.fill(nullptr);
     page_table.attributes.fill(Memory::PageType::Unmapped);
@@ -59,16 +60,21 @@ void VMManager::Reset() {
 VMManager::VMAHandle VMManager::FindVMA(VAddr target) const {
     if (target >= MAX_ADDRESS) {
         return vma_map.end();
-    } else {
-        return std::prev(vma_map.upper_bound(target));
     }
+
+    const u32 page = target >> Memory::PAGE_BITS;
+    const IndexEntry& entry = page_index[page >> INDEX_LEAF_BITS];
+    if (entry.leaf) {
+        return (*entry.leaf)[page & (INDEX_LEAF_PAGES - 1)];
+    }
+    return entry.vma;
 }
 
 ResultVal<VAddr> VMManager::MapBackingMemoryToBase(VAddr base, u32 region_size, u8* memory,
                                                    u32 size, MemoryState state) {
 
-    // Find the first Free VMA.
-    VMAHandle vma_handle = std::find_if(vma_map.begin(), vma_map.end(), [&](const auto& vma) {
+    // Find the first Free VMA. VMAs before the one containing base all end before it.
+    VMAHandle vma_handle = std::find_if(FindVMA(base), vma_map.cend(), [&](const auto& vma) {
         if (vma.second.type != VMAType::Free)
             return false;
 
@@ -76,11 +82,14 @@ ResultVal<VAddr> VMManager::MapBackingMemoryToBase(VAddr base, u32 region_size,
         return vma_end > base && vma_end >= base + size;
     });
 
-    VAddr target = std::max(base, vma_handle->second.base);
-
     // Do not try to allocate the block if there are no available addresses within the desired
     // region.
-    if (vma_handle == vma_map.end() || target + size > base + region_size) {
+    if (vma_handle == vma_map.end()) {
+        return ResultCode(ErrorDescription::OutOfMemory, ErrorModule::Kernel,
+                          ErrorSummary::OutOfResource, ErrorLevel::Permanent);
+    }
+    VAddr target = std::max(base, vma_handle->second.base);
+    if (target + size > base + region_size) {
         return ResultCode(ErrorDescription::OutOfMemory, ErrorModule::Kernel,
                           ErrorSummary::OutOfResource, ErrorLevel::Permanent);
     }
@@ -134,12 +143,12 @@ ResultCode VMManager::ChangeMemoryState(VAddr target, u32 size, MemoryState expe
                                         VMAPermission new_perms) {
     VAddr target_end = target + size;
     VMAIter begin_vma = StripIterConstness(FindVMA(target));
-    VMAIter i_end = vma_map.lower_bound(target_end);
+    const VMAIter end = vma_map.end();
 
-    if (begin_vma == vma_map.end())
+    if (begin_vma == end)
         return ERR_INVALID_ADDRESS;
 
-    for (auto i = begin_vma; i != i_end; ++i) {
+    for (auto i = begin_vma; i != end && i->second.base < target_end; ++i) {
         auto& vma = i->second;
         if (vma.meminfo_state != expected_state) {
             return ERR_INVALID_ADDRESS_STATE;
@@ -152,13 +161,12 @@ ResultCode VMManager::ChangeMemoryState(VAddr target, u32 size, MemoryState expe
 
     CASCADE_RESULT(auto vma, CarveVMARange(target, size));
 
-    const VMAIter end = vma_map.end();
     // The comparison against the end of the range must be done using addresses since VMAs can be
     // merged during this process, causing invalidation of the iterators.
     while (vma != end && vma->second.base < target_end) {
+        // The page table doesn't hold permissions or states, so it stays as it is
         vma->second.permissions = new_perms;
         vma->second.meminfo_state = new_state;
-        UpdatePageTableForVMA(vma->second);
         vma = std::next(MergeAdjacent(vma));
     }
 
@@ -197,9 +205,8 @@ ResultCode VMManager::UnmapRange(VAddr target, u32 size) {
 VMManager::VMAHandle VMManager::Reprotect(VMAHandle vma_handle, VMAPermission new_perms) {
     VMAIter iter = StripIterConstness(vma_handle);
 
-    VirtualMemoryArea& vma = iter->second;
-    vma.permissions = new_perms;
-    UpdatePageTableForVMA(vma);
+    // The page table doesn't hold permissions, so it stays as it is
+    iter->second.permissions = new_perms;
 
     return MergeAdjacent(iter);
 }
@@ -282,10 +289,10 @@ ResultVal<VMManager::VMAIter> VMManager::CarveVMARange(VAddr target, u32 size) {
     ASSERT(size > 0);
 
     VMAIter begin_vma = StripIterConstness(FindVMA(target));
-    const VMAIter i_end = vma_map.lower_bound(target_end);
-    if (std::any_of(begin_vma, i_end,
-                    [](const auto& entry) { return entry.second.type == VMAType::Free; })) {
-        return ERR_INVALID_ADDRESS_STATE;
+    for (auto i = begin_vma; i != vma_map.end() && i->second.base < target_end; ++i) {
+        if (i->second.type == VMAType::Free) {
+            return ERR_INVALID_ADDRESS_STATE;
+        }
     }
 
     if (target != begin_vma->second.base) {
@@ -326,13 +333,16 @@ VMManager::VMAIter VMManager::SplitVMA(VMAIter vma_handle, u32 offset_in_vma) {
 
     ASSERT(old_vma.CanBeMergedWith(new_vma));
 
-    return vma_map.emplace_hint(std::next(vma_handle), new_vma.base, new_vma);
+    const VMAIter right = vma_map.emplace_hint(std::next(vma_handle), new_vma.base, new_vma);
+    UpdatePageIndex(new_vma.base, new_vma.size, right);
+    return right;
 }
 
 VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
     const VMAIter next_vma = std::next(iter);
     if (next_vma != vma_map.end() && iter->second.CanBeMergedWith(next_vma->second)) {
         iter->second.size += next_vma->second.size;
+        UpdatePageIndex(next_vma->second.base, next_vma->second.size, iter);
         vma_map.erase(next_vma);
     }
 
@@ -340,6 +350,7 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
         VMAIter prev_vma = std::prev(iter);
         if (prev_vma->second.CanBeMergedWith(iter->second)) {
             prev_vma->second.size += iter->second.size;
+            UpdatePageIndex(iter->second.base, iter->second.size, prev_vma);
             vma_map.erase(iter);
             iter = prev_vma;
         }
@@ -362,6 +373,36 @@ void VMManager::UpdatePageTableForVMA(const VirtualMemoryArea& vma) {
     }
 }
 
+void VMManager::UpdatePageIndex(VAddr base, u32 size, VMAIter vma) {
+    const u32 end_page = (base + size) >> Memory::PAGE_BITS;
+    for (u32 page = base >> Memory::PAGE_BITS; page != end_page;) {
+        IndexEntry& entry = page_index[page >> INDEX_LEAF_BITS];
+        const u32 offset = page & (INDEX_LEAF_PAGES - 1);
+        const u32 count = std::min(INDEX_LEAF_PAGES - offset, end_page - page);
+        page += count;
+
+        if (count == INDEX_LEAF_PAGES) {
+            // The whole block now belongs to one VMA and doesn't need a leaf
+            entry.vma = vma;
+            if (entry.leaf) {
+                spare_leaves.push_back(std::move(entry.leaf));
+            }
+            continue;
+        }
+
+        if (!entry.leaf) {
+            if (spare_leaves.empty()) {
+                entry.leaf = std::make_unique<IndexLeaf>();
+            } else {
+                entry.leaf = std::move(spare_leaves.back());
+                spare_leaves.pop_back();
+            }
+            entry.leaf->fill(entry.vma);
+        }
+        std::fill_n(entry.leaf->begin() + offset, count, vma);
+    }
+}
+
 ResultVal<std::vector<std::pair<u8*, u32>>> VMManager::GetBackingBlocksForRange(VAddr address,
                                                                                 u32 size) {
     std::vector<std::pair<u8*, u32>> backing_blocks;
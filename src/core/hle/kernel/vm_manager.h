@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 #include <memory>
 #include <utility>
@@ -119,7 +120,10 @@ public:
     /// Clears the address space map, re-initializing with a single free area.
     void Reset();
 
-    /// Finds the VMA in which the given address is included in, or `vma_map.end()`.
+    /**
+     * Finds the VMA in which the given address is included in, or `vma_map.end()`. This is a
+     * lookup in the page index, and doesn't walk the map.
+     */
     VMAHandle FindVMA(VAddr target) const;
 
     // TODO(yuriks): Should these functions actually return the handle?
@@ -195,6 +199,22 @@ public:
 private:
     using VMAIter = decltype(vma_map)::iterator;
 
+    /// Number of pages covered by each entry of the top level of the page index.
+    static constexpr u32 INDEX_LEAF_BITS = 10;
+    static constexpr u32 INDEX_LEAF_PAGES = 1 << INDEX_LEAF_BITS;
+    static constexpr u32 INDEX_NUM_ENTRIES = (MAX_ADDRESS >> Memory::PAGE_BITS) >> INDEX_LEAF_BITS;
+
+    using IndexLeaf = std::array<VMAIter, INDEX_LEAF_PAGES>;
+
+    /**
+     * Entry of the page index for a 4MB block of the address space. A block inside of a single
+     * VMA points at it directly, other blocks have a leaf with the VMA of each of their pages.
+     */
+    struct IndexEntry {
+        VMAIter vma;
+        std::unique_ptr<IndexLeaf> leaf;
+    };
+
     /// Converts a VMAHandle to a mutable VMAIter.
     VMAIter StripIterConstness(const VMAHandle& iter);
 
@@ -228,6 +248,18 @@ private:
     /// Updates the pages corresponding to this VMA so they match the VMA's attributes.
     void UpdatePageTableForVMA(const VirtualMemoryArea& vma);
 
+    /// Points the page index entries of the range [base, base + size) at the given VMA.
+    void UpdatePageIndex(VAddr base, u32 size, VMAIter vma);
+
     Memory::MemorySystem& memory;
+
+    /**
+     * Two-level radix index from page number to the VMA containing it, kept in sync with
+     * `vma_map` whenever VMAs are split or merged. Map iterators stay valid until their own element
+     * is erased, so the index can hold them directly.
+     */
+    std::array<IndexEntry, INDEX_NUM_ENTRIES> page_index;
+    /// Leaves dropped from the page index, kept around to be reused.
+    std::vector<std::unique_ptr<IndexLeaf>> spare_leaves;
 };
 } // namespace Kernel
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <utility>
+#include <boost/container/small_vector.hpp>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "core/hle/kernel/errors.h"
@@ -17,51 +18,89 @@
 namespace Kernel {
 
 void WaitObject::AddWaitingThread(std::shared_ptr<Thread> thread) {
-    auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
-    if (itr == waiting_threads.end())
-        waiting_threads.push_back(std::move(thread));
+    // A thread that passed multiple handles to the same object only waits on it once
+    const auto& nodes = thread->wait_nodes;
+    if (std::any_of(nodes.begin(), nodes.end(),
+                    [this](const WaitNode& node) { return node.object == this; })) {
+        return;
+    }
+
+    // Growing a deque at the back keeps the addresses of the nodes already linked
+    WaitNode& node = thread->wait_nodes.emplace_back();
+    node.thread = thread.get();
+    node.object = this;
+    node.prev = last_waiter;
+    if (last_waiter != nullptr) {
+        last_waiter->next = &node;
+    } else {
+        first_waiter = &node;
+    }
+    last_waiter = &node;
 }
 
 void WaitObject::RemoveWaitingThread(Thread* thread) {
-    auto itr = std::find_if(waiting_threads.begin(), waiting_threads.end(),
-                            [thread](const auto& p) { return p.get() == thread; });
+    auto& nodes = thread->wait_nodes;
+    auto itr = std::find_if(nodes.begin(), nodes.end(),
+                            [this](const WaitNode& node) { return node.object == this; });
     // If a thread passed multiple handles to the same object,
     // the kernel might attempt to remove the thread from the object's
     // waiting threads list multiple times.
-    if (itr != waiting_threads.end())
-        waiting_threads.erase(itr);
+    if (itr == nodes.end())
+        return;
+
+    UnlinkWaitNode(*itr);
+    // Nodes in the middle stay allocated until the ones after them are gone, erasing them would
+    // move the others
+    while (!nodes.empty() && nodes.back().object == nullptr) {
+        nodes.pop_back();
+    }
+}
+
+void WaitObject::UnlinkWaitNode(WaitNode& node) {
+    if (node.prev != nullptr) {
+        node.prev->next = node.next;
+    } else {
+        first_waiter = node.next;
+    }
+    if (node.next != nullptr) {
+        node.next->prev = node.prev;
+    } else {
+        last_waiter = node.prev;
+    }
+    node.prev = nullptr;
+    node.next = nullptr;
+    node.object = nullptr;
+}
+
+bool WaitObject::IsReadyToRun(const Thread& thread) const {
+    // The list of waiting threads must not contain threads that are not waiting to be awakened.
+    ASSERT_MSG(thread.status == ThreadStatus::WaitSynchAny ||
+                   thread.status == ThreadStatus::WaitSynchAll ||
+                   thread.status == ThreadStatus::WaitHleEvent,
+               "Inconsistent thread statuses in waiting_threads");
+
+    if (ShouldWait(&thread))
+        return false;
+
+    // A thread is ready to run if it's either in ThreadStatus::WaitSynchAny or
+    // in ThreadStatus::WaitSynchAll and the rest of the objects it is waiting on are ready.
+    if (thread.status == ThreadStatus::WaitSynchAll) {
+        return std::none_of(thread.wait_objects.begin(), thread.wait_objects.end(),
+                            [&thread](const std::shared_ptr<WaitObject>& object) {
+                                return object->ShouldWait(&thread);
+                            });
+    }
+    return true;
 }
 
 std::shared_ptr<Thread> WaitObject::GetHighestPriorityReadyThread() const {
     Thread* candidate = nullptr;
     u32 candidate_priority = ThreadPrioLowest + 1;
 
-    for (const auto& thread : waiting_threads) {
-        // The list of waiting threads must not contain threads that are not waiting to be awakened.
-        ASSERT_MSG(thread->status == ThreadStatus::WaitSynchAny ||
-                       thread->status == ThreadStatus::WaitSynchAll ||
-                       thread->status == ThreadStatus::WaitHleEvent,
-                   "Inconsistent thread statuses in waiting_threads");
-
-        if (thread->current_priority >= candidate_priority)
-            continue;
-
-        if (ShouldWait(thread.get()))
-            continue;
-
-        // A thread is ready to run if it's either in ThreadStatus::WaitSynchAny or
-        // in ThreadStatus::WaitSynchAll and the rest of the objects it is waiting on are ready.
-        bool ready_to_run = true;
-        if (thread->status == ThreadStatus::WaitSynchAll) {
-            ready_to_run = std::none_of(thread->wait_objects.begin(), thread->wait_objects.end(),
-                                        [&thread](const std::shared_ptr<WaitObject>& object) {
-                                            return object->ShouldWait(thread.get());
-                                        });
-        }
-
-        if (ready_to_run) {
-            candidate = thread.get();
-            candidate_priority = thread->current_priority;
+    for (const WaitNode* node = first_waiter; node != nullptr; node = node->next) {
+        if (node->thread->current_priority < candidate_priority && IsReadyToRun(*node->thread)) {
+            candidate = node->thread;
+            candidate_priority = candidate->current_priority;
         }
     }
 
@@ -69,7 +108,31 @@ std::shared_ptr<Thread> WaitObject::GetHighestPriorityReadyThread() const {
 }
 
 void WaitObject::WakeupAllWaitingThreads() {
-    while (auto thread = GetHighestPriorityReadyThread()) {
+    // Waking a thread up only takes resources away, it never makes another waiter ready. So the
+    // threads that can run are gathered in a single pass over the list, and each one is only
+    // checked again before waking it, in case a better one took what it needed.
+    boost::container::small_vector<Thread*, 16> candidates;
+    for (const WaitNode* node = first_waiter; node != nullptr; node = node->next) {
+        if (IsReadyToRun(*node->thread)) {
+            candidates.push_back(node->thread);
+        }
+    }
+    // Ties go to the thread that has been waiting the longest
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Thread* a, const Thread* b) {
+        return a->current_priority < b->current_priority;
+    });
+
+    for (Thread* candidate : candidates) {
+        // Once a mutex, one-shot event or semaphore has been taken, this is where the other
+        // candidates stop
+        const bool still_waiting = std::any_of(
+            candidate->wait_nodes.begin(), candidate->wait_nodes.end(),
+            [this](const WaitNode& node) { return node.object == this; });
+        if (!still_waiting || !IsReadyToRun(*candidate)) {
+            continue;
+        }
+        std::shared_ptr<Thread> thread = SharedFrom(candidate);
+
         if (!thread->IsSleepingOnWaitAll()) {
             Acquire(thread.get());
         } else {
@@ -93,8 +156,10 @@ void WaitObject::WakeupAllWaitingThreads() {
         hle_notifier();
 }
 
-const std::vector<std::shared_ptr<Thread>>& WaitObject::GetWaitingThreads() const {
-    return waiting_threads;
+std::vector<std::shared_ptr<Thread>> WaitObject::GetWaitingThreads() const {
+    std::vector<std::shared_ptr<Thread>> threads;
+    ForEachWaitingThread([&threads](Thread& thread) { threads.push_back(SharedFrom(&thread)); });
+    return threads;
 }
 
 void WaitObject::SetHLENotifier(std::function<void()> callback) {
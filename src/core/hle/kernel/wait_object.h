@@ -13,6 +13,18 @@
 namespace Kernel {
 
 class Thread;
+class WaitObject;
+
+/**
+ * Entry of a thread in the waiting list of an object. The thread owns one node per object it waits
+ * on, so it can be unlinked from any of the lists without searching them.
+ */
+struct WaitNode {
+    Thread* thread = nullptr;
+    WaitObject* object = nullptr; ///< Null once the node has been unlinked
+    WaitNode* prev = nullptr;
+    WaitNode* next = nullptr;
+};
 
 /// Class that represents a Kernel object that a thread can be waiting on
 class WaitObject : public Object {
@@ -50,15 +62,32 @@ public:
     /// Obtains the highest priority thread that is ready to run from this object's waiting list.
     std::shared_ptr<Thread> GetHighestPriorityReadyThread() const;
 
-    /// Get a const reference to the waiting threads list for debug use
-    const std::vector<std::shared_ptr<Thread>>& GetWaitingThreads() const;
+    /// Get a copy of the waiting threads list for debug use
+    std::vector<std::shared_ptr<Thread>> GetWaitingThreads() const;
+
+    /// Calls func with every thread waiting on this object, in the order they started waiting
+    template <typename Func>
+    void ForEachWaitingThread(Func&& func) const {
+        for (const WaitNode* node = first_waiter; node != nullptr; node = node->next) {
+            func(*node->thread);
+        }
+    }
 
     /// Sets a callback which is called when the object becomes available
     void SetHLENotifier(std::function<void()> callback);
 
 private:
-    /// Threads waiting for this object to become available
-    std::vector<std::shared_ptr<Thread>> waiting_threads;
+    friend class Thread;
+
+    /// Returns whether the thread, waiting on this object, can acquire everything it waits for
+    bool IsReadyToRun(const Thread& thread) const;
+
+    /// Takes a node out of the waiting list, without any of the bookkeeping of subclasses
+    void UnlinkWaitNode(WaitNode& node);
+
+    /// Threads waiting for this object to become available, linked through their WaitNodes
+    WaitNode* first_waiter = nullptr;
+    WaitNode* last_waiter = nullptr;
 
     /// Function to call when this object becomes available
     std::function<void()> hle_notifier;
@@ -73,4 +102,12 @@ inline std::shared_ptr<WaitObject> DynamicObjectCast<WaitObject>(std::shared_ptr
     return nullptr;
 }
 
+template <>
+inline WaitObject* DynamicObjectCast<WaitObject>(Object* object) {
+    if (object != nullptr && object->IsWaitable()) {
+        return static_cast<WaitObject*>(object);
+    }
+    return nullptr;
+}
+
 } // namespace Kernel
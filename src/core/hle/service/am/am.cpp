@@ -5,9 +5,15 @@
 #include <algorithm>
 #include <cinttypes>
 #include <cstddef>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -76,13 +82,152 @@ struct TicketInfo {
 
 static_assert(sizeof(TicketInfo) == 0x18, "Ticket info structure size is wrong");
 
-class CIAFile::DecryptionState {
+constexpr ResultCode ERROR_CONTENT_HASH_MISMATCH(ErrorDescription::NotAuthorized, ErrorModule::AM,
+                                                 ErrorSummary::InvalidArgument,
+                                                 ErrorLevel::Permanent);
+
+class CIAFile::ContentInstaller {
 public:
-    std::vector<CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption> content;
+    /// Maximum amount of data queued before the CIA reader has to wait for the content
+    static constexpr std::size_t MaxQueuedBytes = 0x800000;
+
+    ContentInstaller(u16 index, const std::string& path, const FileSys::TitleMetadata& tmd,
+                     const std::optional<std::array<u8, 16>>& title_key)
+        : index(index), file(path, "wb"), expected_hash(tmd.GetContentHashByIndex(index)) {
+        const bool encrypted =
+            tmd.GetContentTypeByIndex(index) & FileSys::TMDContentTypeFlag::Encrypted;
+        if (title_key && encrypted) {
+            const auto ctr = tmd.GetContentCTRByIndex(index);
+            decryption.emplace();
+            decryption->SetKeyWithIV(title_key->data(), title_key->size(), ctr.data());
+        }
+        // The TMD hashes the decrypted content, so a content written as is can't be checked
+        verify = !encrypted || decryption.has_value();
+        if (!verify) {
+            LOG_WARNING(Service_AM, "No title key for encrypted content {}, it isn't verified",
+                        index);
+        }
+    }
+
+    ~ContentInstaller() {
+        Abort();
+    }
+
+    bool IsOpen() const {
+        return file.IsOpen();
+    }
+
+    /// Queues a chunk of the content, waiting while too much data is queued
+    bool Push(std::vector<u8> chunk) {
+        std::unique_lock lock{mutex};
+        if (!thread.joinable()) {
+            thread = std::thread(&ContentInstaller::Run, this);
+        }
+        queue_space.wait(lock, [this] { return queued_bytes < MaxQueuedBytes || failed; });
+        if (failed) {
+            return false;
+        }
+        queued_bytes += chunk.size();
+        queue.push_back(std::move(chunk));
+        queue_ready.notify_one();
+        return true;
+    }
+
+    /// Waits until the whole content has been written, returns false if writing failed or the
+    /// content didn't match the hash of the TMD. Can be called again for the same result.
+    bool Finish() {
+        {
+            std::lock_guard lock{mutex};
+            finishing = true;
+        }
+        queue_ready.notify_one();
+        if (thread.joinable()) {
+            thread.join();
+        }
+        if (file.IsOpen()) {
+            file.Close();
+
+            std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+            sha.Final(hash.data());
+            if (!failed && verify && hash != expected_hash) {
+                LOG_ERROR(Service_AM, "Content {} doesn't match the hash of the TMD", index);
+                hash_mismatch = true;
+            }
+        }
+        return !failed && !hash_mismatch;
+    }
+
+    /// Stops writing an incomplete content, dropping whatever is still queued. The content isn't
+    /// verified, as it is only partially written.
+    void Abort() {
+        {
+            std::lock_guard lock{mutex};
+            finishing = true;
+            for (const auto& chunk : queue) {
+                queued_bytes -= chunk.size();
+            }
+            queue.clear();
+        }
+        queue_ready.notify_one();
+        if (thread.joinable()) {
+            thread.join();
+        }
+        file.Close();
+    }
+
+private:
+    void Run() {
+        std::unique_lock lock{mutex};
+        while (true) {
+            queue_ready.wait(lock, [this] { return !queue.empty() || finishing; });
+            if (queue.empty()) {
+                return;
+            }
+            std::vector<u8> chunk = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+
+            // Crypto++ uses AES-NI and SHA extensions when the CPU has them
+            if (decryption) {
+                decryption->ProcessData(chunk.data(), chunk.data(), chunk.size());
+            }
+            if (verify) {
+                sha.Update(chunk.data(), chunk.size());
+            }
+            const bool written = file.WriteBytes(chunk.data(), chunk.size()) == chunk.size();
+
+            lock.lock();
+            queued_bytes -= chunk.size();
+            if (!written) {
+                LOG_ERROR(Service_AM, "Could not write content {}", index);
+                failed = true;
+                queue.clear();
+                queue_space.notify_all();
+                return;
+            }
+            queue_space.notify_all();
+        }
+    }
+
+    u16 index;
+    FileUtil::IOFile file;
+    std::array<u8, 0x20> expected_hash;
+    std::optional<CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption> decryption;
+    CryptoPP::SHA256 sha;
+    bool verify = true;
+    bool hash_mismatch = false;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable queue_ready;
+    std::condition_variable queue_space;
+    std::deque<std::vector<u8>> queue;
+    std::size_t queued_bytes = 0;
+    bool finishing = false;
+    bool failed = false;
 };
 
-CIAFile::CIAFile(Service::FS::MediaType media_type)
-    : media_type(media_type), decryption_state(std::make_unique<DecryptionState>()) {}
+CIAFile::CIAFile(Service::FS::MediaType media_type) : media_type(media_type) {}
 
 CIAFile::~CIAFile() {
     Close();
@@ -111,7 +256,7 @@ ResultCode CIAFile::WriteTitleMetadata() {
     if (FileUtil::Exists(GetTitleMetadataPath(media_type, tmd.GetTitleID())))
         is_update = true;
 
-    std::string tmd_path = GetTitleMetadataPath(media_type, tmd.GetTitleID(), is_update);
+    tmd_path = GetTitleMetadataPath(media_type, tmd.GetTitleID(), is_update);
 
     // Create content/ folder if it doesn't exist
     std::string tmd_folder;
@@ -131,15 +276,8 @@ ResultCode CIAFile::WriteTitleMetadata() {
 
     auto content_count = container.GetTitleMetadata().GetContentCount();
     content_written.resize(content_count);
-
-    if (auto title_key = container.GetTicket().GetTitleKey()) {
-        decryption_state->content.resize(content_count);
-        for (std::size_t i = 0; i < content_count; ++i) {
-            auto ctr = tmd.GetContentCTRByIndex(i);
-            decryption_state->content[i].SetKeyWithIV(title_key->data(), title_key->size(),
-                                                      ctr.data());
-        }
-    }
+    content_paths.resize(content_count);
+    content_installers.resize(content_count);
 
     install_state = CIAInstallState::TMDLoaded;
 
@@ -151,7 +289,8 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
     // has been written since we might get a written buffer which contains multiple .app
     // contents or only part of a larger .app's contents.
     u64 offset_max = offset + length;
-    for (int i = 0; i < container.GetTitleMetadata().GetContentCount(); i++) {
+    const FileSys::TitleMetadata& tmd = container.GetTitleMetadata();
+    for (int i = 0; i < tmd.GetContentCount(); i++) {
         if (content_written[i] < container.GetContentSize(i)) {
             // The size, minimum unwritten offset, and maximum unwritten offset of this content
             u64 size = container.GetContentSize(i);
@@ -168,34 +307,60 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
 
             // Since the incoming TMD has already been written, we can use GetTitleContentPath
             // to get the content paths to write to.
-            FileSys::TitleMetadata tmd = container.GetTitleMetadata();
-            FileUtil::IOFile file(GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update),
-                                  content_written[i] ? "ab" : "wb");
+            auto& installer = content_installers[i];
+            if (!installer) {
+                content_paths[i] = GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update);
+                installer = std::make_unique<ContentInstaller>(
+                    static_cast<u16>(i), content_paths[i], tmd,
+                    container.GetTicket().GetTitleKey());
+            }
 
-            if (!file.IsOpen())
+            if (!installer->IsOpen())
                 return FileSys::ERROR_INSUFFICIENT_SPACE;
 
-            std::vector<u8> temp(buffer + (range_min - offset),
-                                 buffer + (range_min - offset) + available_to_write);
-
-            if (tmd.GetContentTypeByIndex(static_cast<u16>(i)) &
-                FileSys::TMDContentTypeFlag::Encrypted) {
-                decryption_state->content[i].ProcessData(temp.data(), temp.data(), temp.size());
+            // Decryption, hashing and writing happen on the installer thread
+            if (!installer->Push(std::vector<u8>(
+                    buffer + (range_min - offset),
+                    buffer + (range_min - offset) + available_to_write))) {
+                return FileSys::ERROR_INSUFFICIENT_SPACE;
             }
 
-            file.WriteBytes(temp.data(), temp.size());
-
             // Keep tabs on how much of this content ID has been written so new range_min
             // values can be calculated.
             content_written[i] += available_to_write;
             LOG_DEBUG(Service_AM, "Wrote {:x} to content {}, total {:x}", available_to_write, i,
                       content_written[i]);
+
+            // Release the thread and the file as soon as the content is done, a CIA can have
+            // hundreds of contents. The result is kept and reported once the install completes.
+            if (content_written[i] == size) {
+                installer->Finish();
+            }
         }
     }
 
+    // Report a bad content on the write that completes the install
+    bool complete = true;
+    for (int i = 0; i < tmd.GetContentCount(); i++) {
+        if (content_written[i] < container.GetContentSize(i))
+            complete = false;
+    }
+    if (complete && !FinishContents())
+        return ERROR_CONTENT_HASH_MISMATCH;
+
     return MakeResult<std::size_t>(length);
 }
 
+bool CIAFile::FinishContents() const {
+    bool success = true;
+    for (const auto& installer : content_installers) {
+        if (installer && !installer->Finish()) {
+            success = false;
+        }
+    }
+    return success;
+}
+
 ResultVal<std::size_t> CIAFile::Write(u64 offset, std::size_t length, bool flush,
                                       const u8* buffer) {
     written += length;
@@ -285,7 +450,20 @@ bool CIAFile::Close() const {
     // Install aborted
     if (!complete) {
         LOG_ERROR(Service_AM, "CIAFile closed prematurely, aborting install...");
-        FileUtil::DeleteDir(GetTitlePath(media_type, container.GetTitleMetadata().GetTitleID()));
+        // Partial contents can't match their hashes, so they aren't verified
+        for (const auto& installer : content_installers) {
+            if (installer) {
+                installer->Abort();
+            }
+        }
+        RemoveInstalledFiles();
+        return true;
+    }
+
+    // A bad content fails the install, the previous version of the title is kept as it was
+    if (!FinishContents()) {
+        LOG_ERROR(Service_AM, "CIA contents failed to install, removing the title...");
+        RemoveInstalledFiles();
         return true;
     }
 
@@ -323,6 +501,49 @@ bool CIAFile::Close() const {
     return true;
 }
 
+void CIAFile::RemoveInstalledFiles() const {
+    const u64 title_id = container.GetTitleMetadata().GetTitleID();
+
+    // Contents an update shares with the installed version were written over the installed files,
+    // which are left to that version
+    std::vector<std::string> installed_paths;
+    if (is_update) {
+        FileSys::TitleMetadata installed_tmd;
+        if (installed_tmd.Load(GetTitleMetadataPath(media_type, title_id, false)) ==
+            Loader::ResultStatus::Success) {
+            for (u16 i = 0; i < installed_tmd.GetContentCount(); i++) {
+                installed_paths.push_back(GetTitleContentPath(media_type, title_id, i, false));
+            }
+        }
+    }
+    for (const std::string& path : content_paths) {
+        if (!path.empty() &&
+            std::find(installed_paths.begin(), installed_paths.end(), path) ==
+                installed_paths.end()) {
+            FileUtil::Delete(path);
+        }
+    }
+    if (!tmd_path.empty()) {
+        FileUtil::Delete(tmd_path);
+    }
+
+    // Directories are only removed once empty, they may hold the installed version or save data
+    const std::string title_path = GetTitlePath(media_type, title_id);
+    const std::string directories[]{
+        title_path + "content/00000000/",
+        title_path + "content/",
+        title_path,
+        fmt::format("{}{:08x}/", GetMediaTitlePath(media_type), title_id >> 32),
+    };
+    for (const std::string& directory : directories) {
+        FileUtil::FSTEntry entries;
+        if (FileUtil::IsDirectory(directory) &&
+            FileUtil::ScanDirectoryTree(directory, entries, 0) == 0) {
+            FileUtil::DeleteDir(directory);
+        }
+    }
+}
+
 void CIAFile::Flush() const {}
 
 InstallStatus InstallCIA(const std::string& path,
@@ -354,7 +575,9 @@ InstallStatus InstallCIA(const std::string& path,
         if (!file.IsOpen())
             return InstallStatus::ErrorFailedToOpenFile;
 
-        std::array<u8, 0x10000> buffer;
+        // Reading overlaps with decrypting, hashing and writing, which run on the content
+        // installer threads
+        std::vector<u8> buffer(0x100000);
         std::size_t total_bytes_read = 0;
         while (total_bytes_read != file.GetSize()) {
             std::size_t bytes_read = file.ReadBytes(buffer.data(), buffer.size());
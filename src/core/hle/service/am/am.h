@@ -83,6 +83,12 @@ private:
     bool is_update = false;
     CIAInstallState install_state = CIAInstallState::InstallStarted;
 
+    // Waits for every content to be written, returns false if any failed or didn't match its hash
+    bool FinishContents() const;
+
+    // Deletes the TMD and contents written by a failed install
+    void RemoveInstalledFiles() const;
+
     // How much has been written total, CIAContainer for the installing CIA, buffer of all data
     // prior to content data, how much of each content index has been written, and where the CIA
     // is being installed to
@@ -92,8 +98,14 @@ private:
     std::vector<u64> content_written;
     Service::FS::MediaType media_type;
 
-    class DecryptionState;
-    std::unique_ptr<DecryptionState> decryption_state;
+    // Files written by the install, removed again if it fails
+    std::string tmd_path;
+    std::vector<std::string> content_paths;
+
+    // Decrypts, hashes and writes one content on its own thread, so that contents are processed
+    // in parallel and the caller can keep reading the CIA meanwhile
+    class ContentInstaller;
+    std::vector<std::unique_ptr<ContentInstaller>> content_installers;
 };
 
 /**
@@ -2,6 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/file_sys/errors.h"
@@ -12,9 +16,76 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/server_session.h"
 #include "core/hle/service/fs/file.h"
+#include "core/settings.h"
 
 namespace Service::FS {
 
+namespace {
+
+/// Emulated time an asynchronous write keeps the client waiting for its host I/O
+constexpr std::chrono::microseconds AsyncWriteDelay{50};
+
+/**
+ * Runs host file I/O off the emulation thread. The jobs run one at a time in submission order,
+ * since the file backends are not thread safe and requests to the same file must not reorder.
+ */
+class HostIOQueue {
+public:
+    ~HostIOQueue() {
+        {
+            std::lock_guard lock{mutex};
+            stop = true;
+        }
+        cv.notify_one();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    std::shared_future<void> Submit(std::function<void()> job) {
+        std::packaged_task<void()> task(std::move(job));
+        std::shared_future<void> future = task.get_future().share();
+        {
+            std::lock_guard lock{mutex};
+            jobs.push_back(std::move(task));
+            if (!thread.joinable()) {
+                thread = std::thread(&HostIOQueue::Loop, this);
+            }
+        }
+        cv.notify_one();
+        return future;
+    }
+
+private:
+    void Loop() {
+        std::unique_lock lock{mutex};
+        while (true) {
+            cv.wait(lock, [this] { return stop || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            std::packaged_task<void()> task = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::packaged_task<void()>> jobs;
+    bool stop = false;
+    std::thread thread;
+};
+
+HostIOQueue& GetHostIOQueue() {
+    static HostIOQueue queue;
+    return queue;
+}
+
+} // namespace
+
 File::File(Core::System& system, std::unique_ptr<FileSys::FileBackend>&& backend,
            const FileSys::Path& path)
     : ServiceFramework("", 1), path(path), backend(std::move(backend)), system(system) {
@@ -33,6 +104,16 @@ File::File(Core::System& system, std::unique_ptr<FileSys::FileBackend>&& backend
     RegisterHandlers(functions);
 }
 
+File::~File() {
+    WaitForHostIO();
+}
+
+void File::WaitForHostIO() {
+    if (last_io.valid()) {
+        last_io.wait();
+    }
+}
+
 void File::Read(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x0802, 3, 2);
     u64 offset = rp.Pop<u64>();
@@ -50,6 +131,42 @@ void File::Read(Kernel::HLERequestContext& ctx) {
     // This file session might have a specific offset from where to start reading, apply it.
     offset += file->offset;
 
+    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
+
+    if (Settings::values.async_fs_io) {
+        // The host read overlaps the emulated delay, the reply is only built once both are over
+        auto data = std::make_shared<std::vector<u8>>(length);
+        auto read = std::make_shared<ResultVal<std::size_t>>();
+        last_io = GetHostIOQueue().Submit([this, offset, length, data, read] {
+            if (offset + length > backend->GetSize()) {
+                LOG_ERROR(Service_FS,
+                          "Reading from out of bounds offset=0x{:x} length=0x{:08X} "
+                          "file_size=0x{:x}",
+                          offset, length, backend->GetSize());
+            }
+            *read = backend->Read(offset, data->size(), data->data());
+        });
+        ctx.SleepClientThread(
+            "file::read", read_timeout_ns,
+            [io = last_io, buffer, data, read](std::shared_ptr<Kernel::Thread> /*thread*/,
+                                               Kernel::HLERequestContext& ctx,
+                                               Kernel::ThreadWakeupReason /*reason*/) mutable {
+                io.wait();
+                IPC::RequestBuilder rb(ctx, 0x0802, 2, 2);
+                if (read->Failed()) {
+                    rb.Push(read->Code());
+                    rb.Push<u32>(0);
+                } else {
+                    buffer.Write(data->data(), 0, **read);
+                    rb.Push(RESULT_SUCCESS);
+                    rb.Push<u32>(static_cast<u32>(**read));
+                }
+                rb.PushMappedBuffer(buffer);
+            });
+        return;
+    }
+
+    WaitForHostIO();
     if (offset + length > backend->GetSize()) {
         LOG_ERROR(Service_FS,
                   "Reading from out of bounds offset=0x{:x} length=0x{:08X} file_size=0x{:x}",
@@ -58,19 +175,23 @@ void File::Read(Kernel::HLERequestContext& ctx) {
 
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
 
-    std::vector<u8> data(length);
-    ResultVal<std::size_t> read = backend->Read(offset, data.size(), data.data());
+    // Read straight into guest memory when the buffer allows it, saving the staging copy
+    u8* const guest_data = length <= buffer.GetSize() ? buffer.GetPointer() : nullptr;
+    std::vector<u8> data(guest_data != nullptr ? 0 : length);
+    ResultVal<std::size_t> read =
+        backend->Read(offset, length, guest_data != nullptr ? guest_data : data.data());
     if (read.Failed()) {
         rb.Push(read.Code());
         rb.Push<u32>(0);
     } else {
-        buffer.Write(data.data(), 0, *read);
+        if (guest_data == nullptr) {
+            buffer.Write(data.data(), 0, *read);
+        }
         rb.Push(RESULT_SUCCESS);
         rb.Push<u32>(static_cast<u32>(*read));
     }
     rb.PushMappedBuffer(buffer);
 
-    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
     ctx.SleepClientThread("file::read", read_timeout_ns,
                           [](std::shared_ptr<Kernel::Thread> /*thread*/,
                              Kernel::HLERequestContext& /*ctx*/,
@@ -100,9 +221,47 @@ void File::Write(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    std::vector<u8> data(length);
-    buffer.Read(data.data(), 0, data.size());
-    ResultVal<std::size_t> written = backend->Write(offset, data.size(), flush != 0, data.data());
+    if (Settings::values.async_fs_io) {
+        // Guest memory is only touched on the emulation thread, copy the data out before queueing
+        auto data = std::make_shared<std::vector<u8>>(length);
+        buffer.Read(data->data(), 0, data->size());
+        auto written = std::make_shared<ResultVal<std::size_t>>();
+        auto new_size = std::make_shared<u64>();
+        last_io = GetHostIOQueue().Submit([this, offset, flush, data, written, new_size] {
+            *written = backend->Write(offset, data->size(), flush != 0, data->data());
+            *new_size = backend->GetSize();
+        });
+        ctx.SleepClientThread(
+            "file::write", AsyncWriteDelay,
+            [this, io = last_io, buffer, written,
+             new_size](std::shared_ptr<Kernel::Thread> /*thread*/, Kernel::HLERequestContext& ctx,
+                       Kernel::ThreadWakeupReason /*reason*/) {
+                io.wait();
+                // Update file size
+                GetSessionData(ctx.Session())->size = *new_size;
+
+                IPC::RequestBuilder rb(ctx, 0x0803, 2, 2);
+                if (written->Failed()) {
+                    rb.Push(written->Code());
+                    rb.Push<u32>(0);
+                } else {
+                    rb.Push(RESULT_SUCCESS);
+                    rb.Push<u32>(static_cast<u32>(**written));
+                }
+                rb.PushMappedBuffer(buffer);
+            });
+        return;
+    }
+
+    WaitForHostIO();
+    const u8* guest_data = length <= buffer.GetSize() ? buffer.GetPointer() : nullptr;
+    std::vector<u8> data;
+    if (guest_data == nullptr) {
+        data.resize(length);
+        buffer.Read(data.data(), 0, data.size());
+        guest_data = data.data();
+    }
+    ResultVal<std::size_t> written = backend->Write(offset, length, flush != 0, guest_data);
 
     // Update file size
     file->size = backend->GetSize();
@@ -141,6 +300,7 @@ void File::SetSize(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    WaitForHostIO();
     file->size = size;
     backend->SetSize(size);
     rb.Push(RESULT_SUCCESS);
@@ -154,6 +314,7 @@ void File::Close(Kernel::HLERequestContext& ctx) {
         LOG_WARNING(Service_FS, "Closing File backend but {} clients still connected",
                     connected_sessions.size());
 
+    WaitForHostIO();
     backend->Close();
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
@@ -172,6 +333,7 @@ void File::Flush(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    WaitForHostIO();
     backend->Flush();
     rb.Push(RESULT_SUCCESS);
 }
@@ -209,6 +371,7 @@ void File::OpenLinkFile(Kernel::HLERequestContext& ctx) {
 
     slot->priority = original_file->priority;
     slot->offset = 0;
+    WaitForHostIO();
     slot->size = backend->GetSize();
     slot->subfile = false;
 
@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <iterator>
 #include <vector>
+#include <boost/icl/interval_set.hpp>
 #include "common/bit_field.h"
 #include "common/microprofile.h"
 #include "common/swap.h"
@@ -439,9 +441,27 @@ void GSP_GPU::SignalInterruptForThread(InterruptId interrupt_id, u32 thread_id)
             info->is_dirty.Assign(false);
         }
     }
+
+    if (defer_interrupt_events) {
+        deferred_interrupt_events[thread_id] = true;
+        return;
+    }
     interrupt_event->Signal();
 }
 
+void GSP_GPU::SignalDeferredInterruptEvents() {
+    defer_interrupt_events = false;
+    for (u32 thread_id = 0; thread_id < MaxGSPThreads; ++thread_id) {
+        if (!deferred_interrupt_events[thread_id])
+            continue;
+
+        deferred_interrupt_events[thread_id] = false;
+        SessionData* session_data = FindRegisteredThreadData(thread_id);
+        if (session_data != nullptr && session_data->interrupt_event != nullptr)
+            session_data->interrupt_event->Signal();
+    }
+}
+
 /**
  * Signals that the specified interrupt type has occurred to userland code
  * @param interrupt_id ID of interrupt that is being signalled
@@ -473,36 +493,66 @@ void GSP_GPU::SignalInterrupt(InterruptId interrupt_id) {
 
 MICROPROFILE_DEFINE(GPU_GSP_DMA, "GPU", "GSP DMA", MP_RGB(100, 0, 255));
 
-/// Executes the next GSP command
-static void ExecuteCommand(const Command& command, u32 thread_id) {
-    // Utility function to convert register ID to address
-    static auto WriteGPURegister = [](u32 id, u32 data) {
-        GPU::Write<u32>(0x1EF00000 + 4 * id, data);
-    };
+/**
+ * Executes a run of consecutive GX DMA requests - typically used for copying memory from GSP heap
+ * to VRAM. The requests only copy memory on the CPU, so none of them can leave data in the
+ * rasterizer cache for a later one to read. The cache is thus flushed and invalidated once for
+ * the whole run, over the merged source and destination ranges, before any copy is made.
+ */
+static void ExecuteDMARequests(const std::vector<Command>& requests) {
+    if (requests.empty())
+        return;
 
-    switch (command.id) {
+    MICROPROFILE_SCOPE(GPU_GSP_DMA);
+    using IntervalSet = boost::icl::interval_set<VAddr>;
+    IntervalSet flush_ranges;
+    IntervalSet invalidate_ranges;
+    for (const Command& command : requests) {
+        const auto& params = command.dma_request;
+        if (params.size == 0)
+            continue;
+
+        flush_ranges += IntervalSet::interval_type::right_open(
+            params.source_address, params.source_address + params.size);
+        invalidate_ranges += IntervalSet::interval_type::right_open(
+            params.dest_address, params.dest_address + params.size);
+    }
 
-    // GX request DMA - typically used for copying memory from GSP heap to VRAM
-    case CommandId::REQUEST_DMA: {
-        MICROPROFILE_SCOPE(GPU_GSP_DMA);
-        Memory::MemorySystem& memory = Core::System::GetInstance().Memory();
-
-        // TODO: Consider attempting rasterizer-accelerated surface blit if that usage is ever
-        // possible/likely
-        Memory::RasterizerFlushVirtualRegion(command.dma_request.source_address,
-                                             command.dma_request.size, Memory::FlushMode::Flush);
-        Memory::RasterizerFlushVirtualRegion(command.dma_request.dest_address,
-                                             command.dma_request.size,
+    // TODO: Consider attempting rasterizer-accelerated surface blit if that usage is ever
+    // possible/likely
+    for (const auto& range : flush_ranges) {
+        Memory::RasterizerFlushVirtualRegion(range.lower(), range.upper() - range.lower(),
+                                             Memory::FlushMode::Flush);
+    }
+    for (const auto& range : invalidate_ranges) {
+        Memory::RasterizerFlushVirtualRegion(range.lower(), range.upper() - range.lower(),
                                              Memory::FlushMode::Invalidate);
+    }
 
+    Memory::MemorySystem& memory = Core::System::GetInstance().Memory();
+    const Kernel::Process& process = *Core::System::GetInstance().Kernel().GetCurrentProcess();
+    for (const Command& command : requests) {
         // TODO(Subv): These memory accesses should not go through the application's memory mapping.
         // They should go through the GSP module's memory mapping.
-        memory.CopyBlock(*Core::System::GetInstance().Kernel().GetCurrentProcess(),
-                         command.dma_request.dest_address, command.dma_request.source_address,
-                         command.dma_request.size);
+        memory.CopyBlock(process, command.dma_request.dest_address,
+                         command.dma_request.source_address, command.dma_request.size);
         SignalInterrupt(InterruptId::DMA);
-        break;
+
+        if (Pica::g_debug_context)
+            Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::GSPCommandProcessed,
+                                           (void*)&command);
     }
+}
+
+/// Executes the next GSP command, other than a DMA request
+static void ExecuteCommand(const Command& command, u32 thread_id) {
+    // Utility function to convert register ID to address
+    static auto WriteGPURegister = [](u32 id, u32 data) {
+        GPU::Write<u32>(0x1EF00000 + 4 * id, data);
+    };
+
+    switch (command.id) {
+
     // TODO: This will need some rework in the future. (why?)
     case CommandId::SUBMIT_GPU_CMDLIST: {
         auto& params = command.submit_gpu_cmdlist;
@@ -627,21 +677,43 @@ void GSP_GPU::SetLcdForceBlack(Kernel::HLERequestContext& ctx) {
 void GSP_GPU::TriggerCmdReqQueue(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0xC, 0, 0);
 
+    // The interrupts raised by the commands are only signalled once every queue is empty, so
+    // that a thread waiting on them is woken up once for the whole batch
+    defer_interrupt_events = true;
+
+    // Consecutive DMA requests are held back to be executed together
+    std::vector<Command> dma_requests;
+
     // Iterate through each thread's command queue...
-    for (unsigned thread_id = 0; thread_id < 0x4; ++thread_id) {
+    for (u32 thread_id = 0; thread_id < MaxGSPThreads; ++thread_id) {
         CommandBuffer* command_buffer = (CommandBuffer*)GetCommandBuffer(shared_memory, thread_id);
+        const u32 num_slots = static_cast<u32>(std::size(command_buffer->commands));
 
-        // Iterate through each command...
-        for (unsigned i = 0; i < command_buffer->number_commands; ++i) {
-            g_debugger.GXCommandProcessed((u8*)&command_buffer->commands[i]);
+        // Drain the queue, which is a ring buffer starting at the current command index
+        while (command_buffer->number_commands != 0) {
+            const Command command = command_buffer->commands[command_buffer->index % num_slots];
+            g_debugger.GXCommandProcessed((u8*)&command);
 
-            // Decode and execute command
-            ExecuteCommand(command_buffer->commands[i], thread_id);
-
-            // Indicates that command has completed
+            // The command is taken out of the queue once loaded, before it is processed
+            command_buffer->index.Assign((command_buffer->index + 1) % num_slots);
             command_buffer->number_commands.Assign(command_buffer->number_commands - 1);
+
+            if (command.id == CommandId::REQUEST_DMA) {
+                dma_requests.push_back(command);
+                continue;
+            }
+
+            // Other commands may use the memory the DMA requests write to
+            ExecuteDMARequests(dma_requests);
+            dma_requests.clear();
+
+            // Decode and execute command
+            ExecuteCommand(command, thread_id);
         }
     }
+    ExecuteDMARequests(dma_requests);
+
+    SignalDeferredInterruptEvents();
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
@@ -316,7 +316,10 @@ private:
      */
     void SetLcdForceBlack(Kernel::HLERequestContext& ctx);
 
-    /// This triggers handling of the GX command written to the command buffer in shared memory.
+    /**
+     * This triggers handling of the GX commands written to the command buffers in shared memory.
+     * Every queued command is processed, and the interrupt events are signalled once they all are.
+     */
     void TriggerCmdReqQueue(Kernel::HLERequestContext& ctx);
 
     /**
@@ -410,6 +413,9 @@ private:
     /// Returns the session data for the specified registered thread id, or nullptr if not found.
     SessionData* FindRegisteredThreadData(u32 thread_id);
 
+    /// Signals the interrupt events held back while the command queues were processed.
+    void SignalDeferredInterruptEvents();
+
     u32 GetUnusedThreadId();
 
     std::unique_ptr<Kernel::SessionRequestHandler::SessionDataBase> MakeSessionData() override;
@@ -430,6 +436,12 @@ private:
     /// Thread ids currently in use by the sessions connected to the GSPGPU service.
     std::array<bool, MaxGSPThreads> used_thread_ids = {false, false, false, false};
 
+    /// Whether interrupts only go to the relay queues for now, without signalling the events.
+    bool defer_interrupt_events = false;
+
+    /// Threads whose interrupt event is to be signalled once the events are no longer deferred.
+    std::array<bool, MaxGSPThreads> deferred_interrupt_events{};
+
     friend class SessionData;
 };
 
@@ -10,6 +10,7 @@
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/ipc_debugger/profiler.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/server_port.h"
 #include "core/hle/kernel/server_session.h"
@@ -177,6 +178,14 @@ void ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context)
 
     LOG_TRACE(Service, "{}",
               MakeFunctionString(info->name, GetServiceName(), context.CommandBuffer()));
+
+    auto& profiler = context.GetIPCProfiler();
+    if (!profiler.IsEnabled()) {
+        handler_invoker(this, info->handler_callback, context);
+        return;
+    }
+    IPCDebugger::Profiler::CallScope scope(profiler, service_name, info->name, header_code,
+                                           context.GetRequestPayloadSize());
     handler_invoker(this, info->handler_callback, context);
 }
 
@@ -2,15 +2,18 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <cstring>
 #include "common/common_funcs.h"
 #include "common/logging/log.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/service/y2r_u.h"
 #include "core/hw/y2r.h"
+#include "core/settings.h"
 
 namespace Service::Y2R {
 
@@ -21,6 +24,17 @@ static const CoefficientSet standard_coefficients[4] = {
     {{0x12A, 0x1CA, 0x88, 0x36, 0x21C, -0x1F04, 0x99C, -0x2421}},  // ITU_Rec709_Scaling
 };
 
+/// Conversions with at least this many pixels run on a separate thread when async_y2r is enabled
+constexpr u32 ASYNC_CONVERSION_MIN_PIXELS = 256 * 128;
+/**
+ * Emulated duration of an asynchronous conversion, per pixel. This is not a hardware measurement:
+ * the conversion is always finished when the event is due, so the guest sees the same timing no
+ * matter how fast the host is. At this rate a 400x240 video frame takes about 0.7ms, short enough
+ * for games converting several frames per vblank, and long enough for the host thread to usually
+ * be done by then instead of stalling the emulated CPU.
+ */
+constexpr s64 ASYNC_CONVERSION_CYCLES_PER_PIXEL = 2;
+
 ResultCode ConversionConfiguration::SetInputLineWidth(u16 width) {
     if (width == 0 || width > 1024 || width % 8 != 0) {
         return ResultCode(ErrorDescription::OutOfRange, ErrorModule::CAM,
@@ -220,6 +234,7 @@ void Y2R_U::GetTransferEndEvent(Kernel::HLERequestContext& ctx) {
 
 void Y2R_U::SetSendingY(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x10, 4, 2);
+    CompletePendingConversion();
     conversion.src_Y.address = rp.Pop<u32>();
     conversion.src_Y.image_size = rp.Pop<u32>();
     conversion.src_Y.transfer_unit = rp.Pop<u32>();
@@ -239,6 +254,7 @@ void Y2R_U::SetSendingY(Kernel::HLERequestContext& ctx) {
 
 void Y2R_U::SetSendingU(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x11, 4, 2);
+    CompletePendingConversion();
     conversion.src_U.address = rp.Pop<u32>();
     conversion.src_U.image_size = rp.Pop<u32>();
     conversion.src_U.transfer_unit = rp.Pop<u32>();
@@ -258,7 +274,7 @@ void Y2R_U::SetSendingU(Kernel::HLERequestContext& ctx) {
 
 void Y2R_U::SetSendingV(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x12, 4, 2);
-
+    CompletePendingConversion();
     conversion.src_V.address = rp.Pop<u32>();
     conversion.src_V.image_size = rp.Pop<u32>();
     conversion.src_V.transfer_unit = rp.Pop<u32>();
@@ -278,7 +294,7 @@ void Y2R_U::SetSendingV(Kernel::HLERequestContext& ctx) {
 
 void Y2R_U::SetSendingYUYV(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x13, 4, 2);
-
+    CompletePendingConversion();
     conversion.src_YUYV.address = rp.Pop<u32>();
     conversion.src_YUYV.image_size = rp.Pop<u32>();
     conversion.src_YUYV.transfer_unit = rp.Pop<u32>();
@@ -338,7 +354,7 @@ void Y2R_U::IsFinishedSendingV(Kernel::HLERequestContext& ctx) {
 
 void Y2R_U::SetReceiving(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x18, 4, 2);
-
+    CompletePendingConversion();
     conversion.dst.address = rp.Pop<u32>();
     conversion.dst.image_size = rp.Pop<u32>();
     conversion.dst.transfer_unit = rp.Pop<u32>();
@@ -507,9 +523,22 @@ void Y2R_U::StartConversion(Kernel::HLERequestContext& ctx) {
     Memory::RasterizerFlushVirtualRegion(conversion.dst.address, total_output_size,
                                          Memory::FlushMode::FlushAndInvalidate);
 
-    HW::Y2R::PerformConversion(system.Memory(), conversion);
-
-    completion_event->Signal();
+    CompletePendingConversion();
+
+    const u32 num_pixels = conversion.input_line_width * conversion.input_lines;
+    if (Settings::values.async_y2r && num_pixels >= ASYNC_CONVERSION_MIN_PIXELS) {
+        // Games wait on the completion event before using the output, so large conversions like
+        // video frames can run alongside the emulated CPU until the event is due
+        staged_conversion =
+            std::make_unique<HW::Y2R::StagedConversion>(system.Memory(), conversion);
+        pending_conversion = std::async(
+            std::launch::async, [staged = staged_conversion.get()] { staged->Run(); });
+        system.CoreTiming().ScheduleEvent(num_pixels * ASYNC_CONVERSION_CYCLES_PER_PIXEL,
+                                          conversion_done_event);
+    } else {
+        HW::Y2R::PerformConversion(system.Memory(), conversion);
+        completion_event->Signal();
+    }
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
@@ -520,6 +549,8 @@ void Y2R_U::StartConversion(Kernel::HLERequestContext& ctx) {
 void Y2R_U::StopConversion(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x27, 0, 0);
 
+    FinishConversion(false);
+
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
 
@@ -531,7 +562,7 @@ void Y2R_U::IsBusyConversion(Kernel::HLERequestContext& ctx) {
 
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
     rb.Push(RESULT_SUCCESS);
-    rb.Push<u8>(0); // StartConversion always finishes immediately
+    rb.Push<u8>(pending_conversion.valid());
 
     LOG_DEBUG(Service_Y2R, "called");
 }
@@ -589,6 +620,8 @@ void Y2R_U::PingProcess(Kernel::HLERequestContext& ctx) {
 void Y2R_U::DriverInitialize(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x2B, 0, 0);
 
+    FinishConversion(false);
+
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
 
     conversion.input_format = InputFormat::YUV422_Indiv8;
@@ -616,6 +649,8 @@ void Y2R_U::DriverInitialize(Kernel::HLERequestContext& ctx) {
 void Y2R_U::DriverFinalize(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x2C, 0, 0);
 
+    FinishConversion(false);
+
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
 
@@ -683,9 +718,45 @@ Y2R_U::Y2R_U(Core::System& system) : ServiceFramework("y2r:u", 1), system(system
     RegisterHandlers(functions);
 
     completion_event = system.Kernel().CreateEvent(Kernel::ResetType::OneShot, "Y2R:Completed");
+    conversion_done_event = system.CoreTiming().RegisterEvent(
+        "Y2R_U::ConversionDone", [this](u64 userdata, s64 cycles_late) {
+            FinishConversion(true);
+            completion_event->Signal();
+        });
+}
+
+Y2R_U::~Y2R_U() {
+    system.CoreTiming().UnscheduleEvent(conversion_done_event, 0);
+    // Guest memory might already be gone, so the output is dropped
+    if (pending_conversion.valid()) {
+        pending_conversion.wait();
+    }
 }
 
-Y2R_U::~Y2R_U() = default;
+void Y2R_U::FinishConversion(bool advance_buffers) {
+    if (!pending_conversion.valid()) {
+        return;
+    }
+    // Finishing early must not leave the event behind to fire during the next conversion
+    system.CoreTiming().UnscheduleEvent(conversion_done_event, 0);
+    if (pending_conversion.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        LOG_DEBUG(Service_Y2R, "Conversion still running when due, waiting for it");
+    }
+    pending_conversion.get();
+    staged_conversion->Finish(system.Memory());
+    if (advance_buffers) {
+        staged_conversion->AdvanceBuffers(conversion);
+    }
+    staged_conversion.reset();
+}
+
+void Y2R_U::CompletePendingConversion() {
+    // A conversion still running is finished first, as if it had been waited on
+    if (pending_conversion.valid()) {
+        FinishConversion(false);
+        completion_event->Signal();
+    }
+}
 
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <future>
 #include <memory>
 #include <string>
 #include "common/common_types.h"
@@ -13,12 +14,17 @@
 
 namespace Core {
 class System;
-}
+struct TimingEventType;
+} // namespace Core
 
 namespace Kernel {
 class Event;
 }
 
+namespace HW::Y2R {
+class StagedConversion;
+}
+
 namespace Service::Y2R {
 
 enum class InputFormat : u8 {
@@ -293,6 +299,16 @@ private:
     void DriverFinalize(Kernel::HLERequestContext& ctx);
     void GetPackageParameter(Kernel::HLERequestContext& ctx);
 
+    /**
+     * Waits for the asynchronous conversion, if one is running, and writes its output to guest
+     * memory. Only a conversion finished when due takes over its DMA progress, an early finish
+     * would otherwise overwrite buffers the guest has set up for the next conversion.
+     */
+    void FinishConversion(bool advance_buffers);
+
+    /// Finishes a conversion still running before its configuration changes and signals its end
+    void CompletePendingConversion();
+
     Core::System& system;
 
     std::shared_ptr<Kernel::Event> completion_event;
@@ -301,6 +317,12 @@ private:
     bool temporal_dithering_enabled = false;
     bool transfer_end_interrupt_enabled = false;
     bool spacial_dithering_enabled = false;
+
+    /// Signals the completion event once an asynchronous conversion is due
+    Core::TimingEventType* conversion_done_event = nullptr;
+    /// Input and output of the asynchronous conversion, kept apart from guest memory while it runs
+    std::unique_ptr<HW::Y2R::StagedConversion> staged_conversion;
+    std::future<void> pending_conversion;
 };
 
 void InstallInterfaces(Core::System& system);
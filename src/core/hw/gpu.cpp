@@ -2,14 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <numeric>
+#include <thread>
 #include <type_traits>
+#include <vector>
 #include "common/alignment.h"
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -49,29 +54,91 @@ inline void Read(T& var, const u32 raw_addr) {
     var = g_regs[addr / 4];
 }
 
-static Common::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
-    switch (input_format) {
-    case Regs::PixelFormat::RGBA8:
+template <Regs::PixelFormat format>
+static Common::Vec4<u8> DecodePixel(const u8* src_pixel) {
+    if constexpr (format == Regs::PixelFormat::RGBA8) {
         return Color::DecodeRGBA8(src_pixel);
-
-    case Regs::PixelFormat::RGB8:
+    } else if constexpr (format == Regs::PixelFormat::RGB8) {
         return Color::DecodeRGB8(src_pixel);
-
-    case Regs::PixelFormat::RGB565:
+    } else if constexpr (format == Regs::PixelFormat::RGB565) {
         return Color::DecodeRGB565(src_pixel);
-
-    case Regs::PixelFormat::RGB5A1:
+    } else if constexpr (format == Regs::PixelFormat::RGB5A1) {
         return Color::DecodeRGB5A1(src_pixel);
-
-    case Regs::PixelFormat::RGBA4:
+    } else {
+        static_assert(format == Regs::PixelFormat::RGBA4);
         return Color::DecodeRGBA4(src_pixel);
+    }
+}
 
-    default:
-        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", static_cast<u32>(input_format));
-        return {0, 0, 0, 0};
+template <Regs::PixelFormat format>
+static void EncodePixel(const Common::Vec4<u8>& color, u8* dst_pixel) {
+    if constexpr (format == Regs::PixelFormat::RGBA8) {
+        Color::EncodeRGBA8(color, dst_pixel);
+    } else if constexpr (format == Regs::PixelFormat::RGB8) {
+        Color::EncodeRGB8(color, dst_pixel);
+    } else if constexpr (format == Regs::PixelFormat::RGB565) {
+        Color::EncodeRGB565(color, dst_pixel);
+    } else if constexpr (format == Regs::PixelFormat::RGB5A1) {
+        Color::EncodeRGB5A1(color, dst_pixel);
+    } else {
+        static_assert(format == Regs::PixelFormat::RGBA4);
+        Color::EncodeRGBA4(color, dst_pixel);
     }
 }
 
+/// Calls func with the pixel format as a compile time constant, returns false if it is invalid
+template <typename Func>
+static bool DispatchPixelFormat(Regs::PixelFormat format, Func&& func) {
+    using Format = Regs::PixelFormat;
+    switch (format) {
+    case Format::RGBA8:
+        func(std::integral_constant<Format, Format::RGBA8>{});
+        return true;
+    case Format::RGB8:
+        func(std::integral_constant<Format, Format::RGB8>{});
+        return true;
+    case Format::RGB565:
+        func(std::integral_constant<Format, Format::RGB565>{});
+        return true;
+    case Format::RGB5A1:
+        func(std::integral_constant<Format, Format::RGB5A1>{});
+        return true;
+    case Format::RGBA4:
+        func(std::integral_constant<Format, Format::RGBA4>{});
+        return true;
+    }
+    return false;
+}
+
+/// Transfers smaller than this many output pixels are not worth waking up other threads for
+constexpr u32 PARALLEL_TRANSFER_MIN_PIXELS = 256 * 256;
+constexpr u32 PARALLEL_TRANSFER_MAX_THREADS = 4;
+
+/// Workers large transfers are split over, kept between transfers
+static std::unique_ptr<Common::ThreadPool> transfer_pool;
+
+/**
+ * Splits the rows [0, num_rows) into contiguous ranges and runs func(begin, end) on each one. Large
+ * jobs are spread over the transfer pool.
+ */
+template <typename Func>
+static void ForEachRowRange(u32 num_rows, u32 row_pixels, bool allow_parallel, Func&& func) {
+    if (!allow_parallel || !transfer_pool || num_rows * row_pixels < PARALLEL_TRANSFER_MIN_PIXELS) {
+        func(0, num_rows);
+        return;
+    }
+
+    const u32 num_threads = static_cast<u32>(transfer_pool->GetThreadCount());
+    // Keep every range a whole number of 8 row tiles so threads never share a tile
+    const u32 rows_per_thread = Common::AlignUp((num_rows + num_threads - 1) / num_threads, 8);
+    const u32 num_ranges = (num_rows + rows_per_thread - 1) / rows_per_thread;
+
+    transfer_pool->ParallelFor(num_ranges, [&](std::size_t range) {
+        const u32 begin = static_cast<u32>(range) * rows_per_thread;
+        func(begin, std::min(begin + rows_per_thread, num_rows));
+    });
+}
+
 MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
 
@@ -105,29 +172,137 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
     Memory::RasterizerInvalidateRegion(config.GetStartAddress(),
                                        config.GetEndAddress() - config.GetStartAddress());
 
+    // Replicate the fill value into a block whose size is a multiple of both 16 bytes and the
+    // value size, so the bulk of the region is written with wide copies of the same block
+    constexpr std::size_t block_size = 48;
+    std::array<u8, block_size> block;
+    std::size_t value_size;
     if (config.fill_24bit) {
-        // fill with 24-bit values
-        for (u8* ptr = start; ptr < end; ptr += 3) {
-            ptr[0] = config.value_24bit_r;
-            ptr[1] = config.value_24bit_g;
-            ptr[2] = config.value_24bit_b;
+        value_size = 3;
+        for (std::size_t i = 0; i < block_size; i += value_size) {
+            block[i + 0] = config.value_24bit_r;
+            block[i + 1] = config.value_24bit_g;
+            block[i + 2] = config.value_24bit_b;
         }
     } else if (config.fill_32bit) {
-        // fill with 32-bit values
-        if (end > start) {
-            u32 value = config.value_32bit;
-            std::size_t len = (end - start) / sizeof(u32);
-            for (std::size_t i = 0; i < len; ++i)
-                memcpy(&start[i * sizeof(u32)], &value, sizeof(u32));
-        }
+        const u32 value = config.value_32bit;
+        value_size = sizeof(u32);
+        for (std::size_t i = 0; i < block_size; i += value_size)
+            std::memcpy(&block[i], &value, sizeof(u32));
+    } else {
+        const u16 value_16bit = config.value_16bit.Value();
+        value_size = sizeof(u16);
+        for (std::size_t i = 0; i < block_size; i += value_size)
+            std::memcpy(&block[i], &value_16bit, sizeof(u16));
+    }
+
+    u8* ptr = start;
+    for (; end - ptr >= static_cast<std::ptrdiff_t>(block_size); ptr += block_size)
+        std::memcpy(ptr, block.data(), block_size);
+
+    if (config.fill_32bit) {
+        // 32-bit fills never write a partial value
+        const std::size_t tail = (end - ptr) / value_size * value_size;
+        std::memcpy(ptr, block.data(), tail);
     } else {
-        // fill with 16-bit values
-        u16 value_16bit = config.value_16bit.Value();
-        for (u8* ptr = start; ptr < end; ptr += sizeof(u16))
-            memcpy(ptr, &value_16bit, sizeof(u16));
+        // The remaining values are written whole, even if the last one crosses the end address
+        for (; ptr < end; ptr += value_size)
+            std::memcpy(ptr, block.data(), value_size);
     }
 }
 
+using TransferRowsFunc = void (*)(const Regs::DisplayTransferConfig& config,
+                                   const u8* src_pointer, u8* dst_pointer, u32 begin_y, u32 end_y);
+
+/**
+ * Converts the output rows [begin_y, end_y) of a display transfer. The pixel formats and the
+ * scaling mode are template parameters, so the conversion of each pair is fully inlined.
+ */
+template <Regs::PixelFormat input_format, Regs::PixelFormat output_format, u32 scaling>
+static void DisplayTransferRows(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                                u8* dst_pointer, u32 begin_y, u32 end_y) {
+    using Config = Regs::DisplayTransferConfig;
+    constexpr u32 src_bytes_per_pixel = input_format == Regs::PixelFormat::RGBA8  ? 4
+                                        : input_format == Regs::PixelFormat::RGB8 ? 3
+                                                                                  : 2;
+    constexpr u32 dst_bytes_per_pixel = output_format == Regs::PixelFormat::RGBA8  ? 4
+                                        : output_format == Regs::PixelFormat::RGB8 ? 3
+                                                                                   : 2;
+    constexpr u32 horizontal_scale = scaling != Config::NoScale ? 1 : 0;
+    constexpr u32 vertical_scale = scaling == Config::ScaleXY ? 1 : 0;
+
+    const u32 input_width = config.input_width;
+    const u32 output_width = config.output_width >> horizontal_scale;
+    const u32 output_height = config.output_height >> vertical_scale;
+    const u32 src_stride = input_width * src_bytes_per_pixel;
+    const u32 dst_stride = output_width * dst_bytes_per_pixel;
+    const bool input_linear = config.input_linear;
+    // The output is tiled when exactly one of the two sides is swizzled
+    const bool dst_tiled = input_linear != static_cast<bool>(config.dont_swizzle);
+
+    for (u32 y = begin_y; y < end_y; ++y) {
+        // Calculate the y position of the input image based on the current output position and
+        // the scale. Flipping is applied to the output afterwards to account for the scaling.
+        const u32 input_y = y << vertical_scale;
+        const u32 output_y = config.flip_vertically ? output_height - y - 1 : y;
+
+        // Offsets of the first pixel of the row, the Morton offset within the tile is added below
+        const u32 src_row = input_linear ? input_y * src_stride : (input_y & ~7) * src_stride;
+        const u32 dst_row = dst_tiled ? (output_y & ~7) * dst_stride : output_y * dst_stride;
+
+        for (u32 x = 0; x < output_width; ++x) {
+            const u32 input_x = x << horizontal_scale;
+
+            const u32 src_offset =
+                input_linear ? src_row + input_x * src_bytes_per_pixel
+                             : src_row + VideoCore::GetMortonOffset(input_x, input_y,
+                                                                    src_bytes_per_pixel);
+            const u32 dst_offset =
+                dst_tiled
+                    ? dst_row + VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel)
+                    : dst_row + x * dst_bytes_per_pixel;
+
+            const u8* src_pixel = src_pointer + src_offset;
+            u8* dst_pixel = dst_pointer + dst_offset;
+
+            if constexpr (input_format == output_format && scaling == Config::NoScale) {
+                // Decoding and encoding the same format is lossless, copy the bytes as they are
+                std::memcpy(dst_pixel, src_pixel, src_bytes_per_pixel);
+            } else {
+                Common::Vec4<u8> src_color = DecodePixel<input_format>(src_pixel);
+                if constexpr (scaling == Config::ScaleX) {
+                    const Common::Vec4<u8> pixel =
+                        DecodePixel<input_format>(src_pixel + src_bytes_per_pixel);
+                    src_color = ((src_color + pixel) / 2).Cast<u8>();
+                } else if constexpr (scaling == Config::ScaleXY) {
+                    const Common::Vec4<u8> pixel1 =
+                        DecodePixel<input_format>(src_pixel + 1 * src_bytes_per_pixel);
+                    const Common::Vec4<u8> pixel2 =
+                        DecodePixel<input_format>(src_pixel + 2 * src_bytes_per_pixel);
+                    const Common::Vec4<u8> pixel3 =
+                        DecodePixel<input_format>(src_pixel + 3 * src_bytes_per_pixel);
+                    src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+                }
+                EncodePixel<output_format>(src_color, dst_pixel);
+            }
+        }
+    }
+}
+
+template <Regs::PixelFormat input_format, Regs::PixelFormat output_format>
+static TransferRowsFunc GetTransferRowsFunc(u32 scaling) {
+    using Config = Regs::DisplayTransferConfig;
+    switch (scaling) {
+    case Config::NoScale:
+        return &DisplayTransferRows<input_format, output_format, Config::NoScale>;
+    case Config::ScaleX:
+        return &DisplayTransferRows<input_format, output_format, Config::ScaleX>;
+    case Config::ScaleXY:
+        return &DisplayTransferRows<input_format, output_format, Config::ScaleXY>;
+    }
+    return nullptr;
+}
+
 static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     const PAddr src_addr = config.GetPhysicalInputAddress();
     const PAddr dst_addr = config.GetPhysicalOutputAddress();
@@ -188,120 +363,44 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     u32 output_width = config.output_width >> horizontal_scale;
     u32 output_height = config.output_height >> vertical_scale;
 
+    if (!DispatchPixelFormat(config.output_format, [](auto) {})) {
+        LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
+                  static_cast<u32>(config.output_format.Value()));
+        return;
+    }
+    u32 output_size = output_width * output_height * GPU::Regs::BytesPerPixel(config.output_format);
+
+    if (!DispatchPixelFormat(config.input_format, [](auto) {})) {
+        // Pixels of an unknown format decode as transparent black, which every destination
+        // format encodes as zero bytes, so the whole output is cleared
+        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}",
+                  static_cast<u32>(config.input_format.Value()));
+        Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
+        std::memset(dst_pointer, 0, output_size);
+        return;
+    }
     u32 input_size =
         config.input_width * config.input_height * GPU::Regs::BytesPerPixel(config.input_format);
-    u32 output_size = output_width * output_height * GPU::Regs::BytesPerPixel(config.output_format);
 
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
-    for (u32 y = 0; y < output_height; ++y) {
-        for (u32 x = 0; x < output_width; ++x) {
-            Common::Vec4<u8> src_color;
-
-            // Calculate the [x,y] position of the input image
-            // based on the current output position and the scale
-            u32 input_x = x << horizontal_scale;
-            u32 input_y = y << vertical_scale;
-
-            u32 output_y;
-            if (config.flip_vertically) {
-                // Flip the y value of the output data,
-                // we do this after calculating the [x,y] position of the input image
-                // to account for the scaling options.
-                output_y = output_height - y - 1;
-            } else {
-                output_y = y;
-            }
-
-            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-            u32 src_offset;
-            u32 dst_offset;
-
-            if (config.input_linear) {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as linear and the output as tiled
-                    u32 coarse_y = output_y & ~7;
-                    u32 stride = output_width * dst_bytes_per_pixel;
-
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 coarse_y * stride;
-                } else {
-                    // Both input and output are linear
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                }
-            } else {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as tiled and the output as linear
-                    u32 coarse_y = input_y & ~7;
-                    u32 stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 coarse_y * stride;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                } else {
-                    // Both input and output are tiled
-                    u32 out_coarse_y = output_y & ~7;
-                    u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                    u32 in_coarse_y = input_y & ~7;
-                    u32 in_stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 in_coarse_y * in_stride;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 out_coarse_y * out_stride;
-                }
-            }
-
-            const u8* src_pixel = src_pointer + src_offset;
-            src_color = DecodePixel(config.input_format, src_pixel);
-            if (config.scaling == config.ScaleX) {
-                Common::Vec4<u8> pixel =
-                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                src_color = ((src_color + pixel) / 2).Cast<u8>();
-            } else if (config.scaling == config.ScaleXY) {
-                Common::Vec4<u8> pixel1 =
-                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel2 =
-                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel3 =
-                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
-            }
-
-            u8* dst_pixel = dst_pointer + dst_offset;
-            switch (config.output_format) {
-            case Regs::PixelFormat::RGBA8:
-                Color::EncodeRGBA8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB8:
-                Color::EncodeRGB8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB565:
-                Color::EncodeRGB565(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB5A1:
-                Color::EncodeRGB5A1(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGBA4:
-                Color::EncodeRGBA4(src_color, dst_pixel);
-                break;
-
-            default:
-                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
-                          static_cast<u32>(config.output_format.Value()));
-                break;
-            }
-        }
-    }
+    TransferRowsFunc transfer_rows = nullptr;
+    DispatchPixelFormat(config.input_format, [&](auto input_format) {
+        DispatchPixelFormat(config.output_format, [&](auto output_format) {
+            transfer_rows =
+                GetTransferRowsFunc<decltype(input_format)::value, decltype(output_format)::value>(
+                    config.scaling);
+        });
+    });
+
+    // Rows only write their own part of the output, so they can run in parallel unless the output
+    // overlaps the input and the result depends on the order the pixels are converted in
+    const bool overlapping = src_pointer < dst_pointer + output_size &&
+                             dst_pointer < src_pointer + input_size;
+    ForEachRowRange(output_height, output_width, !overlapping, [&](u32 begin_y, u32 end_y) {
+        transfer_rows(config, src_pointer, dst_pointer, begin_y, end_y);
+    });
 }
 
 static void TextureCopy(const Regs::DisplayTransferConfig& config) {
@@ -530,6 +629,8 @@ static void VBlankCallback(u64 userdata, s64 cycles_late) {
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory) {
     g_memory = &memory;
+    transfer_pool = std::make_unique<Common::ThreadPool>(
+        std::clamp(std::thread::hardware_concurrency(), 1u, PARALLEL_TRANSFER_MAX_THREADS) - 1);
     memset(&g_regs, 0, sizeof(g_regs));
 
     auto& framebuffer_top = g_regs.framebuffer_config[0];
@@ -567,6 +668,7 @@ void Init(Memory::MemorySystem& memory) {
 
 /// Shutdown hardware
 void Shutdown() {
+    transfer_pool.reset();
     LOG_DEBUG(HW_GPU, "shutdown OK");
 }
 
@@ -5,7 +5,9 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <vector>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
@@ -21,78 +23,101 @@ using namespace Service::Y2R;
 
 static const std::size_t MAX_TILES = 1024 / 8;
 static const std::size_t TILE_SIZE = 8 * 8;
-using ImageTile = std::array<u32, TILE_SIZE>;
 
-/// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
-static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
-                            const u8* input_V, ImageTile output[], unsigned int width,
-                            unsigned int height, const CoefficientSet& coefficients) {
-
-    for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
-            s32 Y = 0;
-            s32 U = 0;
-            s32 V = 0;
-            switch (input_format) {
-            case InputFormat::YUV422_Indiv8:
-            case InputFormat::YUV422_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[(y * width + x) / 2];
-                V = input_V[(y * width + x) / 2];
-                break;
-            case InputFormat::YUV420_Indiv8:
-            case InputFormat::YUV420_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[((y / 2) * width + x) / 2];
-                V = input_V[((y / 2) * width + x) / 2];
-                break;
-            case InputFormat::YUYV422_Interleaved:
-                Y = input_Y[(y * width + x) * 2];
-                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
-                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
-                break;
-            }
+/**
+ * Converts one line of the image strip from the source YUV format into RGB32. The input format is
+ * a template parameter and the line is written contiguously, so the loop is simple enough for the
+ * compiler to vectorize.
+ */
+template <InputFormat input_format>
+static void ConvertYUVToRGBLine(const u8* input_Y, const u8* input_U, const u8* input_V,
+                                u32* output, unsigned int width, unsigned int y,
+                                const CoefficientSet& coefficients) {
+    const u8* line_Y;
+    const u8* line_U;
+    const u8* line_V;
+    if constexpr (input_format == InputFormat::YUYV422_Interleaved) {
+        line_Y = input_Y + y * width * 2;
+        line_U = line_Y + 1;
+        line_V = line_Y + 3;
+    } else if constexpr (input_format == InputFormat::YUV420_Indiv8 ||
+                         input_format == InputFormat::YUV420_Indiv16) {
+        line_Y = input_Y + y * width;
+        line_U = input_U + (y / 2) * width / 2;
+        line_V = input_V + (y / 2) * width / 2;
+    } else {
+        line_Y = input_Y + y * width;
+        line_U = input_U + y * width / 2;
+        line_V = input_V + y * width / 2;
+    }
 
-            // This conversion process is bit-exact with hardware, as far as could be tested.
-            auto& c = coefficients;
-            s32 cY = c[0] * Y;
-
-            s32 r = cY + c[1] * V;
-            s32 g = cY - c[2] * V - c[3] * U;
-            s32 b = cY + c[4] * U;
-
-            const s32 rounding_offset = 0x18;
-            r = (r >> 3) + c[5] + rounding_offset;
-            g = (g >> 3) + c[6] + rounding_offset;
-            b = (b >> 3) + c[7] + rounding_offset;
-
-            unsigned int tile = x / 8;
-            unsigned int tile_x = x % 8;
-            u32* out = &output[tile][y * 8 + tile_x];
-            *out = ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) |
-                   ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
-                   ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
+    // This conversion process is bit-exact with hardware, as far as could be tested.
+    const s32 c0 = coefficients[0];
+    const s32 c1 = coefficients[1];
+    const s32 c2 = coefficients[2];
+    const s32 c3 = coefficients[3];
+    const s32 c4 = coefficients[4];
+    const s32 rounding_offset = 0x18;
+    const s32 r_offset = coefficients[5] + rounding_offset;
+    const s32 g_offset = coefficients[6] + rounding_offset;
+    const s32 b_offset = coefficients[7] + rounding_offset;
+
+    for (unsigned int x = 0; x < width; ++x) {
+        s32 Y;
+        s32 U;
+        s32 V;
+        if constexpr (input_format == InputFormat::YUYV422_Interleaved) {
+            Y = line_Y[x * 2];
+            U = line_U[(x / 2) * 4];
+            V = line_V[(x / 2) * 4];
+        } else {
+            Y = line_Y[x];
+            U = line_U[x / 2];
+            V = line_V[x / 2];
         }
+
+        const s32 cY = c0 * Y;
+        const s32 r = ((cY + c1 * V) >> 3) + r_offset;
+        const s32 g = ((cY - c2 * V - c3 * U) >> 3) + g_offset;
+        const s32 b = ((cY + c4 * U) >> 3) + b_offset;
+
+        output[x] = ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) |
+                    ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
+                    ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
     }
 }
 
+/// Bytes of guest memory, gaps included, that receiving `amount_of_data` bytes covers
+template <std::size_t N>
+static std::size_t GetReceiveSpan(const ConversionBuffer& buf, std::size_t amount_of_data) {
+    const std::size_t output_unit = buf.transfer_unit / N;
+    if (output_unit == 0) {
+        return 0;
+    }
+    return amount_of_data / output_unit * (buf.transfer_unit + buf.gap);
+}
+
 /// Simulates an incoming CDMA transfer. The N parameter is used to automatically convert 16-bit
 /// formats to 8-bit.
 template <std::size_t N>
-static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuffer& buf,
+static void ReceiveData(const BufferAccessor& access, u8* output, ConversionBuffer& buf,
                         std::size_t amount_of_data) {
-    const u8* input = memory.GetPointer(buf.address);
+    const u8* input = access(buf, GetReceiveSpan<N>(buf, amount_of_data));
 
     std::size_t output_unit = buf.transfer_unit / N;
     ASSERT(amount_of_data % output_unit == 0);
 
     while (amount_of_data > 0) {
-        for (std::size_t i = 0; i < output_unit; ++i) {
-            output[i] = input[i * N];
+        if (input != nullptr) {
+            for (std::size_t i = 0; i < output_unit; ++i) {
+                output[i] = input[i * N];
+            }
+            input += buf.transfer_unit + buf.gap;
+        } else {
+            std::fill_n(output, output_unit, u8{0});
         }
 
         output += output_unit;
-        input += buf.transfer_unit + buf.gap;
 
         buf.address += buf.transfer_unit + buf.gap;
         buf.image_size -= buf.transfer_unit;
@@ -100,60 +125,69 @@ static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuff
     }
 }
 
+static constexpr std::size_t GetBytesPerPixel(OutputFormat output_format) {
+    return output_format == OutputFormat::RGBA8  ? 4
+           : output_format == OutputFormat::RGB8 ? 3
+                                                 : 2;
+}
+
+/// Bytes written per transfer unit. Only whole pixels are written, so a transfer unit that isn't a
+/// multiple of the pixel size is overshot.
+static std::size_t GetSendUnitSize(OutputFormat output_format, const ConversionBuffer& buf) {
+    const std::size_t bytes_per_pixel = GetBytesPerPixel(output_format);
+    return (buf.transfer_unit + bytes_per_pixel - 1) / bytes_per_pixel * bytes_per_pixel;
+}
+
+/// Bytes of guest memory, gaps included, that sending `amount_of_data` pixels covers
+static std::size_t GetSendSpan(OutputFormat output_format, const ConversionBuffer& buf,
+                               std::size_t amount_of_data) {
+    const std::size_t unit_size = GetSendUnitSize(output_format, buf);
+    if (unit_size == 0) {
+        return 0;
+    }
+    const std::size_t pixels_per_unit = unit_size / GetBytesPerPixel(output_format);
+    const std::size_t num_units = (amount_of_data + pixels_per_unit - 1) / pixels_per_unit;
+    return num_units * (unit_size + buf.gap);
+}
+
 /// Convert intermediate RGB32 format to the final output format while simulating an outgoing CDMA
 /// transfer.
-static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionBuffer& buf,
-                     int amount_of_data, OutputFormat output_format, u8 alpha) {
+template <OutputFormat output_format>
+static void SendData(const BufferAccessor& access, const u32* input, ConversionBuffer& buf,
+                     int amount_of_data, u8 alpha) {
+    constexpr std::size_t bytes_per_pixel = GetBytesPerPixel(output_format);
+    const std::size_t pixels_per_unit = GetSendUnitSize(output_format, buf) / bytes_per_pixel;
 
-    u8* output = memory.GetPointer(buf.address);
+    u8* output = access(buf, GetSendSpan(output_format, buf, amount_of_data));
 
     while (amount_of_data > 0) {
-        u8* unit_end = output + buf.transfer_unit;
-        while (output < unit_end) {
-            u32 color = *input++;
-            Common::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
-
-            switch (output_format) {
-            case OutputFormat::RGBA8:
-                Color::EncodeRGBA8(col_vec, output);
-                output += 4;
-                break;
-            case OutputFormat::RGB8:
-                Color::EncodeRGB8(col_vec, output);
-                output += 3;
-                break;
-            case OutputFormat::RGB5A1:
-                Color::EncodeRGB5A1(col_vec, output);
-                output += 2;
-                break;
-            case OutputFormat::RGB565:
-                Color::EncodeRGB565(col_vec, output);
-                output += 2;
-                break;
+        if (output != nullptr) {
+            for (std::size_t i = 0; i < pixels_per_unit; ++i) {
+                u32 color = input[i];
+                Common::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8),
+                                         alpha};
+
+                if constexpr (output_format == OutputFormat::RGBA8) {
+                    Color::EncodeRGBA8(col_vec, output);
+                } else if constexpr (output_format == OutputFormat::RGB8) {
+                    Color::EncodeRGB8(col_vec, output);
+                } else if constexpr (output_format == OutputFormat::RGB5A1) {
+                    Color::EncodeRGB5A1(col_vec, output);
+                } else {
+                    Color::EncodeRGB565(col_vec, output);
+                }
+                output += bytes_per_pixel;
             }
-
-            amount_of_data -= 1;
+            output += buf.gap;
         }
 
-        output += buf.gap;
+        input += pixels_per_unit;
+        amount_of_data -= static_cast<int>(pixels_per_unit);
         buf.address += buf.transfer_unit + buf.gap;
         buf.image_size -= buf.transfer_unit;
     }
 }
 
-static const u8 linear_lut[TILE_SIZE] = {
-    // clang-format off
-     0,  1,  2,  3,  4,  5,  6,  7,
-     8,  9, 10, 11, 12, 13, 14, 15,
-    16, 17, 18, 19, 20, 21, 22, 23,
-    24, 25, 26, 27, 28, 29, 30, 31,
-    32, 33, 34, 35, 36, 37, 38, 39,
-    40, 41, 42, 43, 44, 45, 46, 47,
-    48, 49, 50, 51, 52, 53, 54, 55,
-    56, 57, 58, 59, 60, 61, 62, 63,
-    // clang-format on
-};
-
 static const u8 morton_lut[TILE_SIZE] = {
     // clang-format off
      0,  1,  4,  5, 16, 17, 20, 21,
@@ -167,47 +201,81 @@ static const u8 morton_lut[TILE_SIZE] = {
     // clang-format on
 };
 
-static void RotateTile0(const ImageTile& input, ImageTile& output, int height,
-                        const u8 out_map[64]) {
-    for (int i = 0; i < height * 8; ++i) {
-        output[out_map[i]] = input[i];
-    }
-}
+/**
+ * Builds the table mapping each pixel of an 8 x height input tile to its offset in the output
+ * strip, relative to the start of the tile. Rotation and the linear or swizzled output layout are
+ * both folded into the table, so converted lines can be scattered straight to their final place.
+ */
+static std::array<u32, TILE_SIZE> BuildTileMap(Rotation rotation, BlockAlignment block_alignment,
+                                                unsigned int height, unsigned int line_width) {
+    std::array<u32, TILE_SIZE> tile_map{};
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < 8; ++x) {
+            // Position of the pixel in the rotated tile, in the order it is written out
+            unsigned int out_i = 0;
+            switch (rotation) {
+            case Rotation::None:
+                out_i = y * 8 + x;
+                break;
+            case Rotation::Clockwise_90:
+                out_i = x * height + (height - 1 - y);
+                break;
+            case Rotation::Clockwise_180:
+                out_i = height * 8 - 1 - (y * 8 + x);
+                break;
+            case Rotation::Clockwise_270:
+                out_i = (8 - 1 - x) * height + y;
+                break;
+            }
 
-static void RotateTile90(const ImageTile& input, ImageTile& output, int height,
-                         const u8 out_map[64]) {
-    int out_i = 0;
-    for (int x = 0; x < 8; ++x) {
-        for (int y = height - 1; y >= 0; --y) {
-            output[out_map[out_i++]] = input[y * 8 + x];
+            u32 offset = out_i;
+            if (block_alignment == BlockAlignment::Block8x8) {
+                offset = morton_lut[out_i];
+            } else if (rotation == Rotation::None || rotation == Rotation::Clockwise_180) {
+                // Unrotated tiles are 8 pixels wide lines of a strip as wide as the whole image.
+                // Rotated ones form a separate 8 pixels wide image each, which is contiguous.
+                offset = (out_i / 8) * line_width + out_i % 8;
+            }
+            tile_map[y * 8 + x] = offset;
         }
     }
+    return tile_map;
 }
 
-static void RotateTile180(const ImageTile& input, ImageTile& output, int height,
-                          const u8 out_map[64]) {
-    int out_i = 0;
-    for (int i = height * 8 - 1; i >= 0; --i) {
-        output[out_map[out_i++]] = input[i];
-    }
-}
-
-static void RotateTile270(const ImageTile& input, ImageTile& output, int height,
-                          const u8 out_map[64]) {
-    int out_i = 0;
-    for (int x = 8 - 1; x >= 0; --x) {
-        for (int y = 0; y < height; ++y) {
-            output[out_map[out_i++]] = input[y * 8 + x];
-        }
+using ConvertLineFunc = void (*)(const u8* input_Y, const u8* input_U, const u8* input_V,
+                                 u32* output, unsigned int width, unsigned int y,
+                                 const CoefficientSet& coefficients);
+using SendDataFunc = void (*)(const BufferAccessor& access, const u32* input,
+                              ConversionBuffer& buf, int amount_of_data, u8 alpha);
+
+static ConvertLineFunc GetConvertLineFunc(InputFormat input_format) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+        return &ConvertYUVToRGBLine<InputFormat::YUV422_Indiv8>;
+    case InputFormat::YUV420_Indiv8:
+        return &ConvertYUVToRGBLine<InputFormat::YUV420_Indiv8>;
+    case InputFormat::YUV422_Indiv16:
+        return &ConvertYUVToRGBLine<InputFormat::YUV422_Indiv16>;
+    case InputFormat::YUV420_Indiv16:
+        return &ConvertYUVToRGBLine<InputFormat::YUV420_Indiv16>;
+    case InputFormat::YUYV422_Interleaved:
+        return &ConvertYUVToRGBLine<InputFormat::YUYV422_Interleaved>;
     }
+    UNREACHABLE();
 }
 
-static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, int line_stride) {
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            output[y * line_stride + x] = tile[y * 8 + x];
-        }
+static SendDataFunc GetSendDataFunc(OutputFormat output_format) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        return &SendData<OutputFormat::RGBA8>;
+    case OutputFormat::RGB8:
+        return &SendData<OutputFormat::RGB8>;
+    case OutputFormat::RGB5A1:
+        return &SendData<OutputFormat::RGB5A1>;
+    case OutputFormat::RGB565:
+        return &SendData<OutputFormat::RGB565>;
     }
+    UNREACHABLE();
 }
 
 /**
@@ -260,30 +328,31 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
  * Hardware behaves strangely (doesn't fire the completion interrupt, for example) in these cases,
  * so they are believed to be invalid configurations anyway.
  */
-void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cvt) {
+void PerformConversion(const BufferAccessor& access, ConversionConfiguration& cvt) {
     ASSERT(cvt.input_line_width % 8 == 0);
     ASSERT(cvt.block_alignment != BlockAlignment::Block8x8 || cvt.input_lines % 8 == 0);
     // Tiles per row
     std::size_t num_tiles = cvt.input_line_width / 8;
     ASSERT(num_tiles <= MAX_TILES);
 
-    // Buffer used as a CDMA source/target.
+    // Buffer used as a CDMA source.
     std::unique_ptr<u8[]> data_buffer(new u8[cvt.input_line_width * 8 * 4]);
-    // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
-    std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
-    ImageTile tmp_tile;
-
-    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
-    // requiring two different code paths.
-    const u8* tile_remap = nullptr;
-    switch (cvt.block_alignment) {
-    case BlockAlignment::Linear:
-        tile_remap = linear_lut;
-        break;
-    case BlockAlignment::Block8x8:
-        tile_remap = morton_lut;
-        break;
-    }
+    // Converted and rotated strip in RGB32, laid out the way it is sent out. Zero initialized so
+    // the unused part of partial 8x8 tiles is deterministic.
+    std::vector<u32> output_buffer(cvt.input_line_width * 8);
+    // A single converted line, scattered to the output buffer once done
+    std::vector<u32> line_buffer(cvt.input_line_width);
+
+    const auto convert_line = GetConvertLineFunc(cvt.input_format);
+    const auto send_data = GetSendDataFunc(cvt.output_format);
+
+    // 180 and 270 degree rotations also invert the order of tiles in the strip, since the rotations
+    // are done individually on each tile
+    const bool reverse_tiles =
+        cvt.rotation == Rotation::Clockwise_180 || cvt.rotation == Rotation::Clockwise_270;
+
+    std::array<u32, TILE_SIZE> tile_map{};
+    unsigned int tile_map_height = 0;
 
     for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
         unsigned int row_height = std::min(cvt.input_lines - y, 8u);
@@ -297,84 +366,178 @@ void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cv
 
         switch (cvt.input_format) {
         case InputFormat::YUV422_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 2);
+            ReceiveData<1>(access, input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<1>(access, input_U, cvt.src_U, row_data_size / 2);
+            ReceiveData<1>(access, input_V, cvt.src_V, row_data_size / 2);
             break;
         case InputFormat::YUV420_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 4);
+            ReceiveData<1>(access, input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<1>(access, input_U, cvt.src_U, row_data_size / 4);
+            ReceiveData<1>(access, input_V, cvt.src_V, row_data_size / 4);
             break;
         case InputFormat::YUV422_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 2);
+            ReceiveData<2>(access, input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<2>(access, input_U, cvt.src_U, row_data_size / 2);
+            ReceiveData<2>(access, input_V, cvt.src_V, row_data_size / 2);
             break;
         case InputFormat::YUV420_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 4);
+            ReceiveData<2>(access, input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<2>(access, input_U, cvt.src_U, row_data_size / 4);
+            ReceiveData<2>(access, input_V, cvt.src_V, row_data_size / 4);
             break;
         case InputFormat::YUYV422_Interleaved:
             input_U = nullptr;
             input_V = nullptr;
-            ReceiveData<1>(memory, input_Y, cvt.src_YUYV, row_data_size * 2);
+            ReceiveData<1>(access, input_Y, cvt.src_YUYV, row_data_size * 2);
             break;
         }
 
-        // Note(yuriks): If additional optimization is required, input_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.get(),
-                        cvt.input_line_width, row_height, cvt.coefficients);
-
-        u32* output_buffer = reinterpret_cast<u32*>(data_buffer.get());
+        // Only the last strip can be shorter, so the map is rarely rebuilt
+        if (row_height != tile_map_height) {
+            tile_map = BuildTileMap(cvt.rotation, cvt.block_alignment, row_height,
+                                    cvt.input_line_width);
+            tile_map_height = row_height;
+        }
 
-        for (std::size_t i = 0; i < num_tiles; ++i) {
-            int image_strip_width = 0;
-            int output_stride = 0;
+        std::size_t tile_stride = 8;
+        if (cvt.block_alignment == BlockAlignment::Block8x8) {
+            tile_stride = TILE_SIZE;
+        } else if (cvt.rotation == Rotation::Clockwise_90 ||
+                   cvt.rotation == Rotation::Clockwise_270) {
+            tile_stride = 8 * row_height;
+        }
 
-            switch (cvt.rotation) {
-            case Rotation::None:
-                RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_90:
-                RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            case Rotation::Clockwise_180:
-                // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
-                // since the rotates are done individually on each tile.
-                RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_270:
-                RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
+        for (unsigned int line = 0; line < row_height; ++line) {
+            convert_line(input_Y, input_U, input_V, line_buffer.data(), cvt.input_line_width, line,
+                         cvt.coefficients);
+
+            const u32* line_map = &tile_map[line * 8];
+            for (std::size_t tile = 0; tile < num_tiles; ++tile) {
+                const std::size_t out_tile = reverse_tiles ? num_tiles - tile - 1 : tile;
+                u32* out = &output_buffer[out_tile * tile_stride];
+                const u32* in = &line_buffer[tile * 8];
+                for (unsigned int x = 0; x < 8; ++x) {
+                    out[line_map[x]] = in[x];
+                }
             }
+        }
 
-            switch (cvt.block_alignment) {
-            case BlockAlignment::Linear:
-                WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
-                output_buffer += output_stride;
-                break;
-            case BlockAlignment::Block8x8:
-                WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
-                output_buffer += TILE_SIZE;
-                break;
-            }
+        send_data(access, output_buffer.data(), cvt.dst, (int)row_data_size, (u8)cvt.alpha);
+    }
+}
+
+void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cvt) {
+    const auto access = [&memory](const ConversionBuffer& buf, std::size_t) {
+        return memory.GetPointer(buf.address);
+    };
+    PerformConversion(access, cvt);
+}
+
+StagedConversion::StagedConversion(Memory::MemorySystem& memory,
+                                   const ConversionConfiguration& cvt)
+    : cvt(cvt) {
+    const auto stage = [&memory](StagedBuffer& staged, const ConversionBuffer& buf,
+                                 std::size_t span) {
+        staged.address = buf.address;
+        staged.data.resize(span);
+        const u8* source = memory.GetPointer(buf.address);
+        if (source != nullptr && span != 0) {
+            std::memcpy(staged.data.data(), source, span);
         }
+    };
+
+    // Strips only split the transfers, each of them covers whole transfer units
+    const std::size_t num_pixels = cvt.input_line_width * cvt.input_lines;
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+        stage(src_Y, cvt.src_Y, GetReceiveSpan<1>(cvt.src_Y, num_pixels));
+        stage(src_U, cvt.src_U, GetReceiveSpan<1>(cvt.src_U, num_pixels / 2));
+        stage(src_V, cvt.src_V, GetReceiveSpan<1>(cvt.src_V, num_pixels / 2));
+        break;
+    case InputFormat::YUV420_Indiv8:
+        stage(src_Y, cvt.src_Y, GetReceiveSpan<1>(cvt.src_Y, num_pixels));
+        stage(src_U, cvt.src_U, GetReceiveSpan<1>(cvt.src_U, num_pixels / 4));
+        stage(src_V, cvt.src_V, GetReceiveSpan<1>(cvt.src_V, num_pixels / 4));
+        break;
+    case InputFormat::YUV422_Indiv16:
+        stage(src_Y, cvt.src_Y, GetReceiveSpan<2>(cvt.src_Y, num_pixels));
+        stage(src_U, cvt.src_U, GetReceiveSpan<2>(cvt.src_U, num_pixels / 2));
+        stage(src_V, cvt.src_V, GetReceiveSpan<2>(cvt.src_V, num_pixels / 2));
+        break;
+    case InputFormat::YUV420_Indiv16:
+        stage(src_Y, cvt.src_Y, GetReceiveSpan<2>(cvt.src_Y, num_pixels));
+        stage(src_U, cvt.src_U, GetReceiveSpan<2>(cvt.src_U, num_pixels / 4));
+        stage(src_V, cvt.src_V, GetReceiveSpan<2>(cvt.src_V, num_pixels / 4));
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        stage(src_YUYV, cvt.src_YUYV, GetReceiveSpan<1>(cvt.src_YUYV, num_pixels * 2));
+        break;
+    }
 
-        // Note(yuriks): If additional optimization is required, output_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        SendData(memory, reinterpret_cast<u32*>(data_buffer.get()), cvt.dst, (int)row_data_size,
-                 cvt.output_format, (u8)cvt.alpha);
+    // Output units are rounded up per strip, so the strips are summed up one by one. The output
+    // is only written back, there is nothing to copy in.
+    std::size_t dst_span = 0;
+    for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
+        const unsigned int row_height = std::min(cvt.input_lines - y, 8u);
+        dst_span += GetSendSpan(cvt.output_format, cvt.dst, row_height * cvt.input_line_width);
     }
+    dst.address = cvt.dst.address;
+    dst.data.resize(dst_span);
+}
+
+u8* StagedConversion::GetStagedData(const ConversionBuffer& buf, std::size_t size) {
+    StagedBuffer* staged = nullptr;
+    if (&buf == &cvt.src_Y) {
+        staged = &src_Y;
+    } else if (&buf == &cvt.src_U) {
+        staged = &src_U;
+    } else if (&buf == &cvt.src_V) {
+        staged = &src_V;
+    } else if (&buf == &cvt.src_YUYV) {
+        staged = &src_YUYV;
+    } else {
+        ASSERT(&buf == &cvt.dst);
+        staged = &dst;
+    }
+
+    // Wraps around to a huge offset if the buffer has moved before the staged range
+    const std::size_t offset = buf.address - staged->address;
+    if (offset > staged->data.size() || size > staged->data.size() - offset) {
+        return nullptr;
+    }
+    return staged->data.data() + offset;
+}
+
+void StagedConversion::Run() {
+    PerformConversion(
+        [this](const ConversionBuffer& buf, std::size_t size) { return GetStagedData(buf, size); },
+        cvt);
+}
+
+void StagedConversion::Finish(Memory::MemorySystem& memory) const {
+    // The region was flushed when the conversion started, but the guest may have used it since
+    Memory::RasterizerFlushVirtualRegion(dst.address, static_cast<u32>(dst.data.size()),
+                                         Memory::FlushMode::Invalidate);
+
+    // Only the transfer units are written back, the gaps between them keep whatever the guest
+    // has put there in the meantime
+    u8* output = memory.GetPointer(dst.address);
+    if (output != nullptr) {
+        const std::size_t unit_size = GetSendUnitSize(cvt.output_format, cvt.dst);
+        const std::size_t stride = unit_size + cvt.dst.gap;
+        for (std::size_t offset = 0; offset < dst.data.size(); offset += stride) {
+            std::memcpy(output + offset, dst.data.data() + offset,
+                        std::min(unit_size, dst.data.size() - offset));
+        }
+    }
+}
+
+void StagedConversion::AdvanceBuffers(ConversionConfiguration& out_cvt) const {
+    // The conversion only advances the DMA buffers, everything else is left as configured
+    out_cvt.src_Y = cvt.src_Y;
+    out_cvt.src_U = cvt.src_U;
+    out_cvt.src_V = cvt.src_V;
+    out_cvt.src_YUYV = cvt.src_YUYV;
+    out_cvt.dst = cvt.dst;
 }
 } // namespace HW::Y2R
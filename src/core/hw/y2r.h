@@ -4,14 +4,59 @@
 
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "common/common_types.h"
+#include "core/hle/service/y2r_u.h"
+
 namespace Memory {
 class MemorySystem;
 }
 
-namespace Service::Y2R {
-struct ConversionConfiguration;
-} // namespace Service::Y2R
-
 namespace HW::Y2R {
+
+/**
+ * Gives the host memory backing the next `size` bytes, gaps included, that a conversion transfers
+ * from or to one of its buffers, starting at the buffer's current address. Returning nullptr
+ * drops the transfer: input reads as zero and output is discarded.
+ */
+using BufferAccessor =
+    std::function<u8*(const Service::Y2R::ConversionBuffer& buf, std::size_t size)>;
+
 void PerformConversion(Memory::MemorySystem& memory, Service::Y2R::ConversionConfiguration& cvt);
+void PerformConversion(const BufferAccessor& access, Service::Y2R::ConversionConfiguration& cvt);
+
+/**
+ * A conversion that can run on another thread. The input is copied out of guest memory when it is
+ * created and the output is only written back by Finish, so Run never touches guest memory.
+ * Creating and finishing it have to happen on the emulation thread.
+ */
+class StagedConversion {
+public:
+    StagedConversion(Memory::MemorySystem& memory,
+                     const Service::Y2R::ConversionConfiguration& cvt);
+
+    /// Converts the staged input into the staged output
+    void Run();
+
+    /// Writes the output back to guest memory
+    void Finish(Memory::MemorySystem& memory) const;
+
+    /// Advances the buffers of `cvt` like a conversion done in place would have
+    void AdvanceBuffers(Service::Y2R::ConversionConfiguration& cvt) const;
+
+private:
+    struct StagedBuffer {
+        /// Guest address of the first staged byte
+        VAddr address = 0;
+        std::vector<u8> data;
+    };
+
+    u8* GetStagedData(const Service::Y2R::ConversionBuffer& buf, std::size_t size);
+
+    Service::Y2R::ConversionConfiguration cvt;
+    StagedBuffer src_Y, src_U, src_V, src_YUYV, dst;
+};
+
 } // namespace HW::Y2R
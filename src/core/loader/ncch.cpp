@@ -80,7 +80,16 @@ ResultStatus AppLoader_NCCH::LoadExec(std::shared_ptr<Kernel::Process>& process)
     if (!is_loaded)
         return ResultStatus::ErrorNotLoaded;
 
+    // Reserve the whole image including .bss, so that the code is read and decompressed into the
+    // buffer that becomes the codeset memory, and adding .bss doesn't reallocate it
+    const auto& codeset_info = overlay_ncch->exheader_header.codeset_info;
+    const u32 bss_page_size = (codeset_info.bss_size + 0xFFF) & ~0xFFF;
     std::vector<u8> code;
+    code.reserve((codeset_info.text.num_max_pages + codeset_info.ro.num_max_pages +
+                  codeset_info.data.num_max_pages) *
+                     Memory::PAGE_SIZE +
+                 bss_page_size);
+
     u64_le program_id;
     if (ResultStatus::Success == ReadCode(code) &&
         ResultStatus::Success == ReadProgramId(program_id)) {
@@ -103,7 +112,6 @@ ResultStatus AppLoader_NCCH::LoadExec(std::shared_ptr<Kernel::Process>& process)
 
         // TODO(yuriks): Not sure if the bss size is added to the page-aligned .data size or just
         //               to the regular size. Playing it safe for now.
-        u32 bss_page_size = (overlay_ncch->exheader_header.codeset_info.bss_size + 0xFFF) & ~0xFFF;
         code.resize(code.size() + bss_page_size, 0);
 
         codeset->DataSegment().offset =
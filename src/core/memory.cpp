@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include "audio_core/dsp_interface.h"
@@ -87,22 +88,25 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, u8* memor
     RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
 
-    u32 end = base + size;
-    while (base != end) {
-        ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", base);
+    const u32 end = base + size;
+    ASSERT_MSG(end <= PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", end - 1);
 
-        page_table.attributes[base] = type;
-        page_table.pointers[base] = memory;
+    if (type != PageType::Memory) {
+        // Unmapped and special pages carry no pointer, so the whole run can be filled at once
+        std::fill(page_table.attributes.begin() + base, page_table.attributes.begin() + end, type);
+        std::fill(page_table.pointers.begin() + base, page_table.pointers.begin() + end, nullptr);
+        return;
+    }
 
+    for (; base != end; ++base, memory += PAGE_SIZE) {
         // If the memory to map is already rasterizer-cached, mark the page
-        if (type == PageType::Memory && impl->cache_marker.IsCached(base * PAGE_SIZE)) {
+        if (impl->cache_marker.IsCached(base * PAGE_SIZE)) {
             page_table.attributes[base] = PageType::RasterizerCachedMemory;
             page_table.pointers[base] = nullptr;
+        } else {
+            page_table.attributes[base] = PageType::Memory;
+            page_table.pointers[base] = memory;
         }
-
-        base += 1;
-        if (memory != nullptr)
-            memory += PAGE_SIZE;
     }
 }
 
@@ -271,6 +275,27 @@ u8* MemorySystem::GetPointer(const VAddr vaddr) {
     return nullptr;
 }
 
+u8* MemorySystem::GetContiguousPointer(const Kernel::Process& process, const VAddr vaddr,
+                                       const std::size_t size) {
+    if (size == 0 || size > 0x100000000ULL - vaddr) {
+        return nullptr;
+    }
+    const auto& page_table = process.vm_manager.page_table;
+    const std::size_t first_page = vaddr >> PAGE_BITS;
+    const std::size_t last_page = (vaddr + size - 1) >> PAGE_BITS;
+
+    u8* const base = page_table.pointers[first_page];
+    for (std::size_t page = first_page; page <= last_page; ++page) {
+        // Rasterizer cached pages need flushing and MMIO needs its handler, leave those to the
+        // block functions
+        if (page_table.attributes[page] != PageType::Memory ||
+            page_table.pointers[page] != base + (page - first_page) * PAGE_SIZE) {
+            return nullptr;
+        }
+    }
+    return base + (vaddr & PAGE_MASK);
+}
+
 std::string MemorySystem::ReadCString(VAddr vaddr, std::size_t max_length) {
     std::string string;
     string.reserve(max_length);
@@ -274,6 +274,13 @@ public:
 
     u8* GetPointer(VAddr vaddr);
 
+    /**
+     * Gets a pointer to a range of the process memory so that it can be accessed without copying
+     * it. Returns nullptr unless every page of the range is plain memory and the pages follow each
+     * other in host memory, in which case ReadBlock and WriteBlock have to be used instead.
+     */
+    u8* GetContiguousPointer(const Kernel::Process& process, VAddr vaddr, std::size_t size);
+
     bool IsValidPhysicalAddress(PAddr paddr);
 
     /// Gets offset in FCRAM from a pointer inside FCRAM range
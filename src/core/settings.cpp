@@ -75,6 +75,9 @@ void LogSetting(const std::string& name, const T& value) {
 void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     LogSetting("Core_UseCpuJit", Settings::values.use_cpu_jit);
+    LogSetting("Core_AsyncY2R", Settings::values.async_y2r);
+    LogSetting("Core_AsyncFSIO", Settings::values.async_fs_io);
+    LogSetting("Core_SkipIdleLoops", Settings::values.skip_idle_loops);
     LogSetting("Renderer_UseGLES", Settings::values.use_gles);
     LogSetting("Renderer_UseHwRenderer", Settings::values.use_hw_renderer);
     LogSetting("Renderer_UseHwShader", Settings::values.use_hw_shader);
@@ -92,7 +95,9 @@ void LogSettings() {
     LogSetting("Layout_SwapScreen", Settings::values.swap_screen);
     LogSetting("Layout_UprightScreen", Settings::values.upright_screen);
     LogSetting("Utility_DumpTextures", Settings::values.dump_textures);
+    LogSetting("Utility_DumpTexturesBlockWhenFull", Settings::values.dump_textures_block_when_full);
     LogSetting("Utility_CustomTextures", Settings::values.custom_textures);
+    LogSetting("Utility_CustomTexturesBudget", Settings::values.custom_textures_budget);
     LogSetting("Utility_UseDiskShaderCache", Settings::values.use_disk_shader_cache);
     LogSetting("Audio_EnableDspLle", Settings::values.enable_dsp_lle);
     LogSetting("Audio_EnableDspLleMultithread", Settings::values.enable_dsp_lle_multithread);
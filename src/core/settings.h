@@ -129,6 +129,9 @@ struct Values {
     // Core
     bool use_cpu_jit;
     int cpu_clock_percentage;
+    bool async_y2r;
+    bool async_fs_io;
+    bool skip_idle_loops;
 
     // Data Storage
     bool use_virtual_sd;
@@ -174,8 +177,10 @@ struct Values {
     std::string pp_shader_name;
 
     bool dump_textures;
+    bool dump_textures_block_when_full;
     bool custom_textures;
     bool preload_textures;
+    u32 custom_textures_budget; ///< MiB kept for lazily loaded custom textures, 0 for no limit
 
     bool use_vsync_new;
 
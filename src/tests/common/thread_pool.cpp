@@ -0,0 +1,35 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/thread_pool.h"
+
+namespace Common {
+
+TEST_CASE("ThreadPool::ParallelFor", "[common]") {
+    ThreadPool pool(3);
+    REQUIRE(pool.GetThreadCount() == 4);
+
+    for (std::size_t count : {0, 1, 4, 100}) {
+        std::vector<std::atomic<int>> calls(count);
+        pool.ParallelFor(count, [&](std::size_t i) { ++calls[i]; });
+        for (const auto& call : calls) {
+            REQUIRE(call == 1);
+        }
+    }
+}
+
+TEST_CASE("ThreadPool::ParallelFor nested", "[common]") {
+    ThreadPool pool(2);
+    std::atomic<int> calls{0};
+    // The inner jobs find the pool busy and run on the calling thread
+    pool.ParallelFor(4, [&](std::size_t) {
+        pool.ParallelFor(4, [&](std::size_t) { ++calls; });
+    });
+    REQUIRE(calls == 16);
+}
+
+} // namespace Common
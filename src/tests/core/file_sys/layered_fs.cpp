@@ -0,0 +1,140 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/layered_fs.h"
+
+namespace FileSys {
+
+namespace {
+
+class MemoryRomFSReader : public RomFSReader {
+public:
+    explicit MemoryRomFSReader(std::vector<u8> data) : data(std::move(data)) {}
+
+    std::size_t GetSize() const override {
+        return data.size();
+    }
+
+    std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer) override {
+        if (offset >= data.size()) {
+            return 0;
+        }
+        length = std::min(length, data.size() - offset);
+        std::memcpy(buffer, data.data() + offset, length);
+        return length;
+    }
+
+private:
+    std::vector<u8> data;
+};
+
+/// A RomFS with only the root directory in it
+std::shared_ptr<RomFSReader> MakeEmptyRomFS() {
+    const std::vector<u32_le> words = {
+        // Header
+        0x28, 0x28, 0x4, 0x2C, 0x18, 0x44, 0x4, 0x48, 0x0, 0x50,
+        // Directory hash table
+        0x0,
+        // Root directory metadata
+        0x0, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x0,
+        // File hash table
+        0xFFFFFFFF,
+        // Padding up to the file data
+        0x0, 0x0};
+    std::vector<u8> data(words.size() * sizeof(u32_le));
+    std::memcpy(data.data(), words.data(), data.size());
+    return std::make_shared<MemoryRomFSReader>(std::move(data));
+}
+
+std::vector<u8> ReadAll(RomFSReader& reader) {
+    std::vector<u8> data(reader.GetSize());
+    reader.ReadFile(0, data.size(), data.data());
+    return data;
+}
+
+} // namespace
+
+TEST_CASE("LayeredFS - Removed mod leaves no entries in the cached layout", "[core][file_sys]") {
+    const std::string test_dir = FileUtil::GetTempDirectory() + "citra_layered_fs_test/";
+    const std::string mod_path = test_dir + "romfs/";
+    const std::string ext_path = test_dir + "romfs_ext/";
+    const std::string cache_path = test_dir + "layout.bin";
+    FileUtil::DeleteDirRecursively(test_dir);
+    REQUIRE(FileUtil::CreateFullPath(mod_path + "created_dir/"));
+    FileUtil::WriteStringToFile(false, mod_path + "created_dir/file.bin", "created");
+    FileUtil::WriteStringToFile(false, mod_path + "file.bin", "created");
+    FileUtil::WriteStringToFile(false, mod_path + "kept.bin", "kept");
+
+    const auto base = MakeEmptyRomFS();
+    {
+        LayeredFS modded(base, mod_path, ext_path, true, cache_path);
+        RomFSHeader header;
+        modded.ReadFile(0, sizeof(header), reinterpret_cast<u8*>(&header));
+        REQUIRE(header.directory_metadata_table.length > 0x18);
+    }
+    REQUIRE(FileUtil::Exists(cache_path));
+
+    // Removing the mod restores the base tree from the cache and rebuilds the mod layer upon it
+    REQUIRE(FileUtil::DeleteDirRecursively(mod_path + "created_dir/"));
+    REQUIRE(FileUtil::Delete(mod_path + "file.bin"));
+    LayeredFS rebuilt(base, mod_path, ext_path, true, cache_path);
+    LayeredFS uncached(base, mod_path, ext_path, true, "");
+
+    RomFSHeader header;
+    rebuilt.ReadFile(0, sizeof(header), reinterpret_cast<u8*>(&header));
+    // Only the root directory and kept.bin are left
+    CHECK(header.directory_metadata_table.length == 0x18);
+    CHECK(header.file_metadata_table.length == 0x20 + 0x10);
+    CHECK(ReadAll(rebuilt) == ReadAll(uncached));
+
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
+TEST_CASE("LayeredFS - Patched file read from a cached layout", "[core][file_sys]") {
+    const std::string test_dir = FileUtil::GetTempDirectory() + "citra_layered_fs_test/";
+    const std::string base_path = test_dir + "base/";
+    const std::string mod_path = test_dir + "romfs/";
+    const std::string ext_path = test_dir + "romfs_ext/";
+    const std::string cache_path = test_dir + "layout.bin";
+    FileUtil::DeleteDirRecursively(test_dir);
+    REQUIRE(FileUtil::CreateFullPath(base_path));
+    REQUIRE(FileUtil::CreateFullPath(mod_path));
+    REQUIRE(FileUtil::CreateFullPath(ext_path));
+    FileUtil::WriteStringToFile(false, base_path + "file.bin", "original data");
+
+    // Overwrites the first 8 bytes of the file
+    const std::string ips = std::string("PATCH") + std::string("\0\0\0\0\x08", 5) + "patched!" +
+                            "EOF";
+    FileUtil::WriteStringToFile(false, ext_path + "file.bin.ips", ips);
+
+    // A base RomFS holding file.bin
+    const auto base = [&] {
+        LayeredFS builder(MakeEmptyRomFS(), base_path, test_dir + "none/", true, "");
+        return std::make_shared<MemoryRomFSReader>(ReadAll(builder));
+    }();
+
+    {
+        LayeredFS modded(base, mod_path, ext_path, true, cache_path);
+    }
+    REQUIRE(FileUtil::Exists(cache_path));
+
+    // Nothing changed, so the whole layout comes from the cache and the patch is applied on read
+    LayeredFS cached(base, mod_path, ext_path, true, cache_path);
+    LayeredFS uncached(base, mod_path, ext_path, true, "");
+
+    const auto data = ReadAll(cached);
+    const std::string expected = "patched! data";
+    CHECK(std::search(data.begin(), data.end(), expected.begin(), expected.end()) != data.end());
+    CHECK(data == ReadAll(uncached));
+
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
+} // namespace FileSys
@@ -180,6 +180,27 @@ TEST_CASE("HLERequestContext::PopulateFromIncomingCommandBuffer", "[core][kernel
         REQUIRE(process->vm_manager.UnmapRange(target_address, buffer->size()) == RESULT_SUCCESS);
     }
 
+    SECTION("exposes a contiguous MappedBuffer in place") {
+        auto buffer = std::make_shared<std::vector<u8>>(Memory::PAGE_SIZE);
+
+        VAddr target_address = 0x10000000;
+        auto result = process->vm_manager.MapBackingMemory(target_address, buffer->data(),
+                                                           buffer->size(), MemoryState::Private);
+        REQUIRE(result.Code() == RESULT_SUCCESS);
+
+        const u32_le input[]{
+            IPC::MakeHeader(0, 0, 2),
+            IPC::MappedBufferDesc(buffer->size(), IPC::R),
+            target_address,
+        };
+
+        context.PopulateFromIncomingCommandBuffer(input, *process);
+
+        CHECK(context.GetMappedBuffer(0).GetPointer() == buffer->data());
+
+        REQUIRE(process->vm_manager.UnmapRange(target_address, buffer->size()) == RESULT_SUCCESS);
+    }
+
     SECTION("translates mixed params") {
         auto buffer_static = std::make_shared<std::vector<u8>>(Memory::PAGE_SIZE);
         std::fill(buffer_static->begin(), buffer_static->end(), 0xCE);
@@ -0,0 +1,71 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <catch2/catch.hpp>
+#include "core/hle/kernel/idle_loop_detector.h"
+
+namespace Kernel {
+
+namespace {
+
+constexpr u32 SleepThread = 0x0A;
+constexpr u32 GetSystemTick = 0x28;
+constexpr u32 LoopPC = 0x00101000;
+/// svcSleepThread(0): the nanoseconds in r0 and r1
+constexpr std::array<u32, 4> SleepArgs{0, 0, 0, 0};
+
+} // namespace
+
+TEST_CASE("IdleLoopDetector detects spin loops", "[core][kernel]") {
+    IdleLoopDetector detector(2);
+    u64 ticks = 1000;
+    for (u32 i = 0; i < IdleLoopDetector::SpinRepeatThreshold; ++i) {
+        detector.OnSVC(0, 1, SleepThread, LoopPC, SleepArgs, ticks += 100);
+        REQUIRE_FALSE(detector.IsSpinning(0));
+    }
+    detector.OnSVC(0, 1, SleepThread, LoopPC, SleepArgs, ticks += 100);
+    REQUIRE(detector.IsSpinning(0));
+    // Cores are tracked separately
+    REQUIRE_FALSE(detector.IsSpinning(1));
+
+    SECTION("another SVC breaks the loop") {
+        detector.OnSVC(0, 1, GetSystemTick, LoopPC, SleepArgs, ticks += 100);
+        REQUIRE_FALSE(detector.IsSpinning(0));
+    }
+
+    SECTION("another call site breaks the loop") {
+        detector.OnSVC(0, 1, SleepThread, LoopPC + 0x40, SleepArgs, ticks += 100);
+        REQUIRE_FALSE(detector.IsSpinning(0));
+    }
+
+    SECTION("other arguments break the loop") {
+        // A loop counter or pointer kept in r2 means the guest is making progress
+        detector.OnSVC(0, 1, SleepThread, LoopPC, {0, 0, 1, 0}, ticks += 100);
+        REQUIRE_FALSE(detector.IsSpinning(0));
+    }
+
+    SECTION("another thread breaks the loop") {
+        detector.OnSVC(0, 2, SleepThread, LoopPC, SleepArgs, ticks += 100);
+        REQUIRE_FALSE(detector.IsSpinning(0));
+    }
+
+    SECTION("a long gap breaks the loop") {
+        detector.OnSVC(0, 1, SleepThread, LoopPC, SleepArgs,
+                       ticks += IdleLoopDetector::MaxSpinGap + 1);
+        REQUIRE_FALSE(detector.IsSpinning(0));
+    }
+
+    SECTION("skipped ticks don't break the loop") {
+        detector.RecordSkip(0, 100000);
+        detector.OnSVC(0, 1, SleepThread, LoopPC, SleepArgs, ticks += 100000 + 100);
+        REQUIRE(detector.IsSpinning(0));
+
+        detector.RecordSkip(0, 50000);
+        REQUIRE(detector.GetStats().skipped_loops == 2);
+        REQUIRE(detector.GetStats().skipped_ticks == 150000);
+    }
+}
+
+} // namespace Kernel
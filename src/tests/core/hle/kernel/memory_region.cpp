@@ -0,0 +1,214 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/page_bitmap.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+TEST_CASE("PageBitmap matches a plain bitmap", "[core][kernel]") {
+    constexpr u32 NumPages = 1000;
+    PageBitmap bitmap;
+    bitmap.Reset(NumPages);
+    std::vector<bool> free(NumPages, true);
+
+    const auto find_first_fit = [&](u32 count) -> std::optional<u32> {
+        u32 run = 0;
+        for (u32 page = 0; page < NumPages; ++page) {
+            run = free[page] ? run + 1 : 0;
+            if (run == count) {
+                return page + 1 - count;
+            }
+        }
+        return std::nullopt;
+    };
+
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<u32> page_dist(0, NumPages - 1);
+    std::uniform_int_distribution<u32> count_dist(1, 150);
+    for (int i = 0; i < 2000; ++i) {
+        const u32 first = page_dist(rng);
+        const u32 count = std::min(count_dist(rng), NumPages - first);
+
+        bool all_free = true;
+        bool all_used = true;
+        for (u32 page = first; page < first + count; ++page) {
+            all_free = all_free && free[page];
+            all_used = all_used && !free[page];
+        }
+        REQUIRE(bitmap.IsFree(first, count) == all_free);
+        if (all_free) {
+            bitmap.MarkUsed(first, count);
+        } else if (all_used) {
+            bitmap.MarkFree(first, count);
+        }
+        for (u32 page = first; page < first + count; ++page) {
+            free[page] = all_free ? false : all_used ? true : bool(free[page]);
+        }
+
+        const u32 fit_count = count_dist(rng);
+        REQUIRE(bitmap.FindFirstFit(fit_count) == find_first_fit(fit_count));
+
+        const u32 limit = page_dist(rng);
+        const auto run = bitmap.FindLastFreeRun(limit);
+        u32 last = limit;
+        while (last > 0 && !free[last - 1]) {
+            --last;
+        }
+        if (last == 0) {
+            REQUIRE(!run);
+        } else {
+            u32 run_first = last - 1;
+            while (run_first > 0 && free[run_first - 1]) {
+                --run_first;
+            }
+            REQUIRE(run == std::make_pair(run_first, last));
+        }
+    }
+
+    u32 free_count = 0;
+    u32 runs = 0;
+    for (u32 page = 0; page < NumPages; ++page) {
+        free_count += free[page];
+        runs += free[page] && (page == 0 || !free[page - 1]);
+    }
+    REQUIRE(bitmap.GetFreeCount() == free_count);
+    REQUIRE(bitmap.GetFreeRunCount() == runs);
+}
+
+TEST_CASE("MemoryRegionInfo placement", "[core][kernel]") {
+    constexpr u32 Base = 0x100000;
+    constexpr u32 Size = 0x100000;
+    constexpr u32 PageSize = Memory::PAGE_SIZE;
+    MemoryRegionInfo region;
+    region.Reset(Base, Size);
+
+    SECTION("linear allocations are first-fit from the bottom") {
+        REQUIRE(region.LinearAllocate(2 * PageSize) == Base);
+        REQUIRE(region.LinearAllocate(PageSize) == Base + 2 * PageSize);
+        region.Free(Base, 2 * PageSize);
+        REQUIRE(region.LinearAllocate(3 * PageSize) == Base + 3 * PageSize);
+        REQUIRE(region.LinearAllocate(PageSize) == Base);
+        REQUIRE_FALSE(region.LinearAllocate(Base + 3 * PageSize, PageSize));
+        REQUIRE(region.LinearAllocate(Base + PageSize, PageSize));
+        REQUIRE_FALSE(region.LinearAllocate(Base + Size, PageSize));
+        REQUIRE(region.used == 6 * PageSize);
+    }
+
+    SECTION("heap allocations take the highest free pages") {
+        REQUIRE(region.LinearAllocate(Base + Size - 2 * PageSize, PageSize));
+        const auto blocks = region.HeapAllocate(3 * PageSize);
+        MemoryRegionInfo::IntervalSet expected;
+        expected += MemoryRegionInfo::Interval(Base + Size - PageSize, Base + Size);
+        expected +=
+            MemoryRegionInfo::Interval(Base + Size - 4 * PageSize, Base + Size - 2 * PageSize);
+        REQUIRE(blocks == expected);
+
+        for (const auto& block : blocks) {
+            region.Free(block.lower(), block.upper() - block.lower());
+        }
+        REQUIRE(region.used == PageSize);
+        REQUIRE(region.HeapAllocate(Size).empty());
+    }
+
+    SECTION("partial pages are rounded up") {
+        const auto blocks = region.HeapAllocate(PageSize + 0x10);
+        REQUIRE(blocks.iterative_size() == 1);
+        REQUIRE(blocks.begin()->lower() == Base + Size - 2 * PageSize + PageSize - 0x10);
+        REQUIRE(blocks.begin()->upper() == Base + Size);
+        REQUIRE(region.GetFragmentationInfo().free_size == Size - 2 * PageSize);
+
+        region.Free(blocks.begin()->lower(), PageSize + 0x10);
+        REQUIRE(region.used == 0);
+        REQUIRE(region.GetFragmentationInfo().largest_free_block == Size);
+    }
+
+    SECTION("fragmentation info") {
+        for (u32 i = 0; i < 8; ++i) {
+            REQUIRE(region.LinearAllocate(PageSize));
+        }
+        for (u32 i = 0; i < 8; i += 2) {
+            region.Free(Base + i * PageSize, PageSize);
+        }
+        const auto info = region.GetFragmentationInfo();
+        REQUIRE(info.free_size == Size - 4 * PageSize);
+        REQUIRE(info.free_block_count == 5);
+        REQUIRE(info.largest_free_block == Size - 8 * PageSize);
+    }
+}
+
+TEST_CASE("MemoryRegionInfo allocation trace benchmark", "[.][benchmark][core][kernel]") {
+    constexpr u32 PageSize = Memory::PAGE_SIZE;
+    constexpr std::size_t NumOperations = 200000;
+
+    // A 64MB application region, as in the default memory layout
+    MemoryRegionInfo region;
+    region.Reset(0, 0x04000000);
+
+    // Mimics the svcControlMemory pattern of titles with a custom allocator on top of the kernel:
+    // a large linear heap for graphics, then a stream of small heap blocks and linear buffers
+    // allocated and freed out of order, with the region kept close to full.
+    const auto base_linear = region.LinearAllocate(0x01000000);
+    REQUIRE(base_linear);
+
+    struct Allocation {
+        MemoryRegionInfo::IntervalSet heap_blocks;
+        u32 linear_offset;
+        u32 size;
+    };
+    std::vector<Allocation> live;
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<u32> small_pages(1, 16);
+    std::uniform_int_distribution<u32> percent(0, 99);
+
+    std::size_t failures = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < NumOperations; ++i) {
+        if (!live.empty() && (percent(rng) < 45 || region.used > 0x03800000)) {
+            std::uniform_int_distribution<std::size_t> index_dist(0, live.size() - 1);
+            const std::size_t index = index_dist(rng);
+            const Allocation& allocation = live[index];
+            if (allocation.heap_blocks.empty()) {
+                region.Free(allocation.linear_offset, allocation.size);
+            } else {
+                for (const auto& block : allocation.heap_blocks) {
+                    region.Free(block.lower(), block.upper() - block.lower());
+                }
+            }
+            live[index] = std::move(live.back());
+            live.pop_back();
+        } else if (percent(rng) < 50) {
+            const u32 size = small_pages(rng) * PageSize;
+            if (const auto offset = region.LinearAllocate(size)) {
+                live.push_back({{}, *offset, size});
+            } else {
+                ++failures;
+            }
+        } else {
+            const u32 size = small_pages(rng) * PageSize;
+            auto blocks = region.HeapAllocate(size);
+            if (!blocks.empty()) {
+                live.push_back({std::move(blocks), 0, size});
+            } else {
+                ++failures;
+            }
+        }
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    const auto info = region.GetFragmentationInfo();
+    WARN(NumOperations << " operations: " << elapsed.count() / NumOperations
+                       << " ns per operation, " << failures << " failed; free 0x" << std::hex
+                       << info.free_size << " in " << std::dec << info.free_block_count
+                       << " blocks, largest 0x" << std::hex << info.largest_free_block);
+    REQUIRE(region.used <= 0x04000000);
+}
+
+} // namespace Kernel
@@ -0,0 +1,81 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <set>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/hle/kernel/slab_heap.h"
+
+namespace Kernel {
+
+namespace {
+
+struct FakeObject {
+    explicit FakeObject(u32 value) : value(value) {}
+    u32 value;
+    u64 padding[5]{};
+};
+
+} // namespace
+
+TEST_CASE("SlabHeap", "[core][kernel]") {
+    auto heap = std::make_shared<SlabHeap>(4);
+    const SlabAllocator<FakeObject> allocator(heap);
+
+    SECTION("blocks are recycled") {
+        std::vector<std::shared_ptr<FakeObject>> objects;
+        std::set<FakeObject*> addresses;
+        for (u32 i = 0; i < 4; ++i) {
+            objects.push_back(std::allocate_shared<FakeObject>(allocator, i));
+            addresses.insert(objects.back().get());
+        }
+        REQUIRE(heap->GetUsedCount() == 4);
+        REQUIRE(heap->GetCapacity() == 4);
+
+        objects.clear();
+        REQUIRE(heap->GetUsedCount() == 0);
+        for (u32 i = 0; i < 4; ++i) {
+            objects.push_back(std::allocate_shared<FakeObject>(allocator, i));
+            REQUIRE(addresses.count(objects.back().get()) == 1);
+            REQUIRE(objects.back()->value == i);
+        }
+        REQUIRE(heap->GetCapacity() == 4);
+    }
+
+    SECTION("the heap grows by whole chunks") {
+        std::vector<std::shared_ptr<FakeObject>> objects;
+        for (u32 i = 0; i < 9; ++i) {
+            objects.push_back(std::allocate_shared<FakeObject>(allocator, i));
+        }
+        REQUIRE(heap->GetUsedCount() == 9);
+        REQUIRE(heap->GetCapacity() == 12);
+        for (u32 i = 0; i < 9; ++i) {
+            REQUIRE(objects[i]->value == i);
+        }
+    }
+
+    SECTION("other sizes bypass the slab") {
+        auto object = std::allocate_shared<FakeObject>(allocator, 1);
+        auto other = std::allocate_shared<u64>(SlabAllocator<u64>(allocator), 2);
+        REQUIRE(heap->GetUsedCount() == 1);
+        other.reset();
+        REQUIRE(heap->GetUsedCount() == 1);
+    }
+
+    SECTION("objects keep the heap alive") {
+        std::weak_ptr<SlabHeap> weak_heap;
+        std::shared_ptr<FakeObject> object;
+        {
+            auto local_heap = std::make_shared<SlabHeap>(4);
+            weak_heap = local_heap;
+            object = std::allocate_shared<FakeObject>(SlabAllocator<FakeObject>(local_heap), 1);
+        }
+        REQUIRE_FALSE(weak_heap.expired());
+        object.reset();
+        REQUIRE(weak_heap.expired());
+    }
+}
+
+} // namespace Kernel
@@ -0,0 +1,186 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/errors.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/svc_replay.h"
+#include "core/hle/kernel/svc_trace.h"
+#include "core/hle/kernel/thread.h"
+#include "core/hle/kernel/timer.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+namespace {
+
+SVCTraceRecord MakeRecord(u64 ticks, u32 svc_id, std::array<u32, 8> args,
+                          std::array<u32, 4> results = {}) {
+    SVCTraceRecord record{};
+    record.ticks = ticks;
+    record.thread_id = 1;
+    record.svc_id = svc_id;
+    std::copy(args.begin(), args.end(), record.args.begin());
+    std::copy(results.begin(), results.end(), record.results.begin());
+    return record;
+}
+
+} // namespace
+
+TEST_CASE("SVCTraceRecorder", "[core][kernel]") {
+    const std::string path = FileUtil::GetTempDirectory() + "svc_trace_test.bin";
+    std::vector<SVCTraceRecord> records;
+    for (u32 i = 0; i < 20000; ++i) {
+        records.push_back(MakeRecord(i * 100, i % 0x7E, {i, i + 1}, {0, i}));
+    }
+
+    SVCTraceRecorder recorder;
+    REQUIRE(recorder.Start(path));
+    REQUIRE(recorder.IsEnabled());
+    for (const SVCTraceRecord& record : records) {
+        // Don't outrun the writer, so that nothing is dropped
+        while (recorder.GetRecordCount() + 8192 < record.ticks / 100) {
+        }
+        recorder.Record(record);
+    }
+    recorder.Stop();
+    REQUIRE_FALSE(recorder.IsEnabled());
+    REQUIRE(recorder.GetDroppedCount() == 0);
+    REQUIRE(recorder.GetRecordCount() == records.size());
+
+    const auto loaded = LoadSVCTrace(path);
+    FileUtil::Delete(path);
+    REQUIRE(loaded);
+    REQUIRE(loaded->size() == records.size());
+    const auto summaries = recorder.GetSummary();
+    const auto expected_summaries = SummarizeSVCTrace(*loaded);
+    REQUIRE(summaries.size() == expected_summaries.size());
+    for (std::size_t i = 0; i < summaries.size(); ++i) {
+        REQUIRE(summaries[i].svc_id == expected_summaries[i].svc_id);
+        REQUIRE(summaries[i].calls == expected_summaries[i].calls);
+        REQUIRE(summaries[i].repeated_calls == expected_summaries[i].repeated_calls);
+    }
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        REQUIRE((*loaded)[i].ticks == records[i].ticks);
+        REQUIRE((*loaded)[i].svc_id == records[i].svc_id);
+        REQUIRE((*loaded)[i].args == records[i].args);
+        REQUIRE((*loaded)[i].results == records[i].results);
+    }
+}
+
+TEST_CASE("SummarizeSVCTrace", "[core][kernel]") {
+    std::vector<SVCTraceRecord> records;
+    for (u32 i = 0; i < 10; ++i) {
+        // svcSleepThread(0) in a loop
+        records.push_back(MakeRecord(i, 0x0A, {}));
+        records.back().host_ns = 100;
+    }
+    records.push_back(MakeRecord(10, 0x18, {0x1234}));
+    records.back().host_ns = 50;
+    records.push_back(MakeRecord(11, 0x18, {0x1234}));
+    records.back().thread_id = 2;
+
+    const auto summaries = SummarizeSVCTrace(records);
+    REQUIRE(summaries.size() == 2);
+    REQUIRE(summaries[0].svc_id == 0x0A);
+    REQUIRE(summaries[0].calls == 10);
+    REQUIRE(summaries[0].repeated_calls == 9);
+    REQUIRE(summaries[0].host_ns == 1000);
+    REQUIRE(summaries[1].svc_id == 0x18);
+    REQUIRE(summaries[1].calls == 2);
+    // Made by different threads
+    REQUIRE(summaries[1].repeated_calls == 0);
+}
+
+TEST_CASE("SVCTraceReplayer", "[core][kernel]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+    SVCTraceReplayer replayer(kernel);
+    const auto& process = replayer.GetProcess();
+
+    constexpr Handle RecordedEvent = 0x00010001;
+    constexpr Handle RecordedTimer = 0x00020001;
+    constexpr u32 Success = 0;
+    const std::vector<SVCTraceRecord> records{
+        // CreateEvent(OneShot), CreateTimer(Sticky)
+        MakeRecord(1000, 0x17, {0, 0}, {Success, RecordedEvent}),
+        MakeRecord(1100, 0x1A, {0, 1}, {Success, RecordedTimer}),
+        // SetTimer(timer, initial = 1ms, interval = 0)
+        MakeRecord(1200, 0x1B, {RecordedTimer, 0, 1000000, 0, 0}, {Success}),
+        // SignalEvent(event)
+        MakeRecord(1300, 0x18, {RecordedEvent}, {Success}),
+        // SleepThread(0)
+        MakeRecord(1400, 0x0A, {0, 0}),
+        // SendSyncRequest, whose command buffer isn't in the trace
+        MakeRecord(1450, 0x32, {RecordedEvent}),
+        // ClearEvent on a handle the trace never created
+        MakeRecord(1500, 0x19, {0x12345678}, {ERR_INVALID_HANDLE.raw}),
+    };
+    for (const SVCTraceRecord& record : records) {
+        replayer.Replay(record);
+    }
+    REQUIRE(replayer.GetReplayedCount() == 6);
+    REQUIRE(replayer.GetSkippedCount() == 1);
+    REQUIRE(replayer.GetMismatchCount() == 0);
+
+    const auto event = process->handle_table.Get<Event>(replayer.Translate(RecordedEvent));
+    const auto timer = process->handle_table.Get<Timer>(replayer.Translate(RecordedTimer));
+    REQUIRE(event);
+    REQUIRE(timer);
+    REQUIRE_FALSE(event->ShouldWait(nullptr));
+    REQUIRE(timer->ShouldWait(nullptr));
+
+    // 1ms after SetTimer, at 268MHz
+    u64 ticks = 1200 + 268112;
+    replayer.Replay(MakeRecord(ticks, 0x19, {RecordedEvent}, {Success}));
+    REQUIRE(event->ShouldWait(nullptr));
+    REQUIRE_FALSE(timer->ShouldWait(nullptr));
+    REQUIRE(replayer.GetMismatchCount() == 0);
+
+    SECTION("sleeping threads wait for the recorded time") {
+        // SleepThread(1ms)
+        replayer.Replay(MakeRecord(ticks, 0x0A, {1000000, 0}));
+        REQUIRE(replayer.GetReplayedCount() == 8);
+        REQUIRE_FALSE(replayer.Replay(MakeRecord(ticks + 1000, 0x18, {RecordedEvent}, {Success})));
+        REQUIRE(replayer.GetBlockedCount() == 1);
+
+        REQUIRE(replayer.Replay(MakeRecord(ticks + 268112, 0x18, {RecordedEvent}, {Success})));
+        REQUIRE_FALSE(event->ShouldWait(nullptr));
+        REQUIRE(replayer.GetMismatchCount() == 0);
+    }
+
+    SECTION("created threads run the SVCs of new recorded threads") {
+        constexpr Handle RecordedThread = 0x00030001;
+        // CreateThread(priority = 0x30, entry, arg, stack top, processor = 1)
+        replayer.Replay(MakeRecord(ticks, 0x08, {0x30, 0x00100000, 0, 0x10000000, 1},
+                                   {Success, RecordedThread}));
+        const auto thread = process->handle_table.Get<Thread>(replayer.Translate(RecordedThread));
+        REQUIRE(thread);
+        REQUIRE(thread->processor_id == 0);
+
+        // WaitSynchronization1(event, -1) on the main thread, which blocks it. The handler returns
+        // a timeout, replaced by the result of the wait once the thread wakes up.
+        replayer.Replay(MakeRecord(ticks + 100, 0x24, {RecordedEvent, 0, 0xFFFFFFFF, 0xFFFFFFFF},
+                                   {RESULT_TIMEOUT.raw}));
+        // SignalEvent(event) on the new thread
+        SVCTraceRecord signal = MakeRecord(ticks + 200, 0x18, {RecordedEvent}, {Success});
+        signal.thread_id = 2;
+        REQUIRE(replayer.Replay(signal));
+        REQUIRE(kernel.GetCurrentThreadManager().GetCurrentThread() == thread.get());
+
+        // The main thread was woken up by the signal
+        REQUIRE(replayer.Replay(MakeRecord(ticks + 300, 0x19, {RecordedEvent}, {Success})));
+        REQUIRE(replayer.GetBlockedCount() == 0);
+        REQUIRE(replayer.GetMismatchCount() == 0);
+    }
+}
+
+} // namespace Kernel
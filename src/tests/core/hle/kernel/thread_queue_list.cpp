@@ -0,0 +1,140 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/thread_queue_list.h"
+
+namespace {
+
+struct FakeThread {
+    u32 priority;
+    Common::ThreadQueueListNode<FakeThread*> queue_node;
+};
+
+// Same number of levels as the kernel ready queue
+using ReadyQueue = Common::ThreadQueueList<FakeThread*, 64>;
+
+} // namespace
+
+TEST_CASE("ThreadQueueList", "[core][kernel]") {
+    ReadyQueue queue;
+    std::vector<FakeThread> threads(8);
+
+    SECTION("pops the best priority first, in FIFO order") {
+        const u32 priorities[]{48, 24, 48, 63, 24, 0, 48, 40};
+        for (std::size_t i = 0; i < threads.size(); ++i) {
+            threads[i].priority = priorities[i];
+            queue.push_back(priorities[i], &threads[i]);
+        }
+
+        const std::size_t expected[]{5, 1, 4, 7, 0, 2, 6, 3};
+        for (const std::size_t index : expected) {
+            REQUIRE(queue.get_first() == &threads[index]);
+            REQUIRE(queue.pop_first() == &threads[index]);
+        }
+        REQUIRE(queue.pop_first() == nullptr);
+        REQUIRE(queue.get_first() == nullptr);
+    }
+
+    SECTION("pop_first_better only returns strictly better threads") {
+        queue.push_back(48, &threads[0]);
+        queue.push_back(24, &threads[1]);
+
+        REQUIRE(queue.pop_first_better(24) == nullptr);
+        REQUIRE(queue.pop_first_better(25) == &threads[1]);
+        REQUIRE(queue.pop_first_better(48) == nullptr);
+        REQUIRE(queue.pop_first_better(63) == &threads[0]);
+        REQUIRE(queue.empty(48));
+    }
+
+    SECTION("remove, move and rotate keep the links consistent") {
+        for (std::size_t i = 0; i < 4; ++i) {
+            queue.push_back(48, &threads[i]);
+        }
+        queue.push_front(48, &threads[4]);
+
+        queue.remove(48, &threads[2]);
+        queue.remove(48, &threads[2]); // Removing a thread that isn't queued is a no-op
+        REQUIRE(queue.contains(&threads[2]) == static_cast<ReadyQueue::Priority>(-1));
+
+        queue.rotate(48);
+        queue.move(&threads[3], 48, 10);
+        REQUIRE(queue.contains(&threads[3]) == 10);
+
+        const std::size_t expected[]{3, 0, 1, 4};
+        for (const std::size_t index : expected) {
+            REQUIRE(queue.pop_first() == &threads[index]);
+        }
+        REQUIRE(queue.empty(48));
+        REQUIRE(queue.empty(10));
+    }
+
+    SECTION("clear unlinks every thread") {
+        for (std::size_t i = 0; i < threads.size(); ++i) {
+            queue.push_back(static_cast<u32>(i * 8), &threads[i]);
+        }
+        queue.clear();
+        REQUIRE(queue.get_first() == nullptr);
+        for (auto& thread : threads) {
+            REQUIRE_FALSE(thread.queue_node.queued);
+        }
+    }
+}
+
+TEST_CASE("ThreadQueueList scheduling benchmark", "[.][benchmark][core][kernel]") {
+    constexpr std::size_t NumThreads = 512;
+    constexpr std::size_t NumIterations = 1000000;
+
+    ReadyQueue queue;
+    std::vector<FakeThread> threads(NumThreads);
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<u32> priority_dist(24, 63);
+    // Priority changes can also boost a thread above the others, like mutex inheritance does
+    std::uniform_int_distribution<u32> boost_dist(16, 63);
+    for (auto& thread : threads) {
+        thread.priority = priority_dist(rng);
+        queue.push_back(thread.priority, &thread);
+    }
+
+    // Mimics the kernel: the running thread blocks or gets preempted, a waiting thread wakes up
+    // and occasionally changes priority, then the best ready thread is picked
+    std::uniform_int_distribution<std::size_t> thread_dist(0, NumThreads - 1);
+    FakeThread* current = queue.pop_first();
+    std::size_t switches = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < NumIterations; ++i) {
+        FakeThread& woken = threads[thread_dist(rng)];
+        if (&woken != current) {
+            if (i % 16 == 0) {
+                const u32 new_priority = boost_dist(rng);
+                queue.move(&woken, woken.priority, new_priority);
+                woken.priority = new_priority;
+            } else {
+                queue.remove(woken.priority, &woken);
+                queue.push_back(woken.priority, &woken);
+            }
+        }
+
+        FakeThread* next = queue.pop_first_better(current->priority);
+        if (next != nullptr) {
+            queue.push_front(current->priority, current);
+            current = next;
+            ++switches;
+        } else if (i % 4 == 0) {
+            // The current thread blocks and is woken up right away at the back of its level
+            queue.push_back(current->priority, current);
+            current = queue.pop_first();
+            ++switches;
+        }
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    WARN(NumIterations << " scheduling rounds over " << NumThreads << " threads, " << switches
+                       << " switches: " << elapsed.count() / NumIterations << " ns per round");
+    REQUIRE(current != nullptr);
+}
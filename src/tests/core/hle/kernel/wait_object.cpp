@@ -0,0 +1,173 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/arm/dyncom/arm_dyncom.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/thread.h"
+
+namespace Kernel {
+
+namespace {
+
+struct WaitEnvironment {
+    WaitEnvironment() : kernel(memory, timing, [] {}, 0, 1, 0) {
+        kernel.GetThreadManager(0).SetCPU(cpu);
+    }
+
+    /// Creates a thread sleeping on the given objects, like WaitSynchronizationN does
+    std::shared_ptr<Thread> MakeWaitingThread(u32 priority,
+                                              std::vector<std::shared_ptr<WaitObject>> objects,
+                                              bool wait_all = false) {
+        auto thread = std::make_shared<Thread>(kernel, 0);
+        thread->current_priority = thread->nominal_priority = priority;
+        thread->status = wait_all ? ThreadStatus::WaitSynchAll : ThreadStatus::WaitSynchAny;
+        for (auto& object : objects) {
+            object->AddWaitingThread(thread);
+        }
+        thread->wait_objects = std::move(objects);
+        return thread;
+    }
+
+    Core::Timing timing{1, 100};
+    Memory::MemorySystem memory;
+    ARM_DynCom cpu{nullptr, memory, USER32MODE, 0, nullptr};
+    KernelSystem kernel;
+};
+
+} // namespace
+
+TEST_CASE("WaitObject::WakeupAllWaitingThreads", "[core][kernel]") {
+    WaitEnvironment env;
+
+    SECTION("sticky events wake every waiter") {
+        auto event = env.kernel.CreateEvent(ResetType::Sticky);
+        std::vector<std::shared_ptr<Thread>> threads;
+        for (u32 i = 0; i < 8; ++i) {
+            threads.push_back(env.MakeWaitingThread(48 - i, {event}));
+        }
+        REQUIRE(event->GetWaitingThreads().size() == threads.size());
+
+        event->Signal();
+
+        REQUIRE(event->GetWaitingThreads().empty());
+        for (auto& thread : threads) {
+            REQUIRE(thread->status == ThreadStatus::Ready);
+            REQUIRE(thread->wait_nodes.empty());
+        }
+    }
+
+    SECTION("one-shot events wake the best waiter, the oldest on ties") {
+        auto event = env.kernel.CreateEvent(ResetType::OneShot);
+        auto low = env.MakeWaitingThread(48, {event});
+        auto first = env.MakeWaitingThread(24, {event});
+        auto second = env.MakeWaitingThread(24, {event});
+
+        event->Signal();
+        REQUIRE(first->status == ThreadStatus::Ready);
+        REQUIRE(second->status == ThreadStatus::WaitSynchAny);
+        REQUIRE(low->status == ThreadStatus::WaitSynchAny);
+
+        event->Signal();
+        REQUIRE(second->status == ThreadStatus::Ready);
+        REQUIRE(low->status == ThreadStatus::WaitSynchAny);
+        REQUIRE(event->GetWaitingThreads() == std::vector<std::shared_ptr<Thread>>{low});
+    }
+
+    SECTION("wait-all threads only wake once every object is available") {
+        auto a = env.kernel.CreateEvent(ResetType::Sticky);
+        auto b = env.kernel.CreateEvent(ResetType::Sticky);
+        auto thread = env.MakeWaitingThread(48, {a, b}, true);
+        auto any = env.MakeWaitingThread(48, {b, a});
+
+        a->Signal();
+        REQUIRE(thread->status == ThreadStatus::WaitSynchAll);
+        REQUIRE(any->status == ThreadStatus::Ready);
+        REQUIRE(b->GetWaitingThreads() == std::vector<std::shared_ptr<Thread>>{thread});
+
+        b->Signal();
+        REQUIRE(thread->status == ThreadStatus::Ready);
+        REQUIRE(a->GetWaitingThreads().empty());
+        REQUIRE(b->GetWaitingThreads().empty());
+    }
+
+    SECTION("removing a waiter keeps the other links intact") {
+        auto a = env.kernel.CreateEvent(ResetType::Sticky);
+        auto b = env.kernel.CreateEvent(ResetType::Sticky);
+        auto c = env.kernel.CreateEvent(ResetType::Sticky);
+        auto thread = env.MakeWaitingThread(48, {a, b, c});
+        auto other = env.MakeWaitingThread(48, {b});
+
+        b->RemoveWaitingThread(thread.get());
+        b->RemoveWaitingThread(thread.get());
+        REQUIRE(b->GetWaitingThreads() == std::vector<std::shared_ptr<Thread>>{other});
+        REQUIRE(a->GetWaitingThreads() == std::vector<std::shared_ptr<Thread>>{thread});
+        REQUIRE(c->GetWaitingThreads() == std::vector<std::shared_ptr<Thread>>{thread});
+
+        c->Signal();
+        REQUIRE(thread->status == ThreadStatus::Ready);
+        REQUIRE(a->GetWaitingThreads().empty());
+        REQUIRE(other->status == ThreadStatus::WaitSynchAny);
+    }
+}
+
+TEST_CASE("WaitObject wakeup stress benchmark", "[.][benchmark][core][kernel]") {
+    constexpr std::size_t NumThreads = 256;
+    constexpr std::size_t NumEvents = 16;
+    constexpr std::size_t NumRounds = 200;
+
+    WaitEnvironment env;
+    std::vector<std::shared_ptr<Event>> events;
+    for (std::size_t i = 0; i < NumEvents; ++i) {
+        events.push_back(env.kernel.CreateEvent(i % 2 ? ResetType::OneShot : ResetType::Sticky));
+    }
+
+    // Every thread waits on a few events, the way worker pools wait on their job and quit events
+    std::vector<std::shared_ptr<Thread>> threads;
+    const auto wait_objects = [&](std::size_t i) {
+        std::vector<std::shared_ptr<WaitObject>> objects;
+        for (std::size_t j = 0; j < 4; ++j) {
+            objects.push_back(events[(i + j * 5) % NumEvents]);
+        }
+        return objects;
+    };
+    for (std::size_t i = 0; i < NumThreads; ++i) {
+        threads.push_back(env.MakeWaitingThread(static_cast<u32>(24 + i % 40), wait_objects(i)));
+    }
+
+    std::size_t wakeups = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < NumRounds; ++round) {
+        for (auto& event : events) {
+            event->Signal();
+            event->Clear();
+        }
+        // Put the woken threads back to sleep. They stay in the ready queue, which ignores them
+        // when they are woken up again.
+        for (std::size_t i = 0; i < NumThreads; ++i) {
+            auto& thread = threads[i];
+            if (thread->status == ThreadStatus::Ready) {
+                ++wakeups;
+                thread->status = ThreadStatus::WaitSynchAny;
+                thread->wait_objects = wait_objects(i);
+                for (auto& object : thread->wait_objects) {
+                    object->AddWaitingThread(thread);
+                }
+            }
+        }
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    WARN(NumRounds * NumEvents << " signals over " << NumThreads << " threads, " << wakeups
+                               << " wakeups: " << elapsed.count() << " us");
+    REQUIRE(wakeups != 0);
+}
+
+} // namespace Kernel
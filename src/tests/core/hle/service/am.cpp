@@ -0,0 +1,107 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <cryptopp/sha.h>
+#include <fmt/format.h>
+#include "common/alignment.h"
+#include "common/file_util.h"
+#include "core/file_sys/cia_common.h"
+#include "core/file_sys/cia_container.h"
+#include "core/file_sys/title_metadata.h"
+#include "core/hle/service/am/am.h"
+
+namespace Service::AM {
+
+namespace {
+
+constexpr u64 TitleID = 0x0004000000C1A000;
+constexpr std::size_t HeaderSize = FileSys::CIA_HEADER_SIZE;
+/// RSA-2048 signature, stored big endian like the rest of tickets and TMDs
+constexpr u32 SignatureType = FileSys::Rsa2048Sha256;
+constexpr std::size_t SignedBodyOffset = 0x140;
+constexpr std::size_t TicketSize = SignedBodyOffset + 0x210;
+constexpr std::size_t TMDSize = SignedBodyOffset + sizeof(FileSys::TitleMetadata::Body) +
+                                sizeof(FileSys::TitleMetadata::ContentChunk);
+
+template <typename T>
+void WriteAt(std::vector<u8>& data, std::size_t offset, const T& value) {
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+/// Builds an unencrypted CIA with a single content, the TMD holding the hash of the given data
+std::vector<u8> MakeCIA(const std::vector<u8>& content, const std::vector<u8>& hashed_content) {
+    const std::size_t ticket_offset = Common::AlignUp(HeaderSize, 0x40);
+    const std::size_t tmd_offset = Common::AlignUp(ticket_offset + TicketSize, 0x40);
+    const std::size_t content_offset = Common::AlignUp(tmd_offset + TMDSize, 0x40);
+    std::vector<u8> cia(content_offset + content.size());
+
+    // Header size, type and version, then the sizes of the certificates, ticket, TMD, meta and
+    // contents, and the bit array of the contents present
+    WriteAt<u32_le>(cia, 0x00, static_cast<u32>(HeaderSize));
+    WriteAt<u32_le>(cia, 0x0C, static_cast<u32>(TicketSize));
+    WriteAt<u32_le>(cia, 0x10, static_cast<u32>(TMDSize));
+    WriteAt<u64_le>(cia, 0x18, content.size());
+    cia[0x20] = 0x80;
+
+    WriteAt<u32_be>(cia, ticket_offset, SignatureType);
+
+    WriteAt<u32_be>(cia, tmd_offset, SignatureType);
+    FileSys::TitleMetadata::Body body{};
+    body.title_id = TitleID;
+    body.content_count = 1;
+    WriteAt(cia, tmd_offset + SignedBodyOffset, body);
+    FileSys::TitleMetadata::ContentChunk chunk{};
+    chunk.size = static_cast<u64>(content.size());
+    CryptoPP::SHA256().CalculateDigest(chunk.hash.data(), hashed_content.data(),
+                                       hashed_content.size());
+    WriteAt(cia, tmd_offset + SignedBodyOffset + sizeof(body), chunk);
+
+    std::memcpy(cia.data() + content_offset, content.data(), content.size());
+    return cia;
+}
+
+} // namespace
+
+TEST_CASE("InstallCIA", "[core][service]") {
+    const std::string test_dir = FileUtil::GetTempDirectory() + "citra_am_test/";
+    const std::string cia_path = test_dir + "test.cia";
+    FileUtil::DeleteDirRecursively(test_dir);
+    FileUtil::SetUserPath(test_dir + "user/");
+
+    std::vector<u8> content(0x1000);
+    for (std::size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<u8>(i * 7);
+    }
+    const auto media_type = GetTitleMediaType(TitleID);
+
+    SECTION("installs a content matching its hash") {
+        const auto cia = MakeCIA(content, content);
+        REQUIRE(FileUtil::IOFile(cia_path, "wb").WriteBytes(cia.data(), cia.size()) == cia.size());
+
+        REQUIRE(InstallCIA(cia_path) == InstallStatus::Success);
+        std::string installed;
+        FileUtil::ReadFileToString(false, GetTitleContentPath(media_type, TitleID), installed);
+        CHECK(installed == std::string(content.begin(), content.end()));
+    }
+
+    SECTION("leaves nothing behind when a content is corrupted") {
+        std::vector<u8> corrupted = content;
+        corrupted[0x800] ^= 0xFF;
+        const auto cia = MakeCIA(corrupted, content);
+        REQUIRE(FileUtil::IOFile(cia_path, "wb").WriteBytes(cia.data(), cia.size()) == cia.size());
+
+        REQUIRE(InstallCIA(cia_path) == InstallStatus::ErrorAborted);
+        CHECK_FALSE(FileUtil::Exists(GetTitlePath(media_type, TitleID)));
+        CHECK_FALSE(FileUtil::Exists(
+            fmt::format("{}{:08x}/", GetMediaTitlePath(media_type), TitleID >> 32)));
+    }
+
+    FileUtil::DeleteDirRecursively(test_dir);
+    FileUtil::SetUserPath();
+}
+
+} // namespace Service::AM
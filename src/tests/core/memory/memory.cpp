@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <vector>
 #include <catch2/catch.hpp>
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -54,3 +55,43 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::MemorySystem::GetContiguousPointer", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    constexpr VAddr base = 0x10000000;
+    constexpr u32 size = 2 * Memory::PAGE_SIZE;
+    std::vector<u8> backing(4 * Memory::PAGE_SIZE);
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(base, backing.data(), size, Kernel::MemoryState::Private)
+                .Succeeded());
+
+    SECTION("ranges over adjacent host pages are accessed in place") {
+        CHECK(memory.GetContiguousPointer(*process, base + 0x10, 0x20) == backing.data() + 0x10);
+        CHECK(memory.GetContiguousPointer(*process, base + size - 0x10, 0x10) ==
+              backing.data() + size - 0x10);
+        CHECK(memory.GetContiguousPointer(*process, base + 0x10, 0) == nullptr);
+    }
+
+    SECTION("ranges touching unmapped pages are not") {
+        CHECK(memory.GetContiguousPointer(*process, base + size - 0x10, 0x20) == nullptr);
+        CHECK(memory.GetContiguousPointer(*process, base - 0x10, 0x20) == nullptr);
+    }
+
+    SECTION("ranges over pages apart in host memory are not") {
+        // Skip a host page, so the next guest page is not adjacent to the previous one
+        REQUIRE(process->vm_manager
+                    .MapBackingMemory(base + size, backing.data() + size + Memory::PAGE_SIZE,
+                                      Memory::PAGE_SIZE, Kernel::MemoryState::Private)
+                    .Succeeded());
+        CHECK(memory.GetContiguousPointer(*process, base + size - 0x10, 0x20) == nullptr);
+        CHECK(memory.GetContiguousPointer(*process, base + size, 0x20) ==
+              backing.data() + size + Memory::PAGE_SIZE);
+        REQUIRE(process->vm_manager.UnmapRange(base + size, Memory::PAGE_SIZE) == RESULT_SUCCESS);
+    }
+
+    REQUIRE(process->vm_manager.UnmapRange(base, size) == RESULT_SUCCESS);
+}
@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
+#include <iterator>
+#include <random>
 #include <vector>
 #include <catch2/catch.hpp>
 #include "core/hle/kernel/errors.h"
@@ -137,3 +140,98 @@ TEST_CASE("Memory Basics", "[kernel][memory]") {
         REQUIRE(code == RESULT_SUCCESS);
     }
 }
+
+TEST_CASE("VMManager page index", "[kernel][memory]") {
+    constexpr u32 NumPages = 4096;
+    std::vector<u8> block(NumPages * Memory::PAGE_SIZE);
+    Memory::MemorySystem memory;
+    auto manager = std::make_unique<Kernel::VMManager>(memory);
+
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<u32> page_dist(0, NumPages - 1);
+    std::uniform_int_distribution<u32> count_dist(1, 64);
+    std::uniform_int_distribution<int> op_dist(0, 2);
+    for (int i = 0; i < 2000; ++i) {
+        const u32 page = page_dist(rng);
+        const u32 count = std::min(count_dist(rng), NumPages - page);
+        const VAddr address = Memory::HEAP_VADDR + page * Memory::PAGE_SIZE;
+        const u32 size = count * Memory::PAGE_SIZE;
+        switch (op_dist(rng)) {
+        case 0:
+            // Only succeeds when the whole range is free
+            manager->MapBackingMemory(address, block.data() + page * Memory::PAGE_SIZE, size,
+                                      Kernel::MemoryState::Private);
+            break;
+        case 1:
+            // Only succeeds when the whole range is mapped
+            manager->UnmapRange(address, size);
+            break;
+        case 2:
+            manager->ReprotectRange(address, size,
+                                    i % 2 ? Kernel::VMAPermission::Read
+                                          : Kernel::VMAPermission::ReadWrite);
+            break;
+        }
+
+        // The index must agree with the map
+        for (u32 j = 0; j < 16; ++j) {
+            const VAddr target = Memory::HEAP_VADDR + page_dist(rng) * Memory::PAGE_SIZE +
+                                 page_dist(rng) % Memory::PAGE_SIZE;
+            REQUIRE(manager->FindVMA(target) ==
+                    std::prev(manager->vma_map.upper_bound(target)));
+        }
+    }
+
+    for (auto vma = manager->vma_map.begin(); vma != manager->vma_map.end(); ++vma) {
+        REQUIRE(manager->FindVMA(vma->second.base) == vma);
+        REQUIRE(manager->FindVMA(vma->second.base + vma->second.size - 1) == vma);
+    }
+    REQUIRE(manager->FindVMA(Kernel::VMManager::MAX_ADDRESS) == manager->vma_map.end());
+}
+
+TEST_CASE("VMManager mapping benchmark", "[.][benchmark][kernel][memory]") {
+    constexpr u32 NumMappings = 4096;
+    constexpr u32 NumRounds = 16;
+    // Every other page, so that the mappings can't be merged with each other
+    std::vector<u8> block(2 * NumMappings * Memory::PAGE_SIZE);
+    Memory::MemorySystem memory;
+    auto manager = std::make_unique<Kernel::VMManager>(memory);
+
+    std::vector<u32> order(NumMappings);
+    for (u32 i = 0; i < NumMappings; ++i) {
+        order[i] = i;
+    }
+    std::mt19937 rng(0);
+
+    std::size_t lookups = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 round = 0; round < NumRounds; ++round) {
+        std::shuffle(order.begin(), order.end(), rng);
+        for (const u32 i : order) {
+            const VAddr address = Memory::HEAP_VADDR + i * Memory::PAGE_SIZE;
+            REQUIRE(manager
+                        ->MapBackingMemory(address, block.data() + 2 * i * Memory::PAGE_SIZE,
+                                           Memory::PAGE_SIZE, Kernel::MemoryState::Private)
+                        .Succeeded());
+        }
+        for (const u32 i : order) {
+            const VAddr address = Memory::HEAP_VADDR + i * Memory::PAGE_SIZE;
+            REQUIRE(manager->ReprotectRange(address, Memory::PAGE_SIZE,
+                                            Kernel::VMAPermission::Read) == RESULT_SUCCESS);
+            for (u32 j = 0; j < 8; ++j) {
+                lookups += manager->FindVMA(address + j * 0x200)->second.size;
+            }
+        }
+        for (const u32 i : order) {
+            const VAddr address = Memory::HEAP_VADDR + i * Memory::PAGE_SIZE;
+            REQUIRE(manager->UnmapRange(address, Memory::PAGE_SIZE) == RESULT_SUCCESS);
+        }
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    WARN(NumRounds << " rounds of " << NumMappings << " mappings: "
+                   << elapsed.count() / (NumRounds * NumMappings) << " ns per mapping");
+    REQUIRE(lookups == std::size_t{NumRounds} * NumMappings * 8 * Memory::PAGE_SIZE);
+    REQUIRE(manager->vma_map.size() == 1);
+}
@@ -0,0 +1,112 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstdlib>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/texture/filters/texture_filter.h"
+
+namespace Pica::Texture {
+
+namespace {
+
+constexpr u16 ScaleFactor = 2;
+
+std::vector<u8> MakeSolidImage(u32 width, u32 height, std::array<u8, 4> color) {
+    std::vector<u8> image(static_cast<std::size_t>(width) * height * 4);
+    for (std::size_t i = 0; i < image.size(); ++i) {
+        image[i] = color[i % 4];
+    }
+    return image;
+}
+
+/// Black on the left half, white on the right half
+std::vector<u8> MakeSplitImage(u32 width, u32 height) {
+    std::vector<u8> image(static_cast<std::size_t>(width) * height * 4);
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            const u8 value = x < width / 2 ? 0x00 : 0xFF;
+            u8* pixel = &image[(static_cast<std::size_t>(y) * width + x) * 4];
+            pixel[0] = pixel[1] = pixel[2] = value;
+            pixel[3] = 0xFF;
+        }
+    }
+    return image;
+}
+
+u8 GetComponent(const std::vector<u8>& image, u32 width, u32 x, u32 y, u32 component) {
+    return image[(static_cast<std::size_t>(y) * width + x) * 4 + component];
+}
+
+} // namespace
+
+TEST_CASE("TextureFilter - Solid image stays solid", "[video_core]") {
+    constexpr u32 width = 8;
+    constexpr u32 height = 8;
+    const std::array<u8, 4> color{0x20, 0x80, 0xC0, 0xFF};
+    const auto src = MakeSolidImage(width, height, color);
+
+    for (const auto name : GetTextureFilterNames()) {
+        SECTION(std::string(name)) {
+            const auto filter = CreateTextureFilter(name, ScaleFactor);
+            REQUIRE(filter);
+            const auto dst = FilterTexture(*filter, src, width, height);
+            REQUIRE(dst.size() == src.size() * ScaleFactor * ScaleFactor);
+            for (std::size_t i = 0; i < dst.size(); ++i) {
+                REQUIRE(std::abs(dst[i] - color[i % 4]) <= 1);
+            }
+        }
+    }
+}
+
+TEST_CASE("TextureFilter - Edge keeps its sides", "[video_core]") {
+    constexpr u32 width = 8;
+    constexpr u32 height = 8;
+    constexpr u32 dst_width = width * ScaleFactor;
+    const auto src = MakeSplitImage(width, height);
+
+    for (const auto name : GetTextureFilterNames()) {
+        SECTION(std::string(name)) {
+            const auto filter = CreateTextureFilter(name, ScaleFactor);
+            REQUIRE(filter);
+            const auto dst = FilterTexture(*filter, src, width, height);
+            // Pixels away from the edge keep the color of their side
+            for (u32 y = 0; y < height * ScaleFactor; ++y) {
+                REQUIRE(GetComponent(dst, dst_width, 1, y, 0) <= 0x08);
+                REQUIRE(GetComponent(dst, dst_width, dst_width - 2, y, 0) >= 0xF7);
+                REQUIRE(GetComponent(dst, dst_width, 1, y, 3) == 0xFF);
+            }
+            // Across the edge the image goes from dark to light
+            for (u32 y = 0; y < height * ScaleFactor; ++y) {
+                REQUIRE(GetComponent(dst, dst_width, dst_width / 2 - 1, y, 0) <=
+                        GetComponent(dst, dst_width, dst_width / 2, y, 0));
+            }
+        }
+    }
+}
+
+TEST_CASE("TextureFilter - Spreading rows over threads doesn't change the output",
+          "[video_core]") {
+    constexpr u32 width = 48;
+    constexpr u32 height = 96;
+    std::vector<u8> src(width * height * 4);
+    u32 seed = 1;
+    for (u8& byte : src) {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<u8>(seed >> 16);
+    }
+
+    for (const auto name : GetTextureFilterNames()) {
+        SECTION(std::string(name)) {
+            const auto filter = CreateTextureFilter(name, ScaleFactor);
+            REQUIRE(filter);
+            const auto single = FilterTexture(*filter, src, width, height, 1);
+            REQUIRE(FilterTexture(*filter, src, width, height, 4) == single);
+            REQUIRE(FilterTexture(*filter, src, width, height) == single);
+        }
+    }
+}
+
+} // namespace Pica::Texture
@@ -84,5 +84,11 @@ public:
 
     virtual void LoadDiskResources(const std::atomic_bool& stop_loading,
                                    const DiskResourceLoadCallback& callback) {}
+
+    /// Notify rasterizer that the GPU has finished processing a command list
+    virtual void NotifyCommandListProcessed() {}
+
+    /// Notify rasterizer that the current frame has been presented
+    virtual void EndFrame() {}
 };
 } // namespace VideoCore
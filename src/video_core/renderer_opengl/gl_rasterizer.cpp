@@ -15,6 +15,7 @@
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/hw/gpu.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs_framebuffer.h"
@@ -32,6 +33,20 @@ namespace OpenGL {
 using PixelFormat = SurfaceParams::PixelFormat;
 using SurfaceType = SurfaceParams::SurfaceType;
 
+// Every LUT has a fixed place in the texture buffer, so that a change to a few entries only needs
+// those entries to be uploaded and the offsets in the uniform block never change.
+constexpr std::size_t LIGHTING_LUT_OFFSET = 0;
+constexpr std::size_t FOG_LUT_OFFSET =
+    LIGHTING_LUT_OFFSET + sizeof(GLvec2) * 256 * Pica::LightingRegs::NumLightingSampler;
+constexpr std::size_t PROCTEX_NOISE_LUT_OFFSET = FOG_LUT_OFFSET + sizeof(GLvec2) * 128;
+constexpr std::size_t PROCTEX_COLOR_MAP_OFFSET = PROCTEX_NOISE_LUT_OFFSET + sizeof(GLvec2) * 128;
+constexpr std::size_t PROCTEX_ALPHA_MAP_OFFSET = PROCTEX_COLOR_MAP_OFFSET + sizeof(GLvec2) * 128;
+constexpr std::size_t PROCTEX_LUT_OFFSET = PROCTEX_ALPHA_MAP_OFFSET + sizeof(GLvec2) * 128;
+constexpr std::size_t PROCTEX_DIFF_LUT_OFFSET = PROCTEX_LUT_OFFSET + sizeof(GLvec4) * 256;
+constexpr std::size_t TEXTURE_BUFFER_SIZE = PROCTEX_DIFF_LUT_OFFSET + sizeof(GLvec4) * 256;
+static_assert(PROCTEX_LUT_OFFSET % sizeof(GLvec4) == 0,
+              "RGBA LUTs must be aligned to the size of their texel");
+
 MICROPROFILE_DEFINE(OpenGL_VAO, "OpenGL", "Vertex Array Setup", MP_RGB(255, 128, 0));
 MICROPROFILE_DEFINE(OpenGL_VS, "OpenGL", "Vertex Shader Setup", MP_RGB(192, 128, 128));
 MICROPROFILE_DEFINE(OpenGL_GS, "OpenGL", "Geometry Shader Setup", MP_RGB(128, 192, 128));
@@ -46,10 +61,9 @@ static bool IsVendorAmd() {
 
 RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
     : is_amd(IsVendorAmd()), shader_dirty(true),
-      vertex_buffer(GL_ARRAY_BUFFER, VERTEX_BUFFER_SIZE, is_amd),
-      uniform_buffer(GL_UNIFORM_BUFFER, UNIFORM_BUFFER_SIZE, false),
-      index_buffer(GL_ELEMENT_ARRAY_BUFFER, INDEX_BUFFER_SIZE, false),
-      texture_buffer(GL_TEXTURE_BUFFER, TEXTURE_BUFFER_SIZE, false), emu_window{window} {
+      vertex_buffer(GL_ARRAY_BUFFER, VERTEX_BUFFER_SIZE, is_amd, true),
+      uniform_buffer(GL_UNIFORM_BUFFER, UNIFORM_BUFFER_SIZE, false, true),
+      index_buffer(GL_ELEMENT_ARRAY_BUFFER, INDEX_BUFFER_SIZE, false, true), emu_window{window} {
 
     allow_shadow = GLAD_GL_ARB_shader_image_load_store && GLAD_GL_ARB_shader_image_size &&
                    GLAD_GL_ARB_framebuffer_no_attachments;
@@ -89,17 +103,31 @@ RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
     hw_vao.Create();
 
     uniform_block_data.dirty = true;
+    vs_uniforms_dirty = true;
 
-    uniform_block_data.lighting_lut_dirty.fill(true);
+    for (auto& dirty : uniform_block_data.lighting_lut_dirty) {
+        dirty.AddAll(256);
+    }
     uniform_block_data.lighting_lut_dirty_any = true;
 
-    uniform_block_data.fog_lut_dirty = true;
+    uniform_block_data.fog_lut_dirty.AddAll(128);
 
-    uniform_block_data.proctex_noise_lut_dirty = true;
-    uniform_block_data.proctex_color_map_dirty = true;
-    uniform_block_data.proctex_alpha_map_dirty = true;
-    uniform_block_data.proctex_lut_dirty = true;
-    uniform_block_data.proctex_diff_lut_dirty = true;
+    uniform_block_data.proctex_noise_lut_dirty.AddAll(128);
+    uniform_block_data.proctex_color_map_dirty.AddAll(128);
+    uniform_block_data.proctex_alpha_map_dirty.AddAll(128);
+    uniform_block_data.proctex_lut_dirty.AddAll(256);
+    uniform_block_data.proctex_diff_lut_dirty.AddAll(256);
+
+    for (unsigned index = 0; index < Pica::LightingRegs::NumLightingSampler; index++) {
+        uniform_block_data.data.lighting_lut_offset[index / 4][index % 4] = static_cast<GLint>(
+            (LIGHTING_LUT_OFFSET + index * 256 * sizeof(GLvec2)) / sizeof(GLvec2));
+    }
+    uniform_block_data.data.fog_lut_offset = FOG_LUT_OFFSET / sizeof(GLvec2);
+    uniform_block_data.data.proctex_noise_lut_offset = PROCTEX_NOISE_LUT_OFFSET / sizeof(GLvec2);
+    uniform_block_data.data.proctex_color_map_offset = PROCTEX_COLOR_MAP_OFFSET / sizeof(GLvec2);
+    uniform_block_data.data.proctex_alpha_map_offset = PROCTEX_ALPHA_MAP_OFFSET / sizeof(GLvec2);
+    uniform_block_data.data.proctex_lut_offset = PROCTEX_LUT_OFFSET / sizeof(GLvec4);
+    uniform_block_data.data.proctex_diff_lut_offset = PROCTEX_DIFF_LUT_OFFSET / sizeof(GLvec4);
 
     glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_buffer_alignment);
     uniform_size_aligned_vs =
@@ -145,6 +173,12 @@ RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
     // Create render framebuffer
     framebuffer.Create();
 
+    // Allocate the LUT storage. It starts out zeroed to match the cached LUT data.
+    texture_buffer.Create();
+    glBindBuffer(GL_TEXTURE_BUFFER, texture_buffer.handle);
+    const std::vector<u8> zero_luts(TEXTURE_BUFFER_SIZE);
+    glBufferData(GL_TEXTURE_BUFFER, TEXTURE_BUFFER_SIZE, zero_luts.data(), GL_DYNAMIC_DRAW);
+
     // Allocate and bind texture buffer lut textures
     texture_buffer_lut_rg.Create();
     texture_buffer_lut_rgba.Create();
@@ -152,9 +186,9 @@ RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
     state.texture_buffer_lut_rgba.texture_buffer = texture_buffer_lut_rgba.handle;
     state.Apply();
     glActiveTexture(TextureUnits::TextureBufferLUT_RG.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, texture_buffer.GetHandle());
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, texture_buffer.handle);
     glActiveTexture(TextureUnits::TextureBufferLUT_RGBA.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, texture_buffer.GetHandle());
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, texture_buffer.handle);
 
     // Bind index buffer for hardware shader path
     state.draw.vertex_array = hw_vao.handle;
@@ -177,6 +211,8 @@ void RasterizerOpenGL::LoadDiskResources(const std::atomic_bool& stop_loading,
 }
 
 void RasterizerOpenGL::SyncEntireState() {
+    FlushDrawBatch();
+
     // Sync fixed function OpenGL state
     SyncClipEnabled();
     SyncCullMode();
@@ -409,7 +445,12 @@ bool RasterizerOpenGL::AccelerateDrawBatch(bool is_indexed) {
         }
     }
 
-    if (!SetupVertexShader())
+    // Queued software vertices have to be drawn before the programmable shaders get bound
+    if (!draw_batch.accelerate)
+        FlushDrawBatch();
+
+    // The vertex shader config only depends on registers that close the draw batch when written
+    if (!draw_batch.open && !SetupVertexShader())
         return false;
 
     if (!SetupGeometryShader())
@@ -479,9 +520,16 @@ bool RasterizerOpenGL::AccelerateDrawBatchInternal(bool is_indexed) {
     } else {
         glDrawArrays(primitive_mode, 0, regs.pipeline.num_vertices);
     }
+    FenceStreamBuffers();
     return true;
 }
 
+void RasterizerOpenGL::FenceStreamBuffers() {
+    vertex_buffer.FenceWrittenRegions();
+    index_buffer.FenceWrittenRegions();
+    uniform_buffer.FenceWrittenRegions();
+}
+
 void RasterizerOpenGL::DrawTriangles() {
     if (vertex_batch.empty())
         return;
@@ -491,6 +539,24 @@ void RasterizerOpenGL::DrawTriangles() {
 bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     MICROPROFILE_SCOPE(OpenGL_Drawing);
     const auto& regs = Pica::g_state.regs;
+    ++draw_stats.pica_draws;
+
+    // No configuration register has been written since the last draw, so framebuffer, textures,
+    // shaders and uniforms are all still bound. Software vertices simply stay queued in
+    // vertex_batch and are drawn together when the batch is flushed.
+    if (draw_batch.open && draw_batch.accelerate == accelerate) {
+        if (!accelerate) {
+            return true;
+        }
+        ++draw_stats.gl_draws;
+        if (!AccelerateDrawBatchInternal(is_indexed)) {
+            FlushDrawBatch();
+            return false;
+        }
+        return true;
+    }
+    FlushDrawBatch();
+    ++draw_stats.state_syncs;
 
     bool shadow_rendering = regs.framebuffer.output_merger.fragment_operation_mode ==
                             Pica::FramebufferRegs::FragmentOperationMode::Shadow;
@@ -786,8 +852,35 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     // Draw the vertex batch
     bool succeeded = true;
     if (accelerate) {
+        ++draw_stats.gl_draws;
         succeeded = AccelerateDrawBatchInternal(is_indexed);
-    } else {
+    }
+
+    draw_batch.open = true;
+    draw_batch.accelerate = accelerate;
+    draw_batch.shadow_rendering = shadow_rendering;
+    draw_batch.need_texture_barrier = need_texture_barrier;
+    draw_batch.color_surface = write_color_fb ? color_surface : nullptr;
+    draw_batch.depth_surface = write_depth_fb ? depth_surface : nullptr;
+    draw_batch.rect_unscaled = {draw_rect.left / res_scale, draw_rect.top / res_scale,
+                                draw_rect.right / res_scale, draw_rect.bottom / res_scale};
+
+    // Barriers have to be issued between every draw, so these can't be merged with the next one
+    if (!succeeded || shadow_rendering || need_texture_barrier) {
+        FlushDrawBatch();
+    }
+
+    return succeeded;
+}
+
+void RasterizerOpenGL::FlushDrawBatch() {
+    if (!draw_batch.open)
+        return;
+    draw_batch.open = false;
+
+    const auto& regs = Pica::g_state.regs;
+
+    if (!draw_batch.accelerate && !vertex_batch.empty()) {
         state.draw.vertex_array = sw_vao.handle;
         state.draw.vertex_buffer = vertex_buffer.GetHandle();
         shader_program_manager->UseTrivialVertexShader();
@@ -807,12 +900,14 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
             std::memcpy(vbo, vertex_batch.data() + base_vertex, vertex_size);
             vertex_buffer.Unmap(vertex_size);
             glDrawArrays(GL_TRIANGLES, offset / sizeof(HardwareVertex), (GLsizei)vertices);
+            FenceStreamBuffers();
+            ++draw_stats.gl_draws;
         }
+        vertex_batch.clear();
     }
 
-    vertex_batch.clear();
-
     // Reset textures in rasterizer state context because the rasterizer cache might delete them
+    const auto pica_textures = regs.texturing.GetTextures();
     for (unsigned texture_index = 0; texture_index < pica_textures.size(); ++texture_index) {
         state.texture_units[texture_index].texture_2d = 0;
     }
@@ -828,37 +923,93 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     }
     state.Apply();
 
-    if (shadow_rendering) {
+    if (draw_batch.shadow_rendering) {
         glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
                         GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
     }
 
-    if (need_texture_barrier && GLAD_GL_ARB_texture_barrier) {
+    if (draw_batch.need_texture_barrier && GLAD_GL_ARB_texture_barrier) {
         glTextureBarrier();
     }
 
     // Mark framebuffer surfaces as dirty
-    Common::Rectangle<u32> draw_rect_unscaled{draw_rect.left / res_scale, draw_rect.top / res_scale,
-                                              draw_rect.right / res_scale,
-                                              draw_rect.bottom / res_scale};
-
-    if (color_surface != nullptr && write_color_fb) {
-        auto interval = color_surface->GetSubRectInterval(draw_rect_unscaled);
+    if (draw_batch.color_surface != nullptr) {
+        auto interval = draw_batch.color_surface->GetSubRectInterval(draw_batch.rect_unscaled);
         res_cache.InvalidateRegion(boost::icl::first(interval), boost::icl::length(interval),
-                                   color_surface);
+                                   draw_batch.color_surface);
     }
-    if (depth_surface != nullptr && write_depth_fb) {
-        auto interval = depth_surface->GetSubRectInterval(draw_rect_unscaled);
+    if (draw_batch.depth_surface != nullptr) {
+        auto interval = draw_batch.depth_surface->GetSubRectInterval(draw_batch.rect_unscaled);
         res_cache.InvalidateRegion(boost::icl::first(interval), boost::icl::length(interval),
-                                   depth_surface);
+                                   draw_batch.depth_surface);
     }
+    draw_batch.color_surface = nullptr;
+    draw_batch.depth_surface = nullptr;
+}
 
-    return succeeded;
+void RasterizerOpenGL::NotifyCommandListProcessed() {
+    FlushDrawBatch();
+
+    // Games usually read render targets back once the command list that drew them has finished,
+    // so this is the earliest point where a download can be started without going stale
+    res_cache.StartPendingReadbacks();
+}
+
+void RasterizerOpenGL::EndFrame() {
+    FlushDrawBatch();
+
+    const auto LogStreamStats = [](const char* name, OGLStreamBuffer& stream) {
+        const auto& stats = stream.GetStats();
+        if (stats.fence_waits > 0) {
+            LOG_DEBUG(Render_OpenGL,
+                      "{} stream buffer stalled: {} bytes, {} wraps, {} fence waits this frame",
+                      name, stats.bytes_written, stats.wrap_count, stats.fence_waits);
+        }
+        stream.ResetStats();
+    };
+    LogStreamStats("Vertex", vertex_buffer);
+    LogStreamStats("Index", index_buffer);
+    LogStreamStats("Uniform", uniform_buffer);
+
+    LOG_TRACE(Render_OpenGL,
+              "Uploaded {} uniform bytes ({} saved) and {} LUT bytes ({} saved) this frame",
+              upload_stats.uniform_bytes, upload_stats.uniform_bytes_saved,
+              upload_stats.lut_bytes, upload_stats.lut_bytes_saved);
+    upload_stats = {};
+
+    LOG_TRACE(Render_OpenGL, "{} PICA draws issued as {} GL draws with {} state syncs this frame",
+              draw_stats.pica_draws, draw_stats.gl_draws, draw_stats.state_syncs);
+    draw_stats = {};
+
+    const auto& readback_stats = res_cache.GetReadbackStats();
+    if (readback_stats.sync_downloads + readback_stats.async_downloads > 0) {
+        LOG_DEBUG(Render_OpenGL,
+                  "Stalled {} us on surface readback: {} synchronous, {} of {} prefetched used, "
+                  "{} discarded",
+                  readback_stats.stall_time.count(), readback_stats.sync_downloads,
+                  readback_stats.async_downloads, readback_stats.async_started,
+                  readback_stats.async_discarded);
+    }
+    res_cache.ResetReadbackStats();
 }
 
 void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     const auto& regs = Pica::g_state.regs;
 
+    // Vertex input and primitive assembly registers are consumed per draw and never invalidate the
+    // bound state. Shader registers only matter to the hardware shader path, since software
+    // vertices have already been transformed by the time they are queued.
+    constexpr u32 pipeline_begin = PICA_REG_INDEX(pipeline);
+    constexpr u32 pipeline_end = pipeline_begin + sizeof(Pica::PipelineRegs) / sizeof(u32);
+    constexpr u32 shader_end = PICA_REG_INDEX(vs) + sizeof(Pica::ShaderRegs) / sizeof(u32);
+    if (draw_batch.open) {
+        const bool keeps_batch = (id >= pipeline_begin && id < pipeline_end) ||
+                                 (!draw_batch.accelerate && id >= pipeline_end && id < shader_end);
+        if (!keeps_batch) {
+            FlushDrawBatch();
+        }
+    }
+
     switch (id) {
     // Culling
     case PICA_REG_INDEX(rasterizer.cull_mode):
@@ -918,7 +1069,8 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.fog_lut_data[5]):
     case PICA_REG_INDEX(texturing.fog_lut_data[6]):
     case PICA_REG_INDEX(texturing.fog_lut_data[7]):
-        uniform_block_data.fog_lut_dirty = true;
+        // The command processor has already advanced the offset past the written entry
+        uniform_block_data.fog_lut_dirty.Add((regs.texturing.fog_lut_offset - 1) % 128);
         break;
 
     // ProcTex state
@@ -942,26 +1094,29 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.proctex_lut_data[4]):
     case PICA_REG_INDEX(texturing.proctex_lut_data[5]):
     case PICA_REG_INDEX(texturing.proctex_lut_data[6]):
-    case PICA_REG_INDEX(texturing.proctex_lut_data[7]):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[7]): {
         using Pica::TexturingRegs;
+        // The command processor has already advanced the index past the written entry
+        const u32 index = regs.texturing.proctex_lut_config.index - 1;
         switch (regs.texturing.proctex_lut_config.ref_table.Value()) {
         case TexturingRegs::ProcTexLutTable::Noise:
-            uniform_block_data.proctex_noise_lut_dirty = true;
+            uniform_block_data.proctex_noise_lut_dirty.Add(index % 128);
             break;
         case TexturingRegs::ProcTexLutTable::ColorMap:
-            uniform_block_data.proctex_color_map_dirty = true;
+            uniform_block_data.proctex_color_map_dirty.Add(index % 128);
             break;
         case TexturingRegs::ProcTexLutTable::AlphaMap:
-            uniform_block_data.proctex_alpha_map_dirty = true;
+            uniform_block_data.proctex_alpha_map_dirty.Add(index % 128);
             break;
         case TexturingRegs::ProcTexLutTable::Color:
-            uniform_block_data.proctex_lut_dirty = true;
+            uniform_block_data.proctex_lut_dirty.Add(index % 256);
             break;
         case TexturingRegs::ProcTexLutTable::ColorDiff:
-            uniform_block_data.proctex_diff_lut_dirty = true;
+            uniform_block_data.proctex_diff_lut_dirty.Add(index % 256);
             break;
         }
         break;
+    }
 
     // Alpha test
     case PICA_REG_INDEX(framebuffer.output_merger.alpha_test):
@@ -1339,36 +1494,59 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(lighting.lut_data[6]):
     case PICA_REG_INDEX(lighting.lut_data[7]): {
         auto& lut_config = regs.lighting.lut_config;
-        uniform_block_data.lighting_lut_dirty[lut_config.type] = true;
+        // The command processor has already advanced the index past the written entry
+        uniform_block_data.lighting_lut_dirty[lut_config.type].Add((lut_config.index - 1) % 256);
         uniform_block_data.lighting_lut_dirty_any = true;
         break;
     }
+
+    // Vertex shader uniforms
+    case PICA_REG_INDEX(vs.bool_uniforms):
+    case PICA_REG_INDEX(vs.int_uniforms[0]):
+    case PICA_REG_INDEX(vs.int_uniforms[1]):
+    case PICA_REG_INDEX(vs.int_uniforms[2]):
+    case PICA_REG_INDEX(vs.int_uniforms[3]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[0]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[1]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[2]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[3]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[4]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[5]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[6]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[7]):
+        vs_uniforms_dirty = true;
+        break;
     }
 }
 
 void RasterizerOpenGL::FlushAll() {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    FlushDrawBatch();
     res_cache.FlushAll();
 }
 
 void RasterizerOpenGL::FlushRegion(PAddr addr, u32 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    FlushDrawBatch();
     res_cache.FlushRegion(addr, size);
 }
 
 void RasterizerOpenGL::InvalidateRegion(PAddr addr, u32 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    FlushDrawBatch();
     res_cache.InvalidateRegion(addr, size, nullptr);
 }
 
 void RasterizerOpenGL::FlushAndInvalidateRegion(PAddr addr, u32 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    FlushDrawBatch();
     res_cache.FlushRegion(addr, size);
     res_cache.InvalidateRegion(addr, size, nullptr);
 }
 
 bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) {
     MICROPROFILE_SCOPE(OpenGL_Blits);
+    FlushDrawBatch();
 
     SurfaceParams src_params;
     src_params.addr = config.GetPhysicalInputAddress();
@@ -1419,6 +1597,8 @@ bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransfe
 }
 
 bool RasterizerOpenGL::AccelerateTextureCopy(const GPU::Regs::DisplayTransferConfig& config) {
+    FlushDrawBatch();
+
     u32 copy_size = Common::AlignDown(config.texture_copy.size, 16);
     if (copy_size == 0) {
         return false;
@@ -1504,6 +1684,8 @@ bool RasterizerOpenGL::AccelerateTextureCopy(const GPU::Regs::DisplayTransferCon
 }
 
 bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config) {
+    FlushDrawBatch();
+
     Surface dst_surface = res_cache.GetFillSurface(config);
     if (dst_surface == nullptr)
         return false;
@@ -1515,6 +1697,8 @@ bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config)
 bool RasterizerOpenGL::AccelerateDisplay(const GPU::Regs::FramebufferConfig& config,
                                          PAddr framebuffer_addr, u32 pixel_stride,
                                          ScreenInfo& screen_info) {
+    FlushDrawBatch();
+
     if (framebuffer_addr == 0) {
         return false;
     }
@@ -1626,6 +1810,12 @@ void RasterizerOpenGL::SamplerInfo::SyncWithConfig(
 }
 
 void RasterizerOpenGL::SetShader() {
+    // Reported here rather than by the shader generator, which also runs on worker threads and in
+    // tools without a telemetry session
+    if (Pica::g_state.regs.texturing.fog_mode == Pica::TexturingRegs::FogMode::Gas) {
+        Core::System::GetInstance().TelemetrySession().AddField(Telemetry::FieldType::Session,
+                                                                "VideoCore_Pica_UseGasMode", true);
+    }
     shader_program_manager->UseFragmentShader(Pica::g_state.regs);
 }
 
@@ -1949,155 +2139,83 @@ void RasterizerOpenGL::SyncShadowTextureBias() {
 }
 
 void RasterizerOpenGL::SyncAndUploadLUTs() {
-    constexpr std::size_t max_size = sizeof(GLvec2) * 256 * Pica::LightingRegs::NumLightingSampler +
-                                     sizeof(GLvec2) * 128 +     // fog
-                                     sizeof(GLvec2) * 128 * 3 + // proctex: noise + color + alpha
-                                     sizeof(GLvec4) * 256 +     // proctex
-                                     sizeof(GLvec4) * 256;      // proctex diff
-
-    if (!uniform_block_data.lighting_lut_dirty_any && !uniform_block_data.fog_lut_dirty &&
-        !uniform_block_data.proctex_noise_lut_dirty &&
-        !uniform_block_data.proctex_color_map_dirty &&
-        !uniform_block_data.proctex_alpha_map_dirty && !uniform_block_data.proctex_lut_dirty &&
-        !uniform_block_data.proctex_diff_lut_dirty) {
+    if (!uniform_block_data.lighting_lut_dirty_any && !uniform_block_data.fog_lut_dirty.IsDirty() &&
+        !uniform_block_data.proctex_noise_lut_dirty.IsDirty() &&
+        !uniform_block_data.proctex_color_map_dirty.IsDirty() &&
+        !uniform_block_data.proctex_alpha_map_dirty.IsDirty() &&
+        !uniform_block_data.proctex_lut_dirty.IsDirty() &&
+        !uniform_block_data.proctex_diff_lut_dirty.IsDirty()) {
         return;
     }
 
-    u8* buffer;
-    GLintptr offset;
-    bool invalidate;
-    std::size_t bytes_used = 0;
-    glBindBuffer(GL_TEXTURE_BUFFER, texture_buffer.GetHandle());
-    std::tie(buffer, offset, invalidate) = texture_buffer.Map(max_size, sizeof(GLvec4));
+    glBindBuffer(GL_TEXTURE_BUFFER, texture_buffer.handle);
 
-    // Sync the lighting luts
-    if (uniform_block_data.lighting_lut_dirty_any || invalidate) {
-        for (unsigned index = 0; index < uniform_block_data.lighting_lut_dirty.size(); index++) {
-            if (uniform_block_data.lighting_lut_dirty[index] || invalidate) {
-                std::array<GLvec2, 256> new_data;
-                const auto& source_lut = Pica::g_state.lighting.luts[index];
-                std::transform(source_lut.begin(), source_lut.end(), new_data.begin(),
-                               [](const auto& entry) {
-                                   return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-                               });
-
-                if (new_data != lighting_lut_data[index] || invalidate) {
-                    lighting_lut_data[index] = new_data;
-                    std::memcpy(buffer + bytes_used, new_data.data(),
-                                new_data.size() * sizeof(GLvec2));
-                    uniform_block_data.data.lighting_lut_offset[index / 4][index % 4] =
-                        (offset + bytes_used) / sizeof(GLvec2);
-                    uniform_block_data.dirty = true;
-                    bytes_used += new_data.size() * sizeof(GLvec2);
-                }
-                uniform_block_data.lighting_lut_dirty[index] = false;
+    // Converts the dirty entries of a LUT and uploads the part of them that actually changed.
+    // Writes made between two draws are coalesced into a single upload.
+    const auto SyncLUT = [this](const auto& source_lut, auto& lut_data, LUTDirtyRange& dirty,
+                                std::size_t buffer_offset, auto convert) {
+        if (!dirty.IsDirty()) {
+            return;
+        }
+        using Entry = typename std::decay_t<decltype(lut_data)>::value_type;
+
+        u32 changed_begin = dirty.end;
+        u32 changed_end = dirty.begin;
+        for (u32 i = dirty.begin; i < dirty.end; i++) {
+            const Entry new_entry = convert(source_lut[i]);
+            if (new_entry != lut_data[i]) {
+                lut_data[i] = new_entry;
+                changed_begin = std::min(changed_begin, i);
+                changed_end = i + 1;
             }
         }
-    }
-    uniform_block_data.lighting_lut_dirty_any = false;
+        dirty.Clear();
 
-    // Sync the fog lut
-    if (uniform_block_data.fog_lut_dirty || invalidate) {
-        std::array<GLvec2, 128> new_data;
-
-        std::transform(Pica::g_state.fog.lut.begin(), Pica::g_state.fog.lut.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-                       });
-
-        if (new_data != fog_lut_data || invalidate) {
-            fog_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec2));
-            uniform_block_data.data.fog_lut_offset = (offset + bytes_used) / sizeof(GLvec2);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec2);
-        }
-        uniform_block_data.fog_lut_dirty = false;
-    }
-
-    // helper function for SyncProcTexNoiseLUT/ColorMap/AlphaMap
-    auto SyncProcTexValueLUT = [this, buffer, offset, invalidate, &bytes_used](
-                                   const std::array<Pica::State::ProcTex::ValueEntry, 128>& lut,
-                                   std::array<GLvec2, 128>& lut_data, GLint& lut_offset) {
-        std::array<GLvec2, 128> new_data;
-        std::transform(lut.begin(), lut.end(), new_data.begin(), [](const auto& entry) {
-            return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-        });
-
-        if (new_data != lut_data || invalidate) {
-            lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec2));
-            lut_offset = (offset + bytes_used) / sizeof(GLvec2);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec2);
+        std::size_t upload_size = 0;
+        if (changed_begin < changed_end) {
+            upload_size = (changed_end - changed_begin) * sizeof(Entry);
+            glBufferSubData(GL_TEXTURE_BUFFER, buffer_offset + changed_begin * sizeof(Entry),
+                            upload_size, &lut_data[changed_begin]);
         }
+        upload_stats.lut_bytes += upload_size;
+        upload_stats.lut_bytes_saved += lut_data.size() * sizeof(Entry) - upload_size;
     };
 
-    // Sync the proctex noise lut
-    if (uniform_block_data.proctex_noise_lut_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.noise_table, proctex_noise_lut_data,
-                            uniform_block_data.data.proctex_noise_lut_offset);
-        uniform_block_data.proctex_noise_lut_dirty = false;
-    }
-
-    // Sync the proctex color map
-    if (uniform_block_data.proctex_color_map_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.color_map_table, proctex_color_map_data,
-                            uniform_block_data.data.proctex_color_map_offset);
-        uniform_block_data.proctex_color_map_dirty = false;
-    }
-
-    // Sync the proctex alpha map
-    if (uniform_block_data.proctex_alpha_map_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.alpha_map_table, proctex_alpha_map_data,
-                            uniform_block_data.data.proctex_alpha_map_offset);
-        uniform_block_data.proctex_alpha_map_dirty = false;
-    }
-
-    // Sync the proctex lut
-    if (uniform_block_data.proctex_lut_dirty || invalidate) {
-        std::array<GLvec4, 256> new_data;
-
-        std::transform(Pica::g_state.proctex.color_table.begin(),
-                       Pica::g_state.proctex.color_table.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           auto rgba = entry.ToVector() / 255.0f;
-                           return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
-                       });
+    const auto ValueEntryToGL = [](const auto& entry) {
+        return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
+    };
+    const auto ColorEntryToGL = [](const auto& entry) {
+        auto rgba = entry.ToVector() / 255.0f;
+        return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
+    };
 
-        if (new_data != proctex_lut_data || invalidate) {
-            proctex_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec4));
-            uniform_block_data.data.proctex_lut_offset = (offset + bytes_used) / sizeof(GLvec4);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec4);
-        }
-        uniform_block_data.proctex_lut_dirty = false;
-    }
-
-    // Sync the proctex difference lut
-    if (uniform_block_data.proctex_diff_lut_dirty || invalidate) {
-        std::array<GLvec4, 256> new_data;
-
-        std::transform(Pica::g_state.proctex.color_diff_table.begin(),
-                       Pica::g_state.proctex.color_diff_table.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           auto rgba = entry.ToVector() / 255.0f;
-                           return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
-                       });
-
-        if (new_data != proctex_diff_lut_data || invalidate) {
-            proctex_diff_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec4));
-            uniform_block_data.data.proctex_diff_lut_offset =
-                (offset + bytes_used) / sizeof(GLvec4);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec4);
+    // Sync the lighting luts
+    if (uniform_block_data.lighting_lut_dirty_any) {
+        for (unsigned index = 0; index < uniform_block_data.lighting_lut_dirty.size(); index++) {
+            SyncLUT(Pica::g_state.lighting.luts[index], lighting_lut_data[index],
+                    uniform_block_data.lighting_lut_dirty[index],
+                    LIGHTING_LUT_OFFSET + index * 256 * sizeof(GLvec2), ValueEntryToGL);
         }
-        uniform_block_data.proctex_diff_lut_dirty = false;
+        uniform_block_data.lighting_lut_dirty_any = false;
     }
 
-    texture_buffer.Unmap(bytes_used);
+    // Sync the fog lut
+    SyncLUT(Pica::g_state.fog.lut, fog_lut_data, uniform_block_data.fog_lut_dirty, FOG_LUT_OFFSET,
+            ValueEntryToGL);
+
+    // Sync the proctex noise lut, color map and alpha map
+    SyncLUT(Pica::g_state.proctex.noise_table, proctex_noise_lut_data,
+            uniform_block_data.proctex_noise_lut_dirty, PROCTEX_NOISE_LUT_OFFSET, ValueEntryToGL);
+    SyncLUT(Pica::g_state.proctex.color_map_table, proctex_color_map_data,
+            uniform_block_data.proctex_color_map_dirty, PROCTEX_COLOR_MAP_OFFSET, ValueEntryToGL);
+    SyncLUT(Pica::g_state.proctex.alpha_map_table, proctex_alpha_map_data,
+            uniform_block_data.proctex_alpha_map_dirty, PROCTEX_ALPHA_MAP_OFFSET, ValueEntryToGL);
+
+    // Sync the proctex lut and difference lut
+    SyncLUT(Pica::g_state.proctex.color_table, proctex_lut_data,
+            uniform_block_data.proctex_lut_dirty, PROCTEX_LUT_OFFSET, ColorEntryToGL);
+    SyncLUT(Pica::g_state.proctex.color_diff_table, proctex_diff_lut_data,
+            uniform_block_data.proctex_diff_lut_dirty, PROCTEX_DIFF_LUT_OFFSET, ColorEntryToGL);
 }
 
 void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
@@ -2106,9 +2224,15 @@ void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
     state.draw.uniform_buffer = uniform_buffer.GetHandle();
     state.Apply();
 
-    bool sync_vs = accelerate_draw;
+    // The VS block stays bound from the previous accelerated draw, so it only has to be streamed
+    // again when the PICA uniforms changed
+    bool sync_vs = accelerate_draw && vs_uniforms_dirty;
     bool sync_fs = uniform_block_data.dirty;
 
+    if (accelerate_draw && !sync_vs) {
+        upload_stats.uniform_bytes_saved += sizeof(VSUniformData);
+    }
+
     if (!sync_vs && !sync_fs)
         return;
 
@@ -2120,12 +2244,22 @@ void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
     std::tie(uniforms, offset, invalidate) =
         uniform_buffer.Map(uniform_size, uniform_buffer_alignment);
 
+    // Blocks bound from earlier uploads have been overwritten if the buffer wrapped around
+    if (invalidate) {
+        vs_uniforms_dirty = true;
+        if (accelerate_draw && !sync_vs) {
+            upload_stats.uniform_bytes_saved -= sizeof(VSUniformData);
+        }
+        sync_vs = accelerate_draw;
+    }
+
     if (sync_vs) {
         VSUniformData vs_uniforms;
         vs_uniforms.uniforms.SetFromRegs(Pica::g_state.regs.vs, Pica::g_state.vs);
         std::memcpy(uniforms + used_bytes, &vs_uniforms, sizeof(vs_uniforms));
         glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBindings::VS),
                           uniform_buffer.GetHandle(), offset + used_bytes, sizeof(VSUniformData));
+        vs_uniforms_dirty = false;
         used_bytes += uniform_size_aligned_vs;
     }
 
@@ -2137,6 +2271,7 @@ void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
         used_bytes += uniform_size_aligned_fs;
     }
 
+    upload_stats.uniform_bytes += used_bytes;
     uniform_buffer.Unmap(used_bytes);
 }
 
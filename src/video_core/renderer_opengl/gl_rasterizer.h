@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
@@ -59,6 +60,8 @@ public:
     bool AccelerateDisplay(const GPU::Regs::FramebufferConfig& config, PAddr framebuffer_addr,
                            u32 pixel_stride, ScreenInfo& screen_info) override;
     bool AccelerateDrawBatch(bool is_indexed) override;
+    void NotifyCommandListProcessed() override;
+    void EndFrame() override;
 
 private:
     struct SamplerInfo {
@@ -242,6 +245,12 @@ private:
     /// Internal implementation for AccelerateDrawBatch
     bool AccelerateDrawBatchInternal(bool is_indexed);
 
+    /// Fences the stream buffer data written for a draw, once the draw has been submitted
+    void FenceStreamBuffers();
+
+    /// Issues the queued software vertices of the open draw batch and releases its bound state
+    void FlushDrawBatch();
+
     struct VertexArrayInfo {
         u32 vs_input_index_min;
         u32 vs_input_index_max;
@@ -273,27 +282,84 @@ private:
     std::vector<HardwareVertex> vertex_batch;
 
     bool shader_dirty;
+    bool vs_uniforms_dirty;
+
+    /// Range of LUT entries [begin, end) that were written since the last upload
+    struct LUTDirtyRange {
+        u32 begin = 0;
+        u32 end = 0;
+
+        bool IsDirty() const {
+            return begin < end;
+        }
+
+        void Add(u32 index) {
+            if (IsDirty()) {
+                begin = std::min(begin, index);
+                end = std::max(end, index + 1);
+            } else {
+                begin = index;
+                end = index + 1;
+            }
+        }
+
+        void AddAll(u32 size) {
+            begin = 0;
+            end = size;
+        }
+
+        void Clear() {
+            begin = end = 0;
+        }
+    };
 
     struct {
         UniformData data;
-        std::array<bool, Pica::LightingRegs::NumLightingSampler> lighting_lut_dirty;
+        std::array<LUTDirtyRange, Pica::LightingRegs::NumLightingSampler> lighting_lut_dirty;
         bool lighting_lut_dirty_any;
-        bool fog_lut_dirty;
-        bool proctex_noise_lut_dirty;
-        bool proctex_color_map_dirty;
-        bool proctex_alpha_map_dirty;
-        bool proctex_lut_dirty;
-        bool proctex_diff_lut_dirty;
+        LUTDirtyRange fog_lut_dirty;
+        LUTDirtyRange proctex_noise_lut_dirty;
+        LUTDirtyRange proctex_color_map_dirty;
+        LUTDirtyRange proctex_alpha_map_dirty;
+        LUTDirtyRange proctex_lut_dirty;
+        LUTDirtyRange proctex_diff_lut_dirty;
         bool dirty;
     } uniform_block_data = {};
 
+    /// Bytes uploaded for uniforms and LUTs during the current frame, and the bytes that a full
+    /// re-upload of every dirty block would have cost on top of that
+    struct {
+        u64 uniform_bytes;
+        u64 uniform_bytes_saved;
+        u64 lut_bytes;
+        u64 lut_bytes_saved;
+    } upload_stats = {};
+
+    /// State synced by the first draw of a batch, kept bound until a configuration register is
+    /// written or the rasterizer cache is accessed
+    struct {
+        bool open;
+        bool accelerate;
+        bool shadow_rendering;
+        bool need_texture_barrier;
+        Surface color_surface;
+        Surface depth_surface;
+        Common::Rectangle<u32> rect_unscaled;
+    } draw_batch = {};
+
+    /// Number of PICA draws, GL draw calls and full state syncs during the current frame
+    struct {
+        u64 pica_draws;
+        u64 gl_draws;
+        u64 state_syncs;
+    } draw_stats = {};
+
     std::unique_ptr<ShaderProgramManager> shader_program_manager;
 
     // They shall be big enough for about one frame.
     static constexpr std::size_t VERTEX_BUFFER_SIZE = 16 * 1024 * 1024;
     static constexpr std::size_t INDEX_BUFFER_SIZE = 1 * 1024 * 1024;
     static constexpr std::size_t UNIFORM_BUFFER_SIZE = 2 * 1024 * 1024;
-    static constexpr std::size_t TEXTURE_BUFFER_SIZE = 1 * 1024 * 1024;
 
     OGLVertexArray sw_vao; // VAO for software shader draw
     OGLVertexArray hw_vao; // VAO for hardware shader / accelerate draw
@@ -303,7 +369,7 @@ private:
     OGLStreamBuffer vertex_buffer;
     OGLStreamBuffer uniform_buffer;
     OGLStreamBuffer index_buffer;
-    OGLStreamBuffer texture_buffer;
+    OGLBuffer texture_buffer;
     OGLFramebuffer framebuffer;
     GLint uniform_buffer_alignment;
     std::size_t uniform_size_aligned_vs;
@@ -6,6 +6,7 @@
 #include <array>
 #include <atomic>
 #include <bitset>
+#include <chrono>
 #include <cstring>
 #include <iterator>
 #include <memory>
@@ -692,36 +693,14 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
 }
 
 bool CachedSurface::LoadCustomTexture(u64 tex_hash, Core::CustomTexInfo& tex_info) {
-    bool result = false;
     auto& custom_tex_cache = Core::System::GetInstance().CustomTexCache();
-    const auto& image_interface = Core::System::GetInstance().GetImageInterface();
-
-    if (custom_tex_cache.IsTextureCached(tex_hash)) {
-        tex_info = custom_tex_cache.LookupTexture(tex_hash);
-        result = true;
-    } else {
-        if (custom_tex_cache.CustomTextureExists(tex_hash)) {
-            const auto& path_info = custom_tex_cache.LookupTexturePathInfo(tex_hash);
-            if (image_interface->DecodePNG(tex_info.tex, tex_info.width, tex_info.height,
-                                           path_info.path)) {
-                std::bitset<32> width_bits(tex_info.width);
-                std::bitset<32> height_bits(tex_info.height);
-                if (width_bits.count() == 1 && height_bits.count() == 1) {
-                    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-                    Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
-                    custom_tex_cache.CacheTexture(tex_hash, tex_info.tex, tex_info.width,
-                                                  tex_info.height);
-                    result = true;
-                } else {
-                    LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
-                }
-            } else {
-                LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
-            }
-        }
+    const Core::CustomTexInfo* cached = custom_tex_cache.LoadTexture(tex_hash);
+    if (cached == nullptr) {
+        return false;
     }
 
-    return result;
+    tex_info = *cached;
+    return true;
 }
 
 void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
@@ -735,12 +714,9 @@ void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
         return;
     }
 
-    // Dump texture to RGBA8 and encode as PNG
-    const auto& image_interface = Core::System::GetInstance().GetImageInterface();
+    // Dump texture to RGBA8, the PNG is encoded in the background
     auto& custom_tex_cache = Core::System::GetInstance().CustomTexCache();
-    std::string dump_path =
-        fmt::format("{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::DumpDir),
-                    Core::System::GetInstance().Kernel().GetCurrentProcess()->codeset->program_id);
+    std::string dump_path = Core::CustomTexCache::GetDumpPath();
     if (!FileUtil::CreateFullPath(dump_path)) {
         LOG_ERROR(Render, "Unable to create {}", dump_path);
         return;
@@ -749,9 +725,6 @@ void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
     dump_path += fmt::format("tex1_{}x{}_{:016X}_{}.png", width, height, tex_hash,
                              static_cast<u32>(pixel_format));
     if (!custom_tex_cache.IsTextureDumped(tex_hash) && !FileUtil::Exists(dump_path)) {
-        custom_tex_cache.SetTextureDumped(tex_hash);
-
-        LOG_INFO(Render_OpenGL, "Dumping texture to {}", dump_path);
         std::vector<u8> decoded_texture;
         decoded_texture.resize(width * height * 4);
         glBindTexture(GL_TEXTURE_2D, target_tex);
@@ -771,9 +744,8 @@ void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
         GetTexImageOES(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, height, width, 0,
                        &decoded_texture[0], decoded_texture.size());
         glBindTexture(GL_TEXTURE_2D, 0);
-        Common::FlipRGBA8Texture(decoded_texture, width, height);
-        if (!image_interface->EncodePNG(dump_path, decoded_texture, width, height))
-            LOG_ERROR(Render_OpenGL, "Failed to save decoded texture");
+        custom_tex_cache.DumpTexture(tex_hash, std::move(dump_path), std::move(decoded_texture),
+                                     width, height);
     }
 }
 
@@ -956,6 +928,122 @@ void CachedSurface::DownloadGLTexture(const Common::Rectangle<u32>& rect, GLuint
     glPixelStorei(GL_PACK_ROW_LENGTH, 0);
 }
 
+CachedSurface::~CachedSurface() {
+    if (pending_download_fence != nullptr) {
+        glDeleteSync(pending_download_fence);
+    }
+}
+
+bool CachedSurface::StartAsyncDownload(const Common::Rectangle<u32>& rect, GLuint read_fb_handle,
+                                       GLuint draw_fb_handle) {
+    // Depth readback isn't available on every driver, those surfaces keep the synchronous path
+    if (type != SurfaceType::Color)
+        return false;
+
+    DiscardAsyncDownload();
+
+    OpenGLState state = OpenGLState::GetCurState();
+    OpenGLState prev_state = state;
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    const FormatTuple& tuple = GetFormatTuple(pixel_format);
+    const u32 bytes_per_pixel = GetGLBytesPerPixel(pixel_format);
+
+    GLuint read_tex = texture.handle;
+    Common::Rectangle<u32> read_rect = rect;
+
+    // The blit only needs to be queued before the read, so the temporary texture can go right away
+    OGLTexture unscaled_tex;
+    if (res_scale != 1) {
+        auto scaled_rect = rect;
+        scaled_rect.left *= res_scale;
+        scaled_rect.top *= res_scale;
+        scaled_rect.right *= res_scale;
+        scaled_rect.bottom *= res_scale;
+
+        unscaled_tex.Create();
+        read_rect = {0, rect.GetHeight(), rect.GetWidth(), 0};
+        AllocateSurfaceTexture(unscaled_tex.handle, tuple, rect.GetWidth(), rect.GetHeight());
+        BlitTextures(texture.handle, scaled_rect, unscaled_tex.handle, read_rect, type,
+                     read_fb_handle, draw_fb_handle);
+        read_tex = unscaled_tex.handle;
+    }
+
+    state.ResetTexture(texture.handle);
+    state.draw.read_framebuffer = read_fb_handle;
+    state.Apply();
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, read_tex, 0);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+
+    pending_download_buffer =
+        owner.AcquireReadbackBuffer(rect.GetWidth() * rect.GetHeight() * bytes_per_pixel);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pending_download_buffer.handle);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(static_cast<GLint>(read_rect.left), static_cast<GLint>(read_rect.bottom),
+                 static_cast<GLsizei>(read_rect.GetWidth()),
+                 static_cast<GLsizei>(read_rect.GetHeight()), tuple.format, tuple.type, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    pending_download_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pending_download_rect = rect;
+    return true;
+}
+
+MICROPROFILE_DEFINE(OpenGL_TextureDLWait, "OpenGL", "Texture Download Wait", MP_RGB(192, 128, 64));
+bool CachedSurface::FinishAsyncDownload(const Common::Rectangle<u32>& rect) {
+    if (pending_download_fence == nullptr)
+        return false;
+
+    const auto& pending = pending_download_rect;
+    if (rect.left < pending.left || rect.right > pending.right || rect.bottom < pending.bottom ||
+        rect.top > pending.top) {
+        DiscardAsyncDownload();
+        return false;
+    }
+
+    if (glClientWaitSync(pending_download_fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        MICROPROFILE_SCOPE(OpenGL_TextureDLWait);
+        glClientWaitSync(pending_download_fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    }
+
+    if (gl_buffer.empty()) {
+        gl_buffer.resize(width * height * GetGLBytesPerPixel(pixel_format));
+    }
+
+    const u32 bytes_per_pixel = GetGLBytesPerPixel(pixel_format);
+    const std::size_t src_row_size = pending.GetWidth() * bytes_per_pixel;
+    const std::size_t copy_row_size = rect.GetWidth() * bytes_per_pixel;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pending_download_buffer.handle);
+    const u8* src = static_cast<const u8*>(glMapBufferRange(
+        GL_PIXEL_PACK_BUFFER, 0, src_row_size * pending.GetHeight(), GL_MAP_READ_BIT));
+    if (src != nullptr) {
+        for (u32 y = rect.bottom; y < rect.top; ++y) {
+            const std::size_t src_offset =
+                (y - pending.bottom) * src_row_size + (rect.left - pending.left) * bytes_per_pixel;
+            const std::size_t dst_offset = (y * stride + rect.left) * bytes_per_pixel;
+            std::memcpy(&gl_buffer[dst_offset], src + src_offset, copy_row_size);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    DiscardAsyncDownload();
+    return src != nullptr;
+}
+
+bool CachedSurface::DiscardAsyncDownload() {
+    if (pending_download_fence == nullptr)
+        return false;
+
+    glDeleteSync(pending_download_fence);
+    pending_download_fence = nullptr;
+    owner.ReleaseReadbackBuffer(std::move(pending_download_buffer));
+    return true;
+}
+
 enum MatchFlags {
     Invalid = 1,      // Flag that can be applied to other match types, invalid matches require
                       // validation before they can be used
@@ -1694,6 +1782,7 @@ void RasterizerCacheOpenGL::DuplicateSurface(const Surface& src_surface,
 
     BlitSurfaces(src_surface, src_surface->GetScaledRect(), dest_surface,
                  dest_surface->GetScaledSubRect(*src_surface));
+    dest_surface->DiscardAsyncDownload();
 
     dest_surface->invalid_regions -= src_surface->GetInterval();
     dest_surface->invalid_regions += src_surface->invalid_regions;
@@ -1791,8 +1880,17 @@ void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, Surface flush_surf
 
         if (surface->type != SurfaceType::Fill) {
             SurfaceParams params = surface->FromInterval(interval);
-            surface->DownloadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
-                                       draw_framebuffer.handle);
+            const auto rect = surface->GetSubRect(params);
+            const auto start_time = std::chrono::steady_clock::now();
+            if (surface->FinishAsyncDownload(rect)) {
+                ++readback_stats.async_downloads;
+            } else {
+                surface->DownloadGLTexture(rect, read_framebuffer.handle, draw_framebuffer.handle);
+                ++readback_stats.sync_downloads;
+            }
+            readback_stats.stall_time += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start_time);
+            surface->readback_candidate = true;
         }
         surface->FlushGLBuffer(boost::icl::first(interval), boost::icl::last_next(interval));
         flushed_intervals += interval;
@@ -1805,6 +1903,60 @@ void RasterizerCacheOpenGL::FlushAll() {
     FlushRegion(0, 0xFFFFFFFF);
 }
 
+void RasterizerCacheOpenGL::StartPendingReadbacks() {
+    for (const auto& surface : readback_surfaces) {
+        if (!surface->registered)
+            continue;
+
+        // Download the bounding rect of everything the surface still owns in one go
+        std::optional<Common::Rectangle<u32>> bounds;
+        for (const auto& pair : RangeFromInterval(dirty_regions, surface->GetInterval())) {
+            if (pair.second != surface)
+                continue;
+            const auto rect = surface->GetSubRect(surface->FromInterval(pair.first));
+            if (!bounds) {
+                bounds = rect;
+                continue;
+            }
+            bounds->left = std::min(bounds->left, rect.left);
+            bounds->bottom = std::min(bounds->bottom, rect.bottom);
+            bounds->right = std::max(bounds->right, rect.right);
+            bounds->top = std::max(bounds->top, rect.top);
+        }
+
+        if (bounds && surface->StartAsyncDownload(*bounds, read_framebuffer.handle,
+                                                  draw_framebuffer.handle)) {
+            ++readback_stats.async_started;
+        }
+    }
+    readback_surfaces.clear();
+}
+
+OGLBuffer RasterizerCacheOpenGL::AcquireReadbackBuffer(std::size_t size) {
+    OGLBuffer buffer;
+    if (readback_buffer_pool.empty()) {
+        buffer.Create();
+    } else {
+        buffer = std::move(readback_buffer_pool.back());
+        readback_buffer_pool.pop_back();
+    }
+
+    // Respecifying the storage lets the driver hand out fresh memory if the old one is still busy
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.handle);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return buffer;
+}
+
+void RasterizerCacheOpenGL::ReleaseReadbackBuffer(OGLBuffer&& buffer) {
+    constexpr std::size_t max_pooled_buffers = 8;
+    if (readback_buffer_pool.size() < max_pooled_buffers) {
+        readback_buffer_pool.push_back(std::move(buffer));
+    } else {
+        buffer.Release();
+    }
+}
+
 void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface& region_owner) {
     if (size == 0)
         return;
@@ -1817,6 +1969,16 @@ void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface
         // Surfaces can't have a gap
         ASSERT(region_owner->width == region_owner->stride);
         region_owner->invalid_regions.erase(invalid_interval);
+
+        // The surface was just written to, anything downloaded ahead of time is stale now. A
+        // download that was never read means the guest stopped reading the surface back, so
+        // stop predicting until a flush needs it again.
+        if (region_owner->DiscardAsyncDownload()) {
+            region_owner->readback_candidate = false;
+            ++readback_stats.async_discarded;
+        } else if (region_owner->readback_candidate) {
+            readback_surfaces.emplace(region_owner);
+        }
     }
 
     for (auto& pair : RangeFromInterval(surface_cache, invalid_interval)) {
@@ -1895,6 +2057,7 @@ void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
         return;
     }
     surface->registered = false;
+    surface->DiscardAsyncDownload();
     UpdatePagesCachedCount(surface->addr, surface->size, -1);
     surface_cache.subtract({surface->GetInterval(), SurfaceSet{surface}});
 }
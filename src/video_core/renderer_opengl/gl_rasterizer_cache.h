@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <list>
 #include <memory>
 #include <set>
@@ -138,6 +139,7 @@ private:
 
 struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface> {
     CachedSurface(RasterizerCacheOpenGL& owner) : owner{owner} {}
+    ~CachedSurface();
 
     bool CanFill(const SurfaceParams& dest_surface, SurfaceInterval fill_interval) const;
     bool CanCopy(const SurfaceParams& dest_surface, SurfaceInterval copy_interval) const;
@@ -191,6 +193,20 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
     void DownloadGLTexture(const Common::Rectangle<u32>& rect, GLuint read_fb_handle,
                            GLuint draw_fb_handle);
 
+    // Asynchronous download of a region into a pixel pack buffer, finished by a later flush
+    bool StartAsyncDownload(const Common::Rectangle<u32>& rect, GLuint read_fb_handle,
+                            GLuint draw_fb_handle);
+    bool FinishAsyncDownload(const Common::Rectangle<u32>& rect);
+    /// Drops the pending download, returns whether there was one
+    bool DiscardAsyncDownload();
+
+    /// Set once the surface had to be read back, its later contents are downloaded ahead of time.
+    /// Cleared again when a download started ahead of time ends up unused.
+    bool readback_candidate = false;
+    Common::Rectangle<u32> pending_download_rect;
+    OGLBuffer pending_download_buffer;
+    GLsync pending_download_fence = nullptr;
+
     std::shared_ptr<SurfaceWatcher> CreateWatcher() {
         auto watcher = std::make_shared<SurfaceWatcher>(weak_from_this());
         watchers.push_front(watcher);
@@ -273,6 +289,32 @@ public:
     /// Get a surface that matches a "texture copy" display transfer config
     SurfaceRect_Tuple GetTexCopySurface(const SurfaceParams& params);
 
+    /// Start downloading the dirty regions of surfaces that are likely to be read back
+    void StartPendingReadbacks();
+
+    /// Time spent waiting on surface downloads and how they were serviced
+    struct ReadbackStats {
+        u64 sync_downloads = 0;
+        u64 async_downloads = 0;
+        u64 async_started = 0;
+        u64 async_discarded = 0;
+        std::chrono::microseconds stall_time{};
+    };
+
+    const ReadbackStats& GetReadbackStats() const {
+        return readback_stats;
+    }
+
+    void ResetReadbackStats() {
+        readback_stats = {};
+    }
+
+    /// Get a pixel pack buffer of at least the given size from the readback pool
+    OGLBuffer AcquireReadbackBuffer(std::size_t size);
+
+    /// Return a pixel pack buffer to the readback pool
+    void ReleaseReadbackBuffer(OGLBuffer&& buffer);
+
     /// Write any cached resources overlapping the region back to memory (if dirty)
     void FlushRegion(PAddr addr, u32 size, Surface flush_surface = nullptr);
 
@@ -304,6 +346,9 @@ private:
     PageMap cached_pages;
     SurfaceMap dirty_regions;
     SurfaceSet remove_surfaces;
+    SurfaceSet readback_surfaces;
+    std::vector<OGLBuffer> readback_buffer_pool;
+    ReadbackStats readback_stats;
 
     OGLFramebuffer read_framebuffer;
     OGLFramebuffer draw_framebuffer;
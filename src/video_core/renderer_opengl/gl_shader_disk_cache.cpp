@@ -102,7 +102,8 @@ bool ShaderDiskCacheRaw::Save(FileUtil::IOFile& file) const {
     return true;
 }
 
-ShaderDiskCache::ShaderDiskCache(bool separable) : separable{separable} {}
+ShaderDiskCache::ShaderDiskCache(bool separable, u64 program_id)
+    : separable{separable}, program_id{program_id} {}
 
 std::optional<std::vector<ShaderDiskCacheRaw>> ShaderDiskCache::LoadTransferable() {
     const bool has_title_id = GetProgramID() != 0;
@@ -90,7 +90,8 @@ struct ShaderDiskCacheDump {
 
 class ShaderDiskCache {
 public:
-    explicit ShaderDiskCache(bool separable);
+    /// If program_id is zero, the title id is taken from the currently loaded application
+    explicit ShaderDiskCache(bool separable, u64 program_id = 0);
     ~ShaderDiskCache() = default;
 
     /// Loads transferable cache. If file has a old version or on failure, it deletes the file.
@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
+#include <numeric>
 #include <thread>
 #include <unordered_map>
 #include <boost/functional/hash.hpp>
@@ -219,14 +221,27 @@ public:
     explicit ShaderCache(bool separable) : separable(separable) {}
     std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Get(
         const KeyConfigType& config) {
+        const auto iter = shaders.find(config);
+        if (iter != shaders.end()) {
+            return {iter->second.GetHandle(), {}};
+        }
+        return Add(config, CodeGenerator(config, separable));
+    }
+
+    /// Compiles code generated ahead of time for config, unless config is already cached
+    std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Add(
+        const KeyConfigType& config, ShaderDecompiler::ProgramResult result) {
         auto [iter, new_shader] = shaders.emplace(config, OGLShaderStage{separable});
         OGLShaderStage& cached_shader = iter->second;
-        std::optional<ShaderDecompiler::ProgramResult> result{};
-        if (new_shader) {
-            result = CodeGenerator(config, separable);
-            cached_shader.Create(result->code.c_str(), ShaderType);
+        if (!new_shader) {
+            return {cached_shader.GetHandle(), {}};
         }
-        return {cached_shader.GetHandle(), result};
+        cached_shader.Create(result.code.c_str(), ShaderType);
+        return {cached_shader.GetHandle(), std::move(result)};
+    }
+
+    bool Contains(const KeyConfigType& config) const {
+        return shaders.count(config) != 0;
     }
 
     void Inject(const KeyConfigType& key, std::string decomp, OGLProgram&& program) {
@@ -254,24 +269,9 @@ public:
     explicit ShaderDoubleCache(bool separable) : separable(separable) {}
     std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Get(
         const KeyConfigType& key, const Pica::Shader::ShaderSetup& setup) {
-        std::optional<ShaderDecompiler::ProgramResult> result{};
         auto map_it = shader_map.find(key);
         if (map_it == shader_map.end()) {
-            auto program_opt = CodeGenerator(setup, key, separable);
-            if (!program_opt) {
-                shader_map[key] = nullptr;
-                return {0, {}};
-            }
-
-            std::string& program = program_opt->code;
-            auto [iter, new_shader] = shader_cache.emplace(program, OGLShaderStage{separable});
-            OGLShaderStage& cached_shader = iter->second;
-            if (new_shader) {
-                result->code = program;
-                cached_shader.Create(program.c_str(), ShaderType);
-            }
-            shader_map[key] = &cached_shader;
-            return {cached_shader.GetHandle(), result};
+            return Add(key, CodeGenerator(setup, key, separable));
         }
 
         if (map_it->second == nullptr) {
@@ -281,6 +281,38 @@ public:
         return {map_it->second->GetHandle(), {}};
     }
 
+    /**
+     * Compiles code generated ahead of time for key, unless key is already cached. An empty
+     * program_opt marks a program the generator rejected.
+     */
+    std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Add(
+        const KeyConfigType& key, std::optional<ShaderDecompiler::ProgramResult> program_opt) {
+        auto map_it = shader_map.find(key);
+        if (map_it != shader_map.end()) {
+            return {map_it->second == nullptr ? 0 : map_it->second->GetHandle(), {}};
+        }
+
+        if (!program_opt) {
+            shader_map[key] = nullptr;
+            return {0, {}};
+        }
+
+        std::optional<ShaderDecompiler::ProgramResult> result{};
+        std::string& program = program_opt->code;
+        auto [iter, new_shader] = shader_cache.emplace(program, OGLShaderStage{separable});
+        OGLShaderStage& cached_shader = iter->second;
+        if (new_shader) {
+            cached_shader.Create(program.c_str(), ShaderType);
+            result = std::move(program_opt);
+        }
+        shader_map[key] = &cached_shader;
+        return {cached_shader.GetHandle(), result};
+    }
+
+    bool Contains(const KeyConfigType& key) const {
+        return shader_map.count(key) != 0;
+    }
+
     void Inject(const KeyConfigType& key, std::string decomp, OGLProgram&& program) {
         OGLShaderStage stage{separable};
         stage.Inject(std::move(program));
@@ -305,10 +337,10 @@ using FragmentShaders = ShaderCache<PicaFSConfig, &GenerateFragmentShader, GL_FR
 
 class ShaderProgramManager::Impl {
 public:
-    explicit Impl(bool separable, bool is_amd)
+    explicit Impl(bool separable, bool is_amd, u64 program_id)
         : is_amd(is_amd), separable(separable), programmable_vertex_shaders(separable),
           trivial_vertex_shader(separable), fixed_geometry_shaders(separable),
-          fragment_shaders(separable), disk_cache(separable) {
+          fragment_shaders(separable), disk_cache(separable, program_id) {
         if (separable)
             pipeline.Create();
     }
@@ -351,10 +383,159 @@ public:
     std::unordered_map<ShaderTuple, OGLProgram, ShaderTuple::Hash> program_cache;
     OGLPipeline pipeline;
     ShaderDiskCache disk_cache;
+
+    /// Whether the program of a transferable cache entry is already in the runtime caches
+    bool IsCached(const ShaderDiskCacheRaw& raw) const;
+
+    /**
+     * Regenerates the transferable cache entries at the given indices, compiles them into the
+     * runtime caches and saves the new programs to the precompiled cache. Generation is split
+     * across num_threads worker threads, compilation stays on the calling thread as it owns the
+     * GL context.
+     * @param timings receives the generation and compile times of every saved program
+     * @returns false if an entry is corrupted or failed to compile
+     */
+    bool BuildFromRaws(const std::vector<ShaderDiskCacheRaw>& raws,
+                       const std::vector<std::size_t>& indices, std::size_t num_threads,
+                       const std::atomic_bool& stop_loading,
+                       const VideoCore::DiskResourceLoadCallback& callback,
+                       std::vector<ShaderBuildTiming>& timings);
 };
 
-ShaderProgramManager::ShaderProgramManager(bool separable, bool is_amd)
-    : impl(std::make_unique<Impl>(separable, is_amd)) {}
+bool ShaderProgramManager::Impl::IsCached(const ShaderDiskCacheRaw& raw) const {
+    if (raw.GetProgramType() == ProgramType::VS) {
+        auto [conf, setup] = BuildVSConfigFromRaw(raw);
+        return programmable_vertex_shaders.Contains(conf);
+    } else if (raw.GetProgramType() == ProgramType::FS) {
+        return fragment_shaders.Contains(PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig()));
+    }
+    return false;
+}
+
+bool ShaderProgramManager::Impl::BuildFromRaws(const std::vector<ShaderDiskCacheRaw>& raws,
+                                               const std::vector<std::size_t>& indices,
+                                               std::size_t num_threads,
+                                               const std::atomic_bool& stop_loading,
+                                               const VideoCore::DiskResourceLoadCallback& callback,
+                                               std::vector<ShaderBuildTiming>& timings) {
+    using Clock = std::chrono::steady_clock;
+
+    struct GeneratedShader {
+        std::optional<ShaderDecompiler::ProgramResult> result;
+        bool sanitize_mul = false;
+        std::chrono::microseconds generate_time{};
+    };
+    std::vector<GeneratedShader> generated(indices.size());
+    std::atomic_bool generation_failed = false;
+
+    // GLSL generation only depends on the raw entry, so it can run on any thread
+    const auto GenerateWorker = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (stop_loading || generation_failed) {
+                return;
+            }
+            const auto& raw{raws[indices[i]]};
+            const u64 calculated_hash =
+                GetUniqueIdentifier(raw.GetRawShaderConfig(), raw.GetProgramCode());
+            if (raw.GetUniqueIdentifier() != calculated_hash) {
+                LOG_ERROR(Render_OpenGL,
+                          "Invalid hash in entry={:016x} (obtained hash={:016x}) - removing "
+                          "shader cache",
+                          raw.GetUniqueIdentifier(), calculated_hash);
+                generation_failed = true;
+                return;
+            }
+
+            auto& entry = generated[i];
+            const auto start = Clock::now();
+            if (raw.GetProgramType() == ProgramType::VS) {
+                auto [conf, setup] = BuildVSConfigFromRaw(raw);
+                entry.result = GenerateVertexShader(setup, conf, separable);
+                entry.sanitize_mul = conf.state.sanitize_mul;
+            } else if (raw.GetProgramType() == ProgramType::FS) {
+                PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
+                entry.result = GenerateFragmentShader(conf, separable);
+            } else {
+                // Unsupported shader type got stored somehow so nuke the cache
+                LOG_ERROR(Render_OpenGL, "failed to load raw programtype {}",
+                          static_cast<u32>(raw.GetProgramType()));
+                generation_failed = true;
+                return;
+            }
+            entry.generate_time =
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+        }
+    };
+
+    num_threads =
+        std::clamp<std::size_t>(num_threads, 1, std::max<std::size_t>(indices.size(), 1));
+    if (num_threads == 1) {
+        GenerateWorker(0, indices.size());
+    } else {
+        const std::size_t chunk_size = (indices.size() + num_threads - 1) / num_threads;
+        std::vector<std::thread> workers;
+        for (std::size_t begin = 0; begin < indices.size(); begin += chunk_size) {
+            workers.emplace_back(GenerateWorker, begin,
+                                 std::min(begin + chunk_size, indices.size()));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    if (generation_failed) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        if (stop_loading) {
+            return true;
+        }
+        const auto& raw{raws[indices[i]]};
+        const u64 unique_identifier{raw.GetUniqueIdentifier()};
+        auto& entry{generated[i]};
+        if (!entry.result) {
+            // The decompiler rejected this program, the runtime falls back to the software shader
+            LOG_WARNING(Render_OpenGL, "Skipping entry={:016x} which failed to decompile",
+                        unique_identifier);
+            continue;
+        }
+
+        const auto start = Clock::now();
+        GLuint handle{0};
+        std::optional<ShaderDecompiler::ProgramResult> result;
+        if (raw.GetProgramType() == ProgramType::VS) {
+            auto [conf, setup] = BuildVSConfigFromRaw(raw);
+            std::tie(handle, result) =
+                programmable_vertex_shaders.Add(conf, std::move(entry.result));
+        } else {
+            PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
+            std::tie(handle, result) = fragment_shaders.Add(conf, std::move(*entry.result));
+        }
+        const auto compile_time =
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+        if (handle == 0) {
+            LOG_ERROR(Render_OpenGL, "compilation from raw failed for entry={:016x}",
+                      unique_identifier);
+            return false;
+        }
+
+        // Only programs that weren't cached yet, duplicates map to the same program
+        if (result) {
+            disk_cache.SaveDecompiled(unique_identifier, *result, entry.sanitize_mul);
+            disk_cache.SaveDump(unique_identifier, handle);
+            timings.push_back({unique_identifier, raw.GetProgramType(), result->code.size(),
+                               entry.generate_time, compile_time});
+        }
+
+        if (callback) {
+            callback(VideoCore::LoadCallbackStage::Build, indices[i] + 1, raws.size());
+        }
+    }
+    return true;
+}
+
+ShaderProgramManager::ShaderProgramManager(bool separable, bool is_amd, u64 program_id)
+    : impl(std::make_unique<Impl>(separable, is_amd, program_id)) {}
 
 ShaderProgramManager::~ShaderProgramManager() = default;
 
@@ -552,72 +733,71 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
         callback(VideoCore::LoadCallbackStage::Build, 0, raws.size());
     }
 
-    compilation_failed = false;
+    // Entries that weren't restored from the precompiled cache are built now and saved to it
+    std::vector<std::size_t> missing_raws;
+    for (std::size_t i = 0; i < raws.size(); ++i) {
+        if (!impl->IsCached(raws[i])) {
+            missing_raws.push_back(i);
+        }
+    }
+    std::vector<ShaderBuildTiming> timings;
+    if (!impl->BuildFromRaws(raws, missing_raws, 1, stop_loading, callback, timings)) {
+        disk_cache.InvalidateAll();
+    }
+    if (!timings.empty()) {
+        precompiled_cache_altered = true;
+    }
 
-    const auto LoadTransferable = [&](std::size_t begin, std::size_t end,
-                                      const std::vector<ShaderDiskCacheRaw>& raws) {
-        for (std::size_t i = 0; i < end; ++i) {
-            if (stop_loading || compilation_failed) {
-                return;
-            }
-            const auto& raw{raws[i]};
-            const u64 unique_identifier{raw.GetUniqueIdentifier()};
-
-            bool sanitize_mul = false;
-            GLuint handle{0};
-            std::optional<ShaderDecompiler::ProgramResult> result;
-            // Otherwise decompile and build the shader at boot and save the result to the
-            // precompiled file
-            if (raw.GetProgramType() == ProgramType::VS) {
-                // TODO: This isn't the ideal place to lock, since we really only want to
-                // lock access to the shared cache
-                auto [conf, setup] = BuildVSConfigFromRaw(raw);
-                std::scoped_lock lock(mutex);
-                auto [h, r] = impl->programmable_vertex_shaders.Get(conf, setup);
-                handle = h;
-                result = r;
-                sanitize_mul = conf.state.sanitize_mul;
-            } else if (raw.GetProgramType() == ProgramType::FS) {
-                PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
-                std::scoped_lock lock(mutex);
-                auto [h, r] = impl->fragment_shaders.Get(conf);
-                handle = h;
-                result = r;
-            } else {
-                // Unsupported shader type got stored somehow so nuke the cache
-                LOG_ERROR(Frontend, "failed to load raw programtype {}",
-                          static_cast<u32>(raw.GetProgramType()));
-                compilation_failed = true;
-                return;
-            }
-            if (handle == 0) {
-                LOG_ERROR(Frontend, "compilation from raw failed {:x} {:x}",
-                          raw.GetProgramCode().at(0), raw.GetProgramCode().at(1));
-                compilation_failed = true;
-                return;
-            }
-            // If this is a new shader, add it the precompiled cache
-            if (result) {
-                disk_cache.SaveDecompiled(unique_identifier, *result, sanitize_mul);
-                disk_cache.SaveDump(unique_identifier, handle);
-                precompiled_cache_altered = true;
-            }
+    if (precompiled_cache_altered) {
+        disk_cache.SaveVirtualPrecompiledFile();
+    }
+}
 
-            if (callback) {
-                callback(VideoCore::LoadCallbackStage::Build, i, raws.size());
-            }
-        }
-    };
+std::vector<ShaderBuildTiming> ShaderProgramManager::PrebuildDiskCache(
+    std::size_t num_threads, const std::atomic_bool& stop_loading,
+    const VideoCore::DiskResourceLoadCallback& callback) {
+    if (!impl->separable) {
+        LOG_ERROR(Render_OpenGL,
+                  "Cannot build disk cache as separate shader programs are unsupported!");
+        return {};
+    }
+    auto& disk_cache = impl->disk_cache;
+    const auto transferable = disk_cache.LoadTransferable();
+    if (!transferable) {
+        return {};
+    }
+    const auto& raws = *transferable;
 
-    LoadTransferable(0, raws.size(), raws);
+    // Start from an empty precompiled cache so that stale entries from older drivers are dropped
+    disk_cache.InvalidatePrecompiled();
 
-    if (compilation_failed) {
+    // Let the driver spread the compile jobs over its own threads where it is able to
+    if (GLAD_GL_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+
+    if (callback) {
+        callback(VideoCore::LoadCallbackStage::Build, 0, raws.size());
+    }
+
+    std::vector<std::size_t> indices(raws.size());
+    std::iota(indices.begin(), indices.end(), std::size_t{0});
+    std::vector<ShaderBuildTiming> timings;
+    timings.reserve(raws.size());
+    if (!impl->BuildFromRaws(raws, indices, num_threads, stop_loading, callback, timings)) {
         disk_cache.InvalidateAll();
+        return {};
+    }
+    if (stop_loading) {
+        return {};
     }
 
-    if (precompiled_cache_altered) {
-        disk_cache.SaveVirtualPrecompiledFile();
+    disk_cache.SaveVirtualPrecompiledFile();
+
+    if (callback) {
+        callback(VideoCore::LoadCallbackStage::Complete, raws.size(), raws.size());
     }
-} // namespace OpenGL
+    return timings;
+}
 
 } // namespace OpenGL
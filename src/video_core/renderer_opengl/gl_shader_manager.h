@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <vector>
 #include <glad/glad.h>
 #include "video_core/rasterizer_interface.h"
 #include "video_core/regs_lighting.h"
@@ -96,15 +98,35 @@ static_assert(
 static_assert(sizeof(VSUniformData) < 16384,
               "VSUniformData structure must be less than 16kb as per the OpenGL spec");
 
+/// Time spent regenerating and compiling a single transferable cache entry
+struct ShaderBuildTiming {
+    u64 unique_identifier;
+    ProgramType program_type;
+    std::size_t code_size;
+    std::chrono::microseconds generate_time;
+    std::chrono::microseconds compile_time;
+};
+
 /// A class that manage different shader stages and configures them with given config data.
 class ShaderProgramManager {
 public:
-    ShaderProgramManager(bool separable, bool is_amd);
+    /// If program_id is zero, the disk cache uses the title id of the loaded application
+    ShaderProgramManager(bool separable, bool is_amd, u64 program_id = 0);
     ~ShaderProgramManager();
 
     void LoadDiskCache(const std::atomic_bool& stop_loading,
                        const VideoCore::DiskResourceLoadCallback& callback);
 
+    /**
+     * Regenerates every entry of the transferable cache on num_threads worker threads, compiles
+     * them on the calling thread and writes a fresh precompiled cache. Used to build the cache
+     * offline without running the game.
+     * @returns the per-shader generation and compile times, empty on failure
+     */
+    std::vector<ShaderBuildTiming> PrebuildDiskCache(
+        std::size_t num_threads, const std::atomic_bool& stop_loading,
+        const VideoCore::DiskResourceLoadCallback& callback);
+
     bool UseProgrammableVertexShader(const Pica::Regs& config, Pica::Shader::ShaderSetup& setup);
 
     void UseTrivialVertexShader();
@@ -2,8 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <deque>
-#include <vector>
+#include <algorithm>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/microprofile.h"
@@ -12,6 +11,8 @@
 
 MICROPROFILE_DEFINE(OpenGL_StreamBuffer, "OpenGL", "Stream Buffer Orphaning",
                     MP_RGB(128, 128, 192));
+MICROPROFILE_DEFINE(OpenGL_StreamBufferWait, "OpenGL", "Stream Buffer Fence Wait",
+                    MP_RGB(192, 128, 128));
 
 namespace OpenGL {
 
@@ -34,6 +35,7 @@ OGLStreamBuffer::OGLStreamBuffer(GLenum target, GLsizeiptr size, bool array_buff
     if (GLAD_GL_ARB_buffer_storage) {
         persistent = true;
         coherent = prefer_coherent;
+        region_size = buffer_size / NUM_SYNC_POINTS;
         GLbitfield flags =
             GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | (coherent ? GL_MAP_COHERENT_BIT : 0);
         glBufferStorage(gl_target, allocate_size, nullptr, flags);
@@ -45,6 +47,12 @@ OGLStreamBuffer::OGLStreamBuffer(GLenum target, GLsizeiptr size, bool array_buff
 }
 
 OGLStreamBuffer::~OGLStreamBuffer() {
+    for (GLsync& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
     if (persistent) {
         glBindBuffer(gl_target, gl_buffer.handle);
         glUnmapBuffer(gl_target);
@@ -60,6 +68,26 @@ GLsizeiptr OGLStreamBuffer::GetSize() const {
     return buffer_size;
 }
 
+std::size_t OGLStreamBuffer::GetSyncPoint(GLintptr offset) const {
+    return std::min(static_cast<std::size_t>(offset / region_size), NUM_SYNC_POINTS - 1);
+}
+
+void OGLStreamBuffer::WaitRegionsUntil(std::size_t last_sync_point) {
+    for (; next_wait <= last_sync_point; ++next_wait) {
+        GLsync& fence = fences[next_wait];
+        if (!fence) {
+            continue;
+        }
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            MICROPROFILE_SCOPE(OpenGL_StreamBufferWait);
+            ++stats.fence_waits;
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
 std::tuple<u8*, GLintptr, bool> OGLStreamBuffer::Map(GLsizeiptr size, GLintptr alignment) {
     ASSERT(size <= buffer_size);
     ASSERT(alignment <= buffer_size);
@@ -73,16 +101,18 @@ std::tuple<u8*, GLintptr, bool> OGLStreamBuffer::Map(GLsizeiptr size, GLintptr a
     if (buffer_pos + size > buffer_size) {
         buffer_pos = 0;
         invalidate = true;
+        ++stats.wrap_count;
 
-        if (persistent) {
-            glUnmapBuffer(gl_target);
-        }
+        // Regions skipped over by the wrap keep their fence from the previous pass, and are waited
+        // on when the next pass reaches them
+        next_wait = 0;
     }
 
-    if (invalidate || !persistent) {
+    if (persistent) {
+        WaitRegionsUntil(GetSyncPoint(buffer_pos + std::max<GLsizeiptr>(size, 1) - 1));
+    } else {
         MICROPROFILE_SCOPE(OpenGL_StreamBuffer);
-        GLbitfield flags = GL_MAP_WRITE_BIT | (persistent ? GL_MAP_PERSISTENT_BIT : 0) |
-                           (coherent ? GL_MAP_COHERENT_BIT : GL_MAP_FLUSH_EXPLICIT_BIT) |
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT |
                            (invalidate ? GL_MAP_INVALIDATE_BUFFER_BIT : GL_MAP_UNSYNCHRONIZED_BIT);
         mapped_ptr = static_cast<u8*>(
             glMapBufferRange(gl_target, buffer_pos, buffer_size - buffer_pos, flags));
@@ -103,7 +133,31 @@ void OGLStreamBuffer::Unmap(GLsizeiptr size) {
         glUnmapBuffer(gl_target);
     }
 
+    if (persistent && size > 0) {
+        for (std::size_t region = GetSyncPoint(buffer_pos);
+             region <= GetSyncPoint(buffer_pos + size - 1); ++region) {
+            unfenced_regions.set(region);
+        }
+    }
+
+    MICROPROFILE_META_CPU("Stream Buffer Bytes", static_cast<int>(size));
+    stats.bytes_written += size;
     buffer_pos += size;
 }
 
+void OGLStreamBuffer::FenceWrittenRegions() {
+    for (std::size_t region = 0; region < NUM_SYNC_POINTS && unfenced_regions.any(); ++region) {
+        if (!unfenced_regions.test(region)) {
+            continue;
+        }
+        // The region may still hold an older fence, which the new one outlasts
+        GLsync& fence = fences[region];
+        if (fence) {
+            glDeleteSync(fence);
+        }
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        unfenced_regions.reset(region);
+    }
+}
+
 } // namespace OpenGL
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <array>
+#include <bitset>
 #include <tuple>
 #include <glad/glad.h>
 #include "common/common_types.h"
@@ -13,6 +15,13 @@ namespace OpenGL {
 
 class OGLStreamBuffer : private NonCopyable {
 public:
+    /// Upload statistics, accumulated until ResetStats is called
+    struct Stats {
+        u64 bytes_written = 0;
+        u32 wrap_count = 0;
+        u32 fence_waits = 0;
+    };
+
     explicit OGLStreamBuffer(GLenum target, GLsizeiptr size, bool array_buffer_for_amd,
                              bool prefer_coherent = false);
     ~OGLStreamBuffer();
@@ -23,7 +32,10 @@ public:
     /*
      * Allocates a linear chunk of memory in the GPU buffer with at least "size" bytes
      * and the optional alignment requirement.
-     * If the buffer is full, the whole buffer is reallocated which invalidates old chunks.
+     * If the buffer is full, allocation wraps around to the start of the buffer which invalidates
+     * old chunks. With persistent mapping the buffer is split into regions guarded by fences, so
+     * wrapping only waits for the GPU to finish reading the regions being reused; otherwise the
+     * buffer is orphaned.
      * The return values are the pointer to the new chunk, the offset within the buffer,
      * and the invalidation flag for previous chunks.
      * The actual used size must be specified on unmapping the chunk.
@@ -32,7 +44,30 @@ public:
 
     void Unmap(GLsizeiptr size);
 
+    /*
+     * Fences the regions written since the last call. It must be called once the commands reading
+     * the written data have been submitted, e.g. after the draw consuming them, as a region is only
+     * reused once its fence has signaled. Does nothing without persistent mapping.
+     */
+    void FenceWrittenRegions();
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+    void ResetStats() {
+        stats = {};
+    }
+
 private:
+    static constexpr std::size_t NUM_SYNC_POINTS = 16;
+
+    /// Returns the index of the fenced region that contains the given buffer offset
+    std::size_t GetSyncPoint(GLintptr offset) const;
+
+    /// Waits until the GPU is done with every region up to (and including) the given one
+    void WaitRegionsUntil(std::size_t last_sync_point);
+
     OGLBuffer gl_buffer;
     GLenum gl_target;
 
@@ -44,6 +79,13 @@ private:
     GLintptr mapped_offset = 0;
     GLsizeiptr mapped_size = 0;
     u8* mapped_ptr = nullptr;
+
+    GLsizeiptr region_size = 0;
+    std::array<GLsync, NUM_SYNC_POINTS> fences{};
+    std::bitset<NUM_SYNC_POINTS> unfenced_regions; ///< Regions written since the last fence
+    std::size_t next_wait = 0; ///< First region of the current pass that has not been waited on
+
+    Stats stats;
 };
 
 } // namespace OpenGL
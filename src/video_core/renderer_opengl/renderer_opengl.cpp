@@ -7,6 +7,7 @@
 #include <condition_variable>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <deque>
 #include <memory>
 #include <mutex>
@@ -353,7 +354,12 @@ RendererOpenGL::RendererOpenGL(Frontend::EmuWindow& window)
     frame_dumper.mailbox = std::make_unique<OGLVideoDumpingMailbox>();
 }
 
-RendererOpenGL::~RendererOpenGL() = default;
+RendererOpenGL::~RendererOpenGL() {
+    // Hand over a screenshot still in flight, so the frontend isn't left waiting for it
+    if (screenshot_fence != nullptr) {
+        FinishScreenshot();
+    }
+}
 
 MICROPROFILE_DEFINE(OpenGL_RenderFrame, "OpenGL", "Render Frame", MP_RGB(128, 128, 64));
 MICROPROFILE_DEFINE(OpenGL_WaitPresent, "OpenGL", "Wait For Present", MP_RGB(128, 128, 128));
@@ -376,6 +382,7 @@ void RendererOpenGL::SwapBuffers() {
     }
 
     m_current_frame++;
+    rasterizer->EndFrame();
 
     Core::System::GetInstance().perf_stats->EndSystemFrame();
 
@@ -393,7 +400,41 @@ void RendererOpenGL::SwapBuffers() {
     }
 }
 
+MICROPROFILE_DEFINE(OpenGL_ScreenshotWait, "OpenGL", "Screenshot Wait", MP_RGB(128, 64, 64));
+
+void RendererOpenGL::FinishScreenshot() {
+    if (glClientWaitSync(screenshot_fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        MICROPROFILE_SCOPE(OpenGL_ScreenshotWait);
+        glClientWaitSync(screenshot_fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    }
+    glDeleteSync(screenshot_fence);
+    screenshot_fence = nullptr;
+
+    Layout::FramebufferLayout layout{VideoCore::g_screenshot_framebuffer_layout};
+    const GLsizeiptr size = layout.width * layout.height * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, screenshot_buffer.handle);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (pixels != nullptr) {
+        std::memcpy(VideoCore::g_screenshot_bits, pixels, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        LOG_ERROR(Render_OpenGL, "Failed to map the screenshot buffer");
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    screenshot_buffer.Release();
+
+    VideoCore::g_screenshot_complete_callback();
+    VideoCore::g_renderer_screenshot_requested = false;
+}
+
 void RendererOpenGL::RenderScreenshot() {
+    // The screenshot requested last frame has been read into the pack buffer in the background
+    if (screenshot_fence != nullptr) {
+        FinishScreenshot();
+        return;
+    }
+
     if (VideoCore::g_renderer_screenshot_requested) {
         // Draw this frame to the screenshot framebuffer
         screenshot_framebuffer.Create();
@@ -413,17 +454,22 @@ void RendererOpenGL::RenderScreenshot() {
 
         DrawScreens(layout, false);
 
+        // Read into a pack buffer instead of client memory so the frame doesn't wait on the GPU,
+        // the pixels are picked up when the next frame is presented
+        screenshot_buffer.Create();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, screenshot_buffer.handle);
+        glBufferData(GL_PIXEL_PACK_BUFFER, layout.width * layout.height * 4, nullptr,
+                     GL_STREAM_READ);
         glReadPixels(0, 0, layout.width, layout.height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
-                     VideoCore::g_screenshot_bits);
+                     nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        screenshot_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
         screenshot_framebuffer.Release();
         state.draw.read_framebuffer = old_read_fb;
         state.draw.draw_framebuffer = old_draw_fb;
         state.Apply();
         glDeleteRenderbuffers(1, &renderbuffer);
-
-        VideoCore::g_screenshot_complete_callback();
-        VideoCore::g_renderer_screenshot_requested = false;
     }
 }
 
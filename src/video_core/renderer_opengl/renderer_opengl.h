@@ -87,6 +87,8 @@ private:
     void ReloadShader();
     void PrepareRendertarget();
     void RenderScreenshot();
+    /// Waits for the screenshot read back last frame and hands it to the frontend
+    void FinishScreenshot();
     void RenderToMailbox(const Layout::FramebufferLayout& layout,
                          std::unique_ptr<Frontend::TextureMailbox>& mailbox, bool flipped);
     void ConfigureFramebufferTexture(TextureInfo& texture,
@@ -114,6 +116,8 @@ private:
     OGLBuffer vertex_buffer;
     OGLProgram shader;
     OGLFramebuffer screenshot_framebuffer;
+    OGLBuffer screenshot_buffer;
+    GLsync screenshot_fence = nullptr;
     OGLSampler filter_sampler;
 
     /// Display information for top and bottom screens respectively
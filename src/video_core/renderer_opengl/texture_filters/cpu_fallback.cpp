@@ -0,0 +1,117 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "video_core/renderer_opengl/texture_filters/cpu_fallback.h"
+#include "video_core/texture/filters/texture_filter.h"
+
+namespace OpenGL {
+
+namespace {
+
+/**
+ * Makes client memory transfers of tightly packed RGBA8 rows work whatever the caller left bound,
+ * e.g. a PBO of an asynchronous download, and restores the previous pixel store state when done.
+ */
+class ClientPixelTransferScope {
+public:
+    ClientPixelTransferScope() {
+        Save(GL_PIXEL_PACK_BUFFER, GL_PIXEL_PACK_BUFFER_BINDING, GL_PACK_ALIGNMENT,
+             GL_PACK_ROW_LENGTH, pack);
+        Save(GL_PIXEL_UNPACK_BUFFER, GL_PIXEL_UNPACK_BUFFER_BINDING, GL_UNPACK_ALIGNMENT,
+             GL_UNPACK_ROW_LENGTH, unpack);
+    }
+
+    ~ClientPixelTransferScope() {
+        Restore(GL_PIXEL_PACK_BUFFER, GL_PACK_ALIGNMENT, GL_PACK_ROW_LENGTH, pack);
+        Restore(GL_PIXEL_UNPACK_BUFFER, GL_UNPACK_ALIGNMENT, GL_UNPACK_ROW_LENGTH, unpack);
+    }
+
+private:
+    struct PixelStore {
+        GLint buffer = 0;
+        GLint alignment = 4;
+        GLint row_length = 0;
+    };
+
+    static void Save(GLenum target, GLenum binding, GLenum alignment, GLenum row_length,
+                     PixelStore& store) {
+        glGetIntegerv(binding, &store.buffer);
+        glGetIntegerv(alignment, &store.alignment);
+        glGetIntegerv(row_length, &store.row_length);
+        glBindBuffer(target, 0);
+        glPixelStorei(alignment, 4);
+        glPixelStorei(row_length, 0);
+    }
+
+    static void Restore(GLenum target, GLenum alignment, GLenum row_length,
+                        const PixelStore& store) {
+        glBindBuffer(target, static_cast<GLuint>(store.buffer));
+        glPixelStorei(alignment, store.alignment);
+        glPixelStorei(row_length, store.row_length);
+    }
+
+    PixelStore pack;
+    PixelStore unpack;
+};
+
+} // namespace
+
+CpuFallbackFilter::CpuFallbackFilter(std::string_view filter_name, u16 scale_factor)
+    : TextureFilterBase(scale_factor),
+      cpu_filter(Pica::Texture::CreateTextureFilter(filter_name, scale_factor)) {
+    ASSERT_MSG(cpu_filter, "No CPU implementation of texture filter {}", filter_name);
+    staging_texture.Create();
+}
+
+CpuFallbackFilter::~CpuFallbackFilter() = default;
+
+void CpuFallbackFilter::Filter(GLuint src_tex, const Common::Rectangle<u32>& src_rect,
+                               GLuint dst_tex, const Common::Rectangle<u32>& dst_rect,
+                               GLuint read_fb_handle, GLuint draw_fb_handle) {
+    const OpenGLState cur_state = OpenGLState::GetCurState();
+
+    const u32 width = src_rect.GetWidth();
+    const u32 height = src_rect.GetHeight();
+    const u32 filtered_width = width * scale_factor;
+    const u32 filtered_height = height * scale_factor;
+
+    state.draw.read_framebuffer = read_fb_handle;
+    state.draw.draw_framebuffer = draw_fb_handle;
+    state.texture_units[0].texture_2d = staging_texture.handle;
+    state.Apply();
+    const ClientPixelTransferScope pixel_transfer_scope;
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, src_tex, 0);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    src_pixels.resize(static_cast<std::size_t>(width) * height * 4);
+    glReadPixels(static_cast<GLint>(src_rect.left), static_cast<GLint>(src_rect.bottom),
+                 static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA,
+                 GL_UNSIGNED_BYTE, src_pixels.data());
+
+    dst_pixels.resize(static_cast<std::size_t>(filtered_width) * filtered_height * 4);
+    cpu_filter->Filter(src_pixels.data(), width, height, dst_pixels.data());
+
+    glActiveTexture(GL_TEXTURE0);
+    if (staging_width < filtered_width || staging_height < filtered_height) {
+        staging_width = std::max(staging_width, filtered_width);
+        staging_height = std::max(staging_height, filtered_height);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, staging_width, staging_height, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, nullptr);
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, filtered_width, filtered_height, GL_RGBA,
+                    GL_UNSIGNED_BYTE, dst_pixels.data());
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           staging_texture.handle, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dst_tex, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    glBlitFramebuffer(0, 0, filtered_width, filtered_height, dst_rect.left, dst_rect.bottom,
+                      dst_rect.right, dst_rect.top, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    cur_state.Apply();
+}
+
+} // namespace OpenGL
@@ -0,0 +1,46 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/texture_filters/texture_filter_base.h"
+
+namespace Pica::Texture {
+class TextureFilter;
+}
+
+namespace OpenGL {
+
+/**
+ * Runs a CPU texture filter on GL textures, for filters whose shaders the context can't run. The
+ * source is read back, filtered on the CPU and uploaded to a staging texture that is blitted into
+ * the destination, which works regardless of the destination format.
+ */
+class CpuFallbackFilter : public TextureFilterBase {
+public:
+    CpuFallbackFilter(std::string_view filter_name, u16 scale_factor);
+    ~CpuFallbackFilter() override;
+
+    void Filter(GLuint src_tex, const Common::Rectangle<u32>& src_rect, GLuint dst_tex,
+                const Common::Rectangle<u32>& dst_rect, GLuint read_fb_handle,
+                GLuint draw_fb_handle) override;
+
+private:
+    std::unique_ptr<Pica::Texture::TextureFilter> cpu_filter;
+
+    OpenGLState state{};
+    OGLTexture staging_texture;
+    u32 staging_width = 0;
+    u32 staging_height = 0;
+
+    std::vector<u8> src_pixels;
+    std::vector<u8> dst_pixels;
+};
+
+} // namespace OpenGL
@@ -6,8 +6,10 @@
 #include <functional>
 #include <unordered_map>
 #include "common/logging/log.h"
+#include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/texture_filters/anime4k/anime4k_ultrafast.h"
 #include "video_core/renderer_opengl/texture_filters/bicubic/bicubic.h"
+#include "video_core/renderer_opengl/texture_filters/cpu_fallback.h"
 #include "video_core/renderer_opengl/texture_filters/texture_filter_base.h"
 #include "video_core/renderer_opengl/texture_filters/texture_filterer.h"
 #include "video_core/renderer_opengl/texture_filters/xbrz/xbrz_freescale.h"
@@ -23,9 +25,21 @@ std::pair<std::string_view, TextureFilterContructor> FilterMapPair() {
     return {T::NAME, std::make_unique<T, u16>};
 };
 
+/// Filters that need desktop GL features run on the CPU under GLES
+template <typename T>
+std::pair<std::string_view, TextureFilterContructor> DesktopOnlyFilterMapPair() {
+    return {T::NAME, [](u16 scale_factor) -> std::unique_ptr<TextureFilterBase> {
+                if (GLES) {
+                    return std::make_unique<CpuFallbackFilter>(T::NAME, scale_factor);
+                }
+                return std::make_unique<T>(scale_factor);
+            }};
+}
+
 static const std::unordered_map<std::string_view, TextureFilterContructor> filter_map{
     {TextureFilterer::NONE, [](u16) { return nullptr; }},
-    FilterMapPair<Anime4kUltrafast>(),
+    // Anime4K stores its intermediate passes in rectangle textures
+    DesktopOnlyFilterMapPair<Anime4kUltrafast>(),
     FilterMapPair<Bicubic>(),
     FilterMapPair<XbrzFreescale>(),
 };
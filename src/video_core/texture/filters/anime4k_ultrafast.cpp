@@ -0,0 +1,223 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// CPU port of the x_gradient, y_gradient and refine passes, modified from
+// https://github.com/bloc97/Anime4K/blob/533cee5f7018d0e57ad2a26d76d43f13b9d8782a/glsl/Anime4K_Adaptive_v1.0RC2_UltraFast.glsl
+
+// MIT License
+//
+// Copyright(c) 2019 bloc97
+//
+// Permission is hereby granted,
+// free of charge,
+// to any person obtaining a copy of this software and associated documentation
+// files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS",
+// WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <algorithm>
+#include <cmath>
+#include "video_core/texture/filters/anime4k_ultrafast.h"
+#include "video_core/texture/filters/filter_image.h"
+
+namespace Pica::Texture {
+
+namespace {
+
+constexpr float LINE_DETECT_THRESHOLD = 0.4f;
+constexpr float STRENGTH = 0.6f;
+
+using Vec4f = Common::Vec4<float>;
+
+float GetLum(const Vec4f& color) {
+    // TODO: improve handling of alpha channel
+    return 0.2627f * color.r() + 0.6780f * color.g() + 0.0593f * color.b();
+}
+
+// the original shader used the alpha channel for luminance,
+// which doesn't work for our use case
+struct RGBAL {
+    Vec4f c;
+    float l;
+};
+
+Vec4f GetAverage(const Vec4f& cc, const Vec4f& a, const Vec4f& b, const Vec4f& c) {
+    return cc * (1 - STRENGTH) + ((a + b + c) / 3) * STRENGTH;
+}
+
+float Min3(float a, float b, float c) {
+    return std::min(std::min(a, b), c);
+}
+
+float Max3(float a, float b, float c) {
+    return std::max(std::max(a, b), c);
+}
+
+/// The kernels of the refine pass, pixel naming follows refine.frag
+Vec4f Refine(const RGBAL& cc, const RGBAL& tl, const RGBAL& t, const RGBAL& tr, const RGBAL& l,
+             const RGBAL& r, const RGBAL& bl, const RGBAL& b, const RGBAL& br) {
+    // Kernel 0 and 4
+    float max_dark = Max3(br.l, b.l, bl.l);
+    float min_light = Min3(tl.l, t.l, tr.l);
+
+    if (min_light > cc.l && min_light > max_dark) {
+        return GetAverage(cc.c, tl.c, t.c, tr.c);
+    } else {
+        max_dark = Max3(tl.l, t.l, tr.l);
+        min_light = Min3(br.l, b.l, bl.l);
+        if (min_light > cc.l && min_light > max_dark) {
+            return GetAverage(cc.c, br.c, b.c, bl.c);
+        }
+    }
+
+    // Kernel 1 and 5
+    max_dark = Max3(cc.l, l.l, b.l);
+    min_light = Min3(r.l, t.l, tr.l);
+
+    if (min_light > max_dark) {
+        return GetAverage(cc.c, r.c, t.c, tr.c);
+    } else {
+        max_dark = Max3(cc.l, r.l, t.l);
+        min_light = Min3(bl.l, l.l, b.l);
+        if (min_light > max_dark) {
+            return GetAverage(cc.c, bl.c, l.c, b.c);
+        }
+    }
+
+    // Kernel 2 and 6
+    max_dark = Max3(l.l, tl.l, bl.l);
+    min_light = Min3(r.l, br.l, tr.l);
+
+    if (min_light > cc.l && min_light > max_dark) {
+        return GetAverage(cc.c, r.c, br.c, tr.c);
+    } else {
+        max_dark = Max3(r.l, br.l, tr.l);
+        min_light = Min3(l.l, tl.l, bl.l);
+        if (min_light > cc.l && min_light > max_dark) {
+            return GetAverage(cc.c, l.c, tl.c, bl.c);
+        }
+    }
+
+    // Kernel 3 and 7
+    max_dark = Max3(cc.l, l.l, t.l);
+    min_light = Min3(r.l, br.l, b.l);
+
+    if (min_light > max_dark) {
+        return GetAverage(cc.c, r.c, br.c, b.c);
+    } else {
+        max_dark = Max3(cc.l, r.l, b.l);
+        min_light = Min3(t.l, l.l, tl.l);
+        if (min_light > max_dark) {
+            return GetAverage(cc.c, t.c, l.c, tl.c);
+        }
+    }
+
+    return cc.c;
+}
+
+} // Anonymous namespace
+
+Anime4kUltrafast::Anime4kUltrafast(u16 scale_factor) : TextureFilter(scale_factor) {}
+
+void Anime4kUltrafast::Filter(const u8* src, u32 width, u32 height, u8* dst,
+                              std::size_t num_threads) const {
+    const FilterImage image(src, width, height);
+    const u32 internal_width = width * internal_scale_factor;
+    const u32 internal_height = height * internal_scale_factor;
+    const std::size_t internal_size = static_cast<std::size_t>(internal_width) * internal_height;
+
+    // gradient x pass, sampling the source bilinearly at the internal resolution
+    std::vector<float> gradient_x(internal_size);
+    std::vector<float> lum_sum(internal_size);
+    const float texel_width = 1.0f / width;
+    ParallelForRows(internal_height, num_threads, [&](u32 begin_y, u32 end_y) {
+        for (u32 y = begin_y; y < end_y; ++y) {
+            const float v = (y + 0.5f) / internal_height;
+            for (u32 x = 0; x < internal_width; ++x) {
+                const float u = (x + 0.5f) / internal_width;
+                const float l = GetLum(image.Sample(u - texel_width, v));
+                const float c = GetLum(image.Sample(u, v));
+                const float r = GetLum(image.Sample(u + texel_width, v));
+                const std::size_t i = static_cast<std::size_t>(y) * internal_width + x;
+                gradient_x[i] = r - l;
+                lum_sum[i] = l + 2.0f * c + r;
+            }
+        }
+    });
+
+    // gradient y pass, producing the luminance of detected lines
+    std::vector<float> lumad(internal_size);
+    ParallelForRows(internal_height, num_threads, [&](u32 begin_y, u32 end_y) {
+        for (u32 y = begin_y; y < end_y; ++y) {
+            const std::size_t row_t = static_cast<std::size_t>(std::min(y + 1, internal_height - 1));
+            const std::size_t row_b = static_cast<std::size_t>(y == 0 ? 0 : y - 1);
+            for (u32 x = 0; x < internal_width; ++x) {
+                const std::size_t t = row_t * internal_width + x;
+                const std::size_t c = static_cast<std::size_t>(y) * internal_width + x;
+                const std::size_t b = row_b * internal_width + x;
+                const float grad_x = gradient_x[t] + 2 * gradient_x[c] + gradient_x[b];
+                const float grad_y = lum_sum[b] - lum_sum[t];
+                lumad[c] = 1 - std::sqrt(grad_x * grad_x + grad_y * grad_y);
+            }
+        }
+    });
+
+    // refine pass at the output resolution
+    const u32 dst_width = width * scale_factor;
+    const u32 dst_height = height * scale_factor;
+    const float final_scale = static_cast<float>(internal_scale_factor) / scale_factor;
+    const float texel_height = 1.0f / height;
+    ParallelForRows(dst_height, num_threads, [&](u32 begin_y, u32 end_y) {
+        const auto get_lumad = [&](float frag_x, float frag_y) {
+            const s32 x = std::clamp(static_cast<s32>(frag_x * final_scale), 0,
+                                     static_cast<s32>(internal_width) - 1);
+            const s32 y = std::clamp(static_cast<s32>(frag_y * final_scale), 0,
+                                     static_cast<s32>(internal_height) - 1);
+            return lumad[static_cast<std::size_t>(y) * internal_width + x];
+        };
+
+        for (u32 y = begin_y; y < end_y; ++y) {
+            const float frag_y = y + 0.5f;
+            const float v = frag_y / dst_height;
+            u8* dst_row = dst + static_cast<std::size_t>(y) * dst_width * 4;
+            for (u32 x = 0; x < dst_width; ++x) {
+                const float frag_x = x + 0.5f;
+                const float u = frag_x / dst_width;
+                const auto get_rgbal = [&](s32 offset_x, s32 offset_y) {
+                    return RGBAL{image.Sample(u + offset_x * texel_width,
+                                              v + offset_y * texel_height),
+                                 get_lumad(frag_x + offset_x, frag_y + offset_y)};
+                };
+
+                const RGBAL cc = get_rgbal(0, 0);
+                if (cc.l > LINE_DETECT_THRESHOLD) {
+                    StorePixel(dst_row + x * 4, cc.c);
+                    continue;
+                }
+
+                const Vec4f color =
+                    Refine(cc, get_rgbal(-1, -1), get_rgbal(0, -1), get_rgbal(1, -1),
+                           get_rgbal(-1, 0), get_rgbal(1, 0), get_rgbal(-1, 1), get_rgbal(0, 1),
+                           get_rgbal(1, 1));
+                StorePixel(dst_row + x * 4, color);
+            }
+        }
+    });
+}
+
+} // namespace Pica::Texture
@@ -0,0 +1,84 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cmath>
+#include "video_core/texture/filters/bicubic.h"
+#include "video_core/texture/filters/filter_image.h"
+
+namespace Pica::Texture {
+
+namespace {
+
+/**
+ * Bicubic filtering done with four bilinear taps, as in bicubic.frag. The tap positions and
+ * weights only depend on a single axis, so they are computed once per output column and row.
+ */
+struct AxisTaps {
+    float offset0;
+    float offset1;
+    float weight;
+};
+
+// from http://www.java-gaming.org/index.php?topic=35123.0
+Common::Vec4<float> Cubic(float v) {
+    const Common::Vec4<float> n = Common::MakeVec(1.0f, 2.0f, 3.0f, 4.0f) -
+                                  Common::Vec4<float>::AssignToAll(v);
+    const Common::Vec4<float> s = n * n * n;
+    const float x = s.x;
+    const float y = s.y - 4.0f * s.x;
+    const float z = s.z - 4.0f * s.y + 6.0f * s.x;
+    const float w = 6.0f - x - y - z;
+    return Common::MakeVec(x, y, z, w) * (1.0f / 6.0f);
+}
+
+std::vector<AxisTaps> ComputeAxisTaps(u32 src_size, u32 dst_size) {
+    std::vector<AxisTaps> taps(dst_size);
+    const float inv_src_size = 1.0f / src_size;
+    for (u32 i = 0; i < dst_size; ++i) {
+        float coord = (i + 0.5f) / dst_size * src_size - 0.5f;
+        const float fract = coord - std::floor(coord);
+        coord -= fract;
+
+        const Common::Vec4<float> cubic = Cubic(fract);
+        const float s0 = cubic.x + cubic.y;
+        const float s1 = cubic.z + cubic.w;
+        taps[i].offset0 = (coord - 0.5f + cubic.y / s0) * inv_src_size;
+        taps[i].offset1 = (coord + 1.5f + cubic.w / s1) * inv_src_size;
+        taps[i].weight = s0 / (s0 + s1);
+    }
+    return taps;
+}
+
+} // Anonymous namespace
+
+Bicubic::Bicubic(u16 scale_factor) : TextureFilter(scale_factor) {}
+
+void Bicubic::Filter(const u8* src, u32 width, u32 height, u8* dst,
+                     std::size_t num_threads) const {
+    const FilterImage image(src, width, height);
+    const u32 dst_width = width * scale_factor;
+    const u32 dst_height = height * scale_factor;
+    const std::vector<AxisTaps> x_taps = ComputeAxisTaps(width, dst_width);
+    const std::vector<AxisTaps> y_taps = ComputeAxisTaps(height, dst_height);
+
+    ParallelForRows(dst_height, num_threads, [&](u32 begin_y, u32 end_y) {
+        for (u32 y = begin_y; y < end_y; ++y) {
+            const AxisTaps& ty = y_taps[y];
+            u8* dst_row = dst + static_cast<std::size_t>(y) * dst_width * 4;
+            for (u32 x = 0; x < dst_width; ++x) {
+                const AxisTaps& tx = x_taps[x];
+                const auto sample0 = image.Sample(tx.offset0, ty.offset0);
+                const auto sample1 = image.Sample(tx.offset1, ty.offset0);
+                const auto sample2 = image.Sample(tx.offset0, ty.offset1);
+                const auto sample3 = image.Sample(tx.offset1, ty.offset1);
+                const auto color =
+                    Common::Lerp(Common::Lerp(sample3, sample2, tx.weight),
+                                 Common::Lerp(sample1, sample0, tx.weight), ty.weight);
+                StorePixel(dst_row + x * 4, color);
+            }
+        }
+    });
+}
+
+} // namespace Pica::Texture
@@ -0,0 +1,83 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+namespace Pica::Texture {
+
+/**
+ * Read-only view of an RGBA8 image, sampled the way the OpenGL filters sample their input:
+ * normalized coordinates with texel centers at half integers and edges clamped.
+ */
+class FilterImage {
+public:
+    FilterImage(const u8* data, u32 width, u32 height)
+        : data{data}, width{static_cast<s32>(width)}, height{static_cast<s32>(height)} {}
+
+    s32 Width() const {
+        return width;
+    }
+
+    s32 Height() const {
+        return height;
+    }
+
+    /// Returns the texel at the given position as stored, for exact comparisons
+    u32 Raw(s32 x, s32 y) const {
+        x = std::clamp(x, 0, width - 1);
+        y = std::clamp(y, 0, height - 1);
+        u32 texel;
+        std::memcpy(&texel, data + (static_cast<std::size_t>(y) * width + x) * 4, sizeof(texel));
+        return texel;
+    }
+
+    /// Returns the texel at the given position with components in [0, 1]
+    Common::Vec4<float> Fetch(s32 x, s32 y) const {
+        return Unpack(Raw(x, y));
+    }
+
+    /// Bilinear sample at normalized coordinates
+    Common::Vec4<float> Sample(float u, float v) const {
+        const float x = u * width - 0.5f;
+        const float y = v * height - 0.5f;
+        const float x_floor = std::floor(x);
+        const float y_floor = std::floor(y);
+        const s32 x0 = static_cast<s32>(x_floor);
+        const s32 y0 = static_cast<s32>(y_floor);
+        return Common::BilinearInterp(Fetch(x0, y0), Fetch(x0 + 1, y0), Fetch(x0, y0 + 1),
+                                      Fetch(x0 + 1, y0 + 1), x - x_floor, y - y_floor);
+    }
+
+    static Common::Vec4<float> Unpack(u32 texel) {
+        return Common::Vec4<float>(static_cast<float>(texel & 0xFF),
+                                   static_cast<float>((texel >> 8) & 0xFF),
+                                   static_cast<float>((texel >> 16) & 0xFF),
+                                   static_cast<float>(texel >> 24)) /
+               255.0f;
+    }
+
+private:
+    const u8* data;
+    s32 width;
+    s32 height;
+};
+
+/// Stores a color with components in [0, 1] as RGBA8, rounding like a fixed point render target
+inline void StorePixel(u8* dst, const Common::Vec4<float>& color) {
+    for (std::size_t i = 0; i < 4; ++i) {
+        dst[i] = static_cast<u8>(std::clamp(color[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+}
+
+inline void StoreRaw(u8* dst, u32 texel) {
+    std::memcpy(dst, &texel, sizeof(texel));
+}
+
+} // namespace Pica::Texture
@@ -0,0 +1,86 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include "common/logging/log.h"
+#include "common/thread_pool.h"
+#include "video_core/texture/filters/anime4k_ultrafast.h"
+#include "video_core/texture/filters/bicubic.h"
+#include "video_core/texture/filters/texture_filter.h"
+#include "video_core/texture/filters/xbrz_freescale.h"
+
+namespace Pica::Texture {
+
+namespace {
+
+using TextureFilterConstructor = std::function<std::unique_ptr<TextureFilter>(u16)>;
+
+template <typename T>
+std::pair<std::string_view, TextureFilterConstructor> FilterMapPair() {
+    return {T::NAME, std::make_unique<T, u16>};
+}
+
+const std::unordered_map<std::string_view, TextureFilterConstructor> filter_map{
+    FilterMapPair<Anime4kUltrafast>(),
+    FilterMapPair<Bicubic>(),
+    FilterMapPair<XbrzFreescale>(),
+};
+
+/// Workers the rows of an image are spread over, started on first use and kept afterwards
+Common::ThreadPool& GetFilterPool() {
+    static Common::ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+} // namespace
+
+void TextureFilter::ParallelForRows(u32 num_rows, std::size_t num_threads,
+                                    const std::function<void(u32, u32)>& func) {
+    if (num_rows == 0) {
+        return;
+    }
+    Common::ThreadPool& pool = GetFilterPool();
+    if (num_threads == 0) {
+        num_threads = pool.GetThreadCount();
+    }
+    // Small images aren't worth spreading, give every thread a reasonable amount of work
+    constexpr u32 min_rows_per_thread = 16;
+    num_threads = std::clamp<std::size_t>(num_rows / min_rows_per_thread, 1, num_threads);
+    const u32 rows_per_range = static_cast<u32>((num_rows + num_threads - 1) / num_threads);
+    const std::size_t num_ranges = (num_rows + rows_per_range - 1) / rows_per_range;
+
+    pool.ParallelFor(num_ranges, [&](std::size_t range) {
+        const u32 begin = static_cast<u32>(range) * rows_per_range;
+        func(begin, std::min(begin + rows_per_range, num_rows));
+    });
+}
+
+std::unique_ptr<TextureFilter> CreateTextureFilter(std::string_view name, u16 scale_factor) {
+    auto iter = filter_map.find(name);
+    if (iter == filter_map.end()) {
+        LOG_ERROR(HW_GPU, "Invalid texture filter: {}", name);
+        return nullptr;
+    }
+    return iter->second(scale_factor);
+}
+
+std::vector<std::string_view> GetTextureFilterNames() {
+    std::vector<std::string_view> ret;
+    std::transform(filter_map.begin(), filter_map.end(), std::back_inserter(ret),
+                   [](const auto& pair) { return pair.first; });
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+std::vector<u8> FilterTexture(const TextureFilter& filter, const std::vector<u8>& src, u32 width,
+                              u32 height, std::size_t num_threads) {
+    std::vector<u8> dst(static_cast<std::size_t>(width) * filter.scale_factor * height *
+                        filter.scale_factor * 4);
+    filter.Filter(src.data(), width, height, dst.data(), num_threads);
+    return dst;
+}
+
+} // namespace Pica::Texture
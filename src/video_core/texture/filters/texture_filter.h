@@ -0,0 +1,50 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Pica::Texture {
+
+/**
+ * CPU implementation of the texture filters of the OpenGL renderer. It is used where no GL context
+ * is available, like offline texture pack building, and as a fallback for filters the context
+ * can't run. Filters operate on RGBA8 images, rows stored one after another.
+ */
+class TextureFilter {
+public:
+    explicit TextureFilter(u16 scale_factor) : scale_factor{scale_factor} {}
+    virtual ~TextureFilter() = default;
+
+    /**
+     * Filters a width x height image into dst, which must hold (width * scale_factor) x
+     * (height * scale_factor) pixels.
+     * @param num_threads Maximum number of threads to spread the rows over, 0 to use every core
+     */
+    virtual void Filter(const u8* src, u32 width, u32 height, u8* dst,
+                        std::size_t num_threads = 0) const = 0;
+
+    const u16 scale_factor{};
+
+protected:
+    /// Splits the rows [0, num_rows) into contiguous ranges and runs func(begin, end) on each one
+    static void ParallelForRows(u32 num_rows, std::size_t num_threads,
+                                const std::function<void(u32, u32)>& func);
+};
+
+/// Creates the filter with the given name, which are shared with the OpenGL filters
+std::unique_ptr<TextureFilter> CreateTextureFilter(std::string_view name, u16 scale_factor);
+
+std::vector<std::string_view> GetTextureFilterNames();
+
+/// Filters an image into a newly allocated one
+std::vector<u8> FilterTexture(const TextureFilter& filter, const std::vector<u8>& src, u32 width,
+                              u32 height, std::size_t num_threads = 0);
+
+} // namespace Pica::Texture
@@ -0,0 +1,363 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// CPU port of xbrz_freescale.frag, adapted from
+// https://github.com/libretro/glsl-shaders/blob/d7a8b8eb2a61a5732da4cbe2e0f9ad30600c3f17/xbrz/shaders/xbrz-freescale.glsl
+
+// xBRZ freescale
+// based on :
+// 4xBRZ shader - Copyright (C) 2014-2016 DeSmuME team
+//
+// This file is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with the this software.  If not, see <http://www.gnu.org/licenses/>.
+
+// Hyllian's xBR-vertex code and texel mapping
+// Copyright (C) 2011/2016 Hyllian - sergiogdb@gmail.com
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+
+#include <array>
+#include <cmath>
+#include "video_core/texture/filters/filter_image.h"
+#include "video_core/texture/filters/xbrz_freescale.h"
+
+namespace Pica::Texture {
+
+namespace {
+
+enum BlendType : u8 {
+    BLEND_NONE = 0,
+    BLEND_NORMAL = 1,
+    BLEND_DOMINANT = 2,
+};
+
+constexpr float EQUAL_COLOR_TOLERANCE = 30.0f / 255.0f;
+constexpr float STEEP_DIRECTION_THRESHOLD = 2.2f;
+constexpr float DOMINANT_DIRECTION_THRESHOLD = 3.6f;
+constexpr float SQRT_2 = 1.41421356f;
+
+using Vec2f = Common::Vec2<float>;
+using Vec4f = Common::Vec4<float>;
+
+float ColorDist(const Vec4f& a, const Vec4f& b) {
+    // https://en.wikipedia.org/wiki/YCbCr#ITU-R_BT.2020_conversion
+    constexpr float Kr = 0.2627f;
+    constexpr float Kg = 0.6780f;
+    constexpr float Kb = 0.0593f;
+    const Vec4f diff = a - b;
+    const float y = Kr * diff.r() + Kg * diff.g() + Kb * diff.b();
+    const float cb =
+        -0.5f * Kr / (1.0f - Kb) * diff.r() - 0.5f * Kg / (1.0f - Kb) * diff.g() + 0.5f * diff.b();
+    const float cr =
+        0.5f * diff.r() - 0.5f * Kg / (1.0f - Kr) * diff.g() - 0.5f * Kb / (1.0f - Kr) * diff.b();
+    // LUMINANCE_WEIGHT is currently 1, otherwise y would be multiplied by it
+    const float d2 = y * y + cb * cb + cr * cr;
+    return std::sqrt(a.a() * b.a() * d2 + diff.a() * diff.a());
+}
+
+bool IsPixEqual(const Vec4f& a, const Vec4f& b) {
+    return ColorDist(a, b) < EQUAL_COLOR_TOLERANCE;
+}
+
+float SmoothStep(float edge0, float edge1, float x) {
+    const float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+/// A corner of the texel blended towards a neighbour along an edge
+struct CornerBlend {
+    Vec2f origin;
+    Vec2f direction;
+    Vec4f color;
+};
+
+float GetLeftRatio(const Vec2f& center, const CornerBlend& corner, float scale) {
+    const Vec2f p0 = center - corner.origin;
+    const Vec2f& direction = corner.direction;
+    const Vec2f proj = direction * (Common::Dot(p0, direction) / Common::Dot(direction, direction));
+    const Vec2f distv = p0 - proj;
+    const Vec2f orth(-direction.y, direction.x);
+    const float side_dot = Common::Dot(p0, orth);
+    const float side = side_dot > 0.0f ? 1.0f : (side_dot < 0.0f ? -1.0f : 0.0f);
+    const float v = side * (distv * scale).Length();
+    return SmoothStep(-SQRT_2 / 2.0f, SQRT_2 / 2.0f, v);
+}
+
+/// The 5x5 neighbourhood of a texel, as raw values for exact comparisons and as colors
+class Neighbourhood {
+public:
+    Neighbourhood(const FilterImage& image, s32 x, s32 y) {
+        for (s32 dy = -2; dy <= 2; ++dy) {
+            for (s32 dx = -2; dx <= 2; ++dx) {
+                // The corners of the 5x5 area are never sampled
+                if ((dx == -2 || dx == 2) && (dy == -2 || dy == 2)) {
+                    continue;
+                }
+                const u32 texel = image.Raw(x + dx, y + dy);
+                raw[Index(dx, dy)] = texel;
+                color[Index(dx, dy)] = FilterImage::Unpack(texel);
+            }
+        }
+    }
+
+    u32 Raw(s32 dx, s32 dy) const {
+        return raw[Index(dx, dy)];
+    }
+
+    const Vec4f& P(s32 dx, s32 dy) const {
+        return color[Index(dx, dy)];
+    }
+
+private:
+    static constexpr std::size_t Index(s32 dx, s32 dy) {
+        return static_cast<std::size_t>((dy + 2) * 5 + dx + 2);
+    }
+
+    std::array<u32, 25> raw{};
+    std::array<Vec4f, 25> color{};
+};
+
+/**
+ * Computes the corners of the texel that blend with a neighbour. This part only depends on the
+ * source texel, so it is done once for all the output pixels it covers.
+ * @returns the number of corners written to corners
+ */
+std::size_t ComputeCornerBlends(const Neighbourhood& n, std::array<CornerBlend, 4>& corners) {
+    // Input Pixel Mapping:  -|x|x|x|-
+    //                       x|A|B|C|x
+    //                       x|D|E|F|x
+    //                       x|G|H|I|x
+    //                       -|x|x|x|-
+    const u32 rA = n.Raw(-1, -1), rB = n.Raw(0, -1), rC = n.Raw(1, -1);
+    const u32 rD = n.Raw(-1, 0), rE = n.Raw(0, 0), rF = n.Raw(1, 0);
+    const u32 rG = n.Raw(-1, 1), rH = n.Raw(0, 1), rI = n.Raw(1, 1);
+    const Vec4f &A = n.P(-1, -1), &B = n.P(0, -1), &C = n.P(1, -1);
+    const Vec4f &D = n.P(-1, 0), &E = n.P(0, 0), &F = n.P(1, 0);
+    const Vec4f &G = n.P(-1, 1), &H = n.P(0, 1), &I = n.P(1, 1);
+
+    // blendResult Mapping: x|y|
+    //                      w|z|
+    BlendType blend_x = BLEND_NONE;
+    BlendType blend_y = BLEND_NONE;
+    BlendType blend_z = BLEND_NONE;
+    BlendType blend_w = BLEND_NONE;
+
+    // Preprocess corners
+    if (!((rE == rF && rH == rI) || (rE == rH && rF == rI))) {
+        const float dist_H_F = ColorDist(G, E) + ColorDist(E, C) + ColorDist(n.P(0, 2), I) +
+                               ColorDist(I, n.P(2, 0)) + (4.0f * ColorDist(H, F));
+        const float dist_E_I = ColorDist(D, H) + ColorDist(H, n.P(1, 2)) + ColorDist(B, F) +
+                               ColorDist(F, n.P(2, 1)) + (4.0f * ColorDist(E, I));
+        const bool dominant_gradient = (DOMINANT_DIRECTION_THRESHOLD * dist_H_F) < dist_E_I;
+        if (dist_H_F < dist_E_I && rE != rF && rE != rH) {
+            blend_z = dominant_gradient ? BLEND_DOMINANT : BLEND_NORMAL;
+        }
+    }
+    if (!((rD == rE && rG == rH) || (rD == rG && rE == rH))) {
+        const float dist_G_E = ColorDist(n.P(-2, 1), D) + ColorDist(D, B) +
+                               ColorDist(n.P(-1, 2), H) + ColorDist(H, F) +
+                               (4.0f * ColorDist(G, E));
+        const float dist_D_H = ColorDist(n.P(-2, 0), G) + ColorDist(G, n.P(0, 2)) +
+                               ColorDist(A, E) + ColorDist(E, I) + (4.0f * ColorDist(D, H));
+        const bool dominant_gradient = (DOMINANT_DIRECTION_THRESHOLD * dist_D_H) < dist_G_E;
+        if (dist_G_E > dist_D_H && rE != rD && rE != rH) {
+            blend_w = dominant_gradient ? BLEND_DOMINANT : BLEND_NORMAL;
+        }
+    }
+    if (!((rB == rC && rE == rF) || (rB == rE && rC == rF))) {
+        const float dist_E_C = ColorDist(D, B) + ColorDist(B, n.P(1, -2)) + ColorDist(H, F) +
+                               ColorDist(F, n.P(2, -1)) + (4.0f * ColorDist(E, C));
+        const float dist_B_F = ColorDist(A, E) + ColorDist(E, I) + ColorDist(n.P(0, -2), C) +
+                               ColorDist(C, n.P(2, 0)) + (4.0f * ColorDist(B, F));
+        const bool dominant_gradient = (DOMINANT_DIRECTION_THRESHOLD * dist_B_F) < dist_E_C;
+        if (dist_E_C > dist_B_F && rE != rB && rE != rF) {
+            blend_y = dominant_gradient ? BLEND_DOMINANT : BLEND_NORMAL;
+        }
+    }
+    if (!((rA == rB && rD == rE) || (rA == rD && rB == rE))) {
+        const float dist_D_B = ColorDist(n.P(-2, 0), A) + ColorDist(A, n.P(0, -2)) +
+                               ColorDist(G, E) + ColorDist(E, C) + (4.0f * ColorDist(D, B));
+        const float dist_A_E = ColorDist(n.P(-2, -1), D) + ColorDist(D, H) +
+                               ColorDist(n.P(-1, -2), B) + ColorDist(B, F) +
+                               (4.0f * ColorDist(A, E));
+        const bool dominant_gradient = (DOMINANT_DIRECTION_THRESHOLD * dist_D_B) < dist_A_E;
+        if (dist_D_B < dist_A_E && rE != rD && rE != rB) {
+            blend_x = dominant_gradient ? BLEND_DOMINANT : BLEND_NORMAL;
+        }
+    }
+
+    std::size_t count = 0;
+    if (blend_z != BLEND_NONE) {
+        const float dist_F_G = ColorDist(F, G);
+        const float dist_H_C = ColorDist(H, C);
+        const bool do_line_blend =
+            blend_z == BLEND_DOMINANT ||
+            !((blend_y != BLEND_NONE && !IsPixEqual(E, G)) ||
+              (blend_w != BLEND_NONE && !IsPixEqual(E, C)) ||
+              (IsPixEqual(G, H) && IsPixEqual(H, I) && IsPixEqual(I, F) && IsPixEqual(F, C) &&
+               !IsPixEqual(E, I)));
+        CornerBlend& corner = corners[count++];
+        corner.origin = Vec2f(0.0f, 1.0f / SQRT_2);
+        corner.direction = Vec2f(1.0f, -1.0f);
+        if (do_line_blend) {
+            const bool have_shallow_line =
+                (STEEP_DIRECTION_THRESHOLD * dist_F_G <= dist_H_C) && rE != rG && rD != rG;
+            const bool have_steep_line =
+                (STEEP_DIRECTION_THRESHOLD * dist_H_C <= dist_F_G) && rE != rC && rB != rC;
+            corner.origin = have_shallow_line ? Vec2f(0.0f, 0.25f) : Vec2f(0.0f, 0.5f);
+            corner.direction.x += have_shallow_line ? 1.0f : 0.0f;
+            corner.direction.y -= have_steep_line ? 1.0f : 0.0f;
+        }
+        corner.color = ColorDist(E, H) >= ColorDist(E, F) ? F : H;
+    }
+    if (blend_w != BLEND_NONE) {
+        const float dist_H_A = ColorDist(H, A);
+        const float dist_D_I = ColorDist(D, I);
+        const bool do_line_blend =
+            blend_w == BLEND_DOMINANT ||
+            !((blend_z != BLEND_NONE && !IsPixEqual(E, A)) ||
+              (blend_x != BLEND_NONE && !IsPixEqual(E, I)) ||
+              (IsPixEqual(A, D) && IsPixEqual(D, G) && IsPixEqual(G, H) && IsPixEqual(H, I) &&
+               !IsPixEqual(E, G)));
+        CornerBlend& corner = corners[count++];
+        corner.origin = Vec2f(-1.0f / SQRT_2, 0.0f);
+        corner.direction = Vec2f(1.0f, 1.0f);
+        if (do_line_blend) {
+            const bool have_shallow_line =
+                (STEEP_DIRECTION_THRESHOLD * dist_H_A <= dist_D_I) && rE != rA && rB != rA;
+            const bool have_steep_line =
+                (STEEP_DIRECTION_THRESHOLD * dist_D_I <= dist_H_A) && rE != rI && rF != rI;
+            corner.origin = have_shallow_line ? Vec2f(-0.25f, 0.0f) : Vec2f(-0.5f, 0.0f);
+            corner.direction.y += have_shallow_line ? 1.0f : 0.0f;
+            corner.direction.x += have_steep_line ? 1.0f : 0.0f;
+        }
+        corner.color = ColorDist(E, H) >= ColorDist(E, D) ? D : H;
+    }
+    if (blend_y != BLEND_NONE) {
+        const float dist_B_I = ColorDist(B, I);
+        const float dist_F_A = ColorDist(F, A);
+        const bool do_line_blend =
+            blend_y == BLEND_DOMINANT ||
+            !((blend_x != BLEND_NONE && !IsPixEqual(E, I)) ||
+              (blend_z != BLEND_NONE && !IsPixEqual(E, A)) ||
+              (IsPixEqual(I, F) && IsPixEqual(F, C) && IsPixEqual(C, B) && IsPixEqual(B, A) &&
+               !IsPixEqual(E, C)));
+        CornerBlend& corner = corners[count++];
+        corner.origin = Vec2f(1.0f / SQRT_2, 0.0f);
+        corner.direction = Vec2f(-1.0f, -1.0f);
+        if (do_line_blend) {
+            const bool have_shallow_line =
+                (STEEP_DIRECTION_THRESHOLD * dist_B_I <= dist_F_A) && rE != rI && rH != rI;
+            const bool have_steep_line =
+                (STEEP_DIRECTION_THRESHOLD * dist_F_A <= dist_B_I) && rE != rA && rD != rA;
+            corner.origin = have_shallow_line ? Vec2f(0.25f, 0.0f) : Vec2f(0.5f, 0.0f);
+            corner.direction.y -= have_shallow_line ? 1.0f : 0.0f;
+            corner.direction.x -= have_steep_line ? 1.0f : 0.0f;
+        }
+        corner.color = ColorDist(E, F) >= ColorDist(E, B) ? B : F;
+    }
+    if (blend_x != BLEND_NONE) {
+        const float dist_D_C = ColorDist(D, C);
+        const float dist_B_G = ColorDist(B, G);
+        const bool do_line_blend =
+            blend_x == BLEND_DOMINANT ||
+            !((blend_w != BLEND_NONE && !IsPixEqual(E, C)) ||
+              (blend_y != BLEND_NONE && !IsPixEqual(E, G)) ||
+              (IsPixEqual(C, B) && IsPixEqual(B, A) && IsPixEqual(A, D) && IsPixEqual(D, G) &&
+               !IsPixEqual(E, A)));
+        CornerBlend& corner = corners[count++];
+        corner.origin = Vec2f(0.0f, -1.0f / SQRT_2);
+        corner.direction = Vec2f(-1.0f, 1.0f);
+        if (do_line_blend) {
+            const bool have_shallow_line =
+                (STEEP_DIRECTION_THRESHOLD * dist_D_C <= dist_B_G) && rE != rC && rF != rC;
+            const bool have_steep_line =
+                (STEEP_DIRECTION_THRESHOLD * dist_B_G <= dist_D_C) && rE != rG && rH != rG;
+            corner.origin = have_shallow_line ? Vec2f(0.0f, -0.25f) : Vec2f(0.0f, -0.5f);
+            corner.direction.x -= have_shallow_line ? 1.0f : 0.0f;
+            corner.direction.y += have_steep_line ? 1.0f : 0.0f;
+        }
+        corner.color = ColorDist(E, D) >= ColorDist(E, B) ? B : D;
+    }
+    return count;
+}
+
+} // Anonymous namespace
+
+XbrzFreescale::XbrzFreescale(u16 scale_factor) : TextureFilter(scale_factor) {}
+
+void XbrzFreescale::Filter(const u8* src, u32 width, u32 height, u8* dst,
+                           std::size_t num_threads) const {
+    const FilterImage image(src, width, height);
+    const u32 scale = scale_factor;
+    const std::size_t dst_stride = static_cast<std::size_t>(width) * scale * 4;
+    const float float_scale = static_cast<float>(scale);
+
+    // Position of each output pixel within its source texel, relative to the texel center
+    std::vector<float> sub_positions(scale);
+    for (u32 i = 0; i < scale; ++i) {
+        sub_positions[i] = (i + 0.5f) / scale - 0.5f;
+    }
+
+    // Every source texel produces a scale x scale block of the output, so the work is split by
+    // source rows and the blending decisions are made once per texel
+    ParallelForRows(height, num_threads, [&](u32 begin_y, u32 end_y) {
+        std::array<CornerBlend, 4> corners;
+        for (u32 y = begin_y; y < end_y; ++y) {
+            for (u32 x = 0; x < width; ++x) {
+                const Neighbourhood neighbourhood(image, static_cast<s32>(x), static_cast<s32>(y));
+                const std::size_t num_corners = ComputeCornerBlends(neighbourhood, corners);
+                u8* block = dst + static_cast<std::size_t>(y) * scale * dst_stride +
+                            static_cast<std::size_t>(x) * scale * 4;
+
+                if (num_corners == 0) {
+                    const u32 texel = neighbourhood.Raw(0, 0);
+                    for (u32 sy = 0; sy < scale; ++sy) {
+                        for (u32 sx = 0; sx < scale; ++sx) {
+                            StoreRaw(block + sy * dst_stride + sx * 4, texel);
+                        }
+                    }
+                    continue;
+                }
+
+                const Vec4f& center = neighbourhood.P(0, 0);
+                for (u32 sy = 0; sy < scale; ++sy) {
+                    for (u32 sx = 0; sx < scale; ++sx) {
+                        const Vec2f pos(sub_positions[sx], sub_positions[sy]);
+                        Vec4f res = center;
+                        for (std::size_t i = 0; i < num_corners; ++i) {
+                            res = Common::Lerp(res, corners[i].color,
+                                               GetLeftRatio(pos, corners[i], float_scale));
+                        }
+                        StorePixel(block + sy * dst_stride + sx * 4, res);
+                    }
+                }
+            }
+        }
+    });
+}
+
+} // namespace Pica::Texture
@@ -0,0 +1,21 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string_view>
+#include "video_core/texture/filters/texture_filter.h"
+
+namespace Pica::Texture {
+
+class XbrzFreescale : public TextureFilter {
+public:
+    static constexpr std::string_view NAME = "xBRZ freescale";
+
+    explicit XbrzFreescale(u16 scale_factor);
+    void Filter(const u8* src, u32 width, u32 height, u8* dst,
+                std::size_t num_threads) const override;
+};
+
+} // namespace Pica::Texture